@@ -0,0 +1,181 @@
+/**
+ * @file    agg.c
+ *
+ * @brief   Agg Source File
+ *
+ * @remarks Adding a sample is a handful of integer operations per quantity and the window takes constant memory. The
+ *          sums are shifted by the first value, so unlike the textbook sum of squares they do not cancel out, and
+ *          unlike Welford's update they need no division per sample.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "agg.h"
+
+#include "freertos/FreeRTOS.h"
+
+#include <math.h>
+#include <string.h>
+
+
+static sample_t agg_history_samples[AGG_HISTORY_SIZE];
+static uint32_t agg_history_next;
+static uint32_t agg_history_count;
+static portMUX_TYPE agg_history_lock = portMUX_INITIALIZER_UNLOCKED;
+
+
+/**
+ * @brief           Adds a value to the sums of a quantity.
+ */
+static void agg_field_add(agg_field_t *field, uint32_t count, int32_t value)
+{
+  if (count == 0) {
+    field->first = value;
+    field->min = value;
+    field->max = value;
+  }
+
+  int64_t delta = (int64_t)value - field->first;
+  field->sum += delta;
+  field->sum_sq += delta * delta;
+
+  if (value < field->min) {
+    field->min = value;
+  }
+  if (value > field->max) {
+    field->max = value;
+  }
+}
+
+
+/**
+ * @brief           Empties a window.
+ *
+ * @param agg       The window.
+ */
+void agg_reset(agg_t *agg)
+{
+  memset(agg, 0, sizeof(*agg));
+}
+
+
+/**
+ * @brief           Adds a sample to a window.
+ *
+ * @param agg       The window.
+ * @param sample    The sample.
+ */
+void agg_add(agg_t *agg, const sample_t *sample)
+{
+  agg_field_add(&agg->temperature, agg->count, sample->temperature);
+  agg_field_add(&agg->pressure, agg->count, sample->pressure);
+  agg_field_add(&agg->humidity, agg->count, sample->humidity);
+
+  agg->last = *sample;
+  agg->count++;
+}
+
+
+/**
+ * @brief           Gets the mean of a quantity, rounded to its units.
+ *
+ * @param field     The quantity.
+ * @param count     The number of samples in the window.
+ *
+ * @return          The mean.
+ */
+int32_t agg_mean(const agg_field_t *field, uint32_t count)
+{
+  if (count == 0) {
+    return 0;
+  }
+
+  int64_t offset = field->sum >= 0 ? (field->sum + count / 2) / count : -((-field->sum + count / 2) / count);
+
+  return field->first + offset;
+}
+
+
+/**
+ * @brief           Gets the sample standard deviation of a quantity.
+ *
+ * @param field     The quantity.
+ * @param count     The number of samples in the window.
+ * @param scale     The factor to scale the result by, to keep the fractions of the units.
+ *
+ * @return          The standard deviation times scale, rounded.
+ */
+uint32_t agg_stddev(const agg_field_t *field, uint32_t count, uint32_t scale)
+{
+  if (count < 2) {
+    return 0;
+  }
+
+  // n * sum(d^2) - sum(d)^2 is exact in integers and never negative.
+  int64_t numerator = (int64_t)count * field->sum_sq - field->sum * field->sum;
+  float variance = (float)numerator / ((float)count * (count - 1));
+
+  return sqrtf(variance) * scale + 0.5f;
+}
+
+
+/**
+ * @brief           Gets the means of a window as a sample, stamped and located like its latest sample.
+ *
+ * @param agg       The window.
+ * @param sample    The sample.
+ */
+void agg_sample(const agg_t *agg, sample_t *sample)
+{
+  *sample = agg->last;
+  sample->temperature = agg_mean(&agg->temperature, agg->count);
+  sample->pressure = agg_mean(&agg->pressure, agg->count);
+  sample->humidity = agg_mean(&agg->humidity, agg->count);
+}
+
+
+/**
+ * @brief           Keeps a raw sample in the history, overwriting the oldest one.
+ *
+ * @param sample    The sample.
+ */
+void agg_keep(const sample_t *sample)
+{
+  if (AGG_HISTORY_SIZE == 0) {
+    return;
+  }
+
+  portENTER_CRITICAL(&agg_history_lock);
+  agg_history_samples[agg_history_next] = *sample;
+  agg_history_next = (agg_history_next + 1) % AGG_HISTORY_SIZE;
+  if (agg_history_count < AGG_HISTORY_SIZE) {
+    agg_history_count++;
+  }
+  portEXIT_CRITICAL(&agg_history_lock);
+}
+
+
+/**
+ * @brief           Copies the kept raw samples, newest first. Can be called from any task.
+ *
+ * @param samples   The samples destination.
+ * @param max_samples The maximum number of samples to copy.
+ *
+ * @return          The number of samples copied.
+ */
+uint32_t agg_history(sample_t *samples, uint32_t max_samples)
+{
+  uint32_t count = 0;
+
+  portENTER_CRITICAL(&agg_history_lock);
+  while (count < max_samples && count < agg_history_count) {
+    uint32_t index = (agg_history_next + AGG_HISTORY_SIZE - 1 - count) % AGG_HISTORY_SIZE;
+    samples[count++] = agg_history_samples[index];
+  }
+  portEXIT_CRITICAL(&agg_history_lock);
+
+  return count;
+}
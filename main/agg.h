@@ -0,0 +1,80 @@
+/**
+ * @file    agg.h
+ *
+ * @brief   Agg Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _AGG_H_
+#define _AGG_H_
+
+
+#include "power.h"
+#include "sample.h"
+
+#include <stdint.h>
+
+
+// Uploads one point of min/max/mean/stddev per sensor and window instead of every sample. Meant for sampling faster
+// than the uploads can keep up with, e.g. with BME_SAMPLING_PERIOD_MS at 1000. Not used in deep sleep mode.
+#define AGG_ENABLE                    (0)
+#define AGG_WINDOW_MS                 (60000)
+#define AGG_ACTIVE                    (AGG_ENABLE && POWER_MODE != POWER_MODE_DEEP_SLEEP)
+
+// A window is closed early at this many samples, which keeps the sums of squares within 64 bits.
+#define AGG_MAX_SAMPLES               (3600)
+
+// The latest raw samples of every sensor are kept on the device, whether or not they are uploaded.
+#define AGG_HISTORY_SIZE              (64)
+
+/**
+ * @brief   The running sums of one quantity. They are taken around the first value of the window, so that they stay
+ *          small and exact in integers, and the variance needs no floating point until the window closes.
+ */
+typedef struct {
+  int32_t first;
+  int32_t min;
+  int32_t max;
+  int64_t sum;
+  int64_t sum_sq;
+} agg_field_t;
+
+/**
+ * @brief   A tumbling window of one sensor.
+ */
+typedef struct {
+  uint32_t count;
+  int64_t window;
+  sample_t last;
+  agg_field_t temperature;
+  agg_field_t pressure;
+  agg_field_t humidity;
+} agg_t;
+
+
+void agg_reset(agg_t *agg);
+
+
+void agg_add(agg_t *agg, const sample_t *sample);
+
+
+int32_t agg_mean(const agg_field_t *field, uint32_t count);
+
+
+uint32_t agg_stddev(const agg_field_t *field, uint32_t count, uint32_t scale);
+
+
+void agg_sample(const agg_t *agg, sample_t *sample);
+
+
+void agg_keep(const sample_t *sample);
+
+
+uint32_t agg_history(sample_t *samples, uint32_t max_samples);
+
+
+#endif /* _AGG_H_ */
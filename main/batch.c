@@ -0,0 +1,117 @@
+/**
+ * @file    batch.c
+ *
+ * @brief   Batch Source File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "batch.h"
+
+
+/**
+ * @brief           Empties a batch.
+ *
+ * @param batch     The batch.
+ */
+void batch_reset(batch_t *batch)
+{
+  batch->len = 0;
+  batch->points = 0;
+  batch->first_ms = 0;
+}
+
+
+/**
+ * @brief           Gets the position of the next point, so that it can be encoded in place. The room is capped at
+ *                  BATCH_MAX_LINE_SIZE, so that a point that is too long fails the same whether the batch is empty or
+ *                  not.
+ *
+ * @param batch     The batch.
+ * @param size      The room left for the point.
+ *
+ * @return          The position of the next point.
+ */
+char *batch_line(batch_t *batch, uint32_t *size)
+{
+  uint32_t start = batch->len + (batch->points > 0 ? 1 : 0);
+
+  *size = start < BATCH_BUFFER_SIZE ? BATCH_BUFFER_SIZE - start : 0;
+  if (*size > BATCH_MAX_LINE_SIZE) {
+    *size = BATCH_MAX_LINE_SIZE;
+  }
+
+  return batch->buffer + start;
+}
+
+
+/**
+ * @brief           Adds the point encoded at batch_line to the batch. Points are separated by a new line.
+ *
+ * @param batch     The batch.
+ * @param line_len  The point length.
+ * @param now_ms    The current time in milliseconds. Marks the age of the batch when it is its first point.
+ */
+void batch_commit(batch_t *batch, uint32_t line_len, uint32_t now_ms)
+{
+  if (batch->points == 0) {
+    batch->first_ms = now_ms;
+  } else {
+    batch->buffer[batch->len++] = '\n';
+  }
+
+  batch->len += line_len;
+  batch->points++;
+}
+
+
+/**
+ * @brief           Checks if a batch has room for a number of points of the maximum size, with their separators.
+ *
+ * @param batch     The batch.
+ * @param lines     The number of points.
+ *
+ * @return        - true if the points fit
+ *                - false otherwise
+ */
+bool batch_fits(const batch_t *batch, uint32_t lines)
+{
+  return BATCH_BUFFER_SIZE - batch->len >= lines * (BATCH_MAX_LINE_SIZE + 1);
+}
+
+
+/**
+ * @brief           Checks if a batch has no room for another point.
+ *
+ * @param batch     The batch.
+ *
+ * @return        - true if the batch is full
+ *                - false otherwise
+ */
+bool batch_is_full(const batch_t *batch)
+{
+  return !batch_fits(batch, 1);
+}
+
+
+/**
+ * @brief           Checks if a batch has to be sent, either because it reached its size limits or because its first
+ *                  point is too old.
+ *
+ * @param batch     The batch.
+ * @param now_ms    The current time in milliseconds.
+ *
+ * @return        - true if the batch has to be sent
+ *                - false otherwise
+ */
+bool batch_is_due(const batch_t *batch, uint32_t now_ms)
+{
+  if (batch->points == 0) {
+    return false;
+  }
+
+  return batch->points >= BATCH_MAX_POINTS || batch_is_full(batch) || now_ms - batch->first_ms >= BATCH_MAX_AGE_MS;
+}
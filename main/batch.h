@@ -0,0 +1,52 @@
+/**
+ * @file    batch.h
+ *
+ * @brief   Batch Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#define BATCH_BUFFER_SIZE             (4096)
+#define BATCH_MAX_POINTS              (12)
+#define BATCH_MAX_LINE_SIZE           (512)
+#define BATCH_MAX_AGE_MS              (120000)
+#define BATCH_LOW_HEAP_BYTES          (16384)
+
+typedef struct {
+  char buffer[BATCH_BUFFER_SIZE];
+  uint32_t len;
+  uint32_t points;
+  uint32_t first_ms;
+} batch_t;
+
+
+void batch_reset(batch_t *batch);
+
+
+char *batch_line(batch_t *batch, uint32_t *size);
+
+
+void batch_commit(batch_t *batch, uint32_t line_len, uint32_t now_ms);
+
+
+bool batch_fits(const batch_t *batch, uint32_t lines);
+
+
+bool batch_is_full(const batch_t *batch);
+
+
+bool batch_is_due(const batch_t *batch, uint32_t now_ms);
+
+
+#endif /* _BATCH_H_ */
@@ -12,240 +12,440 @@
 #include "bme.h"
 
 #include "esp_log.h"
+#include "esp_rom_sys.h"
 
+#include "agg.h"
+#include "boot.h"
+#include "clock.h"
 #include "i2c.h"
 #include "http.h"
+#include "perf.h"
+#include "report.h"
+#include "serve.h"
+#include "stats.h"
 
+#include <stdio.h>
 #include <string.h>
 
 
+static const bme_config_t bme_configs[] = BME_SENSORS;
+
+static bme_sensor_t bme_sensors[BME_MAX_SENSORS];
+static uint32_t bme_sensor_count;
+
+
 /**
- * @brief           Delays the system.
+ * @brief           Delays the system. Whole ticks are slept and the remainder is busy-waited, so that short delays are
+ *                  not lost to the tick rounding.
  *
  * @param period    The microseconds to delay the system for.
- * @param intf_ptr  The sensor address.
+ * @param intf_ptr  The sensor.
  */
 void bme_delay(uint32_t period, void *intf_ptr)
 {
-  vTaskDelay(period / 1000 / portTICK_PERIOD_MS);
+  uint32_t tick_us = portTICK_PERIOD_MS * 1000;
+
+  if (period >= tick_us) {
+    vTaskDelay(period / tick_us);
+  }
+
+  if (period % tick_us > 0) {
+    esp_rom_delay_us(period % tick_us);
+  }
 }
 
 
+#if BME_ACQ_MODE == BME_ACQ_MODE_FORCED
+/**
+ * @brief           Waits until the sensor is not measuring anymore, polling once per tick.
+ *
+ * @param bme       The sensor.
+ * @param deadline_us The time by which the measurement must have completed, in microseconds.
+ *
+ * @return        - BME280_OK
+ *                - BME280_FAIL
+ */
+static int8_t bme_wait_ready(struct bme280_dev *bme, uint32_t deadline_us)
+{
+  int8_t bme_err = BME280_OK;
+  uint8_t status = 0;
+
+  while (1) {
+    bme_err = bme280_get_regs(BME_STATUS_REG, &status, 1, bme);
+    if (bme_err != BME280_OK) {
+      return bme_err;
+    }
+
+    if ((status & BME_STATUS_MEASURING) == 0) {
+      return BME280_OK;
+    }
+
+    if ((int32_t)(perf_now_us() - deadline_us) >= 0) {
+      break;
+    }
+
+    vTaskDelay(1);
+  }
+
+  return BME280_FAIL;
+}
+#endif
+
+
 /**
  * @brief           Reads from the sensor via I2C.
  *
  * @param reg_addr  The register address.
  * @param reg_data  The data read from the sensor.
  * @param len       The number of bytes to read.
- * @param intf_ptr  The sensor address.
+ * @param intf_ptr  The sensor.
  *
  * @return        - BME280_OK
  *                - BME280_FAIL
  */
 int8_t bme_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr)
 {
-  esp_err_t esp_err = ESP_OK;
-
-  i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+  bme_sensor_t *sensor = intf_ptr;
 
-  esp_err = i2c_master_start(cmd);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(BME_TAG, "Read failed with error 0x%x", esp_err);
+  if (i2c_read_regs(sensor->port, sensor->addr, reg_addr, reg_data, len) != ESP_OK) {
     return BME280_FAIL;
   }
 
-  esp_err = i2c_master_write_byte(cmd, (*(uint8_t *)intf_ptr << 1) | I2C_MASTER_WRITE, 1);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(BME_TAG, "Read failed with error 0x%x", esp_err);
-    return BME280_FAIL;
-  }
+  return BME280_OK;
+}
+
+
+/**
+ * @brief           Writes to the sensor via I2C.
+ *
+ * @param reg_addr  The register address.
+ * @param reg_data  The data to be written.
+ * @param len       The number of bytes to write.
+ * @param intf_ptr  The sensor.
+ *
+ * @return        - BME280_OK
+ *                - BME280_FAIL
+ */
+int8_t bme_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr)
+{
+  bme_sensor_t *sensor = intf_ptr;
 
-  esp_err = i2c_master_write_byte(cmd, reg_addr, 1);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(BME_TAG, "Read failed with error 0x%x", esp_err);
+  if (i2c_write_regs(sensor->port, sensor->addr, reg_addr, reg_data, len) != ESP_OK) {
     return BME280_FAIL;
   }
 
-//  esp_err = i2c_master_stop(cmd);
-//  if (esp_err != ESP_OK) {
-//    ESP_LOGE(BME_TAG, "Read failed with error 0x%x", esp_err);
-//    return BME280_E_COMM_FAIL;
-//  }
+  return BME280_OK;
+}
 
-  esp_err = i2c_master_start(cmd);
-  if (esp_err != ESP_OK) {
-   ESP_LOGE(BME_TAG, "Read failed with error 0x%x", esp_err);
-   return BME280_FAIL;
-  }
 
-  esp_err = i2c_master_write_byte(cmd, (*(uint8_t *)intf_ptr << 1) | I2C_MASTER_READ, 1);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(BME_TAG, "Read failed with error 0x%x", esp_err);
-    return BME280_FAIL;
-  }
+/**
+ * @brief           Initializes and configures a sensor.
+ *
+ * @param sensor    The sensor, with its bus and address set.
+ * @param config    The sensor settings.
+ *
+ * @return        - BME280_OK
+ *                - BME280_FAIL
+ */
+static int8_t bme_setup(bme_sensor_t *sensor, const bme_config_t *config)
+{
+  int8_t bme_err = BME280_OK;
+  struct bme280_dev *bme = &sensor->dev;
 
-  if (len > 1) {
-    esp_err = i2c_master_read(cmd, reg_data, len-1, I2C_MASTER_ACK);
-    if (esp_err != ESP_OK) {
-      ESP_LOGE(BME_TAG, "Read failed with error 0x%x", esp_err);
-      return BME280_FAIL;
-    }
-  }
+  bme->intf = BME280_I2C_INTF;
+  bme->intf_ptr = sensor;
+  bme->read = bme_read;
+  bme->write = bme_write;
+  bme->delay_us = bme_delay;
 
-  esp_err = i2c_master_read_byte(cmd, reg_data+len-1, I2C_MASTER_NACK);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(BME_TAG, "Read failed with error 0x%x", esp_err);
-    return BME280_FAIL;
+  bme_err = bme280_init(bme);
+  if (bme_err != BME280_OK) {
+    ESP_LOGE(BME_TAG, "Initialization failed with code %d", bme_err);
+    return bme_err;
   }
 
-  esp_err = i2c_master_stop(cmd);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(BME_TAG, "Read failed with error 0x%x", esp_err);
-    return BME280_FAIL;
+  bme->settings.osr_h = config->osr_h;
+  bme->settings.osr_p = config->osr_p;
+  bme->settings.osr_t = config->osr_t;
+  bme->settings.filter = config->filter;
+  bme->settings.standby_time = BME_STANDBY_TIME;
+
+  uint8_t settings_sel = BME280_OSR_PRESS_SEL | BME280_OSR_TEMP_SEL | BME280_OSR_HUM_SEL | BME280_FILTER_SEL;
+#if BME_ACQ_MODE == BME_ACQ_MODE_NORMAL
+  settings_sel |= BME280_STANDBY_SEL;
+#endif
+
+  bme_err = bme280_set_sensor_settings(settings_sel, bme);
+  if (bme_err != BME280_OK) {
+    ESP_LOGE(BME_TAG, "Configuration failed with code %d", bme_err);
+    return bme_err;
   }
 
-  esp_err = i2c_master_cmd_begin(I2C_PORT, cmd, I2C_WAIT_MS / portTICK_PERIOD_MS);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(BME_TAG, "Read failed with error 0x%x", esp_err);
-    return BME280_FAIL;
+  sensor->meas_ms = bme280_cal_meas_delay(&bme->settings);
+
+#if BME_ACQ_MODE == BME_ACQ_MODE_NORMAL
+  bme_err = bme280_set_sensor_mode(BME280_NORMAL_MODE, bme);
+  if (bme_err != BME280_OK) {
+    ESP_LOGE(BME_TAG, "Mode setup failed with code %d", bme_err);
+    return bme_err;
   }
 
-  i2c_cmd_link_delete(cmd);
+  // Waits for the first measurement to complete.
+  bme_delay(sensor->meas_ms * 1000, sensor);
+#endif
 
   return BME280_OK;
 }
 
 
 /**
- * @brief           Writes to the sensor via I2C.
- *
- * @param reg_addr  The register address.
- * @param reg_data  The data to be written.
- * @param len       The number of bytes to write.
- * @param intf_ptr  The sensor address.
+ * @brief           Looks for sensors on both addresses of every bus and sets up the ones found.
  *
- * @return        - BME280_OK
- *                - BME280_FAIL
+ * @return          The number of sensors found.
  */
-int8_t bme_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr)
+uint32_t bme_init()
 {
-  esp_err_t esp_err = ESP_OK;
+  static const uint8_t addrs[] = { BME280_I2C_ADDR_PRIM, BME280_I2C_ADDR_SEC };
+  static const bme_config_t defaults = { 0, 0, NULL, BME_OSR_H, BME_OSR_P, BME_OSR_T, BME_FILTER };
 
-  i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+  bme_sensor_count = 0;
 
-  esp_err = i2c_master_start(cmd);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(BME_TAG, "Write failed with error 0x%x", esp_err);
-    return BME280_FAIL;
-  }
+  for (uint32_t i = 0; i < I2C_PORT_COUNT; i++) {
+    for (uint32_t j = 0; j < sizeof(addrs) && bme_sensor_count < BME_MAX_SENSORS; j++) {
+      i2c_port_t port = i2c_get_port(i);
 
-  esp_err = i2c_master_write_byte(cmd, (*(uint8_t *)intf_ptr << 1) | I2C_MASTER_WRITE, 1);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(BME_TAG, "Write failed with error 0x%x", esp_err);
-    return BME280_FAIL;
-  }
+      // Probes for the chip id, so that empty addresses are skipped without the driver's retries.
+      uint8_t chip_id = 0;
+      if (i2c_read_regs(port, addrs[j], BME280_CHIP_ID_ADDR, &chip_id, 1) != ESP_OK || chip_id != BME280_CHIP_ID) {
+        continue;
+      }
 
-  esp_err = i2c_master_write_byte(cmd, reg_addr, 1);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(BME_TAG, "Write failed with error 0x%x", esp_err);
-    return BME280_FAIL;
-  }
+      bme_sensor_t *sensor = &bme_sensors[bme_sensor_count];
+      sensor->port = port;
+      sensor->addr = addrs[j];
 
-  esp_err = i2c_master_write(cmd, reg_data, len, 1);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(BME_TAG, "Write failed with error 0x%x", esp_err);
-    return BME280_FAIL;
+      const bme_config_t *config = &defaults;
+      for (uint32_t k = 0; k < sizeof(bme_configs) / sizeof(bme_configs[0]); k++) {
+        if (bme_configs[k].port == port && bme_configs[k].addr == addrs[j]) {
+          config = &bme_configs[k];
+        }
+      }
+
+      if (config->location != NULL) {
+        snprintf(sensor->location, sizeof(sensor->location), "%s", config->location);
+      } else {
+        snprintf(sensor->location, sizeof(sensor->location), "i2c%d-%02x", port, addrs[j]);
+      }
+
+      if (bme_setup(sensor, config) == BME280_OK) {
+        ESP_LOGI(BME_TAG, "Sensor %u at %s", bme_sensor_count, sensor->location);
+        bme_sensor_count++;
+      }
+    }
   }
 
-  esp_err = i2c_master_stop(cmd);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(BME_TAG, "Write failed with error 0x%x", esp_err);
-    return BME280_FAIL;
+  if (bme_sensor_count == 0) {
+    ESP_LOGE(BME_TAG, "No sensor found");
   }
 
-  esp_err = i2c_master_cmd_begin(I2C_PORT, cmd, I2C_WAIT_MS / portTICK_PERIOD_MS);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(BME_TAG, "Write failed with error 0x%x", esp_err);
-    return BME280_FAIL;
+  return bme_sensor_count;
+}
+
+
+/**
+ * @brief           Gets the number of sensors found.
+ *
+ * @return          The number of sensors.
+ */
+uint32_t bme_count()
+{
+  return bme_sensor_count;
+}
+
+
+/**
+ * @brief           Gets the location tag of a sensor.
+ *
+ * @param sensor    The sensor index.
+ *
+ * @return          The location.
+ */
+const char *bme_location(uint8_t sensor)
+{
+  return sensor < bme_sensor_count ? bme_sensors[sensor].location : "unknown";
+}
+
+
+/**
+ * @brief           Gets the bus and address of a sensor, which unlike its index do not depend on the order the sensors
+ *                  were found in.
+ *
+ * @param sensor    The sensor index.
+ * @param port      The I2C port.
+ * @param addr      The I2C address.
+ *
+ * @return        - true if the sensor exists
+ *                - false otherwise
+ */
+bool bme_get_bus(uint8_t sensor, i2c_port_t *port, uint8_t *addr)
+{
+  if (sensor >= bme_sensor_count) {
+    return false;
   }
 
-  i2c_cmd_link_delete(cmd);
+  *port = bme_sensors[sensor].port;
+  *addr = bme_sensors[sensor].addr;
 
-  return BME280_OK;
+  return true;
 }
 
 
 /**
- * @brief           The BME sensor task function. Initializes the sensor and then polls it for data and sends it via HTTP.
+ * @brief           Finds the sensor on a bus and address.
+ *
+ * @param port      The I2C port.
+ * @param addr      The I2C address.
+ *
+ * @return          The sensor index, or BME_MAX_SENSORS if there is no sensor there.
  */
-void bme_task()
+uint8_t bme_find(i2c_port_t port, uint8_t addr)
 {
-  int8_t bme_err = BME280_OK;
-  struct bme280_data bme_data;
-
-  uint8_t bme_addr = BME280_I2C_ADDR_PRIM;
-  struct bme280_dev bme = {
-    .intf = BME280_I2C_INTF,
-    .intf_ptr = &bme_addr,
-    .read = bme_read,
-    .write = bme_write,
-    .delay_us = bme_delay
-  };
-
-  bme_err = bme280_init(&bme);
-  if (bme_err != BME280_OK) {
-    ESP_LOGE(BME_TAG, "Initialization failed with code %d", bme_err);
-    return;
+  for (uint32_t i = 0; i < bme_sensor_count; i++) {
+    if (bme_sensors[i].port == port && bme_sensors[i].addr == addr) {
+      return i;
+    }
   }
 
-  bme.settings.osr_h = BME280_OVERSAMPLING_1X;
-  bme.settings.osr_p = BME280_OVERSAMPLING_16X;
-  bme.settings.osr_t = BME280_OVERSAMPLING_2X;
-  bme.settings.filter = BME280_FILTER_COEFF_16;
+  return BME_MAX_SENSORS;
+}
 
-  uint8_t settings_sel = BME280_OSR_PRESS_SEL | BME280_OSR_TEMP_SEL | BME280_OSR_HUM_SEL | BME280_FILTER_SEL;
 
-  bme_err = bme280_set_sensor_settings(settings_sel, &bme);
-  if (bme_err != BME280_OK) {
-    ESP_LOGE(BME_TAG, "Configuration failed with code %d", bme_err);
-    return;
+/**
+ * @brief           Takes one measurement from every sensor and stamps them alike.
+ *
+ * @remarks         In forced mode all the sensors are triggered first and measure in parallel, so that a round takes
+ *                  the longest measurement time plus one read per sensor, instead of the sum of the measurement times.
+ *
+ * @param samples   The samples, room for BME_MAX_SENSORS.
+ *
+ * @return          The number of samples taken.
+ */
+uint32_t bme_measure(sample_t *samples)
+{
+  int8_t bme_err = BME280_OK;
+  bool triggered[BME_MAX_SENSORS] = { false };
+  uint32_t count = 0;
+  uint32_t start_us = perf_now_us();
+
+#if BME_ACQ_MODE == BME_ACQ_MODE_FORCED
+  uint32_t meas_ms = 0;
+  for (uint32_t i = 0; i < bme_sensor_count; i++) {
+    bme_err = bme280_set_sensor_mode(BME280_FORCED_MODE, &bme_sensors[i].dev);
+    if (bme_err != BME280_OK) {
+      ESP_LOGE(BME_TAG, "Mode setup of sensor %u failed with code %d", i, bme_err);
+      continue;
+    }
+
+    triggered[i] = true;
+    if (bme_sensors[i].meas_ms > meas_ms) {
+      meas_ms = bme_sensors[i].meas_ms;
+    }
+  }
+
+  // Sleeps for the typical measurement time, about 7/8 of the maximum, and then polls the status for the rest. The
+  // sleep may end up to a tick early, so the polls go on until a tick past the maximum.
+  uint32_t deadline_us = perf_now_us() + meas_ms * 1000 + portTICK_PERIOD_MS * 1000;
+  bme_delay(meas_ms * 1000 * 7 / 8, NULL);
+#else
+  for (uint32_t i = 0; i < bme_sensor_count; i++) {
+    triggered[i] = true;
   }
+#endif
 
-  // Discards the first measurement.
-  bme280_set_sensor_mode(BME280_FORCED_MODE, &bme);
-  bme.delay_us(40000, bme.intf_ptr);
-  bme280_get_sensor_data(BME280_ALL, &bme_data, &bme);
-  bme.delay_us(BME_SAMPLING_PERIOD_MS * 1000, bme.intf_ptr);
+  int64_t timestamp = clock_now_ms();
 
-  while (1) {
-    bme_err = bme280_set_sensor_mode(BME280_FORCED_MODE, &bme);
+  for (uint32_t i = 0; i < bme_sensor_count; i++) {
+    if (!triggered[i]) {
+      continue;
+    }
+
+#if BME_ACQ_MODE == BME_ACQ_MODE_FORCED
+    bme_err = bme_wait_ready(&bme_sensors[i].dev, deadline_us);
     if (bme_err != BME280_OK) {
-      ESP_LOGE(BME_TAG, "Mode setup failed with code %d", bme_err);
-      break;
+      ESP_LOGE(BME_TAG, "Measurement of sensor %u did not complete", i);
+      continue;
     }
+#endif
 
-    // Waits for measurement to complete and gets data.
-    bme.delay_us(40000, bme.intf_ptr);
-    bme_err = bme280_get_sensor_data(BME280_ALL, &bme_data, &bme);
+    // In normal mode the data registers are shadowed during a measurement, so the latest result can be read any time.
+    struct bme280_data bme_data;
+    bme_err = bme280_get_sensor_data(BME280_ALL, &bme_data, &bme_sensors[i].dev);
     if (bme_err != BME280_OK) {
-      ESP_LOGE(BME_TAG, "Data acquisition failed");
-      break;
+      ESP_LOGE(BME_TAG, "Data acquisition of sensor %u failed", i);
+      continue;
     }
 
-    char data[HTTP_FIELD_SIZE];
-    sprintf(data, "sensor,location=home temperature=%0.2lf,pressure=%0.2lf,humidity=%0.2lf", bme_data.temperature,  0.01 * bme_data.pressure, bme_data.humidity);
-    int i = 0;
-    for (i=0; i< BME_HTTP_SEND_RETRIES; i++) {
-      http_data_en err = http_send(data, strlen(data));
-      if (err == HTTP_DATA_OK) {
-        break;
-      } else {
-        bme.delay_us(BME_HTTP_SEND_RETRY_WAIT_MS * 1000, bme.intf_ptr);
-      }
+    // The driver compensates in 32-bit integers: 0.01 degC, Pa and 1/1024 %RH.
+    sample_t *sample = &samples[count++];
+    sample->temperature = bme_data.temperature;
+    sample->pressure = bme_data.pressure;
+    sample->humidity = (bme_data.humidity * 1000 + 512) / 1024;
+    sample->timestamp = timestamp;
+    sample->sensor = i;
+
+    ESP_LOGD(BME_TAG, "%s: %d cdeg C, %u Pa, %u m%%", bme_sensors[i].location, sample->temperature, sample->pressure, sample->humidity);
+  }
+
+  uint32_t acquired_us = perf_now_us();
+  for (uint32_t i = 0; i < count; i++) {
+    samples[i].acquired_us = acquired_us;
+  }
+
+  if (count > 0) {
+    perf_record(PERF_STAGE_ACQUIRE, acquired_us - start_us);
+  }
+
+  return count;
+}
+
+
+/**
+ * @brief           The sampling job. Takes a round from every sensor, keeps it in the raw history and sends the
+ *                  samples that pass the report filter via HTTP. Scheduled every BME_SAMPLING_PERIOD_MS.
+ */
+void bme_sample()
+{
+  sample_t samples[BME_MAX_SENSORS];
+
+  uint32_t count = bme_measure(samples);
+
+#if BME_ACQ_MODE == BME_ACQ_MODE_NORMAL
+  // Discards the first measurement, which the sensors may not have completed yet in normal mode. A forced measurement
+  // is waited for, so it is good from the start.
+  static bool primed;
+  if (!primed) {
+    primed = true;
+    return;
+  }
+#endif
+
+  if (count > 0) {
+    boot_ready(BOOT_STAGE_SAMPLE);
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    agg_keep(&samples[i]);
+
+    if (!SERVE_PUSH || !report_filter(&samples[i])) {
+      continue;
     }
 
-    printf("%0.2lf deg C, %0.2lf hPa, %0.2lf%%\n", bme_data.temperature,  0.01 * bme_data.pressure, bme_data.humidity);
+    if (http_send(&samples[i]) != HTTP_DATA_OK) {
+      ESP_LOGW(BME_TAG, "HTTP queue full, sample dropped");
+      stats_inc(STATS_SAMPLES_DROPPED);
+      continue;
+    }
 
-    bme.delay_us((BME_SAMPLING_PERIOD_MS - i*BME_HTTP_SEND_RETRY_WAIT_MS) * 1000, bme.intf_ptr);
+    report_commit(&samples[i]);
   }
 }
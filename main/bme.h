@@ -14,22 +14,70 @@
 
 
 #include "bme280.h"
+#include "i2c.h"
+#include "sample.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 
 
 #define BME_TAG                       " BME"
 
 #define BME280_FAIL                   (-7)
-#define BME280_FLOAT_ENABLE
 
+// The host build samples faster, see test/CMakeLists.txt.
+#ifndef BME_SAMPLING_PERIOD_MS
 #define BME_SAMPLING_PERIOD_MS        (10000)
-#define BME_HTTP_SEND_RETRIES         (5)
-#define BME_HTTP_SEND_RETRY_WAIT_MS   (100)
+#endif
 
-#define BME_TASK_NAME                "bme"
-#define BME_TASK_PRIORITY            (tskIDLE_PRIORITY + 1)
-#define BME_TASK_STACK_SIZE          (2048)
+// The acquisition modes. In forced mode the sensor is triggered once per sample and read as soon as it reports that
+// the measurement is done. In normal mode the sensor measures on its own standby timer, feeding its IIR filter with
+// every measurement, and the latest result is read once per sample.
+#define BME_ACQ_MODE_FORCED           (0)
+#define BME_ACQ_MODE_NORMAL           (1)
+#define BME_ACQ_MODE                  (BME_ACQ_MODE_FORCED)
+
+#define BME_OSR_H                     (BME280_OVERSAMPLING_1X)
+#define BME_OSR_P                     (BME280_OVERSAMPLING_16X)
+#define BME_OSR_T                     (BME280_OVERSAMPLING_2X)
+#define BME_FILTER                    (BME280_FILTER_COEFF_16)
+#define BME_STANDBY_TIME              (BME280_STANDBY_TIME_1000_MS)
+
+#define BME_STATUS_REG                (0xF3)
+#define BME_STATUS_MEASURING          (0x08)
+
+#define BME_MAX_SENSORS               (4)
+#define BME_LOCATION_SIZE             (16)
+
+// The sensors with their own location and settings, as { port, address, location, osr_h, osr_p, osr_t, filter }.
+// Sensors that are found but not listed get the default settings and are located by their bus and address.
+#define BME_SENSORS                   { \
+  { I2C_PORT, BME280_I2C_ADDR_PRIM, "home", BME_OSR_H, BME_OSR_P, BME_OSR_T, BME_FILTER } \
+}
+
+/**
+ * @brief   The configuration of a known sensor.
+ */
+typedef struct {
+  i2c_port_t port;
+  uint8_t addr;
+  const char *location;
+  uint8_t osr_h;
+  uint8_t osr_p;
+  uint8_t osr_t;
+  uint8_t filter;
+} bme_config_t;
+
+/**
+ * @brief   A sensor found on one of the buses. The driver's interface pointer points back to it.
+ */
+typedef struct {
+  struct bme280_dev dev;
+  i2c_port_t port;
+  uint8_t addr;
+  uint32_t meas_ms;
+  char location[BME_LOCATION_SIZE];
+} bme_sensor_t;
 
 
 void bme_delay(uint32_t period, void *intf_ptr);
@@ -41,7 +89,25 @@ int8_t bme_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_pt
 int8_t bme_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr);
 
 
-void bme_task();
+uint32_t bme_init();
+
+
+uint32_t bme_count();
+
+
+const char *bme_location(uint8_t sensor);
+
+
+bool bme_get_bus(uint8_t sensor, i2c_port_t *port, uint8_t *addr);
+
+
+uint8_t bme_find(i2c_port_t port, uint8_t addr);
+
+
+uint32_t bme_measure(sample_t *samples);
+
+
+void bme_sample();
 
 
 #endif /* _BME_H_ */
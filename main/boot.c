@@ -0,0 +1,110 @@
+/**
+ * @file    boot.c
+ *
+ * @brief   Boot Source File
+ *
+ * @remarks The modules come up in their own tasks at the same time, and the dependencies between them are bits of one
+ *          event group. The time each stage was reached is kept, and the timeline is logged once the first point is
+ *          accepted.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "boot.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/event_groups.h"
+
+#include <stdatomic.h>
+
+
+static const char *boot_stage_names[BOOT_STAGE_MAX] = {
+  "nvs", "net", "sensor", "tls", "ip", "sync", "sample", "upload"
+};
+
+static StaticEventGroup_t boot_event_group_buffer;
+static EventGroupHandle_t boot_event_group;
+static atomic_uint boot_stage_times_ms[BOOT_STAGE_MAX];
+
+
+/**
+ * @brief           Creates the event group. Must be called first thing in app_main.
+ */
+void boot_init()
+{
+  boot_event_group = xEventGroupCreateStatic(&boot_event_group_buffer);
+}
+
+
+/**
+ * @brief           Marks a stage as reached. Only the first time counts.
+ *
+ * @param stage     The stage.
+ */
+void boot_ready(boot_stage_en stage)
+{
+  unsigned int unset = 0;
+  uint32_t now_ms = esp_timer_get_time() / 1000;
+
+  // A stage reached in the first millisecond is still marked as 1, as 0 means not reached.
+  if (!atomic_compare_exchange_strong_explicit(&boot_stage_times_ms[stage], &unset, now_ms > 0 ? now_ms : 1,
+                                               memory_order_relaxed, memory_order_relaxed)) {
+    return;
+  }
+
+  xEventGroupSetBits(boot_event_group, 1 << stage);
+
+  if (stage == BOOT_STAGE_UPLOAD) {
+    for (uint32_t i = 0; i < BOOT_STAGE_MAX; i++) {
+      ESP_LOGI(BOOT_TAG, "stage=%s ready_ms=%u", boot_stage_names[i], boot_stage_ms(i));
+    }
+  }
+}
+
+
+/**
+ * @brief           Checks if a stage was reached.
+ *
+ * @param stage     The stage.
+ *
+ * @return        - true if the stage was reached
+ *                - false otherwise
+ */
+bool boot_is_ready(boot_stage_en stage)
+{
+  return boot_stage_ms(stage) > 0;
+}
+
+
+/**
+ * @brief           Waits until a stage is reached.
+ *
+ * @param stage     The stage.
+ * @param ticks     The time to wait in ticks.
+ *
+ * @return        - true if the stage was reached
+ *                - false on timeout
+ */
+bool boot_wait(boot_stage_en stage, TickType_t ticks)
+{
+  EventBits_t bits = xEventGroupWaitBits(boot_event_group, 1 << stage, pdFALSE, pdTRUE, ticks);
+
+  return (bits & (1 << stage)) != 0;
+}
+
+
+/**
+ * @brief           Gets the time a stage was reached.
+ *
+ * @param stage     The stage.
+ *
+ * @return          The milliseconds since boot, or 0 if the stage was not reached yet.
+ */
+uint32_t boot_stage_ms(boot_stage_en stage)
+{
+  return atomic_load_explicit(&boot_stage_times_ms[stage], memory_order_relaxed);
+}
@@ -0,0 +1,56 @@
+/**
+ * @file    boot.h
+ *
+ * @brief   Boot Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _BOOT_H_
+#define _BOOT_H_
+
+
+#include "freertos/FreeRTOS.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#define BOOT_TAG                      "BOOT"
+
+/**
+ * @brief   The stages of the boot. Each is marked once by the module that reaches it, and the modules that depend on it
+ *          wait for it.
+ */
+typedef enum {
+  BOOT_STAGE_NVS,                     // the NVS is initialized
+  BOOT_STAGE_NET,                     // the TCP/IP stack and the default event loop are up
+  BOOT_STAGE_SENSOR,                  // the sensors are found and configured
+  BOOT_STAGE_TLS,                     // the CA certificates are parsed
+  BOOT_STAGE_IP,                      // the station got its first IP
+  BOOT_STAGE_SYNC,                    // the clock is synchronized
+  BOOT_STAGE_SAMPLE,                  // the first sample is taken
+  BOOT_STAGE_UPLOAD,                  // the server accepted the first point
+  BOOT_STAGE_MAX
+} boot_stage_en;
+
+
+void boot_init();
+
+
+void boot_ready(boot_stage_en stage);
+
+
+bool boot_is_ready(boot_stage_en stage);
+
+
+bool boot_wait(boot_stage_en stage, TickType_t ticks);
+
+
+uint32_t boot_stage_ms(boot_stage_en stage);
+
+
+#endif /* _BOOT_H_ */
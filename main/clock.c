@@ -0,0 +1,137 @@
+/**
+ * @file    clock.c
+ *
+ * @brief   Clock Source File
+ *
+ * @remarks Samples are stamped when they are acquired. Before the first SNTP synchronization the stamps count from
+ *          boot, and they are rebased to the epoch once the time is known, so that queueing and retries never skew the
+ *          time series.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "clock.h"
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_sntp.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "boot.h"
+
+#include <stdatomic.h>
+#include <sys/time.h>
+
+
+// The system time survives deep sleep, and so does the knowledge that it is the epoch.
+static RTC_DATA_ATTR atomic_bool clock_synced;
+static atomic_bool clock_synced_now;
+
+
+/**
+ * @brief           Called by SNTP whenever the system time is set.
+ *
+ * @param tv        The new time.
+ */
+static void clock_sync_cb(struct timeval *tv)
+{
+  atomic_store(&clock_synced_now, true);
+  boot_ready(BOOT_STAGE_SYNC);
+  if (!atomic_exchange(&clock_synced, true)) {
+    ESP_LOGI(CLOCK_TAG, "Time synchronized");
+  }
+}
+
+
+/**
+ * @brief           Starts the SNTP client. Must be called after the TCP/IP stack is initialized.
+ */
+void clock_init()
+{
+  sntp_setoperatingmode(SNTP_OPMODE_POLL);
+  sntp_setservername(0, CLOCK_NTP_SERVER);
+  sntp_set_time_sync_notification_cb(clock_sync_cb);
+  sntp_init();
+}
+
+
+/**
+ * @brief           Checks if the system time has been synchronized.
+ *
+ * @return        - true if synchronized
+ *                - false otherwise
+ */
+bool clock_is_synced()
+{
+  return atomic_load(&clock_synced);
+}
+
+
+/**
+ * @brief           Waits until the time is synchronized during the current boot.
+ *
+ * @param timeout_ms  The maximum milliseconds to wait.
+ *
+ * @return        - true if synchronized
+ *                - false on timeout
+ */
+bool clock_wait_sync(uint32_t timeout_ms)
+{
+  for (uint32_t waited_ms = 0; !atomic_load(&clock_synced_now); waited_ms += CLOCK_POLL_PERIOD_MS) {
+    if (waited_ms >= timeout_ms) {
+      return false;
+    }
+    vTaskDelay(CLOCK_POLL_PERIOD_MS / portTICK_PERIOD_MS);
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief           Gets the current time.
+ *
+ * @return          The milliseconds since the epoch once synchronized, or the milliseconds since boot before that.
+ */
+int64_t clock_now_ms()
+{
+  if (!clock_is_synced()) {
+    return esp_timer_get_time() / 1000;
+  }
+
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+
+  return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+
+/**
+ * @brief               Converts a timestamp taken before the synchronization to the epoch.
+ *
+ * @remarks             Only stamps taken since the current boot can be rebased. CLOCK_UNKNOWN is never rebased.
+ *
+ * @param timestamp_ms  The timestamp to be rebased.
+ *
+ * @return            - true if the timestamp is relative to the epoch
+ *                    - false if it is still relative to boot
+ */
+bool clock_rebase(int64_t *timestamp_ms)
+{
+  if (*timestamp_ms >= CLOCK_EPOCH_MIN_MS) {
+    return true;
+  }
+
+  if (*timestamp_ms == CLOCK_UNKNOWN || !clock_is_synced()) {
+    return false;
+  }
+
+  *timestamp_ms += clock_now_ms() - esp_timer_get_time() / 1000;
+
+  return true;
+}
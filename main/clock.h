@@ -0,0 +1,45 @@
+/**
+ * @file    clock.h
+ *
+ * @brief   Clock Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#define CLOCK_TAG                     "SNTP"
+
+#define CLOCK_NTP_SERVER              "pool.ntp.org"
+#define CLOCK_POLL_PERIOD_MS          (100)
+
+// Timestamps below this value (2020-01-01) count milliseconds since boot instead of since the epoch.
+#define CLOCK_EPOCH_MIN_MS            (1577836800000LL)
+#define CLOCK_UNKNOWN                 (0)
+
+
+void clock_init();
+
+
+bool clock_is_synced();
+
+
+bool clock_wait_sync(uint32_t timeout_ms);
+
+
+int64_t clock_now_ms();
+
+
+bool clock_rebase(int64_t *timestamp_ms);
+
+
+#endif /* _CLOCK_H_ */
@@ -0,0 +1,260 @@
+/**
+ * @file    gzip.c
+ *
+ * @brief   GZIP Source File
+ *
+ * @remarks A small deflate compressor for request bodies. It finds repeated strings through a hash chain over a
+ *          GZIP_WINDOW_SIZE window and codes them with the fixed Huffman tables, so its whole working memory is a few
+ *          static kilobytes. Line protocol repeats the measurement, tags and field keys on every line, which is where
+ *          nearly all of the gain comes from.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "gzip.h"
+
+#include "esp_rom_crc.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+
+#define GZIP_HASH_SIZE                (1 << GZIP_HASH_BITS)
+#define GZIP_MIN_MATCH                (3)
+#define GZIP_MAX_MATCH                (258)
+#define GZIP_NO_POS                   (0xFFFF)
+
+typedef struct {
+  uint8_t *out;
+  uint32_t size;
+  uint32_t len;
+  uint32_t bits;
+  uint32_t bit_count;
+  bool overflow;
+} gzip_writer_t;
+
+static const uint16_t gzip_length_base[] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t gzip_length_extra[] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t gzip_dist_base[] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+  8193, 12289, 16385, 24577
+};
+static const uint8_t gzip_dist_extra[] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// The most recent position of each hash and the previous position with the same hash, within the window.
+static uint16_t gzip_head[GZIP_HASH_SIZE];
+static uint16_t gzip_prev[GZIP_WINDOW_SIZE];
+
+
+/**
+ * @brief           Appends bits, least significant first.
+ */
+static void gzip_put_bits(gzip_writer_t *w, uint32_t value, uint32_t count)
+{
+  w->bits |= value << w->bit_count;
+  w->bit_count += count;
+
+  while (w->bit_count >= 8) {
+    if (w->len < w->size) {
+      w->out[w->len++] = w->bits & 0xFF;
+    } else {
+      w->overflow = true;
+    }
+    w->bits >>= 8;
+    w->bit_count -= 8;
+  }
+}
+
+
+/**
+ * @brief           Appends a Huffman code. Codes are stored most significant bit first, so they are reversed.
+ */
+static void gzip_put_code(gzip_writer_t *w, uint32_t code, uint32_t length)
+{
+  uint32_t reversed = 0;
+
+  for (uint32_t i = 0; i < length; i++) {
+    reversed = (reversed << 1) | ((code >> i) & 1);
+  }
+
+  gzip_put_bits(w, reversed, length);
+}
+
+
+/**
+ * @brief           Appends a literal or length symbol with the fixed Huffman table.
+ */
+static void gzip_put_symbol(gzip_writer_t *w, uint32_t symbol)
+{
+  if (symbol < 144) {
+    gzip_put_code(w, 0x30 + symbol, 8);
+  } else if (symbol < 256) {
+    gzip_put_code(w, 0x190 + symbol - 144, 9);
+  } else if (symbol < 280) {
+    gzip_put_code(w, symbol - 256, 7);
+  } else {
+    gzip_put_code(w, 0xC0 + symbol - 280, 8);
+  }
+}
+
+
+/**
+ * @brief           Appends a match as a length and a distance code.
+ */
+static void gzip_put_match(gzip_writer_t *w, uint32_t length, uint32_t dist)
+{
+  uint32_t i = sizeof(gzip_length_base) / sizeof(gzip_length_base[0]) - 1;
+  while (gzip_length_base[i] > length) {
+    i--;
+  }
+  gzip_put_symbol(w, 257 + i);
+  gzip_put_bits(w, length - gzip_length_base[i], gzip_length_extra[i]);
+
+  uint32_t j = sizeof(gzip_dist_base) / sizeof(gzip_dist_base[0]) - 1;
+  while (gzip_dist_base[j] > dist) {
+    j--;
+  }
+  gzip_put_code(w, j, 5);
+  gzip_put_bits(w, dist - gzip_dist_base[j], gzip_dist_extra[j]);
+}
+
+
+/**
+ * @brief           Appends bytes after the bit stream has been flushed to a byte boundary.
+ */
+static void gzip_put_bytes(gzip_writer_t *w, const uint8_t *bytes, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++) {
+    gzip_put_bits(w, bytes[i], 8);
+  }
+}
+
+
+/**
+ * @brief           Hashes the three bytes starting at a position.
+ */
+static uint32_t gzip_hash(const uint8_t *p)
+{
+  return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & (GZIP_HASH_SIZE - 1);
+}
+
+
+/**
+ * @brief           Links a position into the hash chains.
+ */
+static void gzip_insert(const uint8_t *in, uint32_t pos)
+{
+  uint32_t hash = gzip_hash(in + pos);
+
+  gzip_prev[pos % GZIP_WINDOW_SIZE] = gzip_head[hash];
+  gzip_head[hash] = pos;
+}
+
+
+/**
+ * @brief               Compresses a buffer into the gzip format.
+ *
+ * @remarks             Uses static working memory, so it must only be called from one task. The input has to be
+ *                      shorter than 64 KB.
+ *
+ * @param in            The data to be compressed.
+ * @param in_len        The data length.
+ * @param out           The compressed data.
+ * @param out_size      The size of the compressed data buffer.
+ *
+ * @return              The compressed length, or 0 if it does not fit into the buffer.
+ */
+uint32_t gzip_compress(const uint8_t *in, uint32_t in_len, uint8_t *out, uint32_t out_size)
+{
+  static const uint8_t header[] = { 0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF };
+
+  if (in_len >= GZIP_NO_POS) {
+    return 0;
+  }
+
+  gzip_writer_t w = {
+    .out = out,
+    .size = out_size
+  };
+
+  memset(gzip_head, 0xFF, sizeof(gzip_head));
+
+  gzip_put_bytes(&w, header, sizeof(header));
+
+  // A single final block with the fixed Huffman codes.
+  gzip_put_bits(&w, 1, 1);
+  gzip_put_bits(&w, 1, 2);
+
+  uint32_t pos = 0;
+  while (pos < in_len && !w.overflow) {
+    uint32_t best_len = 0;
+    uint32_t best_dist = 0;
+
+    if (pos + GZIP_MIN_MATCH <= in_len) {
+      uint32_t max_len = in_len - pos < GZIP_MAX_MATCH ? in_len - pos : GZIP_MAX_MATCH;
+      uint32_t candidate = gzip_head[gzip_hash(in + pos)];
+
+      for (int chain = 0; chain < GZIP_MAX_CHAIN && candidate != GZIP_NO_POS; chain++) {
+        uint32_t dist = pos - candidate;
+        if (dist == 0 || dist >= GZIP_WINDOW_SIZE) {
+          break;
+        }
+
+        uint32_t len = 0;
+        while (len < max_len && in[candidate + len] == in[pos + len]) {
+          len++;
+        }
+        if (len > best_len) {
+          best_len = len;
+          best_dist = dist;
+          if (len == max_len) {
+            break;
+          }
+        }
+
+        uint32_t prev = gzip_prev[candidate % GZIP_WINDOW_SIZE];
+        if (prev == GZIP_NO_POS || prev >= candidate) {
+          break;
+        }
+        candidate = prev;
+      }
+    }
+
+    if (best_len >= GZIP_MIN_MATCH) {
+      gzip_put_match(&w, best_len, best_dist);
+      for (uint32_t end = pos + best_len; pos < end; pos++) {
+        if (pos + GZIP_MIN_MATCH <= in_len) {
+          gzip_insert(in, pos);
+        }
+      }
+    } else {
+      if (pos + GZIP_MIN_MATCH <= in_len) {
+        gzip_insert(in, pos);
+      }
+      gzip_put_symbol(&w, in[pos]);
+      pos++;
+    }
+  }
+
+  // End of block, padded to a byte boundary.
+  gzip_put_symbol(&w, 256);
+  gzip_put_bits(&w, 0, (8 - w.bit_count) % 8);
+
+  uint32_t crc = esp_rom_crc32_le(0, in, in_len);
+  uint8_t trailer[] = {
+    crc & 0xFF, (crc >> 8) & 0xFF, (crc >> 16) & 0xFF, (crc >> 24) & 0xFF,
+    in_len & 0xFF, (in_len >> 8) & 0xFF, (in_len >> 16) & 0xFF, (in_len >> 24) & 0xFF
+  };
+  gzip_put_bytes(&w, trailer, sizeof(trailer));
+
+  return w.overflow ? 0 : w.len;
+}
@@ -0,0 +1,27 @@
+/**
+ * @file    gzip.h
+ *
+ * @brief   GZIP Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _GZIP_H_
+#define _GZIP_H_
+
+
+#include <stdint.h>
+
+
+#define GZIP_HASH_BITS                (10)
+#define GZIP_WINDOW_SIZE              (2048)
+#define GZIP_MAX_CHAIN                (8)
+
+
+uint32_t gzip_compress(const uint8_t *in, uint32_t in_len, uint8_t *out, uint32_t out_size);
+
+
+#endif /* _GZIP_H_ */
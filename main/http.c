@@ -11,167 +11,990 @@
 
 #include "http.h"
 
-#include "esp_http_client.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
 #include "esp_tls.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
+#include "agg.h"
+#include "batch.h"
+#include "bme.h"
+#include "boot.h"
+#include "clock.h"
+#include "gzip.h"
+#include "lp.h"
+#include "mqtt.h"
+#include "perf.h"
+#include "resp.h"
+#include "ring.h"
+#include "stats.h"
+#include "store.h"
+#include "tls.h"
+#include "udp.h"
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
 #include <string.h>
 
 
 extern const uint8_t influxdb_pem_start[] asm("_binary_influxdb_pem_start");
 extern const uint8_t influxdb_pem_end[]   asm("_binary_influxdb_pem_end");
 
-static http_data_en http_data_flag = HTTP_DATA_OK;
+// Samples handed over from the sensor task. The sensor task is the only producer and http_task the only consumer.
+_Static_assert(HTTP_QUEUE_MIN_LENGTH <= HTTP_QUEUE_LENGTH, "The sampling is too fast for the HTTP queue");
+_Static_assert(BME_SAMPLING_PERIOD_MS >= 2 * HTTP_PRECISION_MS, "The timestamps are too coarse for the sampling");
+
+static sample_t http_queue_storage[HTTP_QUEUE_LENGTH];
+static ring_t http_queue = RING_INIT(http_queue_storage, HTTP_QUEUE_LENGTH);
+static TaskHandle_t http_consumer;
+static _Atomic TaskHandle_t http_flusher;
+static atomic_bool http_kicked;
+static bool http_flushing;
+
+static batch_t http_batch;
+// The samples of the batch, kept to be stored if the post fails. The batch may hold other points too.
+static sample_t http_batch_samples[BATCH_MAX_POINTS];
+static uint32_t http_batch_popped_us[BATCH_MAX_POINTS];
+static uint32_t http_batch_sample_count;
+static uint32_t http_stats_ms;
+static sample_t http_backlog[HTTP_BACKLOG_POINTS];
+
+#if AGG_ACTIVE
+static agg_t http_aggs[BME_MAX_SENSORS];
+#endif
+
+#if HTTP_GZIP && HTTP_TRANSPORT == HTTP_TRANSPORT_HTTPS
+static uint8_t http_gzip_buffer[BATCH_BUFFER_SIZE];
+#endif
 
-static char field[HTTP_FIELD_SIZE];
-static uint32_t field_len;
+static bool http_offline;
+static uint32_t http_offline_ms;
+static bool http_store_failed;
+
+static http_stats_t http_stats;
+// The most samples the queue held, written by the producer only.
+static uint32_t http_queue_max;
+
+#if HTTP_TRANSPORT == HTTP_TRANSPORT_HTTPS
+static esp_tls_t *http_tls;
+static resp_t http_resp;
+static char http_header[HTTP_HEADER_SIZE];
+static char http_read_buffer[HTTP_READ_SIZE];
 
 
 /**
- * @brief     Handles HTTP client events.
+ * @brief           Checks the status of an answered post against the parsed response body.
  *
- * @param evt The event to be handled.
+ * @param status    The status code.
  *
- * @return  - ESP_OK
- *          - ESP_FAIL
+ * @return        - ESP_OK
+ *                - ESP_FAIL if the points are to be sent again later
+ *                - ESP_ERR_INVALID_RESPONSE if the server refused the points for good
  */
-esp_err_t http_event_handler(esp_http_client_event_t *evt)
+static esp_err_t http_check_status(int status)
 {
-  static char *output_buffer;  // Buffer to store response of http request from event handler
-  static int output_len;       // Stores number of bytes read
-  switch (evt->event_id) {
-    case HTTP_EVENT_ERROR:
-        ESP_LOGD(HTTP_TAG, "HTTP_EVENT_ERROR");
-        break;
-    case HTTP_EVENT_ON_CONNECTED:
-        ESP_LOGD(HTTP_TAG, "HTTP_EVENT_ON_CONNECTED");
-        break;
-    case HTTP_EVENT_HEADER_SENT:
-        ESP_LOGD(HTTP_TAG, "HTTP_EVENT_HEADERS_SENT");
-        break;
-    case HTTP_EVENT_ON_HEADER:
-        ESP_LOGD(HTTP_TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
+  switch (resp_classify(status)) {
+    case RESP_RESULT_SUCCESS:
+      return ESP_OK;
+    case RESP_RESULT_DROP:
+      ESP_LOGE(HTTP_TAG, "Server refused the points with status %d: %s", status, resp_message(&http_resp));
+      return ESP_ERR_INVALID_RESPONSE;
+    default:
+      ESP_LOGW(HTTP_TAG, "Server failed with status %d: %s", status, resp_message(&http_resp));
+      return ESP_FAIL;
+  }
+}
+
+
+/**
+ * @brief           Closes the connection to the InfluxDB, if there is one.
+ */
+static void http_close()
+{
+  if (http_tls != NULL) {
+    tls_close(http_tls);
+    http_tls = NULL;
+  }
+}
+
+
+/**
+ * @brief           Writes all of a buffer to the connection.
+ *
+ * @param data      The buffer.
+ * @param len       The buffer length.
+ * @param end_us    The time to give up at, in microseconds.
+ *
+ * @return        - true if it was written
+ *                - false if the connection failed or timed out
+ */
+static bool http_write(const char *data, uint32_t len, int64_t end_us)
+{
+  uint32_t written = 0;
+  while (written < len) {
+    ssize_t ret = esp_tls_conn_write(http_tls, data + written, len - written);
+    if (ret > 0) {
+      written += ret;
+    } else if ((ret != ESP_TLS_ERR_SSL_WANT_READ && ret != ESP_TLS_ERR_SSL_WANT_WRITE) || esp_timer_get_time() >= end_us) {
+      ESP_LOGD(HTTP_TAG, "Write failed with error -0x%x", -(int)ret);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief           Reads the response to a request off the connection and parses it as it arrives, so that it never
+ *                  has to be held whole.
+ *
+ * @param end_us    The time to give up at, in microseconds.
+ *
+ * @return        - true if the whole response was read
+ *                - false if the connection failed or timed out first
+ */
+static bool http_read(int64_t end_us)
+{
+  while (!resp_is_done(&http_resp)) {
+    ssize_t ret = esp_tls_conn_read(http_tls, http_read_buffer, sizeof(http_read_buffer));
+    if (ret > 0) {
+      resp_read(&http_resp, http_read_buffer, ret);
+    } else if (ret == 0) {
+      // A body without a length ends with the connection.
+      return resp_end(&http_resp);
+    } else if ((ret != ESP_TLS_ERR_SSL_WANT_READ && ret != ESP_TLS_ERR_SSL_WANT_WRITE) || esp_timer_get_time() >= end_us) {
+      ESP_LOGD(HTTP_TAG, "Read failed with error -0x%x", -(int)ret);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief           Posts a body to the InfluxDB over the long-lived connection.
+ *
+ * @remarks         The connection is kept open between posts and is only re-established when the server or the WIFI
+ *                  dropped it, resuming the TLS session of the last one, see tls.c. A failed post on a reused
+ *                  connection is repeated once over a fresh one, since the server may have closed it while idle.
+ *
+ * @param data      The POST body.
+ * @param data_len  The POST body length.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL if the points are to be sent again later
+ *                - ESP_ERR_INVALID_RESPONSE if the server refused the points for good
+ */
+static esp_err_t http_post(const char *data, uint32_t data_len)
+{
+  esp_err_t esp_err = ESP_OK;
+  const char *body = data;
+  uint32_t body_len = data_len;
+  const char *encoding = "";
+  bool answered = false;
+
+#if HTTP_GZIP
+  // Small bodies gain too little to be worth the CPU time, and a body that does not shrink is sent as is.
+  uint32_t gzip_len = 0;
+  if (data_len >= HTTP_GZIP_MIN_SIZE) {
+    int64_t start_us = esp_timer_get_time();
+    uint32_t gzip_size = data_len < sizeof(http_gzip_buffer) ? data_len : sizeof(http_gzip_buffer);
+    gzip_len = gzip_compress((const uint8_t *)data, data_len, http_gzip_buffer, gzip_size);
+    ESP_LOGD(HTTP_TAG, "Compressed %u to %u bytes in %u us", data_len, gzip_len, (uint32_t)(esp_timer_get_time() - start_us));
+  }
+
+  if (gzip_len > 0) {
+    body = (const char *)http_gzip_buffer;
+    body_len = gzip_len;
+    encoding = "Content-Encoding: gzip\r\n";
+  }
+#endif
+
+  int header_len = snprintf(http_header, sizeof(http_header),
+                            "POST " HTTP_WRITE_PATH "&precision=" HTTP_PRECISION " HTTP/1.1\r\n"
+                            "Host: " HTTP_HOST "\r\n"
+                            "Content-Type: text/plain\r\n"
+                            "%s"
+                            "Content-Length: %u\r\n"
+                            "%s\r\n", encoding, body_len, HTTP_KEEP_ALIVE ? "" : "Connection: close\r\n");
+  assert(header_len < (int)sizeof(http_header));
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (attempt > 0) {
+      stats_inc(STATS_POST_RETRIES);
+    }
+
+    bool reused = http_tls != NULL;
+    if (!reused) {
+      bool resumed = false;
+      http_tls = tls_connect(HTTP_HOST, HTTP_PORT, HTTP_TIMEOUT_MS, &resumed);
+      if (http_tls == NULL) {
+        http_stats.failures++;
+        esp_err = ESP_FAIL;
         break;
-    case HTTP_EVENT_ON_DATA:
-      ESP_LOGD(HTTP_TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-      /*
-       *  Check for chunked encoding is added as the URL for chunked encoding used in this example returns binary data.
-       *  However, event handler can also be used in case chunked encoding is used.
-       */
-      if (!esp_http_client_is_chunked_response(evt->client)) {
-        // If user_data buffer is configured, copy the response into the buffer
-        if (evt->user_data) {
-          memcpy(evt->user_data + output_len, evt->data, evt->data_len);
-        } else {
-          if (output_buffer == NULL) {
-            output_buffer = (char *)malloc(esp_http_client_get_content_length(evt->client));
-            output_len = 0;
-            if (output_buffer == NULL) {
-              ESP_LOGE(HTTP_TAG, "Failed to allocate memory for output buffer");
-              return ESP_FAIL;
-            }
-          }
-          memcpy(output_buffer + output_len, evt->data, evt->data_len);
-        }
-        output_len += evt->data_len;
       }
 
-      break;
-    case HTTP_EVENT_ON_FINISH:
-      ESP_LOGD(HTTP_TAG, "HTTP_EVENT_ON_FINISH");
-      if (output_buffer != NULL) {
-        // Response is accumulated in the output_buffer.
-        ESP_LOGD(HTTP_TAG, "%s", output_buffer);
-        free(output_buffer);
-        output_buffer = NULL;
+      http_stats.handshakes++;
+      if (resumed) {
+        http_stats.resumptions++;
       }
-      output_len = 0;
-      break;
-    case HTTP_EVENT_DISCONNECTED:
-      ESP_LOGD(HTTP_TAG, "HTTP_EVENT_DISCONNECTED");
-      int mbedtls_err = 0;
-      esp_err_t err = esp_tls_get_and_clear_last_error(evt->data, &mbedtls_err, NULL);
-      if (err != 0) {
-        if (output_buffer != NULL) {
-          free(output_buffer);
-          output_buffer = NULL;
-        }
-        output_len = 0;
-        ESP_LOGE(HTTP_TAG, "Last esp error code: 0x%x", err);
-        ESP_LOGE(HTTP_TAG, "Last mbedtls failure: 0x%x", mbedtls_err);
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    int64_t end_us = start_us + HTTP_TIMEOUT_MS * 1000LL;
+    uint32_t attempt_us = perf_now_us();
+
+    resp_reset(&http_resp);
+    answered = http_write(http_header, header_len, end_us) && http_write(body, body_len, end_us) &&
+                    http_read(end_us);
+
+    http_stats.requests++;
+    if (reused) {
+      http_stats.reuses++;
+    }
+    http_stats.last_latency_ms = (esp_timer_get_time() - start_us) / 1000;
+    perf_record(PERF_STAGE_POST, perf_now_us() - attempt_us);
+
+    if (answered) {
+      http_stats.bytes += body_len;
+      http_stats.raw_bytes += data_len;
+      ESP_LOGD(HTTP_TAG, "Status = %d, latency = %u ms%s", http_resp.status, http_stats.last_latency_ms, reused ? " (reused)" : "");
+      esp_err = http_check_status(http_resp.status);
+      if (http_resp.close) {
+        http_close();
       }
       break;
+    }
+
+    // Drops the broken connection. The next post reconnects.
+    http_stats.failures++;
+    http_close();
+    esp_err = ESP_FAIL;
+
+    if (!reused) {
+      break;
+    }
+  }
+
+  if (!answered) {
+    ESP_LOGE(HTTP_TAG, "Post failed without a response");
+  }
+
+#if !HTTP_KEEP_ALIVE
+  http_close();
+#endif
+
+  if (http_stats.requests % HTTP_STATS_LOG_PERIOD == 0) {
+    ESP_LOGI(HTTP_TAG, "Requests %u, handshakes %u, resumptions %u, reuses %u, failures %u, %u bytes/point, %u%% compressed", http_stats.requests, http_stats.handshakes, http_stats.resumptions, http_stats.reuses, http_stats.failures, http_stats.points ? http_stats.bytes / http_stats.points : 0, http_stats.raw_bytes ? 100 * http_stats.bytes / http_stats.raw_bytes : 100);
+  }
+
+  return esp_err;
+}
+
+
+/**
+ * @brief           Posts points, and splits them in two to be posted apart when the server refused them all, so that
+ *                  only the malformed ones are lost.
+ *
+ * @remarks         A partial write stored the valid points, and names how many it dropped. Any other refusal stored
+ *                  none, which is what a malformed point, or a body too large, gets from some servers and proxies. The
+ *                  halves are split further until the refused points are alone, within HTTP_SPLIT_MAX_POSTS posts,
+ *                  past which the refused parts are dropped whole. If a post fails, the whole batch is stored, and the
+ *                  parts already accepted are sent again, which the server takes as the same points.
+ *
+ * @param lines     The points, separated by a new line.
+ * @param len       The length of the points.
+ * @param points    The number of points.
+ * @param posts     The posts left to split with.
+ *
+ * @return        - ESP_OK once every point was accepted or refused for good
+ *                - ESP_FAIL if the points are to be sent again later
+ */
+static esp_err_t http_post_points(const char *lines, uint32_t len, uint32_t points, uint32_t *posts)
+{
+  esp_err_t esp_err = http_post(lines, len);
+  if (esp_err != ESP_ERR_INVALID_RESPONSE) {
+    return esp_err;
+  }
+
+  if (http_resp.partial || points == 1 || *posts < 2) {
+    // Refused points are not sent again, as they would only be refused again and hold up the points behind them.
+    stats_add(STATS_POINTS_REJECTED, http_resp.partial && http_resp.dropped > 0 ? http_resp.dropped : points);
+    return ESP_OK;
+  }
+
+  *posts -= 2;
+  uint32_t half = points / 2;
+  // The new line after the first half of the points, which are not terminated by one.
+  const char *middle = lines - 1;
+  for (uint32_t i = 0; i < half; i++) {
+    middle = memchr(middle + 1, '\n', lines + len - middle - 1);
+  }
+  ESP_LOGW(HTTP_TAG, "Splitting %u refused points to find the malformed ones", points);
+
+  esp_err = http_post_points(lines, middle - lines, half, posts);
+  if (esp_err != ESP_OK) {
+    return esp_err;
+  }
+
+  return http_post_points(middle + 1, lines + len - middle - 1, points - half, posts);
+}
+#endif
+
+
+/**
+ * @brief           Converts a time on the epoch to a timestamp in HTTP_PRECISION. Rounds to HTTP_PRECISION_MS, so that
+ *                  evenly spaced samples get evenly spaced timestamps.
+ *
+ * @param time_ms   The time in milliseconds since the epoch.
+ *
+ * @return          The timestamp.
+ */
+static uint64_t http_timestamp(int64_t time_ms)
+{
+  return (time_ms + HTTP_PRECISION_MS / 2) / HTTP_PRECISION_MS * HTTP_PRECISION_SCALE;
+}
+
+
+/**
+ * @brief           Encodes a sample as a line protocol point.
+ *
+ * @param sample    The sample.
+ * @param line      The line destination.
+ * @param size      The size of the destination.
+ *
+ * @return          The length of the line, or 0 if it does not fit.
+ */
+uint32_t http_encode(const sample_t *sample, char *line, uint32_t size)
+{
+  lp_t lp;
+  lp_begin(&lp, line, size, HTTP_MEASUREMENT);
+  lp_tag(&lp, "location", bme_location(sample->sensor));
+  lp_field_fixed(&lp, "temperature", sample->temperature, 2);
+  lp_field_fixed(&lp, "pressure", sample->pressure, 2);
+  lp_field_fixed(&lp, "humidity", sample->humidity, 3);
+
+  // A sample that cannot be placed on the epoch is left for the server to stamp.
+  int64_t timestamp = sample->timestamp;
+  if (clock_rebase(&timestamp)) {
+    lp_timestamp(&lp, http_timestamp(timestamp));
+  }
+
+  return lp_end(&lp);
+}
+
+
+/**
+ * @brief           Encodes a sample as a line protocol point directly into a batch.
+ *
+ * @param batch     The batch.
+ * @param sample    The sample.
+ * @param now_ms    The current time in milliseconds.
+ *
+ * @return        - true if the point was appended
+ *                - false if the point does not fit
+ */
+static bool http_append(batch_t *batch, const sample_t *sample, uint32_t now_ms)
+{
+  uint32_t size = 0;
+  char *line = batch_line(batch, &size);
+
+  uint32_t line_len = http_encode(sample, line, size);
+  if (line_len == 0) {
+    return false;
+  }
+
+  batch_commit(batch, line_len, now_ms);
+
+  return true;
+}
+
+
+#if AGG_ACTIVE
+/**
+ * @brief           Encodes the mean, min, max and standard deviation of a quantity as fields. The mean keeps the name
+ *                  of the raw field, so that the existing queries keep working.
+ *
+ * @param lp        The encoder.
+ * @param name      The name of the quantity.
+ * @param field     The quantity.
+ * @param count     The number of samples in the window.
+ * @param decimals  The decimals of the quantity.
+ */
+static void http_append_field(lp_t *lp, const char *name, const agg_field_t *field, uint32_t count, uint32_t decimals)
+{
+  char key[24];
+
+  lp_field_fixed(lp, name, agg_mean(field, count), decimals);
+  snprintf(key, sizeof(key), "%s_min", name);
+  lp_field_fixed(lp, key, field->min, decimals);
+  snprintf(key, sizeof(key), "%s_max", name);
+  lp_field_fixed(lp, key, field->max, decimals);
+  snprintf(key, sizeof(key), "%s_stddev", name);
+  lp_field_fixed(lp, key, agg_stddev(field, count, 10), decimals + 1);
+}
+
+
+/**
+ * @brief           Encodes a window as a line protocol point into a batch. It is stamped like its latest sample.
+ *
+ * @param batch     The batch.
+ * @param agg       The window.
+ * @param now_ms    The current time in milliseconds.
+ *
+ * @return        - true if the point was appended
+ *                - false if the point does not fit
+ */
+static bool http_append_agg(batch_t *batch, const agg_t *agg, uint32_t now_ms)
+{
+  uint32_t size = 0;
+  char *line = batch_line(batch, &size);
+
+  lp_t lp;
+  lp_begin(&lp, line, size, HTTP_MEASUREMENT);
+  lp_tag(&lp, "location", bme_location(agg->last.sensor));
+  http_append_field(&lp, "temperature", &agg->temperature, agg->count, 2);
+  http_append_field(&lp, "pressure", &agg->pressure, agg->count, 2);
+  http_append_field(&lp, "humidity", &agg->humidity, agg->count, 3);
+  lp_field_int(&lp, "samples", agg->count);
+
+  int64_t timestamp = agg->last.timestamp;
+  if (clock_rebase(&timestamp)) {
+    lp_timestamp(&lp, http_timestamp(timestamp));
+  }
+
+  // The batch is not full, so anything short of BATCH_MAX_LINE_SIZE fits.
+  uint32_t line_len = lp_end(&lp);
+  assert(line_len > 0);
+  if (line_len == 0) {
+    return false;
+  }
+
+  batch_commit(batch, line_len, now_ms);
+
+  return true;
+}
+#endif
+
+
+/**
+ * @brief           Starts a part of the health of the station.
+ *
+ * @param batch     The batch.
+ * @param lp        The encoder.
+ */
+static void http_stats_begin(batch_t *batch, lp_t *lp)
+{
+  uint32_t size = 0;
+  char *line = batch_line(batch, &size);
+
+  lp_begin(lp, line, size, STATS_MEASUREMENT);
+  lp_tag(lp, "location", HTTP_LOCATION);
+}
+
+
+/**
+ * @brief           Stamps a part of the health of the station and adds it to the batch.
+ *
+ * @param batch     The batch.
+ * @param lp        The encoder.
+ * @param time_ms   The time of the point in milliseconds, or -1 to leave it to the server.
+ * @param now_ms    The current time in milliseconds.
+ *
+ * @return        - true if the point was appended
+ *                - false if the point does not fit
+ */
+static bool http_stats_end(batch_t *batch, lp_t *lp, int64_t time_ms, uint32_t now_ms)
+{
+  if (time_ms >= 0) {
+    lp_timestamp(lp, http_timestamp(time_ms));
+  }
+
+  // The room for all the parts was checked, so anything short of BATCH_MAX_LINE_SIZE fits.
+  uint32_t line_len = lp_end(lp);
+  assert(line_len > 0);
+  if (line_len == 0) {
+    return false;
+  }
+
+  batch_commit(batch, line_len, now_ms);
+
+  return true;
+}
+
+
+/**
+ * @brief           Encodes the health of the station as HTTP_STATS_POINTS line protocol points into a batch. They
+ *                  share their series and time, so the server merges their fields back into one point.
+ *
+ * @remarks         The batch must have room for HTTP_STATS_POINTS points of the maximum size.
+ *
+ * @param batch     The batch.
+ * @param now_ms    The current time in milliseconds.
+ *
+ * @return        - true if the points were appended
+ *                - false if a point does not fit
+ */
+static bool http_append_stats(batch_t *batch, uint32_t now_ms)
+{
+  // Without the time, the server stamps all the points of a request alike.
+  int64_t time_ms = clock_is_synced() ? clock_now_ms() : -1;
+  lp_t lp;
+
+  // The memory and the tasks.
+  http_stats_begin(batch, &lp);
+  lp_field_int(&lp, "uptime_s", esp_timer_get_time() / 1000000);
+  lp_field_int(&lp, "heap_free", esp_get_free_heap_size());
+  lp_field_int(&lp, "heap_min", esp_get_minimum_free_heap_size());
+  lp_field_int(&lp, "heap_largest", heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+
+  const char *task_name = NULL;
+  uint32_t stack_min = 0;
+  for (uint32_t i = 0; perf_get_task(i, &task_name, &stack_min); i++) {
+    char key[8 + configMAX_TASK_NAME_LEN] = "stack_";
+    strncat(key, task_name, sizeof(key) - strlen(key) - 1);
+    lp_field_int(&lp, key, stack_min);
+  }
+
+  lp_field_int(&lp, "boot_to_upload_ms", boot_stage_ms(BOOT_STAGE_UPLOAD));
+  if (!http_stats_end(batch, &lp, time_ms, now_ms)) {
+    return false;
+  }
+
+  // The latencies and the requests.
+  http_stats_begin(batch, &lp);
+  lp_field_int(&lp, "handshake_p50_us", perf_percentile(PERF_STAGE_CONNECT, 50));
+  lp_field_int(&lp, "handshake_p99_us", perf_percentile(PERF_STAGE_CONNECT, 99));
+  lp_field_int(&lp, "resume_p50_us", perf_percentile(PERF_STAGE_RESUME, 50));
+  lp_field_int(&lp, "resume_p99_us", perf_percentile(PERF_STAGE_RESUME, 99));
+  lp_field_int(&lp, "post_p50_us", perf_percentile(PERF_STAGE_POST, 50));
+  lp_field_int(&lp, "post_p90_us", perf_percentile(PERF_STAGE_POST, 90));
+  lp_field_int(&lp, "post_p99_us", perf_percentile(PERF_STAGE_POST, 99));
+  lp_field_int(&lp, "time_to_ip_p50_us", perf_percentile(PERF_STAGE_WIFI, 50));
+  lp_field_int(&lp, "time_to_ip_max_us", perf_percentile(PERF_STAGE_WIFI, 100));
+  lp_field_int(&lp, "requests", http_stats.requests);
+  lp_field_int(&lp, "handshakes", http_stats.handshakes);
+  lp_field_int(&lp, "resumptions", http_stats.resumptions);
+  lp_field_int(&lp, "failures", http_stats.failures);
+  lp_field_int(&lp, "queue_max", http_queue_max);
+  if (!http_stats_end(batch, &lp, time_ms, now_ms)) {
+    return false;
+  }
+
+  // The event counters.
+  http_stats_begin(batch, &lp);
+  for (uint32_t counter = 0; counter < STATS_COUNTER_MAX; counter++) {
+    lp_field_int(&lp, stats_name(counter), stats_get(counter));
   }
-  return ESP_OK;
+
+  return http_stats_end(batch, &lp, time_ms, now_ms);
+}
+
+
+/**
+ * @brief           Posts the batch and empties it.
+ *
+ * @param now_ms    The current time in milliseconds.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL
+ */
+static esp_err_t http_post_batch(uint32_t now_ms)
+{
+#if HTTP_TRANSPORT == HTTP_TRANSPORT_MQTT
+  esp_err_t esp_err = mqtt_publish(http_batch.buffer, http_batch.len, http_batch_samples, http_batch_sample_count);
+#elif HTTP_TRANSPORT == HTTP_TRANSPORT_UDP
+  esp_err_t esp_err = udp_send(http_batch.buffer, http_batch.len);
+#else
+  uint32_t posts = HTTP_SPLIT_MAX_POSTS;
+  esp_err_t esp_err = http_post_points(http_batch.buffer, http_batch.len, http_batch.points, &posts);
+#endif
+
+  if (esp_err == ESP_OK) {
+    http_stats.points += http_batch.points;
+    http_offline = false;
+    boot_ready(BOOT_STAGE_UPLOAD);
+  } else {
+    http_offline = true;
+    http_offline_ms = now_ms;
+  }
+
+  batch_reset(&http_batch);
+  http_batch_sample_count = 0;
+
+  return esp_err;
+}
+
+
+/**
+ * @brief           Posts the oldest stored samples in one large batch. They are only removed from the store once the
+ *                  server accepted them.
+ *
+ * @param now_ms    The current time in milliseconds.
+ */
+static void http_drain(uint32_t now_ms)
+{
+  uint32_t count = store_read(http_backlog, HTTP_BACKLOG_POINTS);
+  uint32_t appended = 0;
+
+  while (appended < count && !batch_is_full(&http_batch) && http_append(&http_batch, &http_backlog[appended], now_ms)) {
+    appended++;
+  }
+
+  if (appended == 0) {
+    return;
+  }
+
+  if (http_post_batch(now_ms) != ESP_OK) {
+    return;
+  }
+
+#if HTTP_TRANSPORT == HTTP_TRANSPORT_MQTT
+  // The stored samples are only given up once the broker has them, and are sent again otherwise.
+  if (!mqtt_wait_acked(HTTP_TIMEOUT_MS)) {
+    ESP_LOGW(HTTP_TAG, "Stored samples unacknowledged, keeping them");
+    http_offline = true;
+    http_offline_ms = now_ms;
+    return;
+  }
+#endif
+
+  store_commit(appended);
+  ESP_LOGI(HTTP_TAG, "Sent %u stored samples, %u left", appended, store_count());
+}
+
+/**
+ * @brief           Keeps a sample in the store until the server can be reached. The store counts the samples it could
+ *                  not keep as lost, and the failure is logged once until the store works again.
+ *
+ * @param sample    The sample.
+ */
+static void http_store(const sample_t *sample)
+{
+  esp_err_t esp_err = store_write(sample);
+  if (esp_err != ESP_OK && !http_store_failed) {
+    ESP_LOGE(HTTP_TAG, "Store failed with error 0x%x, losing samples", esp_err);
+  }
+  http_store_failed = esp_err != ESP_OK;
+}
+
+#if AGG_ACTIVE
+/**
+ * @brief           Adds a window to the batch, or to the store while offline, and empties it.
+ *
+ * @param agg       The window.
+ * @param popped_us The time its latest sample was popped, in microseconds.
+ * @param now_ms    The current time in milliseconds.
+ */
+static void http_close_window(agg_t *agg, uint32_t popped_us, uint32_t now_ms)
+{
+  // Only the means of a closed window are kept, as they are what a failed post or the store can hold.
+  sample_t mean;
+  agg_sample(agg, &mean);
+
+  if (http_offline) {
+    http_store(&mean);
+  } else {
+    http_batch_popped_us[http_batch_sample_count] = popped_us;
+    http_batch_samples[http_batch_sample_count++] = mean;
+    http_append_agg(&http_batch, agg, now_ms);
+  }
+
+  agg_reset(agg);
+}
+
+
+/**
+ * @brief           Closes the windows that are still open, so that a flush does not leave their samples behind.
+ *
+ * @param now_ms    The current time in milliseconds.
+ *
+ * @return        - true if every window was closed
+ *                - false if the batch has to be sent first
+ */
+static bool http_close_windows(uint32_t now_ms)
+{
+  for (uint32_t i = 0; i < BME_MAX_SENSORS; i++) {
+    if (http_aggs[i].count == 0) {
+      continue;
+    }
+
+    if (!http_offline && batch_is_due(&http_batch, now_ms)) {
+      return false;
+    }
+
+    http_close_window(&http_aggs[i], perf_now_us(), now_ms);
+  }
+
+  return true;
+}
+#endif
+
+
+/**
+ * @brief           Adds a sample popped from the queue to the batch, or to the store while offline.
+ *
+ * @param sample    The sample.
+ * @param popped_us The time the sample was popped, in microseconds.
+ * @param now_ms    The current time in milliseconds.
+ */
+static void http_consume(const sample_t *sample, uint32_t popped_us, uint32_t now_ms)
+{
+#if AGG_ACTIVE
+  agg_t *agg = &http_aggs[sample->sensor];
+  int64_t window = sample->timestamp / AGG_WINDOW_MS;
+  if (agg->count > 0 && (window != agg->window || agg->count >= AGG_MAX_SAMPLES)) {
+    http_close_window(agg, popped_us, now_ms);
+  }
+
+  if (agg->count == 0) {
+    agg->window = window;
+  }
+  agg_add(agg, sample);
+#else
+  if (http_offline) {
+    http_store(sample);
+  } else {
+    http_batch_popped_us[http_batch_sample_count] = popped_us;
+    http_batch_samples[http_batch_sample_count++] = *sample;
+    http_append(&http_batch, sample, now_ms);
+  }
+#endif
 }
 
 
 /**
  * @brief           The HTTP task function. Checks for pending data and posts it to the InfluxDB.
+ *
+ * @remarks         While the server cannot be reached, the samples are kept in the store. The server is probed every
+ *                  HTTP_RETRY_PERIOD_MS with the oldest stored samples and the store is drained once a post succeeds.
  */
 void http_task()
 {
-  esp_http_client_config_t http_config = {
-    .url = HTTP_POST_URL,
-    .cert_pem = (const char*)influxdb_pem_start,
-    .skip_cert_common_name_check = true,
-    .timeout_ms = HTTP_TIMEOUT_MS,
-    .event_handler = http_event_handler
-  };
+#if HTTP_TRANSPORT != HTTP_TRANSPORT_UDP
+  // Parses the CA certificates once for every connection, instead of on each handshake.
+  esp_err_t ca_err = esp_tls_set_global_ca_store(influxdb_pem_start, influxdb_pem_end - influxdb_pem_start);
+  if (ca_err != ESP_OK) {
+    ESP_LOGE(HTTP_TAG, "CA store setup failed with error 0x%x", ca_err);
+    vTaskDelete(NULL);
+    return;
+  }
+#endif
+  boot_ready(BOOT_STAGE_TLS);
+
+#if HTTP_TRANSPORT == HTTP_TRANSPORT_MQTT
+  // The client task opens its socket right away.
+  boot_wait(BOOT_STAGE_NET, portMAX_DELAY);
+  if (mqtt_start() != ESP_OK) {
+    vTaskDelete(NULL);
+    return;
+  }
+#endif
+
+  esp_err_t esp_err = store_init();
+  if (esp_err != ESP_OK) {
+    ESP_LOGE(HTTP_TAG, "Store initialization failed with error 0x%x", esp_err);
+  }
 
+  http_consumer = xTaskGetCurrentTaskHandle();
+
+  TickType_t wait_ticks = 0;
   while (1) {
-    if (http_data_flag == HTTP_DATA_PENDING) {
-      esp_http_client_handle_t http_client = esp_http_client_init(&http_config);
+    // Sleeps until the sensor task queues a sample, or until the pending batch or the next retry is due.
+    ulTaskNotifyTake(pdTRUE, wait_ticks);
 
-      esp_http_client_set_method(http_client, HTTP_METHOD_POST);
-      esp_http_client_set_header(http_client, "Content-Type", "text/plain");
-      esp_http_client_set_post_field(http_client, field, field_len);
+    uint32_t now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
 
-      esp_err_t esp_err = esp_http_client_perform(http_client);
+    // A kick or a flush sends everything that is queued right away, and lasts until it is all out.
+    if (atomic_exchange(&http_kicked, false) || atomic_load(&http_flusher) != NULL) {
+      http_flushing = true;
+    }
+    bool flush = http_flushing;
 
-      if (esp_err == ESP_OK) {
-        ESP_LOGD(HTTP_TAG, "Status = %d, content_length = %d", esp_http_client_get_status_code(http_client), esp_http_client_get_content_length(http_client));
+    // Holds the samples in the queue for a while after boot, so that they can be stamped once the time is known.
+    bool hold = !flush && !clock_is_synced() && now_ms < HTTP_SYNC_WAIT_MS;
+
+    sample_t sample;
+    while (!hold && !batch_is_due(&http_batch, now_ms) && ring_pop(&http_queue, &sample)) {
+      uint32_t popped_us = perf_now_us();
+      perf_record(PERF_STAGE_QUEUE, popped_us - sample.acquired_us);
+      http_consume(&sample, popped_us, now_ms);
+    }
+
+    // The health of the station rides along with the samples, but is not worth keeping while offline.
+    // The period only restarts once they are in, so they are not skipped when the batch has no room for them.
+    if (!http_offline && now_ms - http_stats_ms >= STATS_PERIOD_MS && !batch_is_due(&http_batch, now_ms) &&
+        batch_fits(&http_batch, HTTP_STATS_POINTS) && http_append_stats(&http_batch, now_ms)) {
+      http_stats_ms = now_ms;
+    }
+
+    // Low memory sends whatever is pending early.
+    bool low_heap = esp_get_free_heap_size() < BATCH_LOW_HEAP_BYTES;
+    bool flush_due = flush && ring_count(&http_queue) == 0;
+#if AGG_ACTIVE
+    if (flush_due && !http_close_windows(now_ms)) {
+      flush_due = false;
+    }
+#endif
+    // The first points after boot go out as soon as they can be stamped, instead of waiting for a full batch.
+    bool first_due = !boot_is_ready(BOOT_STAGE_UPLOAD) && boot_is_ready(BOOT_STAGE_IP) && clock_is_synced();
+    if (batch_is_due(&http_batch, now_ms) || ((low_heap || flush_due || first_due) && http_batch.points > 0)) {
+      uint32_t points = http_batch_sample_count;
+      uint32_t post_us = perf_now_us();
+      for (uint32_t i = 0; i < points; i++) {
+        perf_record(PERF_STAGE_BATCH, post_us - http_batch_popped_us[i]);
+      }
+
+      if (http_post_batch(now_ms) == ESP_OK) {
+#if HTTP_TRANSPORT != HTTP_TRANSPORT_MQTT
+        // A publish is only in once the broker acknowledges it, see mqtt.c.
+        uint32_t ack_us = perf_now_us();
+        for (uint32_t i = 0; i < points; i++) {
+          perf_record(PERF_STAGE_INGEST, ack_us - http_batch_samples[i].acquired_us);
+        }
+#endif
       } else {
-        ESP_LOGE(HTTP_TAG, "Perform failed with error 0x%x", esp_err);
+        for (uint32_t i = 0; i < points; i++) {
+          http_store(&http_batch_samples[i]);
+        }
+        ESP_LOGW(HTTP_TAG, "Server unreachable, storing samples");
       }
+    }
+
+    bool retry_due = http_offline && now_ms - http_offline_ms >= HTTP_RETRY_PERIOD_MS;
+    if (retry_due && store_count() == 0) {
+      // Nothing is stored to probe the server with, so the next live batch does it.
+      http_offline = false;
+    }
+
+    if (http_batch.points == 0 && store_count() > 0 && (!http_offline || retry_due)) {
+      http_drain(now_ms);
+    }
 
-      esp_err = esp_http_client_cleanup(http_client);
-      if (esp_err != ESP_OK) {
-        ESP_LOGE(HTTP_TAG, "Cleanup failed with error 0x%x", esp_err);
+    if (flush_due && http_batch.points == 0 && (http_offline || store_count() == 0)) {
+      // Everything is either sent or in flash, as the caller may power down next.
+      store_flush();
+#if HTTP_TRANSPORT == HTTP_TRANSPORT_MQTT
+      if (!mqtt_wait_acked(HTTP_TIMEOUT_MS)) {
+        ESP_LOGW(HTTP_TAG, "Publishes still unacknowledged, storing their samples");
+        mqtt_store_unacked();
+        store_flush();
+      }
+#endif
+      http_flushing = false;
+      TaskHandle_t flusher = atomic_exchange(&http_flusher, NULL);
+      if (flusher != NULL) {
+        xTaskNotifyGive(flusher);
       }
+    }
 
-     http_data_flag = HTTP_DATA_OK;
+    perf_poll();
+
+    if (hold) {
+      wait_ticks = 1000 / portTICK_PERIOD_MS;
+    } else if (http_flushing || ring_count(&http_queue) > 0 || (!http_offline && store_count() > 0 && http_batch.points == 0)) {
+      wait_ticks = 0;
+    } else if (http_batch.points > 0) {
+      wait_ticks = (BATCH_MAX_AGE_MS - (now_ms - http_batch.first_ms)) / portTICK_PERIOD_MS;
+    } else if (http_offline) {
+      uint32_t offline_ms = xTaskGetTickCount() * portTICK_PERIOD_MS - http_offline_ms;
+      wait_ticks = offline_ms < HTTP_RETRY_PERIOD_MS ? (HTTP_RETRY_PERIOD_MS - offline_ms) / portTICK_PERIOD_MS : 0;
     } else {
-      vTaskDelay(HTTP_POLL_PERIOD_MS / portTICK_PERIOD_MS);
+      wait_ticks = portMAX_DELAY;
     }
   }
+}
 
 
+/**
+ * @brief           Copies the connection statistics.
+ *
+ * @param stats     The statistics destination.
+ */
+void http_get_stats(http_stats_t *stats)
+{
+  *stats = http_stats;
+  stats->queue_max = http_queue_max;
 }
 
 
 /**
- * @brief           Prepares a data send request.
+ * @brief           Sends everything that is queued without waiting for the batch to fill up. Scheduled every
+ *                  HTTP_UPLOAD_PERIOD_MS, so that the uploads follow the sampling rounds.
+ */
+void http_kick()
+{
+  atomic_store(&http_kicked, true);
+
+  if (http_consumer != NULL) {
+    xTaskNotifyGive(http_consumer);
+  }
+}
+
+
+/**
+ * @brief           Sends everything that is queued without waiting for the batch to fill up, and waits until it is done.
  *
- * @remarks         If HTTP_DATA_PENDING is returned, then the request has to be repeated, because another request is waiting to be served.
+ * @remarks         Must not be called by the HTTP task. Once it returns, the samples are either sent or stored in
+ *                  flash, unless it timed out.
  *
- * @param data      The POST field data.
- * @param data_len  The POST field data length.
+ * @param timeout_ms  The maximum milliseconds to wait.
+ *
+ * @return        - ESP_OK if everything was sent
+ *                - ESP_FAIL if the server is unreachable and the samples were stored
+ *                - ESP_ERR_TIMEOUT
+ */
+esp_err_t http_flush(uint32_t timeout_ms)
+{
+  // Clears any stale notification before registering.
+  ulTaskNotifyTake(pdTRUE, 0);
+  atomic_store(&http_flusher, xTaskGetCurrentTaskHandle());
+
+  if (http_consumer != NULL) {
+    xTaskNotifyGive(http_consumer);
+  }
+
+  if (ulTaskNotifyTake(pdTRUE, timeout_ms / portTICK_PERIOD_MS) == 0) {
+    atomic_store(&http_flusher, NULL);
+    return ESP_ERR_TIMEOUT;
+  }
+
+  return http_offline ? ESP_FAIL : ESP_OK;
+}
+
+
+/**
+ * @brief           Queues a sample to be sent with the next batch and wakes up the HTTP task.
+ *
+ * @remarks         Must only be called by one task, the sensor task or the main task in deep sleep mode. If
+ *                  HTTP_DATA_PENDING is returned, then the queue is full and the sample was not accepted; the caller
+ *                  decides whether it is dropped or kept.
+ *
+ * @param sample    The sample.
  *
  * @return        - HTTP_DATA_OK
  *                - HTTP_DATA_PENDING
  */
-http_data_en http_send(char *data, uint32_t data_len)
+http_data_en http_send(const sample_t *sample)
 {
-  // Checks if other data is waiting to be sent.
-  if (http_data_flag == HTTP_DATA_PENDING) {
+  if (!ring_push(&http_queue, sample)) {
     return HTTP_DATA_PENDING;
   }
 
-  memcpy(field, data, data_len);
-  field_len = data_len;
-  http_data_flag = HTTP_DATA_PENDING;
+  uint32_t count = ring_count(&http_queue);
+  if (count > http_queue_max) {
+    http_queue_max = count;
+  }
+
+  if (http_consumer != NULL) {
+    xTaskNotifyGive(http_consumer);
+  }
 
   return HTTP_DATA_OK;
 }
@@ -13,30 +13,123 @@
 #define _HTTP_H_
 
 
+#include "batch.h"
+#include "bme.h"
+#include "ring.h"
+#include "sample.h"
+
+#include "esp_err.h"
+
 #include <stdint.h>
 
 
 #define HTTP_TAG                      "HTTP"
 
+// The transports the batches can be delivered over. HTTPS posts them to the InfluxDB, MQTT publishes them to a broker
+// over one persistent session, see mqtt.h, and UDP sends them unacknowledged to the InfluxDB UDP listener, see udp.h.
+// The host build makes a station of each, to compare them.
+#define HTTP_TRANSPORT_HTTPS          (0)
+#define HTTP_TRANSPORT_MQTT           (1)
+#define HTTP_TRANSPORT_UDP            (2)
+#ifndef HTTP_TRANSPORT
+#define HTTP_TRANSPORT                (HTTP_TRANSPORT_HTTPS)
+#endif
+
 #define HTTP_TASK_NAME                "http"
 #define HTTP_TASK_PRIORITY            (tskIDLE_PRIORITY + 1)
+// Without TLS and the compression the task needs a fraction of the stack.
+#if HTTP_TRANSPORT == HTTP_TRANSPORT_UDP
+#define HTTP_TASK_STACK_SIZE          (4096)
+#else
 #define HTTP_TASK_STACK_SIZE          (8192)
+#endif
 
-#define HTTP_FIELD_SIZE               (256)
-#define HTTP_POLL_PERIOD_MS           (5000)
+#define HTTP_MEASUREMENT              "sensor"
+#define HTTP_LOCATION                 "home"
+// The queue has to hold every sample taken while it is not drained, that is during the hold for the time after boot,
+// and during a post and its retry.
+#define HTTP_QUEUE_MIN_LENGTH         (BME_MAX_SENSORS * \
+                                       ((HTTP_SYNC_WAIT_MS + 2 * HTTP_TIMEOUT_MS) / BME_SAMPLING_PERIOD_MS + 1))
+#define HTTP_QUEUE_LENGTH             (RING_CAPACITY(HTTP_QUEUE_MIN_LENGTH))
+#define HTTP_UPLOAD_PERIOD_MS         (BATCH_MAX_AGE_MS)
+#define HTTP_UPLOAD_PHASE_MS          (500)
+#define HTTP_BACKLOG_POINTS           (48)
+#define HTTP_RETRY_PERIOD_MS          (30000)
 
-#define HTTP_POST_URL                 "https://<Your InfluxDB Address:Port>/write?db=<Your InfluxDB DB Name>&u=<Your InfluxDB Username>&p=<Your InfluxDB Password>"
+#define HTTP_HOST                     "<Your InfluxDB Address>"
+#define HTTP_PORT                     (8086)
+#define HTTP_WRITE_PATH               "/write?db=<Your InfluxDB DB Name>&u=<Your InfluxDB Username>&p=<Your InfluxDB Password>"
+// The request line and the headers of a post.
+#define HTTP_HEADER_SIZE              (512)
+#define HTTP_READ_SIZE                (128)
+// The posts a batch the server refused whole may be split into, to find its malformed points.
+#define HTTP_SPLIT_MAX_POSTS          (16)
+// The timestamps are rounded to the coarsest unit that leaves at least two of them between the samples of a sensor, so
+// that two samples never share a timestamp, which would make the InfluxDB keep only the last. The clock counts in
+// milliseconds, so there is no finer unit. The InfluxDB is told the precision with every post, while the UDP listener
+// and the Telegraf mqtt_consumer take the points without one and read them in nanoseconds.
+#if BME_SAMPLING_PERIOD_MS >= 2000
+#define HTTP_PRECISION_MS             (1000)
+#else
+#define HTTP_PRECISION_MS             (1)
+#endif
+#if HTTP_TRANSPORT != HTTP_TRANSPORT_HTTPS
+#define HTTP_PRECISION                "ns"
+#define HTTP_PRECISION_SCALE          (HTTP_PRECISION_MS * 1000000ULL)
+#elif HTTP_PRECISION_MS == 1000
+#define HTTP_PRECISION                "s"
+#define HTTP_PRECISION_SCALE          (1ULL)
+#else
+#define HTTP_PRECISION                "ms"
+#define HTTP_PRECISION_SCALE          (1ULL)
+#endif
+#define HTTP_SYNC_WAIT_MS             (60000)
 #define HTTP_TIMEOUT_MS               (10000)
+// Set to 0 to close the connection after every post. The host build makes a station of each, to compare them.
+#ifndef HTTP_KEEP_ALIVE
+#define HTTP_KEEP_ALIVE               (1)
+#endif
+#define HTTP_GZIP                     (1)
+// Compressing takes about the same time per byte at every size, but below about three points the gzip framing and the
+// header that announces it eat most of what it saves. From here on a body saves at least a quarter, see test_gzip.
+#define HTTP_GZIP_MIN_SIZE            (256)
+#define HTTP_STATS_LOG_PERIOD         (60)
+#define HTTP_STATS_POINTS             (3)
 
 typedef enum {
   HTTP_DATA_OK,
   HTTP_DATA_PENDING
 } http_data_en;
 
+typedef struct {
+  uint32_t handshakes;
+  uint32_t resumptions;
+  uint32_t requests;
+  uint32_t reuses;
+  uint32_t failures;
+  uint32_t points;
+  uint32_t bytes;
+  uint32_t raw_bytes;
+  uint32_t last_latency_ms;
+  uint32_t queue_max;
+} http_stats_t;
+
+
+uint32_t http_encode(const sample_t *sample, char *line, uint32_t size);
+
 
-http_data_en http_send(char *data, uint32_t data_len);
+http_data_en http_send(const sample_t *sample);
+
+
+void http_kick();
+
+
+esp_err_t http_flush(uint32_t timeout_ms);
 
 
 void http_task();
 
+
+void http_get_stats(http_stats_t *stats);
+
 #endif /* _HTTP_H_ */
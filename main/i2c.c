@@ -0,0 +1,220 @@
+/**
+ * @file    i2c.c
+ *
+ * @brief   I2C Source File
+ *
+ * @remarks The transactions are built in a statically allocated command link, so no heap is used per transaction. The
+ *          link is shared, so the transactions must only be issued from one task.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "i2c.h"
+
+#include "esp_idf_version.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+
+// The static command links were added in v4.4.
+#if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(4, 4, 0)
+#error "ESP IDF v4.4 or later is required"
+#endif
+
+
+static const struct {
+  i2c_port_t port;
+  int scl;
+  int sda;
+} i2c_pins[] = {
+  { I2C_PORT, I2C_SCL, I2C_SDA },
+  { I2C_PORT_1, I2C_SCL_1, I2C_SDA_1 }
+};
+
+static uint8_t i2c_cmd_buffer[I2C_CMD_LINK_SIZE];
+static i2c_stats_t i2c_stats;
+
+
+/**
+ * @brief           Executes a built command link, releases it and accounts for its latency and result.
+ */
+static esp_err_t i2c_execute(i2c_port_t port, i2c_cmd_handle_t cmd, esp_err_t esp_err)
+{
+  int64_t start_us = esp_timer_get_time();
+
+  if (esp_err == ESP_OK) {
+    esp_err = i2c_master_cmd_begin(port, cmd, I2C_WAIT_MS / portTICK_PERIOD_MS);
+  }
+
+  i2c_cmd_link_delete_static(cmd);
+
+  uint32_t latency_us = esp_timer_get_time() - start_us;
+  i2c_stats.transactions++;
+  i2c_stats.last_latency_us = latency_us;
+  i2c_stats.total_latency_us += latency_us;
+  if (latency_us > i2c_stats.max_latency_us) {
+    i2c_stats.max_latency_us = latency_us;
+  }
+  if (esp_err != ESP_OK) {
+    i2c_stats.errors++;
+  }
+
+  return esp_err;
+}
+
+
+/**
+ * @brief           Configures the I2C masters and installs their drivers.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL
+ */
+esp_err_t i2c_setup()
+{
+  esp_err_t esp_err = ESP_OK;
+
+  for (uint32_t i = 0; i < I2C_PORT_COUNT; i++) {
+    i2c_config_t i2c_config = {
+      .mode = I2C_MODE_MASTER,
+      .sda_io_num = i2c_pins[i].sda,
+      .sda_pullup_en = GPIO_PULLUP_ENABLE,
+      .scl_io_num = i2c_pins[i].scl,
+      .scl_pullup_en = GPIO_PULLUP_ENABLE,
+      .master.clk_speed = I2C_SPEED
+    };
+
+    esp_err = i2c_param_config(i2c_pins[i].port, &i2c_config);
+    if (esp_err != ESP_OK) {
+      ESP_LOGE(I2C_TAG, "Configuration failed with code %x [%s]", esp_err, esp_err_to_name(esp_err));
+      return esp_err;
+    }
+
+    esp_err = i2c_driver_install(i2c_pins[i].port, i2c_config.mode, 0, 0, 0);
+    if (esp_err != ESP_OK) {
+      ESP_LOGE(I2C_TAG, "Driver initialization failed with code %x [%s]", esp_err, esp_err_to_name(esp_err));
+      return esp_err;
+    }
+  }
+
+  return esp_err;
+}
+
+
+/**
+ * @brief           Gets a configured controller.
+ *
+ * @param index     The index of the controller, up to I2C_PORT_COUNT.
+ *
+ * @return          The I2C port.
+ */
+i2c_port_t i2c_get_port(uint32_t index)
+{
+  return i2c_pins[index].port;
+}
+
+
+/**
+ * @brief           Reads consecutive registers in one burst.
+ *
+ * @param port      The I2C port.
+ * @param addr      The device address.
+ * @param reg       The first register address.
+ * @param data      The data read.
+ * @param len       The number of bytes to read.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL
+ */
+esp_err_t i2c_read_regs(i2c_port_t port, uint8_t addr, uint8_t reg, uint8_t *data, uint32_t len)
+{
+  esp_err_t esp_err = ESP_OK;
+
+  if (len == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(i2c_cmd_buffer, sizeof(i2c_cmd_buffer));
+
+  // Every step is skipped once one fails, and the link is still released.
+  esp_err = i2c_master_start(cmd);
+  if (esp_err == ESP_OK) {
+    esp_err = i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_WRITE, 1);
+  }
+  if (esp_err == ESP_OK) {
+    esp_err = i2c_master_write_byte(cmd, reg, 1);
+  }
+  if (esp_err == ESP_OK) {
+    esp_err = i2c_master_start(cmd);
+  }
+  if (esp_err == ESP_OK) {
+    esp_err = i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_READ, 1);
+  }
+  if (esp_err == ESP_OK) {
+    esp_err = i2c_master_read(cmd, data, len, I2C_MASTER_LAST_NACK);
+  }
+  if (esp_err == ESP_OK) {
+    esp_err = i2c_master_stop(cmd);
+  }
+
+  esp_err = i2c_execute(port, cmd, esp_err);
+  if (esp_err != ESP_OK) {
+    ESP_LOGE(I2C_TAG, "Read failed with error 0x%x", esp_err);
+  }
+
+  return esp_err;
+}
+
+
+/**
+ * @brief           Writes to consecutive registers.
+ *
+ * @param port      The I2C port.
+ * @param addr      The device address.
+ * @param reg       The first register address.
+ * @param data      The data to be written.
+ * @param len       The number of bytes to write.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL
+ */
+esp_err_t i2c_write_regs(i2c_port_t port, uint8_t addr, uint8_t reg, const uint8_t *data, uint32_t len)
+{
+  esp_err_t esp_err = ESP_OK;
+
+  i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(i2c_cmd_buffer, sizeof(i2c_cmd_buffer));
+
+  esp_err = i2c_master_start(cmd);
+  if (esp_err == ESP_OK) {
+    esp_err = i2c_master_write_byte(cmd, (addr << 1) | I2C_MASTER_WRITE, 1);
+  }
+  if (esp_err == ESP_OK) {
+    esp_err = i2c_master_write_byte(cmd, reg, 1);
+  }
+  if (esp_err == ESP_OK && len > 0) {
+    esp_err = i2c_master_write(cmd, data, len, 1);
+  }
+  if (esp_err == ESP_OK) {
+    esp_err = i2c_master_stop(cmd);
+  }
+
+  esp_err = i2c_execute(port, cmd, esp_err);
+  if (esp_err != ESP_OK) {
+    ESP_LOGE(I2C_TAG, "Write failed with error 0x%x", esp_err);
+  }
+
+  return esp_err;
+}
+
+
+/**
+ * @brief           Copies the transaction statistics.
+ *
+ * @param stats     The statistics destination.
+ */
+void i2c_get_stats(i2c_stats_t *stats)
+{
+  *stats = i2c_stats;
+}
@@ -15,6 +15,8 @@
 
 #include "driver/i2c.h"
 
+#include <stdint.h>
+
 
 #define I2C_TAG                       (" I2C")
 
@@ -22,7 +24,39 @@
 #define I2C_SCL                       (GPIO_NUM_19)
 #define I2C_SDA                       (GPIO_NUM_23)
 #define I2C_SPEED                     (1e6)
+
+// The second controller. Sensors are looked for on the first I2C_PORT_COUNT controllers.
+#define I2C_PORT_1                    (I2C_NUM_1)
+#define I2C_SCL_1                     (GPIO_NUM_18)
+#define I2C_SDA_1                     (GPIO_NUM_5)
+#define I2C_PORT_COUNT                (2)
 #define I2C_WAIT_MS                   (10)
 
+// A register read is start, address, register, repeated start, address, data and stop.
+#define I2C_CMD_LINK_SIZE             (I2C_LINK_RECOMMENDED_SIZE(2))
+
+typedef struct {
+  uint32_t transactions;
+  uint32_t errors;
+  uint32_t last_latency_us;
+  uint32_t max_latency_us;
+  uint64_t total_latency_us;
+} i2c_stats_t;
+
+
+esp_err_t i2c_setup();
+
+
+i2c_port_t i2c_get_port(uint32_t index);
+
+
+esp_err_t i2c_read_regs(i2c_port_t port, uint8_t addr, uint8_t reg, uint8_t *data, uint32_t len);
+
+
+esp_err_t i2c_write_regs(i2c_port_t port, uint8_t addr, uint8_t reg, const uint8_t *data, uint32_t len);
+
+
+void i2c_get_stats(i2c_stats_t *stats);
+
 
 #endif /* _I2C_H_ */
@@ -0,0 +1,209 @@
+/**
+ * @file    lp.c
+ *
+ * @brief   Line Protocol Source File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "lp.h"
+
+
+/**
+ * @brief           Appends a character.
+ */
+static void lp_put(lp_t *lp, char c)
+{
+  if (lp->len >= lp->size) {
+    lp->overflow = true;
+    return;
+  }
+
+  lp->buf[lp->len++] = c;
+}
+
+
+/**
+ * @brief           Appends a string, escaping the given special characters with a backslash.
+ */
+static void lp_put_escaped(lp_t *lp, const char *str, const char *special)
+{
+  for (; *str != '\0'; str++) {
+    for (const char *s = special; *s != '\0'; s++) {
+      if (*str == *s) {
+        lp_put(lp, '\\');
+        break;
+      }
+    }
+    lp_put(lp, *str);
+  }
+}
+
+
+/**
+ * @brief           Appends the decimal digits of a number, left padded with zeros to at least min_digits.
+ *
+ * @remarks         Only the digits above the lower 9 are divided in 64 bits, which the ESP32 does in software.
+ */
+static void lp_put_digits(lp_t *lp, uint64_t value, uint32_t min_digits)
+{
+  char digits[20];
+  uint32_t count = 0;
+
+  uint32_t low = value % 1000000000;
+  uint64_t high = value / 1000000000;
+  if (high > 0) {
+    // The lower part of a larger number keeps its zeros.
+    for (uint32_t i = 0; i < 9; i++) {
+      digits[count++] = '0' + low % 10;
+      low /= 10;
+    }
+    low = high % 1000000000;
+    high /= 1000000000;
+    if (high > 0) {
+      for (uint32_t i = 0; i < 9; i++) {
+        digits[count++] = '0' + low % 10;
+        low /= 10;
+      }
+      low = high;
+    }
+  }
+
+  do {
+    digits[count++] = '0' + low % 10;
+    low /= 10;
+  } while (low > 0);
+
+  while (count < min_digits && count < sizeof(digits)) {
+    digits[count++] = '0';
+  }
+
+  while (count > 0) {
+    lp_put(lp, digits[--count]);
+  }
+}
+
+
+/**
+ * @brief           Starts a field, writing its separator and escaped key.
+ */
+static void lp_put_key(lp_t *lp, const char *key)
+{
+  lp_put(lp, lp->fields++ == 0 ? ' ' : ',');
+  lp_put_escaped(lp, key, ",= ");
+  lp_put(lp, '=');
+}
+
+
+/**
+ * @brief               Starts a point.
+ *
+ * @param lp            The encoder.
+ * @param buf           The buffer to encode into.
+ * @param size          The buffer size.
+ * @param measurement   The measurement name.
+ */
+void lp_begin(lp_t *lp, char *buf, uint32_t size, const char *measurement)
+{
+  lp->buf = buf;
+  lp->size = size;
+  lp->len = 0;
+  lp->fields = 0;
+  lp->overflow = false;
+
+  lp_put_escaped(lp, measurement, ", ");
+}
+
+
+/**
+ * @brief           Adds a tag. Tags have to be added before any field.
+ *
+ * @param lp        The encoder.
+ * @param key       The tag key.
+ * @param value     The tag value.
+ */
+void lp_tag(lp_t *lp, const char *key, const char *value)
+{
+  lp_put(lp, ',');
+  lp_put_escaped(lp, key, ",= ");
+  lp_put(lp, '=');
+  lp_put_escaped(lp, value, ",= ");
+}
+
+
+/**
+ * @brief           Adds a float field from a fixed-point value, e.g. 2345 with 2 decimals is written as 23.45.
+ *
+ * @param lp        The encoder.
+ * @param key       The field key.
+ * @param value     The fixed-point value.
+ * @param decimals  The number of decimal digits of the value.
+ */
+void lp_field_fixed(lp_t *lp, const char *key, int32_t value, uint32_t decimals)
+{
+  uint32_t scale = 1;
+  for (uint32_t i = 0; i < decimals; i++) {
+    scale *= 10;
+  }
+
+  lp_put_key(lp, key);
+
+  uint32_t magnitude = value < 0 ? -(uint32_t)value : (uint32_t)value;
+  if (value < 0) {
+    lp_put(lp, '-');
+  }
+
+  lp_put_digits(lp, magnitude / scale, 1);
+  if (decimals > 0) {
+    lp_put(lp, '.');
+    lp_put_digits(lp, magnitude % scale, decimals);
+  }
+}
+
+
+/**
+ * @brief           Adds an integer field.
+ *
+ * @param lp        The encoder.
+ * @param key       The field key.
+ * @param value     The value.
+ */
+void lp_field_int(lp_t *lp, const char *key, int32_t value)
+{
+  lp_put_key(lp, key);
+
+  if (value < 0) {
+    lp_put(lp, '-');
+  }
+  lp_put_digits(lp, value < 0 ? -(uint32_t)value : (uint32_t)value, 1);
+  lp_put(lp, 'i');
+}
+
+
+/**
+ * @brief           Adds the timestamp. It has to be added after all fields, in the precision of the write request.
+ *
+ * @param lp        The encoder.
+ * @param timestamp The timestamp.
+ */
+void lp_timestamp(lp_t *lp, uint64_t timestamp)
+{
+  lp_put(lp, ' ');
+  lp_put_digits(lp, timestamp, 1);
+}
+
+
+/**
+ * @brief           Finishes a point.
+ *
+ * @param lp        The encoder.
+ *
+ * @return          The length of the point, or 0 if it did not fit into the buffer.
+ */
+uint32_t lp_end(lp_t *lp)
+{
+  return lp->overflow ? 0 : lp->len;
+}
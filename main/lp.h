@@ -0,0 +1,53 @@
+/**
+ * @file    lp.h
+ *
+ * @brief   Line Protocol Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _LP_H_
+#define _LP_H_
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * @brief   Encodes one InfluxDB line protocol point into a caller supplied buffer.
+ *
+ * @remarks The point is written as measurement, tags and fields are added. Once anything does not fit, the encoder
+ *          stops writing and lp_end reports the overflow.
+ */
+typedef struct {
+  char *buf;
+  uint32_t size;
+  uint32_t len;
+  uint32_t fields;
+  bool overflow;
+} lp_t;
+
+
+void lp_begin(lp_t *lp, char *buf, uint32_t size, const char *measurement);
+
+
+void lp_tag(lp_t *lp, const char *key, const char *value);
+
+
+void lp_field_fixed(lp_t *lp, const char *key, int32_t value, uint32_t decimals);
+
+
+void lp_field_int(lp_t *lp, const char *key, int32_t value);
+
+
+void lp_timestamp(lp_t *lp, uint64_t timestamp);
+
+
+uint32_t lp_end(lp_t *lp);
+
+
+#endif /* _LP_H_ */
@@ -13,63 +13,110 @@
 #include "nvs_flash.h"
 
 #include "bme.h"
+#include "boot.h"
 #include "http.h"
 #include "i2c.h"
+#include "mem.h"
+#include "perf.h"
+#include "power.h"
+#include "sched.h"
+#include "serve.h"
 #include "wifi.h"
 
 
 #define MAIN_TAG                      "MAIN"
 
 
-static TaskHandle_t bme_task_handle = NULL;
+static TaskHandle_t sched_task_handle = NULL;
 static TaskHandle_t http_task_handle = NULL;
 static TaskHandle_t wifi_task_handle = NULL;
 
+#if MEM_STATIC
+// The stack depth of the IDF is in bytes. Only the tasks the configuration creates get one, see MEM_SUBSYSTEMS.
+#if MEM_SCHED_TASK
+static StackType_t sched_task_stack[SCHED_TASK_STACK_SIZE];
+static StaticTask_t sched_task_tcb;
+#endif
+#if MEM_HTTP_TASK
+static StackType_t http_task_stack[HTTP_TASK_STACK_SIZE];
+static StaticTask_t http_task_tcb;
+#endif
+static StackType_t wifi_task_stack[WIFI_TASK_STACK_SIZE];
+static StaticTask_t wifi_task_tcb;
+
+#define MAIN_TASK_MEMORY(task)        task##_task_stack, &task##_task_tcb
+#else
+#define MAIN_TASK_MEMORY(task)        NULL, NULL
+#endif
+
 
 void app_main(void)
 {
   esp_err_t esp_err = ESP_OK;
 
+  boot_init();
+  mem_init();
+
+#if POWER_MODE != POWER_MODE_DEEP_SLEEP
+  // Brings the network up and parses the CA certificates in the background, while the sensors are set up here. Each
+  // task waits for the stages it depends on.
+  wifi_task_handle = mem_task_create(wifi_task, WIFI_TASK_NAME, WIFI_TASK_STACK_SIZE, WIFI_TASK_PRIORITY,
+                                     MAIN_TASK_MEMORY(wifi));
+  perf_watch(wifi_task_handle);
+
+#if MEM_HTTP_TASK
+  http_task_handle = mem_task_create(http_task, HTTP_TASK_NAME, HTTP_TASK_STACK_SIZE, HTTP_TASK_PRIORITY,
+                                     MAIN_TASK_MEMORY(http));
+  perf_watch(http_task_handle);
+#endif
+#endif
+
   // Initializes the NVS. Required by the WIFI driver.
   esp_err = nvs_flash_init();
   if (esp_err != ESP_OK) {
     ESP_LOGE(MAIN_TAG, "NVS initial failed with code %x [%s]", esp_err, esp_err_to_name(esp_err));
     return;
   }
+  boot_ready(BOOT_STAGE_NVS);
 
-  // Creates the WIFI task.
-  xTaskCreate(wifi_task, WIFI_TASK_NAME, WIFI_TASK_STACK_SIZE, NULL, WIFI_TASK_PRIORITY, &wifi_task_handle);
+  power_init();
 
+  // Initializes the I2C master.
+  i2c_setup();
 
-  i2c_config_t i2c_config = {
-    .mode = I2C_MODE_MASTER,
-    .sda_io_num = I2C_SDA,
-    .sda_pullup_en = GPIO_PULLUP_ENABLE,
-    .scl_io_num = I2C_SCL,
-    .scl_pullup_en = GPIO_PULLUP_ENABLE,
-    .master.clk_speed = I2C_SPEED
-  };
-
-  esp_err = i2c_param_config(I2C_PORT, &i2c_config);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(I2C_TAG, "Configuration failed with code %x [%s]", esp_err, esp_err_to_name(esp_err));
-  }
-
-  esp_err = i2c_driver_install(I2C_PORT, i2c_config.mode, 0, 0, 0);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(I2C_TAG, "Driver initialization failed with code %x [%s]", esp_err, esp_err_to_name(esp_err));
+#if POWER_MODE == POWER_MODE_DEEP_SLEEP
+  // Takes one sample per boot and only brings the WIFI up when the kept samples are due to be sent.
+  if (power_sample()) {
+    wifi_task_handle = mem_task_create(wifi_task, WIFI_TASK_NAME, WIFI_TASK_STACK_SIZE, WIFI_TASK_PRIORITY,
+                                       MAIN_TASK_MEMORY(wifi));
+    http_task_handle = mem_task_create(http_task, HTTP_TASK_NAME, HTTP_TASK_STACK_SIZE, HTTP_TASK_PRIORITY,
+                                       MAIN_TASK_MEMORY(http));
+    power_flush();
   }
 
-  vTaskDelay(5000 / portTICK_PERIOD_MS);
-
-  // Creates the BME sensor task.
-  xTaskCreate(bme_task, BME_TASK_NAME, BME_TASK_STACK_SIZE, NULL, BME_TASK_PRIORITY, &bme_task_handle);
-
-  // Creates the HTTP task.
-  xTaskCreate(http_task, HTTP_TASK_NAME, HTTP_TASK_STACK_SIZE, NULL, HTTP_TASK_PRIORITY, &http_task_handle);
-
-  while (1) {
-    vTaskDelay(5000 / portTICK_PERIOD_MS);
-  }
+  power_sleep();
+#else
+  bme_init();
+  boot_ready(BOOT_STAGE_SENSOR);
+
+  // Sampling and uploading share the period grid, so each upload follows a sampling round. The first sample is taken
+  // right away and held by the HTTP task until it can be stamped.
+  sched_add_now("sample", bme_sample, BME_SAMPLING_PERIOD_MS, 0);
+#if SERVE_PUSH
+  sched_add("upload", http_kick, HTTP_UPLOAD_PERIOD_MS, HTTP_UPLOAD_PHASE_MS);
+#endif
+  sched_add("mem", mem_check, MEM_CHECK_PERIOD_MS, 0);
+
+  // Creates the scheduler task, which runs the jobs.
+  sched_task_handle = mem_task_create(sched_task, SCHED_TASK_NAME, SCHED_TASK_STACK_SIZE, SCHED_TASK_PRIORITY,
+                                      MAIN_TASK_MEMORY(sched));
+  perf_watch(sched_task_handle);
+
+#if SERVE_ACTIVE
+  boot_wait(BOOT_STAGE_NET, portMAX_DELAY);
+  serve_start();
+#endif
+
+  // Returning deletes the main task and frees its stack.
+#endif
 }
-
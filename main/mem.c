@@ -0,0 +1,298 @@
+/**
+ * @file    mem.c
+ *
+ * @brief   Mem Source File
+ *
+ * @remarks The budget is computed from the same configuration the modules size their buffers with, so it follows every
+ *          change to them. The IDF before v5 has no allocation hooks, so the calls to malloc, calloc and realloc of
+ *          the station are redirected here once compiled, see main/CMakeLists.txt, to flag the ones after the init by
+ *          their call site. The allocations of the IDF, the WIFI and lwIP are left to the levels of the heap, as they
+ *          come and go with the traffic. The heap guard also watches the low-water mark and the largest free block
+ *          against their levels at the end of the init, and counts the failed allocations.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "mem.h"
+
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_wifi.h"
+#include "freertos/event_groups.h"
+
+#include "agg.h"
+#include "batch.h"
+#include "bme.h"
+#include "boot.h"
+#include "gzip.h"
+#include "http.h"
+#include "i2c.h"
+#include "mqtt.h"
+#include "perf.h"
+#include "power.h"
+#include "report.h"
+#include "resp.h"
+#include "sched.h"
+#include "serve.h"
+#include "stats.h"
+#include "store.h"
+#include "tls.h"
+#include "udp.h"
+#include "wifi.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+
+#define MEM_SUBSYSTEMS(X) \
+  X("stack_wifi", MEM_STATIC ? WIFI_TASK_STACK_SIZE + sizeof(StaticTask_t) : 0) \
+  X("stack_http", MEM_STATIC && MEM_HTTP_TASK ? HTTP_TASK_STACK_SIZE + sizeof(StaticTask_t) : 0) \
+  X("stack_sched", MEM_STATIC && MEM_SCHED_TASK ? SCHED_TASK_STACK_SIZE + sizeof(StaticTask_t) : 0) \
+  X("http_queue", sizeof(ring_t) + HTTP_QUEUE_LENGTH * sizeof(sample_t)) \
+  X("http_batch", sizeof(batch_t) + BATCH_MAX_POINTS * (sizeof(sample_t) + sizeof(uint32_t))) \
+  X("http_backlog", HTTP_BACKLOG_POINTS * sizeof(sample_t)) \
+  X("http_response", HTTP_TRANSPORT == HTTP_TRANSPORT_HTTPS ? sizeof(resp_t) + HTTP_HEADER_SIZE + HTTP_READ_SIZE : 0) \
+  X("gzip", HTTP_GZIP && HTTP_TRANSPORT == HTTP_TRANSPORT_HTTPS ? \
+    BATCH_BUFFER_SIZE + (GZIP_WINDOW_SIZE + (1 << GZIP_HASH_BITS)) * sizeof(uint16_t) : 0) \
+  X("tls", HTTP_TRANSPORT == HTTP_TRANSPORT_HTTPS ? sizeof(esp_tls_client_session_t) : 0) \
+  X("udp", HTTP_TRANSPORT == HTTP_TRANSPORT_UDP ? UDP_DATAGRAM_SIZE : 0) \
+  X("mqtt", HTTP_TRANSPORT == HTTP_TRANSPORT_MQTT ? MQTT_INFLIGHT * sizeof(mqtt_inflight_t) : 0) \
+  X("agg", AGG_HISTORY_SIZE * sizeof(sample_t) + (AGG_ACTIVE ? BME_MAX_SENSORS * sizeof(agg_t) : 0)) \
+  X("serve", SERVE_ACTIVE ? AGG_HISTORY_SIZE * sizeof(sample_t) : 0) \
+  X("bme", BME_MAX_SENSORS * sizeof(bme_sensor_t)) \
+  X("boot", sizeof(StaticEventGroup_t) + BOOT_STAGE_MAX * sizeof(atomic_uint)) \
+  X("wifi", sizeof(StaticEventGroup_t) + sizeof(wifi_config_t) + sizeof(wifi_cache_t)) \
+  X("i2c", I2C_CMD_LINK_SIZE) \
+  X("store", STORE_APPEND_PAGES * STORE_PAGE_SIZE) \
+  X("perf", PERF_STAGE_MAX * sizeof(perf_hist_t) + PERF_MAX_TASKS * sizeof(TaskHandle_t)) \
+  X("stats", STATS_COUNTER_MAX * sizeof(atomic_uint)) \
+  X("sched", SCHED_MAX_JOBS * sizeof(sched_job_t)) \
+  X("mem", MEM_ALLOC_SITES * sizeof(mem_site_t))
+
+// What is kept in RTC memory through deep sleep.
+#define MEM_RTC_SUBSYSTEMS(X) \
+  X("rtc_power", POWER_RTC_SAMPLES * sizeof(sample_t) + sizeof(uint32_t) + sizeof(power_stats_t)) \
+  X("rtc_report", BME_MAX_SENSORS * sizeof(report_state_t)) \
+  X("rtc_tls", HTTP_TRANSPORT == HTTP_TRANSPORT_HTTPS ? TLS_SESSION_SIZE + sizeof(uint32_t) : 0)
+
+#define MEM_ENTRY(name, bytes)        { name, bytes },
+#define MEM_SUM(name, bytes)          + (bytes)
+
+/**
+ * @brief   A call site that allocated after the init.
+ */
+typedef struct {
+  _Atomic uintptr_t caller;
+  atomic_uint count;
+  atomic_uint bytes;
+  bool logged;
+} mem_site_t;
+
+_Static_assert(0 MEM_SUBSYSTEMS(MEM_SUM) <= MEM_BUDGET_BYTES, "The static RAM exceeds MEM_BUDGET_BYTES");
+_Static_assert(0 MEM_RTC_SUBSYSTEMS(MEM_SUM) <= MEM_RTC_BUDGET_BYTES, "The RTC memory exceeds MEM_RTC_BUDGET_BYTES");
+
+static const mem_budget_t mem_budgets[] = {
+  MEM_SUBSYSTEMS(MEM_ENTRY)
+};
+
+static const mem_budget_t mem_rtc_budgets[] = {
+  MEM_RTC_SUBSYSTEMS(MEM_ENTRY)
+};
+
+static bool mem_baseline;
+static uint32_t mem_heap_floor;
+static atomic_uint mem_failed_allocs;
+static atomic_uint mem_failed_bytes;
+static atomic_bool mem_sealed;
+static atomic_uint mem_allocs;
+static mem_site_t mem_sites[MEM_ALLOC_SITES];
+
+
+/**
+ * @brief           Counts an allocation once the station is up, against its call site. Lock-free, as it runs in the
+ *                  context of the allocating task.
+ *
+ * @param size      The requested size.
+ * @param caller    The return address into the allocating function.
+ */
+static IRAM_ATTR void mem_alloc_seen(size_t size, void *caller)
+{
+  if (!atomic_load_explicit(&mem_sealed, memory_order_relaxed)) {
+    return;
+  }
+
+  atomic_fetch_add_explicit(&mem_allocs, 1, memory_order_relaxed);
+
+  // Claims the first free slot for a new site. The sites beyond MEM_ALLOC_SITES are only counted.
+  for (uint32_t i = 0; i < MEM_ALLOC_SITES; i++) {
+    mem_site_t *site = &mem_sites[i];
+    uintptr_t expected = 0;
+    if (atomic_compare_exchange_strong(&site->caller, &expected, (uintptr_t)caller) || expected == (uintptr_t)caller) {
+      atomic_fetch_add_explicit(&site->count, 1, memory_order_relaxed);
+      atomic_fetch_add_explicit(&site->bytes, size, memory_order_relaxed);
+      return;
+    }
+  }
+}
+
+
+// The heap capabilities malloc, calloc and realloc take without PSRAM, as these replace them.
+IRAM_ATTR void *mem_malloc(size_t size)
+{
+  mem_alloc_seen(size, __builtin_return_address(0));
+
+  return heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+}
+
+
+IRAM_ATTR void *mem_calloc(size_t n, size_t size)
+{
+  mem_alloc_seen(n * size, __builtin_return_address(0));
+
+  return heap_caps_calloc(n, size, MALLOC_CAP_DEFAULT);
+}
+
+
+IRAM_ATTR void *mem_realloc(void *ptr, size_t size)
+{
+  mem_alloc_seen(size, __builtin_return_address(0));
+
+  return heap_caps_realloc(ptr, size, MALLOC_CAP_DEFAULT);
+}
+
+
+/**
+ * @brief           Counts a failed allocation. Called by the heap in the context of the allocating task.
+ *
+ * @param size      The requested size.
+ * @param caps      The requested capabilities.
+ * @param function  The allocating function.
+ */
+static void mem_alloc_failed(size_t size, uint32_t caps, const char *function)
+{
+  atomic_fetch_add_explicit(&mem_failed_allocs, 1, memory_order_relaxed);
+  atomic_store_explicit(&mem_failed_bytes, size, memory_order_relaxed);
+}
+
+
+/**
+ * @brief           Logs the static RAM of every subsystem against the budget.
+ */
+static void mem_report()
+{
+  uint32_t total = 0;
+
+  for (uint32_t i = 0; i < sizeof(mem_budgets) / sizeof(mem_budgets[0]); i++) {
+    ESP_LOGI(MEM_TAG, "subsystem=%s bytes=%u", mem_budgets[i].name, mem_budgets[i].bytes);
+    total += mem_budgets[i].bytes;
+  }
+
+  uint32_t rtc_total = 0;
+  for (uint32_t i = 0; i < sizeof(mem_rtc_budgets) / sizeof(mem_rtc_budgets[0]); i++) {
+    ESP_LOGI(MEM_TAG, "subsystem=%s bytes=%u", mem_rtc_budgets[i].name, mem_rtc_budgets[i].bytes);
+    rtc_total += mem_rtc_budgets[i].bytes;
+  }
+
+  ESP_LOGI(MEM_TAG, "static_bytes=%u budget_bytes=%u rtc_bytes=%u rtc_budget_bytes=%u heap_free=%u heap_min=%u "
+           "heap_largest=%u", total, MEM_BUDGET_BYTES, rtc_total, MEM_RTC_BUDGET_BYTES, esp_get_free_heap_size(),
+           esp_get_minimum_free_heap_size(), heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+}
+
+
+/**
+ * @brief           Registers the failed allocation counter and logs the memory budget. Call early in app_main.
+ */
+void mem_init()
+{
+  heap_caps_register_failed_alloc_callback(mem_alloc_failed);
+  mem_report();
+}
+
+
+/**
+ * @brief           Creates a task, on the given static stack in static memory mode.
+ *
+ * @param fn        The task function.
+ * @param name      The task name.
+ * @param stack_size The stack size in bytes.
+ * @param priority  The task priority.
+ * @param stack     The stack of stack_size bytes. Only used in static memory mode.
+ * @param tcb       The task control block. Only used in static memory mode.
+ *
+ * @return          The task, or NULL if it could not be created.
+ */
+TaskHandle_t mem_task_create(TaskFunction_t fn, const char *name, uint32_t stack_size, UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb)
+{
+#if MEM_STATIC
+  return xTaskCreateStatic(fn, name, stack_size, NULL, priority, stack, tcb);
+#else
+  TaskHandle_t task = NULL;
+  xTaskCreate(fn, name, stack_size, NULL, priority, &task);
+
+  return task;
+#endif
+}
+
+
+/**
+ * @brief           The heap guard job. Takes the heap levels once the first point is sent, and from then on flags the
+ *                  heap shrinking beyond MEM_HEAP_SLACK_BYTES, every failed allocation, every new call site that
+ *                  allocated and a fragmented heap. Scheduled every MEM_CHECK_PERIOD_MS.
+ */
+void mem_check()
+{
+  uint32_t heap_min = esp_get_minimum_free_heap_size();
+  uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+  if (!mem_baseline) {
+    if (boot_is_ready(BOOT_STAGE_UPLOAD)) {
+      mem_baseline = true;
+      mem_heap_floor = heap_min > MEM_HEAP_SLACK_BYTES ? heap_min - MEM_HEAP_SLACK_BYTES : 0;
+      atomic_store(&mem_sealed, true);
+      mem_report();
+    }
+    return;
+  }
+
+  uint32_t failed = atomic_exchange_explicit(&mem_failed_allocs, 0, memory_order_relaxed);
+  if (failed > 0) {
+    ESP_LOGE(MEM_TAG, "%u allocations failed, the last of %u bytes", failed,
+             atomic_load_explicit(&mem_failed_bytes, memory_order_relaxed));
+    stats_add(STATS_HEAP_ALERTS, failed);
+  }
+
+  uint32_t allocs = atomic_exchange_explicit(&mem_allocs, 0, memory_order_relaxed);
+  if (allocs > 0) {
+    stats_add(STATS_HEAP_ALLOCS, allocs);
+  }
+
+  // Each call site is flagged once, with the return address into it for addr2line.
+  for (uint32_t i = 0; i < MEM_ALLOC_SITES; i++) {
+    mem_site_t *site = &mem_sites[i];
+    uintptr_t caller = atomic_load(&site->caller);
+    if (caller != 0 && !site->logged) {
+      site->logged = true;
+      ESP_LOGW(MEM_TAG, "Allocation after the init from 0x%08x, %u calls and %u bytes so far", (uint32_t)caller,
+               atomic_load(&site->count), atomic_load(&site->bytes));
+      stats_inc(STATS_HEAP_ALERTS);
+    }
+  }
+
+  // Each new low is flagged once.
+  if (heap_min < mem_heap_floor) {
+    ESP_LOGW(MEM_TAG, "Heap fell %u bytes below its floor, heap_min=%u", mem_heap_floor - heap_min, heap_min);
+    mem_heap_floor = heap_min;
+    stats_inc(STATS_HEAP_ALERTS);
+  }
+
+  if (largest < MEM_MIN_BLOCK_BYTES) {
+    ESP_LOGW(MEM_TAG, "Heap fragmented, heap_largest=%u", largest);
+    stats_inc(STATS_HEAP_ALERTS);
+  }
+}
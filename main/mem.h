@@ -0,0 +1,68 @@
+/**
+ * @file    mem.h
+ *
+ * @brief   Mem Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MEM_H_
+#define _MEM_H_
+
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "power.h"
+#include "serve.h"
+
+#include <stdint.h>
+
+
+#define MEM_TAG                       "MEM "
+
+// Creates the tasks on static stacks, so that after the init the station itself takes nothing from the heap.
+#define MEM_STATIC                    (1)
+// The tasks the configuration creates, and so the stacks it needs. In deep sleep the samples are always pushed, as
+// there is nothing to serve them, and app_main takes them instead of the scheduler.
+#define MEM_HTTP_TASK                 (SERVE_PUSH || POWER_MODE == POWER_MODE_DEEP_SLEEP)
+#define MEM_SCHED_TASK                (POWER_MODE != POWER_MODE_DEEP_SLEEP)
+
+// The RAM the modules reserve statically may not exceed this, which is checked at compile time.
+#define MEM_BUDGET_BYTES              (64 * 1024)
+// The same for the RTC slow memory, which is kept through deep sleep. The ESP32 has 8 KB of it, part of which the IDF
+// takes for itself.
+#define MEM_RTC_BUDGET_BYTES          (4 * 1024)
+
+// Once the first point is sent, the heap may still shrink by this much for the WIFI, lwIP and TLS buffers of the IDF.
+// Anything beyond it, a failed allocation, or no block left for a TLS record, is flagged.
+#define MEM_HEAP_SLACK_BYTES          (16 * 1024)
+#define MEM_MIN_BLOCK_BYTES           (17 * 1024)
+#define MEM_CHECK_PERIOD_MS           (60000)
+// Once the first point is sent, every malloc, calloc and realloc of the station is counted, and each of the first call
+// sites is logged once. Only the calls of this component are redirected, see main/CMakeLists.txt, while the ones of the
+// IDF, the WIFI and lwIP are only seen by the heap levels.
+#define MEM_ALLOC_SITES               (16)
+
+/**
+ * @brief   The RAM a subsystem reserves statically.
+ */
+typedef struct {
+  const char *name;
+  uint32_t bytes;
+} mem_budget_t;
+
+
+void mem_init();
+
+
+TaskHandle_t mem_task_create(TaskFunction_t fn, const char *name, uint32_t stack_size, UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb);
+
+
+void mem_check();
+
+
+#endif /* _MEM_H_ */
@@ -0,0 +1,313 @@
+/**
+ * @file    mqtt.c
+ *
+ * @brief   MQTT Source File
+ *
+ * @remarks One session is kept for the whole uptime and is not cleaned on reconnection, so the broker and the client
+ *          resend what was in flight. A publish returns as soon as the client took it, and up to MQTT_INFLIGHT of
+ *          them are pipelined, so a batch costs no round trip and no headers beyond the fixed MQTT ones. The samples of
+ *          a publish are kept until the broker acknowledges it, and go to the store if the client gives up on it. The
+ *          store is only written from the HTTP task, which is the only publisher.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "mqtt.h"
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mqtt_client.h"
+
+#include "perf.h"
+#include "stats.h"
+#include "store.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+
+static esp_mqtt_client_handle_t mqtt_client;
+static atomic_bool mqtt_connected;
+static uint32_t mqtt_attempt_us;
+
+// The ids are written by the publisher and the client task, the samples only by the publisher.
+static mqtt_inflight_t mqtt_inflight[MQTT_INFLIGHT];
+// Acknowledgements that came in before their publish returned its id, matched by the publisher once it has it.
+static int mqtt_early_acks[MQTT_INFLIGHT];
+static uint32_t mqtt_early_ack_next;
+static portMUX_TYPE mqtt_inflight_lock = portMUX_INITIALIZER_UNLOCKED;
+
+
+/**
+ * @brief           Records how long a publish waited for its acknowledgement, and its samples for the broker. Must be
+ *                  called before the slot is freed, as its samples are overwritten afterwards.
+ *
+ * @param inflight  The slot of the publish.
+ */
+static void mqtt_record_acked(const mqtt_inflight_t *inflight)
+{
+  uint32_t now_us = perf_now_us();
+
+  perf_record(PERF_STAGE_POST, now_us - inflight->sent_us);
+  for (uint32_t i = 0; i < inflight->sample_count; i++) {
+    perf_record(PERF_STAGE_INGEST, now_us - inflight->samples[i].acquired_us);
+  }
+}
+
+
+/**
+ * @brief           Handles the MQTT client events.
+ *
+ * @param args      Unused.
+ * @param base      The event base.
+ * @param event_id  The event.
+ * @param event_data The event data.
+ */
+static void mqtt_event_handler(void *args, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+  esp_mqtt_event_handle_t event = event_data;
+
+  switch (event_id) {
+    case MQTT_EVENT_BEFORE_CONNECT:
+      mqtt_attempt_us = perf_now_us();
+      break;
+    case MQTT_EVENT_CONNECTED:
+      ESP_LOGI(MQTT_TAG, "Connected, session %s", event->session_present ? "resumed" : "new");
+      perf_record(PERF_STAGE_CONNECT, perf_now_us() - mqtt_attempt_us);
+      atomic_store(&mqtt_connected, true);
+      break;
+    case MQTT_EVENT_DISCONNECTED:
+      ESP_LOGW(MQTT_TAG, "Disconnected");
+      atomic_store(&mqtt_connected, false);
+      break;
+    case MQTT_EVENT_PUBLISHED: {
+      bool found = false;
+
+      portENTER_CRITICAL(&mqtt_inflight_lock);
+      for (uint32_t i = 0; i < MQTT_INFLIGHT && !found; i++) {
+        if (mqtt_inflight[i].msg_id == event->msg_id) {
+          found = true;
+          mqtt_record_acked(&mqtt_inflight[i]);
+          mqtt_inflight[i].msg_id = 0;
+        }
+      }
+      // The client may deliver the acknowledgement before esp_mqtt_client_publish returned its id.
+      if (!found) {
+        mqtt_early_acks[mqtt_early_ack_next] = event->msg_id;
+        mqtt_early_ack_next = (mqtt_early_ack_next + 1) % MQTT_INFLIGHT;
+      }
+      portEXIT_CRITICAL(&mqtt_inflight_lock);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+
+/**
+ * @brief           Stores the samples of the slots the client will not resend.
+ *
+ * @param slots     The slots, one bit each.
+ */
+static void mqtt_store_slots(uint32_t slots)
+{
+  for (uint32_t i = 0; i < MQTT_INFLIGHT; i++) {
+    if (slots & (1 << i)) {
+      for (uint32_t j = 0; j < mqtt_inflight[i].sample_count; j++) {
+        store_write(&mqtt_inflight[i].samples[j]);
+      }
+      mqtt_inflight[i].sample_count = 0;
+    }
+  }
+}
+
+
+/**
+ * @brief           Finds a free in-flight slot. Slots whose publish the client has given up on are freed first, and
+ *                  their samples stored.
+ *
+ * @return          The slot, or -1 if the window is full.
+ */
+static int mqtt_reserve()
+{
+  int slot = -1;
+  uint32_t now_us = perf_now_us();
+
+  uint32_t expired = 0;
+
+  portENTER_CRITICAL(&mqtt_inflight_lock);
+  for (int i = 0; i < MQTT_INFLIGHT; i++) {
+    if (mqtt_inflight[i].msg_id > 0 && now_us - mqtt_inflight[i].sent_us >= MQTT_OUTBOX_EXPIRED_TIMEOUT_MS * 1000) {
+      mqtt_inflight[i].msg_id = 0;
+      expired |= 1 << i;
+    }
+    if (mqtt_inflight[i].msg_id == 0 && slot < 0) {
+      slot = i;
+    }
+  }
+  portEXIT_CRITICAL(&mqtt_inflight_lock);
+
+  // A freed slot is only reused by this task, so its samples are still there.
+  if (expired != 0) {
+    stats_add(STATS_PUBLISHES_EXPIRED, __builtin_popcount(expired));
+    mqtt_store_slots(expired);
+  }
+
+  return slot;
+}
+
+
+/**
+ * @brief           Starts the MQTT client. It connects in the background and reconnects by itself. The broker is
+ *                  verified against the global CA store.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL
+ */
+esp_err_t mqtt_start()
+{
+  esp_mqtt_client_config_t mqtt_config = {
+    .uri = MQTT_URI,
+    .client_id = MQTT_CLIENT_ID,
+    .username = MQTT_USERNAME,
+    .password = MQTT_PASSWORD,
+    .keepalive = MQTT_KEEPALIVE_S,
+    .reconnect_timeout_ms = MQTT_RECONNECT_MS,
+    .disable_clean_session = true,
+    .use_global_ca_store = true,
+    .skip_cert_common_name_check = true
+  };
+
+  mqtt_client = esp_mqtt_client_init(&mqtt_config);
+  if (mqtt_client == NULL) {
+    ESP_LOGE(MQTT_TAG, "Client initialization failed");
+    return ESP_FAIL;
+  }
+
+  esp_mqtt_client_register_event(mqtt_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+
+  esp_err_t esp_err = esp_mqtt_client_start(mqtt_client);
+  if (esp_err != ESP_OK) {
+    ESP_LOGE(MQTT_TAG, "Start failed with error 0x%x", esp_err);
+  }
+
+  return esp_err;
+}
+
+
+/**
+ * @brief           Publishes a body to MQTT_TOPIC. Waits while the client connects or the in-flight window is full.
+ *
+ * @param data      The body.
+ * @param data_len  The body length.
+ * @param samples   The samples in the body, stored if the client gives up on it. Samples that are already in the store
+ *                  are not passed, they are only committed once acknowledged, see mqtt_wait_acked().
+ * @param sample_count The number of samples, up to BATCH_MAX_POINTS.
+ *
+ * @return        - ESP_OK if the client took the body, it is resent until the broker acknowledges it
+ *                - ESP_FAIL if the connection or the window was not there in time
+ */
+esp_err_t mqtt_publish(const char *data, uint32_t data_len, const sample_t *samples, uint32_t sample_count)
+{
+  int slot = -1;
+  uint32_t waited_ms = 0;
+
+  while ((!atomic_load(&mqtt_connected) || (slot = mqtt_reserve()) < 0) && waited_ms < MQTT_WINDOW_TIMEOUT_MS) {
+    vTaskDelay(MQTT_POLL_PERIOD_MS / portTICK_PERIOD_MS);
+    waited_ms += MQTT_POLL_PERIOD_MS;
+  }
+
+  if (slot < 0) {
+    return ESP_FAIL;
+  }
+
+  mqtt_inflight[slot].sample_count = sample_count;
+  memcpy(mqtt_inflight[slot].samples, samples, sample_count * sizeof(sample_t));
+
+  // The slot is claimed before the publish, as the acknowledgement may arrive before it returns.
+  portENTER_CRITICAL(&mqtt_inflight_lock);
+  mqtt_inflight[slot].msg_id = -1;
+  mqtt_inflight[slot].sent_us = perf_now_us();
+  portEXIT_CRITICAL(&mqtt_inflight_lock);
+
+  int msg_id = esp_mqtt_client_publish(mqtt_client, MQTT_TOPIC, data, data_len, MQTT_QOS, 0);
+
+  bool acked = false;
+  portENTER_CRITICAL(&mqtt_inflight_lock);
+  for (uint32_t i = 0; i < MQTT_INFLIGHT && msg_id > 0 && !acked; i++) {
+    if (mqtt_early_acks[i] == msg_id) {
+      mqtt_early_acks[i] = 0;
+      acked = true;
+    }
+  }
+  mqtt_inflight[slot].msg_id = msg_id > 0 && !acked ? msg_id : 0;
+  portEXIT_CRITICAL(&mqtt_inflight_lock);
+
+  // The slot is only reused by this task, so its samples are still there.
+  if (acked) {
+    mqtt_record_acked(&mqtt_inflight[slot]);
+  }
+
+  if (msg_id < 0) {
+    // The caller stores the samples of a failed publish.
+    mqtt_inflight[slot].sample_count = 0;
+    ESP_LOGE(MQTT_TAG, "Publish of %u bytes failed", data_len);
+    return ESP_FAIL;
+  }
+
+  return ESP_OK;
+}
+
+
+/**
+ * @brief           Waits until the broker acknowledged every publish, e.g. before powering down.
+ *
+ * @param timeout_ms The time to wait in milliseconds.
+ *
+ * @return        - true if nothing is in flight
+ *                - false on timeout
+ */
+bool mqtt_wait_acked(uint32_t timeout_ms)
+{
+  for (uint32_t waited_ms = 0; ; waited_ms += MQTT_POLL_PERIOD_MS) {
+    bool acked = true;
+
+    portENTER_CRITICAL(&mqtt_inflight_lock);
+    for (uint32_t i = 0; i < MQTT_INFLIGHT; i++) {
+      acked = acked && mqtt_inflight[i].msg_id == 0;
+    }
+    portEXIT_CRITICAL(&mqtt_inflight_lock);
+
+    if (acked || waited_ms >= timeout_ms) {
+      return acked;
+    }
+
+    vTaskDelay(MQTT_POLL_PERIOD_MS / portTICK_PERIOD_MS);
+  }
+}
+
+
+/**
+ * @brief           Stores the samples of every publish not yet acknowledged and gives up on them, e.g. before powering
+ *                  down. A publish that is acknowledged later is then sent twice, which the InfluxDB overwrites.
+ */
+void mqtt_store_unacked()
+{
+  uint32_t unacked = 0;
+
+  portENTER_CRITICAL(&mqtt_inflight_lock);
+  for (uint32_t i = 0; i < MQTT_INFLIGHT; i++) {
+    if (mqtt_inflight[i].msg_id != 0) {
+      mqtt_inflight[i].msg_id = 0;
+      unacked |= 1 << i;
+    }
+  }
+  portEXIT_CRITICAL(&mqtt_inflight_lock);
+
+  mqtt_store_slots(unacked);
+}
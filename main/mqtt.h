@@ -0,0 +1,77 @@
+/**
+ * @file    mqtt.h
+ *
+ * @brief   MQTT Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MQTT_H_
+#define _MQTT_H_
+
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#include "batch.h"
+#include "sample.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#define MQTT_TAG                      "MQTT"
+
+// The broker CA goes into influxdb.pem next to the InfluxDB one. The batches are published in line protocol, e.g. for
+// a Telegraf mqtt_consumer with data_format = "influx", stamped in nanoseconds as it expects, see HTTP_PRECISION.
+#define MQTT_URI                      "mqtts://<Your Broker Address>:8883"
+#define MQTT_USERNAME                 "<Your Broker Username>"
+#define MQTT_PASSWORD                 "<Your Broker Password>"
+#define MQTT_CLIENT_ID                "ws-home"
+#define MQTT_TOPIC                    "ws/home"
+#define MQTT_QOS                      (1)
+#define MQTT_KEEPALIVE_S              (120)
+// The client connects as soon as it is started, which is before the station has an IP, and tries again after this
+// long. The default of the client is 10 s.
+#define MQTT_RECONNECT_MS             (2000)
+
+// Publishes not yet acknowledged by the broker. A full window makes the next publish wait for an acknowledgement, as
+// does a connection that is not up yet.
+#define MQTT_INFLIGHT                 (4)
+#define MQTT_WINDOW_TIMEOUT_MS        (10000)
+// The client drops an unacknowledged publish from its outbox after this long, so its samples go to the store and its
+// slot is freed too. Set with CONFIG_MQTT_USE_CUSTOM_CONFIG, otherwise the default of the client.
+#ifdef CONFIG_MQTT_OUTBOX_EXPIRED_TIMEOUT_MS
+#define MQTT_OUTBOX_EXPIRED_TIMEOUT_MS (CONFIG_MQTT_OUTBOX_EXPIRED_TIMEOUT_MS)
+#else
+#define MQTT_OUTBOX_EXPIRED_TIMEOUT_MS (30000)
+#endif
+#define MQTT_POLL_PERIOD_MS           (10)
+
+/**
+ * @brief   A publish waiting for its acknowledgement, with the samples it carries until then.
+ */
+typedef struct {
+  int msg_id;
+  uint32_t sent_us;
+  uint32_t sample_count;
+  sample_t samples[BATCH_MAX_POINTS];
+} mqtt_inflight_t;
+
+
+esp_err_t mqtt_start();
+
+
+esp_err_t mqtt_publish(const char *data, uint32_t data_len, const sample_t *samples, uint32_t sample_count);
+
+
+bool mqtt_wait_acked(uint32_t timeout_ms);
+
+
+void mqtt_store_unacked();
+
+
+#endif /* _MQTT_H_ */
@@ -0,0 +1,203 @@
+/**
+ * @file    perf.c
+ *
+ * @brief   Perf Source File
+ *
+ * @remarks Every stage is recorded by a single task, the acquisition by the sensor task and the rest by the HTTP task,
+ *          so the histograms need no locking. The report is one line per stage and one summary line of key=value
+ *          pairs in a fixed order, so that the logs of two builds can be diffed.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "perf.h"
+
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+
+static const char *perf_stage_names[PERF_STAGE_MAX] = {
+  "acquire", "queue", "batch", "connect", "resume", "post", "ingest", "serve", "wifi"
+};
+
+static perf_hist_t perf_hists[PERF_STAGE_MAX];
+static TaskHandle_t perf_tasks[PERF_MAX_TASKS];
+static uint32_t perf_task_count;
+static int64_t perf_report_us;
+
+
+/**
+ * @brief           Maps a latency to its histogram bucket.
+ */
+static uint32_t perf_bucket(uint32_t latency_us)
+{
+  if (latency_us < (1 << PERF_SUB_BITS)) {
+    return latency_us;
+  }
+
+  uint32_t msb = 31 - __builtin_clz(latency_us);
+  uint32_t sub = (latency_us >> (msb - PERF_SUB_BITS)) & ((1 << PERF_SUB_BITS) - 1);
+
+  return (1 << PERF_SUB_BITS) + ((msb - PERF_SUB_BITS) << PERF_SUB_BITS) + sub;
+}
+
+
+/**
+ * @brief           Gets the largest latency that falls into a bucket.
+ */
+static uint32_t perf_bucket_max(uint32_t bucket)
+{
+  if (bucket < (1 << PERF_SUB_BITS)) {
+    return bucket;
+  }
+
+  uint32_t msb = ((bucket - (1 << PERF_SUB_BITS)) >> PERF_SUB_BITS) + PERF_SUB_BITS;
+  uint32_t sub = bucket & ((1 << PERF_SUB_BITS) - 1);
+
+  return (((uint64_t)(1 << PERF_SUB_BITS) + sub + 1) << (msb - PERF_SUB_BITS)) - 1;
+}
+
+
+/**
+ * @brief           Gets a percentile of a histogram, capped to the largest latency recorded.
+ */
+static uint32_t perf_hist_percentile(const perf_hist_t *hist, uint32_t percent)
+{
+  uint32_t rank = (hist->count * percent + 99) / 100;
+  uint32_t seen = 0;
+
+  for (uint32_t bucket = 0; bucket < PERF_BUCKETS; bucket++) {
+    seen += hist->buckets[bucket];
+    if (seen >= rank && seen > 0) {
+      uint32_t latency_us = perf_bucket_max(bucket);
+      return latency_us < hist->max_us ? latency_us : hist->max_us;
+    }
+  }
+
+  return hist->max_us;
+}
+
+
+/**
+ * @brief           Gets a timestamp for measuring latencies. It wraps every 71 minutes, which the unsigned differences
+ *                  handle.
+ *
+ * @return          The microseconds since boot.
+ */
+uint32_t perf_now_us()
+{
+  return (uint32_t)esp_timer_get_time();
+}
+
+
+/**
+ * @brief           Records the latency of one stage.
+ *
+ * @param stage     The stage.
+ * @param latency_us  The latency in microseconds.
+ */
+void perf_record(perf_stage_en stage, uint32_t latency_us)
+{
+  perf_hist_t *hist = &perf_hists[stage];
+
+  hist->count++;
+  hist->total_us += latency_us;
+  if (latency_us > hist->max_us) {
+    hist->max_us = latency_us;
+  }
+  hist->buckets[perf_bucket(latency_us)]++;
+}
+
+
+/**
+ * @brief           Gets a latency percentile of a stage.
+ *
+ * @param stage     The stage.
+ * @param percent   The percentile.
+ *
+ * @return          The latency in microseconds, or 0 if nothing was recorded.
+ */
+uint32_t perf_percentile(perf_stage_en stage, uint32_t percent)
+{
+  return perf_hist_percentile(&perf_hists[stage], percent);
+}
+
+
+/**
+ * @brief           Gets the stack high-water mark of a watched task.
+ *
+ * @param index     The index of the task in the order it was watched.
+ * @param name      The task name.
+ * @param stack_min The minimum free stack ever, in bytes.
+ *
+ * @return        - true if the task exists
+ *                - false otherwise
+ */
+bool perf_get_task(uint32_t index, const char **name, uint32_t *stack_min)
+{
+  if (index >= perf_task_count) {
+    return false;
+  }
+
+  *name = pcTaskGetTaskName(perf_tasks[index]);
+  *stack_min = uxTaskGetStackHighWaterMark(perf_tasks[index]);
+
+  return true;
+}
+
+
+/**
+ * @brief           Adds a task to the stack high-water marks of the report.
+ *
+ * @param task      The task.
+ */
+void perf_watch(TaskHandle_t task)
+{
+  if (task != NULL && perf_task_count < PERF_MAX_TASKS) {
+    perf_tasks[perf_task_count++] = task;
+  }
+}
+
+
+/**
+ * @brief           Logs the report every PERF_REPORT_PERIOD_MS. Must be called by the HTTP task.
+ */
+void perf_poll()
+{
+  if (esp_timer_get_time() - perf_report_us >= PERF_REPORT_PERIOD_MS * 1000LL) {
+    perf_report();
+  }
+}
+
+
+/**
+ * @brief           Logs the latency percentiles of every stage, the sustained throughput and the memory high-water
+ *                  marks since boot. Must be called by the HTTP task.
+ */
+void perf_report()
+{
+  int64_t now_us = esp_timer_get_time();
+  perf_report_us = now_us;
+
+  for (uint32_t stage = 0; stage < PERF_STAGE_MAX; stage++) {
+    const perf_hist_t *hist = &perf_hists[stage];
+    ESP_LOGI(PERF_TAG, "stage=%s n=%u mean_us=%u p50_us=%u p90_us=%u p99_us=%u max_us=%u", perf_stage_names[stage],
+             hist->count, hist->count ? (uint32_t)(hist->total_us / hist->count) : 0, perf_hist_percentile(hist, 50),
+             perf_hist_percentile(hist, 90), perf_hist_percentile(hist, 99), hist->max_us);
+  }
+
+  // The points per hour keep the integer output meaningful at low sampling rates.
+  uint32_t points = perf_hists[PERF_STAGE_INGEST].count;
+  ESP_LOGI(PERF_TAG, "points=%u points_per_h=%u heap_free=%u heap_min=%u", points,
+           now_us > 0 ? (uint32_t)(points * 3600000000LL / now_us) : 0, esp_get_free_heap_size(),
+           esp_get_minimum_free_heap_size());
+
+  for (uint32_t i = 0; i < perf_task_count; i++) {
+    ESP_LOGI(PERF_TAG, "task=%s stack_min=%u", pcTaskGetTaskName(perf_tasks[i]),
+             uxTaskGetStackHighWaterMark(perf_tasks[i]));
+  }
+}
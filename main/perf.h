@@ -0,0 +1,80 @@
+/**
+ * @file    perf.h
+ *
+ * @brief   Perf Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _PERF_H_
+#define _PERF_H_
+
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#define PERF_TAG                      "PERF"
+
+#define PERF_REPORT_PERIOD_MS         (300000)
+#define PERF_MAX_TASKS                (4)
+
+// Values below 2^PERF_SUB_BITS microseconds get a bucket each, larger ones 2^PERF_SUB_BITS buckets per power of two.
+#define PERF_SUB_BITS                 (2)
+#define PERF_BUCKETS                  ((32 - PERF_SUB_BITS + 1) << PERF_SUB_BITS)
+
+/**
+ * @brief   The stages a sample goes through from the sensor to the InfluxDB.
+ */
+typedef enum {
+  PERF_STAGE_ACQUIRE,                 // measurement, from triggering the sensor to the compensated data
+  PERF_STAGE_QUEUE,                   // from the acquisition until the HTTP task dequeues the sample
+  PERF_STAGE_BATCH,                   // from the dequeue until the batch is posted
+  PERF_STAGE_CONNECT,                 // TCP and full TLS handshake, when a post has to connect
+  PERF_STAGE_RESUME,                  // TCP and abbreviated TLS handshake, resuming the saved session
+  PERF_STAGE_POST,                    // one request, from sending the body to the response
+  PERF_STAGE_INGEST,                  // end to end, from the acquisition until the server accepted the point
+  PERF_STAGE_SERVE,                   // one scrape of the local HTTP server, from the request to the last chunk
+  PERF_STAGE_WIFI,                    // from the boot or a disconnection until the station has an IP again
+  PERF_STAGE_MAX
+} perf_stage_en;
+
+/**
+ * @brief   A latency histogram with logarithmic buckets, so that percentiles are within 1/2^PERF_SUB_BITS.
+ */
+typedef struct {
+  uint32_t count;
+  uint32_t max_us;
+  uint64_t total_us;
+  uint32_t buckets[PERF_BUCKETS];
+} perf_hist_t;
+
+
+uint32_t perf_now_us();
+
+
+void perf_record(perf_stage_en stage, uint32_t latency_us);
+
+
+uint32_t perf_percentile(perf_stage_en stage, uint32_t percent);
+
+
+void perf_watch(TaskHandle_t task);
+
+
+bool perf_get_task(uint32_t index, const char **name, uint32_t *stack_min);
+
+
+void perf_poll();
+
+
+void perf_report();
+
+
+#endif /* _PERF_H_ */
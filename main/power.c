@@ -0,0 +1,203 @@
+/**
+ * @file    power.c
+ *
+ * @brief   Power Source File
+ *
+ * @remarks In deep sleep mode the station boots once per sample. The samples are kept in RTC memory, which survives
+ *          deep sleep, and every POWER_FLUSH_SAMPLES samples the WIFI and HTTP tasks are started to send them. The
+ *          time spent in each state of a wake-up is accumulated, so that the time awake per sample can be measured.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "power.h"
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+
+#include "bme.h"
+#include "clock.h"
+#include "http.h"
+#include "perf.h"
+#include "report.h"
+
+#include <string.h>
+
+_Static_assert(POWER_RTC_SAMPLES <= HTTP_QUEUE_LENGTH, "A flush of the RTC samples must fit in the HTTP queue");
+
+
+static RTC_DATA_ATTR sample_t power_samples[POWER_RTC_SAMPLES];
+static RTC_DATA_ATTR uint32_t power_sample_count;
+static RTC_DATA_ATTR power_stats_t power_stats;
+
+static power_state_en power_state;
+static int64_t power_state_since_us;
+static uint64_t power_wake_us[POWER_STATE_MAX];
+
+
+/**
+ * @brief           Initializes the power management of the selected mode. Must be called first thing after boot.
+ */
+void power_init()
+{
+  power_stats.wakes++;
+  power_state = POWER_STATE_BOOT;
+  power_state_since_us = 0;
+
+#if POWER_MODE == POWER_MODE_LIGHT_SLEEP
+  esp_pm_config_esp32_t pm_config = {
+    .max_freq_mhz = POWER_CPU_MAX_MHZ,
+    .min_freq_mhz = POWER_CPU_MIN_MHZ,
+    .light_sleep_enable = true
+  };
+
+  esp_err_t esp_err = esp_pm_configure(&pm_config);
+  if (esp_err != ESP_OK) {
+    ESP_LOGE(POWER_TAG, "Power management configuration failed with error 0x%x", esp_err);
+  }
+#endif
+}
+
+
+/**
+ * @brief           Marks the start of a new state in the timeline of the current wake-up.
+ *
+ * @param state     The new state.
+ */
+void power_mark(power_state_en state)
+{
+  int64_t now_us = esp_timer_get_time();
+
+  power_wake_us[power_state] += now_us - power_state_since_us;
+  power_stats.state_us[power_state] += now_us - power_state_since_us;
+
+  power_state = state;
+  power_state_since_us = now_us;
+}
+
+
+/**
+ * @brief           Takes a sample and keeps it in RTC memory.
+ *
+ * @return        - true if the samples should be flushed during this wake-up
+ *                - false otherwise
+ */
+bool power_sample()
+{
+  power_mark(POWER_STATE_SENSE);
+
+  // Stamps counted from an earlier boot can no longer be rebased.
+  for (uint32_t i = 0; i < power_sample_count; i++) {
+    if (power_samples[i].timestamp < CLOCK_EPOCH_MIN_MS) {
+      power_samples[i].timestamp = CLOCK_UNKNOWN;
+    }
+  }
+
+  sample_t samples[BME_MAX_SENSORS];
+  uint32_t sensors = bme_init();
+  uint32_t count = bme_measure(samples);
+
+  if (power_sample_count + count > POWER_RTC_SAMPLES) {
+    uint32_t dropped = power_sample_count + count - POWER_RTC_SAMPLES;
+    ESP_LOGW(POWER_TAG, "RTC buffer full, %u oldest samples dropped", dropped);
+    memmove(&power_samples[0], &power_samples[dropped], (power_sample_count - dropped) * sizeof(sample_t));
+    power_sample_count -= dropped;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (report_filter(&samples[i])) {
+      power_samples[power_sample_count++] = samples[i];
+      report_commit(&samples[i]);
+    }
+  }
+  power_stats.samples += count;
+
+  // A cold boot connects right away, so that the clock is synchronized before the samples pile up.
+  return esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER || power_sample_count >= POWER_FLUSH_SAMPLES * sensors;
+}
+
+
+/**
+ * @brief           Hands the samples kept in RTC memory to the HTTP task and waits until they are sent or stored in
+ *                  flash. The WIFI and HTTP tasks must already be started.
+ */
+void power_flush()
+{
+  power_mark(POWER_STATE_CONNECT);
+
+  if (!clock_wait_sync(POWER_CONNECT_TIMEOUT_MS)) {
+    ESP_LOGW(POWER_TAG, "No time synchronization, sending anyway");
+  }
+
+  power_mark(POWER_STATE_SEND);
+
+  // The time the samples spent in RTC memory is in the power timeline, not in the queue latency.
+  uint32_t queued = 0;
+  while (queued < power_sample_count) {
+    power_samples[queued].acquired_us = perf_now_us();
+    if (http_send(&power_samples[queued]) != HTTP_DATA_OK) {
+      break;
+    }
+    queued++;
+  }
+
+  if (queued < power_sample_count) {
+    ESP_LOGW(POWER_TAG, "HTTP queue full, keeping %u samples for the next flush", power_sample_count - queued);
+  }
+
+  // On a timeout the samples are kept and sent again with the next flush.
+  esp_err_t esp_err = http_flush(POWER_FLUSH_TIMEOUT_MS);
+  if (esp_err == ESP_ERR_TIMEOUT) {
+    ESP_LOGW(POWER_TAG, "Flush timed out");
+    return;
+  }
+
+  memmove(&power_samples[0], &power_samples[queued], (power_sample_count - queued) * sizeof(sample_t));
+  power_sample_count -= queued;
+}
+
+
+/**
+ * @brief           Logs the timeline of the current wake-up and enters deep sleep until the next sample is due.
+ */
+void power_sleep()
+{
+  power_mark(POWER_STATE_SLEEP);
+
+  int64_t awake_us = esp_timer_get_time();
+  power_stats.awake_us += awake_us;
+
+  ESP_LOGI(POWER_TAG, "wake=%u samples=%u boot_us=%llu sense_us=%llu connect_us=%llu send_us=%llu awake_us=%lld "
+           "awake_per_sample_us=%llu", power_stats.wakes, power_stats.samples, power_wake_us[POWER_STATE_BOOT],
+           power_wake_us[POWER_STATE_SENSE], power_wake_us[POWER_STATE_CONNECT], power_wake_us[POWER_STATE_SEND],
+           awake_us, power_stats.samples > 0 ? power_stats.awake_us / power_stats.samples : 0);
+
+  // Fails harmlessly if the WIFI was not started during this wake-up.
+  esp_wifi_stop();
+
+  int64_t sleep_us = (int64_t)BME_SAMPLING_PERIOD_MS * 1000 - awake_us;
+  if (sleep_us < 0) {
+    sleep_us = 0;
+  }
+
+  esp_sleep_enable_timer_wakeup(sleep_us);
+  esp_deep_sleep_start();
+}
+
+
+/**
+ * @brief           Copies the accumulated power statistics.
+ *
+ * @param stats     The statistics destination.
+ */
+void power_get_stats(power_stats_t *stats)
+{
+  *stats = power_stats;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file    power.h
+ *
+ * @brief   Power Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _POWER_H_
+#define _POWER_H_
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#define POWER_TAG                     "POWR"
+
+// The power modes. In continuous mode the radio stays associated and the CPU runs at full speed. In light sleep mode
+// the CPU scales down and sleeps whenever the tasks are idle, and the radio wakes up only for the AP beacons. In deep
+// sleep mode the chip is off between the samples, which are kept in RTC memory, and the radio is only brought up every
+// POWER_FLUSH_SAMPLES samples of every sensor to send them.
+#define POWER_MODE_CONTINUOUS         (0)
+#define POWER_MODE_LIGHT_SLEEP        (1)
+#define POWER_MODE_DEEP_SLEEP         (2)
+#define POWER_MODE                    (POWER_MODE_CONTINUOUS)
+
+#define POWER_CPU_MAX_MHZ             (160)
+#define POWER_CPU_MIN_MHZ             (40)
+#define POWER_LISTEN_INTERVAL         (10)
+
+// Checked against HTTP_QUEUE_LENGTH in power.c, so that a flush fits in the queue.
+#define POWER_RTC_SAMPLES             (48)
+#define POWER_FLUSH_SAMPLES           (6)
+#define POWER_CONNECT_TIMEOUT_MS      (15000)
+#define POWER_FLUSH_TIMEOUT_MS        (30000)
+
+typedef enum {
+  POWER_STATE_BOOT,
+  POWER_STATE_SENSE,
+  POWER_STATE_CONNECT,
+  POWER_STATE_SEND,
+  POWER_STATE_SLEEP,
+  POWER_STATE_MAX
+} power_state_en;
+
+/**
+ * @brief   The time spent awake in each state, accumulated over all the wake-ups since power on.
+ */
+typedef struct {
+  uint32_t wakes;
+  uint32_t samples;
+  uint64_t state_us[POWER_STATE_MAX];
+  uint64_t awake_us;
+} power_stats_t;
+
+
+void power_init();
+
+
+void power_mark(power_state_en state);
+
+
+bool power_sample();
+
+
+void power_flush();
+
+
+void power_sleep();
+
+
+void power_get_stats(power_stats_t *stats);
+
+
+#endif /* _POWER_H_ */
@@ -0,0 +1,101 @@
+/**
+ * @file    report.c
+ *
+ * @brief   Report Source File
+ *
+ * @remarks The heartbeat is counted in samples rather than in time, so that it keeps working across deep sleep, where
+ *          the state is kept in RTC memory like the samples themselves.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "report.h"
+
+#include "esp_attr.h"
+
+#include "stats.h"
+
+#include <stdlib.h>
+
+
+static RTC_DATA_ATTR report_state_t report_states[BME_MAX_SENSORS];
+
+
+/**
+ * @brief           Checks if a value moved out of its band around the last sent value.
+ *
+ * @param value     The value.
+ * @param last      The last sent value.
+ * @param abs_band  The absolute band.
+ * @param ppm_band  The relative band in parts per million.
+ *
+ * @return        - true if the value is out of its band
+ *                - false otherwise
+ */
+static bool report_out_of_band(int64_t value, int64_t last, int64_t abs_band, int64_t ppm_band)
+{
+  int64_t delta = llabs(value - last);
+  int64_t band = llabs(last) * ppm_band / 1000000;
+
+  return delta > (band > abs_band ? band : abs_band);
+}
+
+
+/**
+ * @brief           Decides if a sample should be sent. Counts the suppressed samples.
+ *
+ * @remarks         The sample only becomes the last sent one with report_commit, so that a sample that could not be
+ *                  handed over is not taken for one the server holds.
+ *
+ * @param sample    The sample.
+ *
+ * @return        - true if the sample should be sent
+ *                - false if the server can hold the last sent one instead
+ */
+bool report_filter(const sample_t *sample)
+{
+  if (!REPORT_ACTIVE || sample->sensor >= BME_MAX_SENSORS) {
+    return true;
+  }
+
+  report_state_t *state = &report_states[sample->sensor];
+
+  bool send = !state->valid || ++state->silent >= REPORT_HEARTBEAT_SAMPLES ||
+    report_out_of_band(sample->temperature, state->temperature, REPORT_TEMPERATURE_ABS, REPORT_TEMPERATURE_PPM) ||
+    report_out_of_band(sample->pressure, state->pressure, REPORT_PRESSURE_ABS, REPORT_PRESSURE_PPM) ||
+    report_out_of_band(sample->humidity, state->humidity, REPORT_HUMIDITY_ABS, REPORT_HUMIDITY_PPM);
+
+  if (!send) {
+    stats_inc(STATS_POINTS_SUPPRESSED);
+  }
+
+  return send;
+}
+
+
+/**
+ * @brief           Remembers a sample as the last sent one of its sensor. Counts the sent samples.
+ *
+ * @remarks         To be called once the sample is queued for the server. From there on it is either acknowledged or
+ *                  kept in the store until it is, so the server ends up holding it.
+ *
+ * @param sample    The sample that passed report_filter.
+ */
+void report_commit(const sample_t *sample)
+{
+  if (!REPORT_ACTIVE || sample->sensor >= BME_MAX_SENSORS) {
+    return;
+  }
+
+  report_state_t *state = &report_states[sample->sensor];
+
+  state->valid = true;
+  state->silent = 0;
+  state->temperature = sample->temperature;
+  state->pressure = sample->pressure;
+  state->humidity = sample->humidity;
+  stats_inc(STATS_POINTS_EMITTED);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file    report.h
+ *
+ * @brief   Report Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _REPORT_H_
+#define _REPORT_H_
+
+
+#include "agg.h"
+#include "bme.h"
+#include "sample.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+// Sends a sample only when one of its quantities moved out of its band around the last sent value, or when nothing was
+// sent for REPORT_HEARTBEAT_MS. Holding the last sent value on the server is then within the band of every sample.
+// Not used while aggregating, as the windows need every sample. Off by default, as the server then has gaps to fill.
+#define REPORT_ENABLE                 (0)
+#define REPORT_ACTIVE                 (REPORT_ENABLE && !AGG_ACTIVE)
+#define REPORT_HEARTBEAT_MS           (900000)
+#define REPORT_HEARTBEAT_SAMPLES      (REPORT_HEARTBEAT_MS / BME_SAMPLING_PERIOD_MS)
+
+// The band of a quantity is the larger of its absolute band, in the units of sample_t, and its relative band, in parts
+// per million of the last sent value.
+#define REPORT_TEMPERATURE_ABS        (10)
+#define REPORT_TEMPERATURE_PPM        (0)
+#define REPORT_PRESSURE_ABS           (10)
+#define REPORT_PRESSURE_PPM           (0)
+#define REPORT_HUMIDITY_ABS           (500)
+#define REPORT_HUMIDITY_PPM           (10000)
+
+/**
+ * @brief   The last sent sample of a sensor.
+ */
+typedef struct {
+  bool valid;
+  uint32_t silent;
+  int32_t temperature;
+  uint32_t pressure;
+  uint32_t humidity;
+} report_state_t;
+
+
+bool report_filter(const sample_t *sample);
+
+
+void report_commit(const sample_t *sample);
+
+
+#endif /* _REPORT_H_ */
@@ -0,0 +1,357 @@
+/**
+ * @file    resp.c
+ *
+ * @brief   Response Source File
+ *
+ * @remarks InfluxDB v1 answers a rejected write with {"error":"..."} and v2 with {"code":"...","message":"..."}. A
+ *          partial write names the first bad point and ends with dropped=N on v1. Both frame the body with a
+ *          Content-Length, but a proxy in front of them may send it chunked or until it closes the connection.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "resp.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+
+#define RESP_STATE_OUTSIDE            (0)
+#define RESP_STATE_KEY                (1)
+#define RESP_STATE_STRING             (2)
+
+#define RESP_FRAME_STATUS             (0)
+#define RESP_FRAME_HEADER             (1)
+#define RESP_FRAME_BODY               (2)
+#define RESP_FRAME_CHUNK_SIZE         (3)
+#define RESP_FRAME_CHUNK              (4)
+#define RESP_FRAME_CHUNK_END          (5)
+#define RESP_FRAME_TRAILER            (6)
+#define RESP_FRAME_UNTIL_CLOSE        (7)
+#define RESP_FRAME_DONE               (8)
+
+
+/**
+ * @brief           Advances the match of a pattern by one character.
+ *
+ * @return          True once the whole pattern matched.
+ */
+static bool resp_match(const char *pattern, uint8_t *matched, char c)
+{
+  if (c == pattern[*matched]) {
+    (*matched)++;
+    if (pattern[*matched] == '\0') {
+      *matched = 0;
+      return true;
+    }
+    return false;
+  }
+
+  *matched = c == pattern[0] ? 1 : 0;
+  return false;
+}
+
+
+/**
+ * @brief           Scans one character of the error message.
+ */
+static void resp_scan(resp_t *resp, char c)
+{
+  if (resp->message_len < sizeof(resp->message) - 1) {
+    resp->message[resp->message_len++] = c;
+  }
+
+  if (resp->dropped_digits) {
+    if (c >= '0' && c <= '9') {
+      resp->dropped = 10 * resp->dropped + (c - '0');
+      return;
+    }
+    resp->dropped_digits = false;
+  }
+
+  if (resp_match("partial write", &resp->partial_matched, c)) {
+    resp->partial = true;
+  }
+
+  if (resp_match("dropped=", &resp->dropped_matched, c)) {
+    resp->dropped_digits = true;
+    resp->dropped = 0;
+  }
+}
+
+
+/**
+ * @brief           Resets the parser for a new response.
+ *
+ * @param resp      The parser.
+ */
+void resp_reset(resp_t *resp)
+{
+  memset(resp, 0, sizeof(*resp));
+}
+
+
+/**
+ * @brief           Feeds the parser the next part of the response body, see resp_read() for the whole response.
+ *
+ * @param resp      The parser.
+ * @param data      The part of the body.
+ * @param len       The part length.
+ */
+void resp_feed(resp_t *resp, const char *data, uint32_t len)
+{
+  for (uint32_t i = 0; i < len; i++) {
+    char c = data[i];
+
+    if (resp->state == RESP_STATE_OUTSIDE) {
+      if (c == '"') {
+        if (resp->value) {
+          resp->state = RESP_STATE_STRING;
+          resp->capture = strcmp(resp->key, "error") == 0 || strcmp(resp->key, "message") == 0;
+        } else {
+          resp->state = RESP_STATE_KEY;
+          resp->key_len = 0;
+        }
+      } else if (c == ':') {
+        resp->value = true;
+      } else if (c == ',' || c == '{') {
+        resp->value = false;
+      }
+      continue;
+    }
+
+    if (!resp->escape && c == '\\') {
+      resp->escape = true;
+      continue;
+    }
+
+    if (!resp->escape && c == '"') {
+      if (resp->state == RESP_STATE_KEY) {
+        // A key too long to keep matches nothing.
+        resp->key[resp->key_len < sizeof(resp->key) ? resp->key_len : 0] = '\0';
+      }
+      resp->state = RESP_STATE_OUTSIDE;
+      resp->value = false;
+      resp->capture = false;
+      continue;
+    }
+
+    // An escaped character is kept as its letter, which is enough for the log and the scan.
+    resp->escape = false;
+
+    if (resp->state == RESP_STATE_KEY) {
+      if (resp->key_len < sizeof(resp->key)) {
+        resp->key[resp->key_len++] = c;
+      }
+    } else if (resp->capture) {
+      resp_scan(resp, c);
+    }
+  }
+}
+
+
+/**
+ * @brief           Checks whether a header line is the given header, and gets its value.
+ *
+ * @return          The value without its leading spaces, or NULL for another header.
+ */
+static const char *resp_header(const char *line, const char *name)
+{
+  size_t name_len = strlen(name);
+  if (strncasecmp(line, name, name_len) != 0 || line[name_len] != ':') {
+    return NULL;
+  }
+
+  const char *value = line + name_len + 1;
+  while (*value == ' ' || *value == '\t') {
+    value++;
+  }
+
+  return value;
+}
+
+
+/**
+ * @brief           Takes a status or header line, once it is complete.
+ */
+static void resp_line(resp_t *resp)
+{
+  const char *line = resp->line;
+  const char *value;
+
+  switch (resp->frame) {
+    case RESP_FRAME_STATUS:
+      // Anything else than HTTP/1.x is not a response this parser can frame.
+      if (strncmp(line, "HTTP/1.", 7) != 0 || line[8] != ' ') {
+        resp->status = 0;
+        resp->close = true;
+        resp->frame = RESP_FRAME_DONE;
+        return;
+      }
+      resp->status = atoi(line + 9);
+      resp->close = line[7] == '0';
+      resp->frame = RESP_FRAME_HEADER;
+      break;
+    case RESP_FRAME_HEADER:
+      if ((value = resp_header(line, "Content-Length")) != NULL) {
+        resp->sized = true;
+        resp->remaining = strtoul(value, NULL, 10);
+      } else if ((value = resp_header(line, "Transfer-Encoding")) != NULL) {
+        resp->chunked = strncasecmp(value, "chunked", 7) == 0;
+      } else if ((value = resp_header(line, "Connection")) != NULL) {
+        resp->close = strncasecmp(value, "close", 5) == 0;
+      } else if (line[0] == '\0') {
+        if (resp->status >= 100 && resp->status < 200) {
+          // An interim response, the final one follows.
+          resp->frame = RESP_FRAME_STATUS;
+          resp->sized = false;
+          resp->chunked = false;
+        } else if (resp->status == 204 || resp->status == 304 || (!resp->chunked && resp->sized && resp->remaining == 0)) {
+          resp->frame = RESP_FRAME_DONE;
+        } else if (resp->chunked) {
+          resp->frame = RESP_FRAME_CHUNK_SIZE;
+        } else if (resp->sized) {
+          resp->frame = RESP_FRAME_BODY;
+        } else {
+          resp->close = true;
+          resp->frame = RESP_FRAME_UNTIL_CLOSE;
+        }
+      }
+      break;
+    case RESP_FRAME_CHUNK_SIZE:
+      resp->remaining = strtoul(line, NULL, 16);
+      resp->frame = resp->remaining > 0 ? RESP_FRAME_CHUNK : RESP_FRAME_TRAILER;
+      break;
+    case RESP_FRAME_CHUNK_END:
+      resp->frame = RESP_FRAME_CHUNK_SIZE;
+      break;
+    case RESP_FRAME_TRAILER:
+      if (line[0] == '\0') {
+        resp->frame = RESP_FRAME_DONE;
+      }
+      break;
+  }
+}
+
+
+/**
+ * @brief           Feeds the parser the next part of the raw HTTP response. The body is passed on to resp_feed().
+ *
+ * @param resp      The parser.
+ * @param data      The part of the response.
+ * @param len       The part length.
+ *
+ * @return          The bytes taken, fewer than len only once the response is complete.
+ */
+uint32_t resp_read(resp_t *resp, const char *data, uint32_t len)
+{
+  uint32_t i = 0;
+
+  while (i < len && resp->frame != RESP_FRAME_DONE) {
+    if (resp->frame == RESP_FRAME_UNTIL_CLOSE) {
+      resp_feed(resp, data + i, len - i);
+      i = len;
+    } else if (resp->frame == RESP_FRAME_BODY || resp->frame == RESP_FRAME_CHUNK) {
+      uint32_t part = len - i < resp->remaining ? len - i : resp->remaining;
+      resp_feed(resp, data + i, part);
+      i += part;
+      resp->remaining -= part;
+      if (resp->remaining == 0) {
+        resp->frame = resp->frame == RESP_FRAME_BODY ? RESP_FRAME_DONE : RESP_FRAME_CHUNK_END;
+      }
+    } else {
+      char c = data[i++];
+      if (c != '\n') {
+        if (resp->line_len < sizeof(resp->line) - 1) {
+          resp->line[resp->line_len++] = c;
+        }
+        continue;
+      }
+
+      if (resp->line_len > 0 && resp->line[resp->line_len - 1] == '\r') {
+        resp->line_len--;
+      }
+      resp->line[resp->line_len] = '\0';
+      resp->line_len = 0;
+      resp_line(resp);
+    }
+  }
+
+  return i;
+}
+
+
+/**
+ * @brief           Checks whether the whole response was read.
+ *
+ * @param resp      The parser.
+ *
+ * @return          True once the response is complete, or could not be parsed.
+ */
+bool resp_is_done(const resp_t *resp)
+{
+  return resp->frame == RESP_FRAME_DONE;
+}
+
+
+/**
+ * @brief           Tells the parser that the server closed the connection, which ends a body without a length.
+ *
+ * @param resp      The parser.
+ *
+ * @return          True if the response is complete.
+ */
+bool resp_end(resp_t *resp)
+{
+  if (resp->frame == RESP_FRAME_UNTIL_CLOSE) {
+    resp->frame = RESP_FRAME_DONE;
+  }
+
+  return resp_is_done(resp);
+}
+
+
+/**
+ * @brief           Returns the start of the error message.
+ *
+ * @param resp      The parser.
+ *
+ * @return          The message, empty if there was none.
+ */
+const char *resp_message(resp_t *resp)
+{
+  resp->message[resp->message_len] = '\0';
+
+  return resp->message;
+}
+
+
+/**
+ * @brief           Classifies the outcome of a request from its status code.
+ *
+ * @remarks         A 400 is a malformed point or a partial write, and a 413 or 422 a body the server will never take.
+ *                  Sending them again would only be refused again, and hold up the points behind them. Any other
+ *                  failure, overload, authentication or a missing bucket, may clear up, so the points are kept.
+ *
+ * @param status    The status code.
+ *
+ * @return        - RESP_RESULT_SUCCESS
+ *                - RESP_RESULT_RETRY
+ *                - RESP_RESULT_DROP
+ */
+resp_result_en resp_classify(int status)
+{
+  if (status >= 200 && status < 300) {
+    return RESP_RESULT_SUCCESS;
+  }
+
+  if (status == 400 || status == 413 || status == 422) {
+    return RESP_RESULT_DROP;
+  }
+
+  return RESP_RESULT_RETRY;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file    resp.h
+ *
+ * @brief   Response Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _RESP_H_
+#define _RESP_H_
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#define RESP_KEY_SIZE                 (16)
+#define RESP_MESSAGE_SIZE             (128)
+// Longer status and header lines are cut, which only loses the parts of them that are not used.
+#define RESP_LINE_SIZE                (48)
+
+/**
+ * @brief   What to do with the points of a request once the server answered.
+ */
+typedef enum {
+  RESP_RESULT_SUCCESS,                // accepted
+  RESP_RESULT_RETRY,                  // not accepted for now, to be sent again later
+  RESP_RESULT_DROP                    // refused for good, to be dropped
+} resp_result_en;
+
+/**
+ * @brief   Parses an HTTP/1.1 response of the InfluxDB as it streams in, in constant memory: the status, the framing of
+ *          the body and the JSON error in it.
+ *
+ * @remarks Only the start of the error message is kept, for the log, but all of it is scanned for a partial write and
+ *          the count of dropped points. Anything that is not JSON is skipped over.
+ */
+typedef struct {
+  uint8_t frame;
+  char line[RESP_LINE_SIZE];
+  uint8_t line_len;
+  int status;
+  bool close;
+  bool chunked;
+  bool sized;
+  uint32_t remaining;
+  uint8_t state;
+  bool escape;
+  bool value;
+  bool capture;
+  char key[RESP_KEY_SIZE];
+  uint8_t key_len;
+  uint8_t partial_matched;
+  uint8_t dropped_matched;
+  bool dropped_digits;
+  bool partial;
+  uint32_t dropped;
+  char message[RESP_MESSAGE_SIZE];
+  uint32_t message_len;
+} resp_t;
+
+
+void resp_reset(resp_t *resp);
+
+
+void resp_feed(resp_t *resp, const char *data, uint32_t len);
+
+
+uint32_t resp_read(resp_t *resp, const char *data, uint32_t len);
+
+
+bool resp_is_done(const resp_t *resp);
+
+
+bool resp_end(resp_t *resp);
+
+
+const char *resp_message(resp_t *resp);
+
+
+resp_result_en resp_classify(int status);
+
+
+#endif /* _RESP_H_ */
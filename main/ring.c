@@ -0,0 +1,80 @@
+/**
+ * @file    ring.c
+ *
+ * @brief   Ring Source File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "ring.h"
+
+#include <string.h>
+
+
+/**
+ * @brief           Appends an element. Must only be called by the producer.
+ *
+ * @param ring      The ring.
+ * @param elem      The element to be copied into the ring.
+ *
+ * @return        - true if the element was appended
+ *                - false if the ring is full
+ */
+bool ring_push(ring_t *ring, const void *elem)
+{
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+  if (head - tail > ring->mask) {
+    return false;
+  }
+
+  memcpy(ring->storage + (head & ring->mask) * ring->elem_size, elem, ring->elem_size);
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+  return true;
+}
+
+
+/**
+ * @brief           Removes the oldest element. Must only be called by the consumer.
+ *
+ * @param ring      The ring.
+ * @param elem      The element copied out of the ring.
+ *
+ * @return        - true if an element was removed
+ *                - false if the ring is empty
+ */
+bool ring_pop(ring_t *ring, void *elem)
+{
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+  if (head == tail) {
+    return false;
+  }
+
+  memcpy(elem, ring->storage + (tail & ring->mask) * ring->elem_size, ring->elem_size);
+  atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+
+  return true;
+}
+
+
+/**
+ * @brief           Counts the queued elements. The result is a snapshot and may be stale by the time it is used.
+ *
+ * @param ring      The ring.
+ *
+ * @return          The number of queued elements.
+ */
+uint32_t ring_count(ring_t *ring)
+{
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+  return head - tail;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file    ring.h
+ *
+ * @brief   Ring Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _RING_H_
+#define _RING_H_
+
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * @brief   Statically initializes a ring over a storage array. The capacity has to be a power of two.
+ */
+#define RING_INIT(storage_, capacity_)  {                 \
+  .storage = (uint8_t *)(storage_),                       \
+  .elem_size = sizeof((storage_)[0]),                     \
+  .mask = (capacity_) - 1,                                \
+  .head = 0,                                              \
+  .tail = 0                                               \
+}
+
+/**
+ * @brief   Rounds a capacity up to a power of two at compile time, from 16 up to 1024.
+ */
+#define RING_CAPACITY(n_)             ((n_) <= 16 ? 16 : (n_) <= 32 ? 32 : (n_) <= 64 ? 64 : (n_) <= 128 ? 128 : \
+                                       (n_) <= 256 ? 256 : (n_) <= 512 ? 512 : 1024)
+
+/**
+ * @brief   A bounded single-producer/single-consumer queue of fixed-size elements.
+ *
+ * @remarks The producer only writes head and the consumer only writes tail. Each side publishes its index with release
+ *          ordering and reads the other side's with acquire ordering, so an element is fully copied before it becomes
+ *          visible on the other core.
+ */
+typedef struct {
+  uint8_t *storage;
+  uint32_t elem_size;
+  uint32_t mask;
+  atomic_uint head;
+  atomic_uint tail;
+} ring_t;
+
+
+bool ring_push(ring_t *ring, const void *elem);
+
+
+bool ring_pop(ring_t *ring, void *elem);
+
+
+uint32_t ring_count(ring_t *ring);
+
+
+#endif /* _RING_H_ */
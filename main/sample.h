@@ -0,0 +1,32 @@
+/**
+ * @file    sample.h
+ *
+ * @brief   Sample Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _SAMPLE_H_
+#define _SAMPLE_H_
+
+
+#include <stdint.h>
+
+
+/**
+ * @brief   A sensor reading in fixed-point units, as it travels from the sensor to the uploader.
+ */
+typedef struct {
+  int32_t temperature;                // 0.01 degC
+  uint32_t pressure;                  // Pa
+  uint32_t humidity;                  // 0.001 %RH
+  uint32_t acquired_us;               // perf_now_us() when acquired, only meaningful during the same boot
+  int64_t timestamp;                  // ms, see clock.h
+  uint8_t sensor;                     // index of the sensor, see bme_location()
+} sample_t;
+
+
+#endif /* _SAMPLE_H_ */
@@ -0,0 +1,162 @@
+/**
+ * @file    sched.c
+ *
+ * @brief   Sched Source File
+ *
+ * @remarks The deadlines are absolute times on the esp_timer clock, so the work a job does and the tick rounding of
+ *          the sleeps never accumulate into drift. A job starts at most one tick after its deadline, and the delay is
+ *          recorded as its jitter. A job that overruns its next deadlines skips them instead of running back to back.
+ *          Jobs with a common period and phase wake up together, so that the CPU and the radio can sleep in one block.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "sched.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+
+static sched_job_t sched_jobs[SCHED_MAX_JOBS];
+static uint32_t sched_job_count;
+
+
+/**
+ * @brief           Moves the deadline of a job to its first period boundary after a time.
+ */
+static void sched_advance(sched_job_t *job, int64_t now_us)
+{
+  int64_t period_us = (int64_t)job->period_ms * 1000;
+  int64_t phase_us = (int64_t)job->phase_ms * 1000;
+
+  if (now_us < phase_us) {
+    job->deadline_us = phase_us;
+    return;
+  }
+
+  job->deadline_us = phase_us + ((now_us - phase_us) / period_us + 1) * period_us;
+}
+
+
+/**
+ * @brief           Adds a periodic job. Must be called before the scheduler task is created.
+ *
+ * @param name      The job name.
+ * @param fn        The job function. Runs on the scheduler task, so it should not block for long.
+ * @param period_ms The period in milliseconds.
+ * @param phase_ms  The offset of the deadlines from the period boundaries in milliseconds.
+ *
+ * @return        - true if the job was added
+ *                - false if there is no room
+ */
+bool sched_add(const char *name, sched_fn_t fn, uint32_t period_ms, uint32_t phase_ms)
+{
+  if (sched_job_count == SCHED_MAX_JOBS || period_ms == 0) {
+    return false;
+  }
+
+  sched_jobs[sched_job_count++] = (sched_job_t) {
+    .name = name,
+    .fn = fn,
+    .period_ms = period_ms,
+    .phase_ms = phase_ms % period_ms
+  };
+
+  return true;
+}
+
+
+/**
+ * @brief           Adds a periodic job that also runs once as soon as the scheduler task starts. Must be called before
+ *                  the scheduler task is created.
+ *
+ * @param name      The job name.
+ * @param fn        The job function.
+ * @param period_ms The period in milliseconds.
+ * @param phase_ms  The offset of the deadlines from the period boundaries in milliseconds.
+ *
+ * @return        - true if the job was added
+ *                - false if there is no room
+ */
+bool sched_add_now(const char *name, sched_fn_t fn, uint32_t period_ms, uint32_t phase_ms)
+{
+  if (!sched_add(name, fn, period_ms, phase_ms)) {
+    return false;
+  }
+
+  sched_jobs[sched_job_count - 1].now = true;
+
+  return true;
+}
+
+
+/**
+ * @brief           Logs the jitter of every job.
+ */
+void sched_report()
+{
+  for (uint32_t i = 0; i < sched_job_count; i++) {
+    const sched_job_t *job = &sched_jobs[i];
+    ESP_LOGI(SCHED_TAG, "job=%s period_ms=%u runs=%u skipped=%u jitter_mean_us=%u jitter_max_us=%u", job->name,
+             job->period_ms, job->runs, job->skipped, job->runs ? (uint32_t)(job->total_jitter_us / job->runs) : 0,
+             job->max_jitter_us);
+  }
+}
+
+
+/**
+ * @brief           The scheduler task function. Runs every job at its deadlines.
+ */
+void sched_task()
+{
+  sched_add("report", sched_report, SCHED_REPORT_PERIOD_MS, 0);
+
+  int64_t now_us = esp_timer_get_time();
+  for (uint32_t i = 0; i < sched_job_count; i++) {
+    if (sched_jobs[i].now) {
+      sched_jobs[i].deadline_us = now_us;
+    } else {
+      sched_advance(&sched_jobs[i], now_us);
+    }
+  }
+
+  while (1) {
+    sched_job_t *next = &sched_jobs[0];
+    for (uint32_t i = 1; i < sched_job_count; i++) {
+      if (sched_jobs[i].deadline_us < next->deadline_us) {
+        next = &sched_jobs[i];
+      }
+    }
+
+    // Sleeps to the tick at or after the deadline, never before it.
+    now_us = esp_timer_get_time();
+    if (next->deadline_us > now_us) {
+      int64_t tick_us = portTICK_PERIOD_MS * 1000;
+      vTaskDelay((next->deadline_us - now_us + tick_us - 1) / tick_us);
+      continue;
+    }
+
+    uint32_t jitter_us = now_us - next->deadline_us;
+    next->runs++;
+    next->total_jitter_us += jitter_us;
+    if (jitter_us > next->max_jitter_us) {
+      next->max_jitter_us = jitter_us;
+    }
+
+    next->fn();
+
+    // Keeps the deadlines on the period grid, skipping the ones the job overran. An immediate first run is off the
+    // grid, so it skips none.
+    int64_t deadline_us = next->deadline_us;
+    sched_advance(next, esp_timer_get_time());
+    if (!next->now) {
+      next->skipped += (next->deadline_us - deadline_us) / ((int64_t)next->period_ms * 1000) - 1;
+    }
+    next->now = false;
+  }
+}
@@ -0,0 +1,60 @@
+/**
+ * @file    sched.h
+ *
+ * @brief   Sched Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#define SCHED_TAG                     "SCHD"
+
+#define SCHED_MAX_JOBS                (8)
+#define SCHED_REPORT_PERIOD_MS        (300000)
+
+#define SCHED_TASK_NAME               "sched"
+#define SCHED_TASK_PRIORITY           (tskIDLE_PRIORITY + 2)
+#define SCHED_TASK_STACK_SIZE         (3072)
+
+typedef void (*sched_fn_t)();
+
+/**
+ * @brief   A periodic job. It runs at every multiple of its period after boot, shifted by its phase.
+ */
+typedef struct {
+  const char *name;
+  sched_fn_t fn;
+  uint32_t period_ms;
+  uint32_t phase_ms;
+  bool now;
+  int64_t deadline_us;
+  uint32_t runs;
+  uint32_t skipped;
+  uint32_t max_jitter_us;
+  uint64_t total_jitter_us;
+} sched_job_t;
+
+
+bool sched_add(const char *name, sched_fn_t fn, uint32_t period_ms, uint32_t phase_ms);
+
+
+bool sched_add_now(const char *name, sched_fn_t fn, uint32_t period_ms, uint32_t phase_ms);
+
+
+void sched_report();
+
+
+void sched_task();
+
+
+#endif /* _SCHED_H_ */
@@ -0,0 +1,235 @@
+/**
+ * @file    serve.c
+ *
+ * @brief   Serve Source File
+ *
+ * @remarks Every response is rendered one line at a time into a buffer on the stack and sent as a chunk, so a request
+ *          allocates nothing and its size is not bounded by a buffer. The server runs its handlers one at a time in
+ *          its own task, so concurrent scrapers are served in turn and the history copy can be a static buffer.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "serve.h"
+
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "agg.h"
+#include "bme.h"
+#include "http.h"
+#include "perf.h"
+#include "stats.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+
+static sample_t serve_history[AGG_HISTORY_SIZE];
+
+
+/**
+ * @brief           Formats a line and sends it as a chunk.
+ *
+ * @param req       The request.
+ * @param format    The printf format of the line.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL if the client went away
+ */
+static esp_err_t serve_printf(httpd_req_t *req, const char *format, ...)
+{
+  char line[SERVE_LINE_SIZE];
+
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+
+  if (len < 0) {
+    return ESP_FAIL;
+  }
+
+  return httpd_resp_send_chunk(req, line, len < (int)sizeof(line) ? len : (int)sizeof(line) - 1);
+}
+
+
+/**
+ * @brief           Gets a quantity of a sample.
+ *
+ * @param sample    The sample.
+ * @param quantity  The quantity, 0 for the temperature, 1 for the pressure and 2 for the humidity.
+ *
+ * @return          The value in the units of sample_t.
+ */
+static int32_t serve_value(const sample_t *sample, uint32_t quantity)
+{
+  switch (quantity) {
+    case 0:
+      return sample->temperature;
+    case 1:
+      return sample->pressure;
+    default:
+      return sample->humidity;
+  }
+}
+
+
+/**
+ * @brief           Sends a gauge of every sensor from their latest samples.
+ *
+ * @param req       The request.
+ * @param name      The name of the metric.
+ * @param help      The description of the metric.
+ * @param count     The number of samples, newest first.
+ * @param quantity  The quantity, see serve_value().
+ * @param decimals  The decimals of the value.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL
+ */
+static esp_err_t serve_gauge(httpd_req_t *req, const char *name, const char *help, uint32_t count, uint32_t quantity, uint32_t decimals)
+{
+  uint32_t scale = 1;
+  for (uint32_t i = 0; i < decimals; i++) {
+    scale *= 10;
+  }
+
+  esp_err_t esp_err = serve_printf(req, "# HELP %s %s\n# TYPE %s gauge\n", name, help, name);
+
+  uint32_t seen = 0;
+  for (uint32_t i = 0; i < count && esp_err == ESP_OK; i++) {
+    const sample_t *sample = &serve_history[i];
+    if (sample->sensor >= BME_MAX_SENSORS || (seen & (1 << sample->sensor))) {
+      continue;
+    }
+    seen |= 1 << sample->sensor;
+
+    int32_t fixed = serve_value(sample, quantity);
+    uint32_t magnitude = fixed < 0 ? -(uint32_t)fixed : (uint32_t)fixed;
+    esp_err = serve_printf(req, "%s{location=\"%s\"} %s%u.%0*u\n", name, bme_location(sample->sensor), fixed < 0 ? "-" : "", magnitude / scale, decimals, magnitude % scale);
+  }
+
+  return esp_err;
+}
+
+
+/**
+ * @brief           Handles GET /metrics with the latest readings and the health of the station.
+ *
+ * @param req       The request.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL
+ */
+static esp_err_t serve_metrics(httpd_req_t *req)
+{
+  uint32_t start_us = perf_now_us();
+  uint32_t count = agg_history(serve_history, AGG_HISTORY_SIZE);
+
+  httpd_resp_set_type(req, "text/plain; version=0.0.4");
+
+  esp_err_t esp_err = serve_gauge(req, "station_temperature_celsius", "Latest temperature.", count, 0, 2);
+  if (esp_err == ESP_OK) {
+    esp_err = serve_gauge(req, "station_pressure_pascals", "Latest pressure.", count, 1, 0);
+  }
+  if (esp_err == ESP_OK) {
+    esp_err = serve_gauge(req, "station_humidity_percent", "Latest relative humidity.", count, 2, 3);
+  }
+  if (esp_err == ESP_OK) {
+    esp_err = serve_printf(req, "# TYPE station_uptime_seconds counter\nstation_uptime_seconds %lld\n", esp_timer_get_time() / 1000000);
+  }
+  if (esp_err == ESP_OK) {
+    esp_err = serve_printf(req, "# TYPE station_heap_free_bytes gauge\nstation_heap_free_bytes %u\n", esp_get_free_heap_size());
+  }
+  for (uint32_t counter = 0; counter < STATS_COUNTER_MAX && esp_err == ESP_OK; counter++) {
+    esp_err = serve_printf(req, "# TYPE station_%s_total counter\nstation_%s_total %u\n", stats_name(counter), stats_name(counter), stats_get(counter));
+  }
+
+  if (esp_err != ESP_OK) {
+    return ESP_FAIL;
+  }
+
+  esp_err = httpd_resp_send_chunk(req, NULL, 0);
+  perf_record(PERF_STAGE_SERVE, perf_now_us() - start_us);
+
+  return esp_err;
+}
+
+
+/**
+ * @brief           Handles GET /history with the kept raw samples in line protocol, newest first, stamped in
+ *                  HTTP_PRECISION, one point per line.
+ *
+ * @param req       The request.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL
+ */
+static esp_err_t serve_history_handler(httpd_req_t *req)
+{
+  uint32_t start_us = perf_now_us();
+  uint32_t count = agg_history(serve_history, AGG_HISTORY_SIZE);
+
+  httpd_resp_set_type(req, "text/plain");
+
+  // Leaves room for the new line that ends every point.
+  char line[SERVE_LINE_SIZE];
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t line_len = http_encode(&serve_history[i], line, sizeof(line) - 1);
+    if (line_len == 0) {
+      continue;
+    }
+    line[line_len++] = '\n';
+
+    if (httpd_resp_send_chunk(req, line, line_len) != ESP_OK) {
+      return ESP_FAIL;
+    }
+  }
+
+  esp_err_t esp_err = httpd_resp_send_chunk(req, NULL, 0);
+  perf_record(PERF_STAGE_SERVE, perf_now_us() - start_us);
+
+  return esp_err;
+}
+
+
+/**
+ * @brief           Starts the HTTP server. The network interface must already be initialized.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL
+ */
+esp_err_t serve_start()
+{
+  httpd_handle_t server = NULL;
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+  config.server_port = SERVE_PORT;
+  config.max_open_sockets = SERVE_MAX_SOCKETS;
+  config.stack_size = SERVE_STACK_SIZE;
+  config.lru_purge_enable = true;
+
+  esp_err_t esp_err = httpd_start(&server, &config);
+  if (esp_err != ESP_OK) {
+    ESP_LOGE(SERVE_TAG, "Start failed with error 0x%x", esp_err);
+    return esp_err;
+  }
+
+  static const httpd_uri_t serve_uris[] = {
+    { .uri = "/metrics", .method = HTTP_GET, .handler = serve_metrics },
+    { .uri = "/history", .method = HTTP_GET, .handler = serve_history_handler }
+  };
+
+  for (uint32_t i = 0; i < sizeof(serve_uris) / sizeof(serve_uris[0]); i++) {
+    httpd_register_uri_handler(server, &serve_uris[i]);
+  }
+
+  ESP_LOGI(SERVE_TAG, "Serving on port %u", SERVE_PORT);
+
+  return ESP_OK;
+}
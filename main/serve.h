@@ -0,0 +1,41 @@
+/**
+ * @file    serve.h
+ *
+ * @brief   Serve Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _SERVE_H_
+#define _SERVE_H_
+
+
+#include "power.h"
+
+#include "esp_err.h"
+
+
+#define SERVE_TAG                     "SERV"
+
+// Serves the latest readings at /metrics in the Prometheus text format and the recent raw samples at /history in line
+// protocol, for a local collector to scrape. Not used in deep sleep mode, where the station is mostly off.
+#define SERVE_ENABLE                  (0)
+#define SERVE_ACTIVE                  (SERVE_ENABLE && POWER_MODE != POWER_MODE_DEEP_SLEEP)
+
+// Stops pushing to the InfluxDB, so that the station is only scraped.
+#define SERVE_ONLY                    (0)
+#define SERVE_PUSH                    (!(SERVE_ACTIVE && SERVE_ONLY))
+
+#define SERVE_PORT                    (80)
+#define SERVE_MAX_SOCKETS             (4)
+#define SERVE_STACK_SIZE              (4096)
+#define SERVE_LINE_SIZE               (160)
+
+
+esp_err_t serve_start();
+
+
+#endif /* _SERVE_H_ */
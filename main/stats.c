@@ -0,0 +1,76 @@
+/**
+ * @file    stats.c
+ *
+ * @brief   Stats Source File
+ *
+ * @remarks The counters are updated from several tasks, including the hot paths of the sensor and the HTTP tasks.
+ *          They are relaxed atomic additions, which never block and cost a few cycles, since nothing is ordered
+ *          against them.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "stats.h"
+
+#include <stdatomic.h>
+
+
+static const char *stats_names[STATS_COUNTER_MAX] = {
+  "samples_dropped", "post_retries", "points_stored", "points_lost", "wifi_reconnects",
+  "points_emitted", "points_suppressed", "publishes_expired", "points_rejected", "heap_alerts",
+  "heap_allocs"
+};
+
+static atomic_uint stats_counters[STATS_COUNTER_MAX];
+
+
+/**
+ * @brief           Adds to a counter.
+ *
+ * @param counter   The counter.
+ * @param value     The value to add.
+ */
+void stats_add(stats_counter_en counter, uint32_t value)
+{
+  atomic_fetch_add_explicit(&stats_counters[counter], value, memory_order_relaxed);
+}
+
+
+/**
+ * @brief           Increments a counter.
+ *
+ * @param counter   The counter.
+ */
+void stats_inc(stats_counter_en counter)
+{
+  stats_add(counter, 1);
+}
+
+
+/**
+ * @brief           Gets the value of a counter.
+ *
+ * @param counter   The counter.
+ *
+ * @return          The value.
+ */
+uint32_t stats_get(stats_counter_en counter)
+{
+  return atomic_load_explicit(&stats_counters[counter], memory_order_relaxed);
+}
+
+
+/**
+ * @brief           Gets the field name of a counter.
+ *
+ * @param counter   The counter.
+ *
+ * @return          The name.
+ */
+const char *stats_name(stats_counter_en counter)
+{
+  return stats_names[counter];
+}
@@ -0,0 +1,53 @@
+/**
+ * @file    stats.h
+ *
+ * @brief   Stats Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+
+#include <stdint.h>
+
+
+#define STATS_MEASUREMENT             "station_stats"
+#define STATS_PERIOD_MS               (60000)
+
+/**
+ * @brief   The event counters of the station, counted since boot.
+ */
+typedef enum {
+  STATS_SAMPLES_DROPPED,              // samples lost because the HTTP queue was full
+  STATS_POST_RETRIES,                 // posts repeated over a fresh connection
+  STATS_POINTS_STORED,                // samples written to the flash log
+  STATS_POINTS_LOST,                  // samples the flash log dropped when full, or could not write
+  STATS_WIFI_RECONNECTS,              // reconnection attempts to the AP
+  STATS_POINTS_EMITTED,               // samples queued after passing the report filter
+  STATS_POINTS_SUPPRESSED,            // samples held back by the report filter
+  STATS_PUBLISHES_EXPIRED,            // MQTT publishes never acknowledged by the broker
+  STATS_POINTS_REJECTED,              // points the server refused for good, as malformed, alone or in a partial write
+  STATS_HEAP_ALERTS,                  // failed allocations, heap drops and fragmentation flagged by the heap guard
+  STATS_HEAP_ALLOCS,                  // malloc, calloc and realloc calls of the station once it is up, see mem.c
+  STATS_COUNTER_MAX
+} stats_counter_en;
+
+
+void stats_add(stats_counter_en counter, uint32_t value);
+
+
+void stats_inc(stats_counter_en counter);
+
+
+uint32_t stats_get(stats_counter_en counter);
+
+
+const char *stats_name(stats_counter_en counter);
+
+
+#endif /* _STATS_H_ */
@@ -0,0 +1,490 @@
+/**
+ * @file    store.c
+ *
+ * @brief   Store Source File
+ *
+ * @remarks The store is an append-only log of samples on its own flash partition, used to keep the samples that could
+ *          not be uploaded. The partition is split into sectors that are written in a circle, so every sector is
+ *          erased equally often. Each sector starts with a header carrying an increasing sequence number, which is
+ *          how the oldest and the newest sector are found after a reset. Records carry a CRC, so a record torn by a
+ *          power loss is skipped instead of being uploaded. When the log is full, the oldest sector is dropped.
+ *          The header takes the first page of a sector, and the records are appended in groups that fill whole pages.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "store.h"
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+#include "bme.h"
+#include "clock.h"
+#include "stats.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+
+#define STORE_RECORD_SIZE             (sizeof(store_record_t))
+#define STORE_SLOTS                   ((STORE_SECTOR_SIZE - STORE_PAGE_SIZE) / STORE_RECORD_SIZE)
+#define STORE_APPEND_RECORDS          (STORE_APPEND_PAGES * STORE_PAGE_SIZE / STORE_RECORD_SIZE)
+
+#define STORE_BUS(port, addr)         ((port) << 7 | (addr))
+#define STORE_BUS_PORT(bus)           ((bus) >> 7)
+#define STORE_BUS_ADDR(bus)           ((bus) & 0x7F)
+
+_Static_assert(STORE_RECORD_SIZE == 4 + 3 * 4 + 8, "store_record_t must not be padded");
+_Static_assert(STORE_APPEND_RECORDS * STORE_RECORD_SIZE == STORE_APPEND_PAGES * STORE_PAGE_SIZE,
+               "The records must fill the appended pages");
+_Static_assert(STORE_SLOTS % STORE_APPEND_RECORDS == 0, "The appends must fill the sectors");
+
+typedef struct {
+  uint32_t magic;
+  uint32_t seq;
+} store_header_t;
+
+typedef struct {
+  uint32_t sector;
+  uint32_t slot;
+} store_cursor_t;
+
+static const esp_partition_t *store_partition;
+static uint32_t store_sectors;
+
+static store_cursor_t store_head;
+static uint32_t store_head_seq;
+static store_cursor_t store_tail;
+static uint32_t store_pending;
+
+// Records waiting to be written with the next append of whole pages.
+static store_record_t store_page[STORE_APPEND_RECORDS];
+static uint32_t store_page_len;
+
+
+/**
+ * @brief           Computes the flash offset of a record slot. The first page of each sector holds the header.
+ */
+static uint32_t store_offset(uint32_t sector, uint32_t slot)
+{
+  return sector * STORE_SECTOR_SIZE + STORE_PAGE_SIZE + slot * STORE_RECORD_SIZE;
+}
+
+
+/**
+ * @brief           Computes the CRC of a record, from its bus on.
+ */
+static uint16_t store_crc(const store_record_t *record)
+{
+  uint16_t crc = esp_rom_crc16_le(0, &record->bus, sizeof(record->bus));
+
+  return esp_rom_crc16_le(crc, (const uint8_t *)&record->temperature, STORE_RECORD_SIZE - offsetof(store_record_t, temperature));
+}
+
+
+/**
+ * @brief           Checks if a record holds a sample that has not been uploaded yet.
+ */
+static bool store_is_pending(const store_record_t *record)
+{
+  return record->state == STORE_STATE_VALID && record->crc == store_crc(record);
+}
+
+
+/**
+ * @brief           Turns a record back into a sample. A sensor that is not found on its bus anymore gets an unknown
+ *                  location.
+ */
+static void store_unpack(const store_record_t *record, sample_t *sample)
+{
+  sample->temperature = record->temperature;
+  sample->pressure = record->pressure;
+  sample->humidity = record->humidity;
+  sample->acquired_us = 0;
+  sample->timestamp = record->timestamp;
+  sample->sensor = record->bus == STORE_BUS_UNKNOWN ? BME_MAX_SENSORS :
+                   bme_find(STORE_BUS_PORT(record->bus), STORE_BUS_ADDR(record->bus));
+}
+
+
+/**
+ * @brief           Checks if a record slot has never been written.
+ */
+static bool store_is_erased(const store_record_t *record)
+{
+  const uint8_t *bytes = (const uint8_t *)record;
+
+  for (uint32_t i = 0; i < STORE_RECORD_SIZE; i++) {
+    if (bytes[i] != 0xFF) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief           Moves a cursor to the next slot. The cursor only leaves the head sector through store_head itself.
+ */
+static void store_advance(store_cursor_t *cursor)
+{
+  if (cursor->slot + 1 >= STORE_SLOTS && cursor->sector != store_head.sector) {
+    cursor->sector = (cursor->sector + 1) % store_sectors;
+    cursor->slot = 0;
+  } else {
+    cursor->slot++;
+  }
+}
+
+
+/**
+ * @brief           Checks if a cursor reached the first free slot.
+ */
+static bool store_at_head(const store_cursor_t *cursor)
+{
+  return cursor->sector == store_head.sector && cursor->slot >= store_head.slot;
+}
+
+
+/**
+ * @brief           Erases a sector and writes its header.
+ */
+static esp_err_t store_format(uint32_t sector, uint32_t seq)
+{
+  esp_err_t esp_err = esp_partition_erase_range(store_partition, sector * STORE_SECTOR_SIZE, STORE_SECTOR_SIZE);
+  if (esp_err != ESP_OK) {
+    ESP_LOGE(STORE_TAG, "Erase failed with error 0x%x", esp_err);
+    return esp_err;
+  }
+
+  // Writes the sequence number before the magic, so that a valid magic always comes with a complete sequence number.
+  store_header_t header = {
+    .magic = STORE_MAGIC,
+    .seq = seq
+  };
+  esp_err = esp_partition_write(store_partition, sector * STORE_SECTOR_SIZE + offsetof(store_header_t, seq), &header.seq, sizeof(header.seq));
+  if (esp_err == ESP_OK) {
+    esp_err = esp_partition_write(store_partition, sector * STORE_SECTOR_SIZE, &header.magic, sizeof(header.magic));
+  }
+  if (esp_err != ESP_OK) {
+    ESP_LOGE(STORE_TAG, "Header write failed with error 0x%x", esp_err);
+  }
+
+  return esp_err;
+}
+
+
+/**
+ * @brief           Counts the pending records of a sector.
+ */
+static uint32_t store_count_sector(uint32_t sector)
+{
+  uint32_t count = 0;
+  store_record_t record;
+
+  for (uint32_t slot = 0; slot < STORE_SLOTS; slot++) {
+    if (esp_partition_read(store_partition, store_offset(sector, slot), &record, sizeof(record)) == ESP_OK && store_is_pending(&record)) {
+      count++;
+    }
+  }
+
+  return count;
+}
+
+
+/**
+ * @brief           Moves the head to the next sector. Drops the oldest sector if the log is full.
+ */
+static esp_err_t store_next_sector()
+{
+  uint32_t next = (store_head.sector + 1) % store_sectors;
+
+  if (next == store_tail.sector) {
+    uint32_t dropped = store_count_sector(next);
+    ESP_LOGW(STORE_TAG, "Log full, dropping %u records", dropped);
+    store_pending -= dropped;
+    stats_add(STATS_POINTS_LOST, dropped);
+    store_tail.sector = (next + 1) % store_sectors;
+    store_tail.slot = 0;
+  }
+
+  esp_err_t esp_err = store_format(next, store_head_seq + 1);
+  if (esp_err != ESP_OK) {
+    return esp_err;
+  }
+
+  store_head.sector = next;
+  store_head.slot = 0;
+  store_head_seq++;
+
+  return ESP_OK;
+}
+
+
+/**
+ * @brief           Mounts the log. Finds the newest sector from the sequence numbers and walks back to the oldest one.
+ *
+ * @return        - ESP_OK
+ *                - ESP_ERR_NOT_FOUND
+ *                - ESP_FAIL
+ */
+esp_err_t store_init()
+{
+  store_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, STORE_PARTITION_LABEL);
+  if (store_partition == NULL) {
+    ESP_LOGE(STORE_TAG, "Partition %s not found", STORE_PARTITION_LABEL);
+    return ESP_ERR_NOT_FOUND;
+  }
+
+  store_page_len = 0;
+  store_sectors = store_partition->size / STORE_SECTOR_SIZE;
+  if (store_sectors < 2) {
+    ESP_LOGE(STORE_TAG, "Partition %s too small", STORE_PARTITION_LABEL);
+    return ESP_FAIL;
+  }
+
+  // Finds the newest sector.
+  bool found = false;
+  for (uint32_t sector = 0; sector < store_sectors; sector++) {
+    store_header_t header;
+    if (esp_partition_read(store_partition, sector * STORE_SECTOR_SIZE, &header, sizeof(header)) != ESP_OK || header.magic != STORE_MAGIC) {
+      continue;
+    }
+
+    if (!found || header.seq > store_head_seq) {
+      store_head.sector = sector;
+      store_head_seq = header.seq;
+      found = true;
+    }
+  }
+
+  if (!found) {
+    ESP_LOGI(STORE_TAG, "Formatting empty log");
+    store_head.sector = 0;
+    store_head.slot = 0;
+    store_head_seq = 1;
+    store_tail = store_head;
+    store_pending = 0;
+    return store_format(0, store_head_seq);
+  }
+
+  // Finds the first free slot of the newest sector. A torn record is never reused.
+  store_head.slot = 0;
+  for (uint32_t slot = 0; slot < STORE_SLOTS; slot++) {
+    store_record_t record;
+    esp_partition_read(store_partition, store_offset(store_head.sector, slot), &record, sizeof(record));
+    if (!store_is_erased(&record)) {
+      store_head.slot = slot + 1;
+    }
+  }
+
+  // Walks back through the consecutive sequence numbers to the oldest sector.
+  store_tail.sector = store_head.sector;
+  store_tail.slot = 0;
+  for (uint32_t i = 1; i < store_sectors; i++) {
+    uint32_t sector = (store_head.sector + store_sectors - i) % store_sectors;
+    store_header_t header;
+    if (esp_partition_read(store_partition, sector * STORE_SECTOR_SIZE, &header, sizeof(header)) != ESP_OK ||
+        header.magic != STORE_MAGIC || header.seq != store_head_seq - i) {
+      break;
+    }
+    store_tail.sector = sector;
+  }
+
+  // Counts the pending records and skips the already uploaded ones.
+  store_pending = 0;
+  bool tail_found = false;
+  for (store_cursor_t cursor = store_tail; !store_at_head(&cursor); store_advance(&cursor)) {
+    store_record_t record;
+    esp_partition_read(store_partition, store_offset(cursor.sector, cursor.slot), &record, sizeof(record));
+    if (store_is_pending(&record)) {
+      if (!tail_found) {
+        store_tail = cursor;
+        tail_found = true;
+      }
+      store_pending++;
+    }
+  }
+  if (!tail_found) {
+    store_tail = store_head;
+  }
+
+  ESP_LOGI(STORE_TAG, "Mounted with %u pending records", store_pending);
+
+  return ESP_OK;
+}
+
+
+/**
+ * @brief           Appends a sample. Records are grouped and written to flash once they fill whole pages.
+ *
+ * @remarks         The samples that cannot be kept are counted as lost, along with the ones grouped with them.
+ *
+ * @param sample    The sample.
+ *
+ * @return        - ESP_OK
+ *                - ESP_ERR_INVALID_STATE if the log is not mounted
+ *                - ESP_FAIL if the grouped records could not be written
+ */
+esp_err_t store_write(const sample_t *sample)
+{
+  if (store_partition == NULL) {
+    stats_inc(STATS_POINTS_LOST);
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  store_record_t *record = &store_page[store_page_len++];
+
+  record->state = STORE_STATE_VALID;
+  record->bus = STORE_BUS_UNKNOWN;
+  i2c_port_t port;
+  uint8_t addr;
+  if (bme_get_bus(sample->sensor, &port, &addr)) {
+    record->bus = STORE_BUS(port, addr);
+  }
+  record->temperature = sample->temperature;
+  record->pressure = sample->pressure;
+  record->humidity = sample->humidity;
+
+  // The log outlives the boot, so a timestamp still relative to boot is dropped and the server stamps the sample.
+  record->timestamp = sample->timestamp;
+  if (!clock_rebase(&record->timestamp)) {
+    record->timestamp = CLOCK_UNKNOWN;
+  }
+  record->crc = store_crc(record);
+  stats_inc(STATS_POINTS_STORED);
+
+  // Waits for the group that ends on a page, which realigns the appends after an early flush.
+  if ((store_head.slot + store_page_len) % STORE_APPEND_RECORDS != 0) {
+    return ESP_OK;
+  }
+
+  return store_flush();
+}
+
+
+/**
+ * @brief           Writes the grouped records to flash. The records that could not be written are counted as lost.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL
+ */
+esp_err_t store_flush()
+{
+  esp_err_t esp_err = ESP_OK;
+  uint32_t written = 0;
+
+  while (written < store_page_len) {
+    if (store_head.slot >= STORE_SLOTS) {
+      esp_err = store_next_sector();
+      if (esp_err != ESP_OK) {
+        break;
+      }
+    }
+
+    uint32_t count = store_page_len - written;
+    if (count > STORE_SLOTS - store_head.slot) {
+      count = STORE_SLOTS - store_head.slot;
+    }
+
+    esp_err = esp_partition_write(store_partition, store_offset(store_head.sector, store_head.slot), &store_page[written], count * STORE_RECORD_SIZE);
+    if (esp_err != ESP_OK) {
+      ESP_LOGE(STORE_TAG, "Write failed with error 0x%x", esp_err);
+      break;
+    }
+
+    store_head.slot += count;
+    store_pending += count;
+    written += count;
+  }
+
+  if (written < store_page_len) {
+    ESP_LOGE(STORE_TAG, "Lost %u records", store_page_len - written);
+    stats_add(STATS_POINTS_LOST, store_page_len - written);
+  }
+  store_page_len = 0;
+
+  return esp_err;
+}
+
+
+/**
+ * @brief               Reads the oldest pending samples without consuming them.
+ *
+ * @param samples       The samples read.
+ * @param max_samples   The maximum number of samples to read.
+ *
+ * @return              The number of samples read.
+ */
+uint32_t store_read(sample_t *samples, uint32_t max_samples)
+{
+  uint32_t count = 0;
+
+  if (store_partition == NULL) {
+    return 0;
+  }
+
+  store_flush();
+
+  for (store_cursor_t cursor = store_tail; count < max_samples && !store_at_head(&cursor); store_advance(&cursor)) {
+    store_record_t record;
+    if (esp_partition_read(store_partition, store_offset(cursor.sector, cursor.slot), &record, sizeof(record)) == ESP_OK && store_is_pending(&record)) {
+      store_unpack(&record, &samples[count++]);
+    }
+  }
+
+  return count;
+}
+
+
+/**
+ * @brief           Marks the oldest pending samples as uploaded. Sectors left without pending samples are only erased
+ *                  once the head comes round to reuse them, so that each sector is erased once per cycle.
+ *
+ * @param count     The number of samples, as returned by store_read.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL
+ */
+esp_err_t store_commit(uint32_t count)
+{
+  store_cursor_t cursor = store_tail;
+  uint8_t state = STORE_STATE_CONSUMED;
+
+  while (count > 0 && !store_at_head(&cursor)) {
+    store_record_t record;
+    uint32_t offset = store_offset(cursor.sector, cursor.slot);
+    if (esp_partition_read(store_partition, offset, &record, sizeof(record)) == ESP_OK && store_is_pending(&record)) {
+      esp_err_t esp_err = esp_partition_write(store_partition, offset, &state, sizeof(state));
+      if (esp_err != ESP_OK) {
+        ESP_LOGE(STORE_TAG, "Commit failed with error 0x%x", esp_err);
+        return esp_err;
+      }
+      store_pending--;
+      count--;
+    }
+
+    store_advance(&cursor);
+  }
+
+  store_tail = cursor;
+
+  return ESP_OK;
+}
+
+
+/**
+ * @brief           Counts the pending samples, including the ones not written to flash yet.
+ *
+ * @return          The number of pending samples.
+ */
+uint32_t store_count()
+{
+  return store_pending + store_page_len;
+}
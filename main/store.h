@@ -0,0 +1,71 @@
+/**
+ * @file    store.h
+ *
+ * @brief   Store Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _STORE_H_
+#define _STORE_H_
+
+
+#include "sample.h"
+
+#include "esp_err.h"
+
+#include <stdint.h>
+
+
+#define STORE_TAG                     "STOR"
+
+#define STORE_PARTITION_LABEL         "store"
+#define STORE_SECTOR_SIZE             (4096)
+#define STORE_PAGE_SIZE               (256)
+#define STORE_APPEND_PAGES            (3)
+#define STORE_MAGIC                   (0x53543034)
+
+#define STORE_STATE_ERASED            (0xFF)
+#define STORE_STATE_VALID             (0x7F)
+#define STORE_STATE_CONSUMED          (0x3F)
+
+#define STORE_BUS_UNKNOWN             (0xFF)
+
+/**
+ * @brief   A record of the log, as it is laid out on flash. The state byte only ever clears bits, so it can be updated
+ *          in place without an erase. The sensor is kept by its bus, as its index depends on the order the sensors are
+ *          found in at boot.
+ */
+typedef struct {
+  uint8_t state;
+  uint8_t bus;                        // I2C port in the top bit and I2C address below, or STORE_BUS_UNKNOWN
+  uint16_t crc;
+  int32_t temperature;
+  uint32_t pressure;
+  uint32_t humidity;
+  int64_t timestamp;
+} store_record_t;
+
+
+esp_err_t store_init();
+
+
+esp_err_t store_write(const sample_t *sample);
+
+
+esp_err_t store_flush();
+
+
+uint32_t store_read(sample_t *samples, uint32_t max_samples);
+
+
+esp_err_t store_commit(uint32_t count);
+
+
+uint32_t store_count();
+
+
+#endif /* _STORE_H_ */
@@ -0,0 +1,169 @@
+/**
+ * @file    tls.c
+ *
+ * @brief   TLS Source File
+ *
+ * @remarks The session of the last handshake is kept serialized in RTC memory, so that the connections after an idle
+ *          close, a lost AP, a light sleep or a deep sleep resume it with an abbreviated handshake: the server takes
+ *          back its session ticket, and neither the certificate chain, nor the signature check, nor the key exchange
+ *          are needed. A session the server no longer takes only costs the full handshake it would have cost anyway.
+ *          The session is loaded into and copied out of one static client session, so that a reconnect allocates
+ *          nothing for it beyond what mbedTLS does for its ticket.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "tls.h"
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "mbedtls/ssl.h"
+
+#include "perf.h"
+
+#include <string.h>
+
+
+static RTC_DATA_ATTR uint8_t tls_session[TLS_SESSION_SIZE];
+static RTC_DATA_ATTR uint32_t tls_session_len;
+// The session offered to, or taken from, the connection being made. Only the HTTP task connects.
+static esp_tls_client_session_t tls_client_session;
+
+
+/**
+ * @brief           Loads the saved session into the client session.
+ *
+ * @return          The client session, or NULL if there is none.
+ */
+static esp_tls_client_session_t *tls_restore()
+{
+  if (tls_session_len == 0) {
+    return NULL;
+  }
+
+  mbedtls_ssl_session_init(&tls_client_session.saved_session);
+  int ret = mbedtls_ssl_session_load(&tls_client_session.saved_session, tls_session, tls_session_len);
+  if (ret != 0) {
+    ESP_LOGW(TLS_TAG, "Session load failed with error -0x%x", -ret);
+    mbedtls_ssl_session_free(&tls_client_session.saved_session);
+    tls_forget();
+    return NULL;
+  }
+
+  return &tls_client_session;
+}
+
+
+/**
+ * @brief           Saves the session of an established connection, for the next one to resume. The session is copied
+ *                  out of the connection itself, as esp_tls_get_client_session would allocate one to copy it into.
+ *
+ * @param tls       The connection.
+ */
+static void tls_save(esp_tls_t *tls)
+{
+  mbedtls_ssl_session *session = &tls_client_session.saved_session;
+  mbedtls_ssl_session_init(session);
+
+  int ret = mbedtls_ssl_get_session(&tls->ssl, session);
+  if (ret != 0) {
+    ESP_LOGW(TLS_TAG, "Session copy failed with error -0x%x", -ret);
+    mbedtls_ssl_session_free(session);
+    return;
+  }
+
+  size_t len = 0;
+  ret = mbedtls_ssl_session_save(session, tls_session, sizeof(tls_session), &len);
+  if (ret != 0) {
+    ESP_LOGW(TLS_TAG, "Session save of %u bytes failed with error -0x%x", (uint32_t)len, -ret);
+    len = 0;
+  }
+  tls_session_len = len;
+
+  mbedtls_ssl_session_free(session);
+}
+
+
+/**
+ * @brief           Connects to a server and verifies it against the global CA store, resuming the saved session if
+ *                  there is one.
+ *
+ * @param host      The server name or address.
+ * @param port      The server port.
+ * @param timeout_ms  The timeout of the connection and of every read and write on it.
+ * @param resumed   Set if the handshake resumed the saved session.
+ *
+ * @return          The connection, or NULL on failure.
+ */
+esp_tls_t *tls_connect(const char *host, uint16_t port, uint32_t timeout_ms, bool *resumed)
+{
+  esp_tls_t *tls = esp_tls_init();
+  if (tls == NULL) {
+    ESP_LOGE(TLS_TAG, "Initialization failed");
+    return NULL;
+  }
+
+  esp_tls_client_session_t *session = tls_restore();
+  esp_tls_cfg_t cfg = {
+    .use_global_ca_store = true,
+    .skip_common_name = true,
+    .timeout_ms = timeout_ms,
+    .client_session = session
+  };
+
+  // A resumed handshake keeps the master secret of the saved session, while a full one derives a new one.
+  uint8_t offered_master[sizeof(session->saved_session.master)];
+  if (session != NULL) {
+    memcpy(offered_master, session->saved_session.master, sizeof(offered_master));
+  }
+
+  uint32_t start_us = perf_now_us();
+  int ret = esp_tls_conn_new_sync(host, strlen(host), port, &cfg, tls);
+  uint32_t handshake_us = perf_now_us() - start_us;
+
+  if (ret != 1) {
+    int mbedtls_err = 0;
+    esp_err_t esp_err = esp_tls_get_and_clear_last_error(tls->error_handle, &mbedtls_err, NULL);
+    ESP_LOGE(TLS_TAG, "Connection failed with error 0x%x, mbedtls error -0x%x", esp_err, -mbedtls_err);
+    if (session != NULL) {
+      mbedtls_ssl_session_free(&session->saved_session);
+    }
+    esp_tls_conn_destroy(tls);
+    return NULL;
+  }
+
+  *resumed = session != NULL && tls->ssl.session != NULL &&
+             memcmp(tls->ssl.session->master, offered_master, sizeof(offered_master)) == 0;
+  if (session != NULL) {
+    mbedtls_ssl_session_free(&session->saved_session);
+  }
+  perf_record(*resumed ? PERF_STAGE_RESUME : PERF_STAGE_CONNECT, handshake_us);
+  ESP_LOGD(TLS_TAG, "%s handshake in %u us", *resumed ? "Resumed" : "Full", handshake_us);
+
+  tls_save(tls);
+
+  return tls;
+}
+
+
+/**
+ * @brief           Closes a connection. Its session is kept for the next one.
+ *
+ * @param tls       The connection.
+ */
+void tls_close(esp_tls_t *tls)
+{
+  esp_tls_conn_destroy(tls);
+}
+
+
+/**
+ * @brief           Drops the saved session, so that the next connection makes a full handshake.
+ */
+void tls_forget()
+{
+  tls_session_len = 0;
+}
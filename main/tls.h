@@ -0,0 +1,39 @@
+/**
+ * @file    tls.h
+ *
+ * @brief   TLS Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _TLS_H_
+#define _TLS_H_
+
+
+#include "esp_tls.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#define TLS_TAG                       "TLS "
+
+// The serialized session of the last handshake: the ticket, the master secret and, if mbedTLS keeps it, the certificate
+// of the server. One on P-256 fits, while a session that does not is not saved and every connection costs a full
+// handshake, as without resumption.
+#define TLS_SESSION_SIZE              (1024)
+
+
+esp_tls_t *tls_connect(const char *host, uint16_t port, uint32_t timeout_ms, bool *resumed);
+
+
+void tls_close(esp_tls_t *tls);
+
+
+void tls_forget();
+
+
+#endif /* _TLS_H_ */
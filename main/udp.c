@@ -0,0 +1,163 @@
+/**
+ * @file    udp.c
+ *
+ * @brief   UDP Source File
+ *
+ * @remarks A batch is cut at its line boundaries into as few datagrams as fit it. They are assembled in one static
+ *          buffer, so a send allocates nothing beyond what the IP stack does for the packet itself.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "udp.h"
+
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "lwip/sockets.h"
+
+#include "http.h"
+#include "lp.h"
+#include "perf.h"
+
+#include <string.h>
+
+
+static int udp_socket = -1;
+static char udp_datagram[UDP_DATAGRAM_SIZE];
+static RTC_DATA_ATTR uint32_t udp_sequence;
+
+
+/**
+ * @brief           Starts a datagram, with its sequence point if enabled.
+ *
+ * @return          The length of the datagram so far.
+ */
+static uint32_t udp_begin()
+{
+#if UDP_SEQUENCE
+  lp_t lp;
+  lp_begin(&lp, udp_datagram, sizeof(udp_datagram), UDP_SEQ_MEASUREMENT);
+  lp_tag(&lp, "location", HTTP_LOCATION);
+  lp_field_int(&lp, "seq", udp_sequence++);
+
+  return lp_end(&lp);
+#else
+  return 0;
+#endif
+}
+
+
+/**
+ * @brief           Sends the assembled datagram.
+ *
+ * @param len       The length of the datagram.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL
+ */
+static esp_err_t udp_flush(uint32_t len)
+{
+  uint32_t start_us = perf_now_us();
+  int sent = send(udp_socket, udp_datagram, len, 0);
+  perf_record(PERF_STAGE_POST, perf_now_us() - start_us);
+
+  // The socket is opened again on the next send, as an error may have left it unusable.
+  if (sent < 0) {
+    ESP_LOGE(UDP_TAG, "Send failed with errno %d", errno);
+    close(udp_socket);
+    udp_socket = -1;
+    return ESP_FAIL;
+  }
+
+  return ESP_OK;
+}
+
+
+/**
+ * @brief           Opens the socket to the InfluxDB UDP listener.
+ *
+ * @return        - ESP_OK
+ *                - ESP_FAIL
+ */
+static esp_err_t udp_open()
+{
+  struct sockaddr_in addr = {
+    .sin_family = AF_INET,
+    .sin_port = htons(UDP_PORT)
+  };
+
+  if (inet_aton(UDP_HOST, &addr.sin_addr) == 0) {
+    ESP_LOGE(UDP_TAG, "Invalid host %s", UDP_HOST);
+    return ESP_FAIL;
+  }
+
+  udp_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+  if (udp_socket < 0) {
+    ESP_LOGE(UDP_TAG, "Socket failed with errno %d", errno);
+    return ESP_FAIL;
+  }
+
+  // Fixes the destination, so that every send skips the address lookup.
+  if (connect(udp_socket, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    ESP_LOGE(UDP_TAG, "Connect failed with errno %d", errno);
+    close(udp_socket);
+    udp_socket = -1;
+    return ESP_FAIL;
+  }
+
+  return ESP_OK;
+}
+
+
+/**
+ * @brief           Sends a batch of line protocol points, as many to a datagram as fit. The socket is opened on the
+ *                  first send, once the network is up.
+ *
+ * @param data      The points, separated by new lines.
+ * @param data_len  The length of the points.
+ *
+ * @return        - ESP_OK if every datagram was handed to the IP stack
+ *                - ESP_FAIL
+ */
+esp_err_t udp_send(const char *data, uint32_t data_len)
+{
+  if (data_len == 0) {
+    return ESP_OK;
+  }
+
+  if (udp_socket < 0 && udp_open() != ESP_OK) {
+    return ESP_FAIL;
+  }
+
+  uint32_t len = udp_begin();
+  uint32_t start = 0;
+
+  while (start < data_len) {
+    const char *end = memchr(data + start, '\n', data_len - start);
+    uint32_t line_len = end != NULL ? (uint32_t)(end - data) - start : data_len - start;
+
+    if (len > 0 && len + 1 + line_len > sizeof(udp_datagram)) {
+      if (udp_flush(len) != ESP_OK) {
+        return ESP_FAIL;
+      }
+      len = udp_begin();
+    }
+
+    if (len + 1 + line_len > sizeof(udp_datagram)) {
+      ESP_LOGW(UDP_TAG, "Point of %u bytes does not fit a datagram", line_len);
+    } else {
+      if (len > 0) {
+        udp_datagram[len++] = '\n';
+      }
+      memcpy(udp_datagram + len, data + start, line_len);
+      len += line_len;
+    }
+
+    start += line_len + 1;
+  }
+
+  return len > 0 ? udp_flush(len) : ESP_OK;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file    udp.h
+ *
+ * @brief   UDP Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _UDP_H_
+#define _UDP_H_
+
+
+#include "esp_err.h"
+
+#include <stdint.h>
+
+
+#define UDP_TAG                       "UDP "
+
+// The InfluxDB UDP listener. Only for trusted networks, the points are neither encrypted nor acknowledged. They are
+// stamped in nanoseconds, see HTTP_PRECISION, so the listener is left at its default precision.
+// The host build points it at its own listener.
+#ifndef UDP_HOST
+#define UDP_HOST                      "<Your InfluxDB IPv4 Address>"
+#endif
+#define UDP_PORT                      (8089)
+
+// An Ethernet MTU less the IP and UDP headers, so that a datagram is never fragmented.
+#define UDP_DATAGRAM_SIZE             (1472)
+
+// Starts every datagram with a UDP_SEQ_MEASUREMENT point holding its sequence number, so that the receiver can count
+// the lost datagrams from the gaps.
+#define UDP_SEQUENCE                  (1)
+#define UDP_SEQ_MEASUREMENT           "udp_seq"
+
+
+esp_err_t udp_send(const char *data, uint32_t data_len);
+
+
+#endif /* _UDP_H_ */
@@ -12,17 +12,134 @@
 #include "wifi.h"
 
 #include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "freertos/event_groups.h"
+#include "nvs.h"
 
+#include "boot.h"
+#include "clock.h"
+#include "perf.h"
+#include "power.h"
+#include "stats.h"
 
-static volatile uint8_t wifi_reconnect_counter;
+#include <string.h>
+
+
+static uint32_t wifi_attempts;
+static bool wifi_fast;
+static bool wifi_up;
+static uint32_t wifi_down_us;
+static wifi_cache_t wifi_cache;
+static bool wifi_cached;
+static wifi_config_t wifi_config;
+static esp_netif_t *wifi_netif;
+static esp_timer_handle_t wifi_backoff_timer;
 static EventGroupHandle_t wifi_event_group;
+static StaticEventGroup_t wifi_event_group_buffer;
+
+
+/**
+ * @brief             Starts a connection attempt.
+ */
+static void wifi_connect()
+{
+  esp_err_t esp_err = esp_wifi_connect();
+  if (esp_err != ESP_OK) {
+    ESP_LOGE(WIFI_TAG, "Connect failed with error 0x%x [%s]", esp_err, esp_err_to_name(esp_err));
+  }
+}
+
+
+/**
+ * @brief             Starts the connection attempt a backoff was waiting for. Called by the backoff timer.
+ *
+ * @param arg         Unused.
+ */
+static void wifi_backoff_expired(void *arg)
+{
+  wifi_connect();
+}
+
+
+/**
+ * @brief             Directs the next connection attempts either at the cached AP on its channel, or at any AP with
+ *                    the SSID after a scan of all channels.
+ *
+ * @param fast        Whether to go straight to the cached AP.
+ */
+static void wifi_set_target(bool fast)
+{
+  wifi_fast = fast && wifi_cached;
+
+  wifi_config.sta.bssid_set = wifi_fast;
+  wifi_config.sta.channel = wifi_fast ? wifi_cache.channel : 0;
+  wifi_config.sta.scan_method = wifi_fast ? WIFI_FAST_SCAN : WIFI_ALL_CHANNEL_SCAN;
+  wifi_config.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
+  if (wifi_fast) {
+    memcpy(wifi_config.sta.bssid, wifi_cache.bssid, sizeof(wifi_config.sta.bssid));
+  }
+
+  esp_err_t esp_err = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+  if (esp_err != ESP_OK) {
+    ESP_LOGE(WIFI_TAG, "Configuration failed with error 0x%x [%s]", esp_err, esp_err_to_name(esp_err));
+  }
+}
+
+
+/**
+ * @brief             Schedules the next connection attempt after the backoff delay.
+ */
+static void wifi_backoff()
+{
+  uint32_t shift = wifi_attempts < 16 ? wifi_attempts : 16;
+  uint32_t delay_ms = WIFI_BACKOFF_MIN_MS << shift;
+  if (delay_ms > WIFI_BACKOFF_MAX_MS) {
+    delay_ms = WIFI_BACKOFF_MAX_MS;
+  }
+  delay_ms = delay_ms / 2 + esp_random() % (delay_ms / 2 + 1);
+
+  wifi_attempts++;
+  stats_inc(STATS_WIFI_RECONNECTS);
+
+  ESP_LOGI(WIFI_TAG, "Reconnect attempt %u in %u ms", wifi_attempts, delay_ms);
+  esp_timer_stop(wifi_backoff_timer);
+  esp_timer_start_once(wifi_backoff_timer, (uint64_t)delay_ms * 1000);
+}
+
+
+#if WIFI_STATIC_IP
+/**
+ * @brief             Sets the fixed address instead of asking the DHCP server. Posts IP_EVENT_STA_GOT_IP.
+ */
+static void wifi_set_static_ip()
+{
+  esp_netif_dhcpc_stop(wifi_netif);
+
+  esp_netif_ip_info_t ip_info = { 0 };
+  esp_netif_str_to_ip4(WIFI_IP, &ip_info.ip);
+  esp_netif_str_to_ip4(WIFI_GATEWAY, &ip_info.gw);
+  esp_netif_str_to_ip4(WIFI_NETMASK, &ip_info.netmask);
+
+  esp_err_t esp_err = esp_netif_set_ip_info(wifi_netif, &ip_info);
+  if (esp_err != ESP_OK) {
+    ESP_LOGE(WIFI_TAG, "Static IP setup failed with error 0x%x [%s]", esp_err, esp_err_to_name(esp_err));
+  }
+
+  esp_netif_dns_info_t dns_info = { .ip.type = ESP_IPADDR_TYPE_V4 };
+  esp_netif_str_to_ip4(WIFI_DNS, &dns_info.ip.u_addr.ip4);
+  esp_netif_set_dns_info(wifi_netif, ESP_NETIF_DNS_MAIN, &dns_info);
+}
+#endif
 
 
 /**
  * @brief             The WIFI event handler.
  *
+ * @remarks           A connection that drops is retried right away at the cached AP, and a failed attempt at the
+ *                    cached AP right away with a full scan. Only failed full scans back off.
+ *
  * @param arg         Arguments sent by event registrations.
  * @param event_base  The base code of the event.
  * @param event_id    The id of the event.
@@ -30,33 +147,96 @@ static EventGroupHandle_t wifi_event_group;
  */
 static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
 {
-  esp_err_t esp_err = ESP_OK;
   if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-    esp_err = esp_wifi_connect();
-    if (esp_err != ESP_OK) {
-      ESP_LOGE(WIFI_TAG, "Connect failed with error 0x%x [%s]", esp_err, esp_err_to_name(esp_err));
-    }
+    wifi_connect();
+  } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+#if WIFI_STATIC_IP
+    wifi_set_static_ip();
+#endif
   } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-    if (wifi_reconnect_counter < WIFI_MAX_RECONNECTIONS) {
-      wifi_reconnect_counter++;
+    if (wifi_up) {
+      wifi_up = false;
+      wifi_down_us = perf_now_us();
+      xEventGroupSetBits(wifi_event_group, WIFI_FAIL_BIT);
 
-      ESP_LOGI(WIFI_TAG, "Reconnect attempt %d", wifi_reconnect_counter);
-      esp_err = esp_wifi_connect();
-      if (esp_err != ESP_OK) {
-        ESP_LOGE(WIFI_TAG, "Connect failed with error 0x%x [%s]", esp_err, esp_err_to_name(esp_err));
-      }
+      stats_inc(STATS_WIFI_RECONNECTS);
+      wifi_set_target(true);
+      wifi_connect();
+    } else if (wifi_fast) {
+      ESP_LOGI(WIFI_TAG, "Cached AP not found, scanning");
+      wifi_set_target(false);
+      wifi_connect();
     } else {
-      xEventGroupSetBits(wifi_event_group, WIFI_FAIL_BIT);
+      wifi_backoff();
     }
   } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
     ip_event_got_ip_t *event = (ip_event_got_ip_t*) event_data;
-    ESP_LOGI(WIFI_TAG, "Got IP:" IPSTR, IP2STR(&event->ip_info.ip));
-    wifi_reconnect_counter = 0;
+    uint32_t down_us = perf_now_us() - wifi_down_us;
+    ESP_LOGI(WIFI_TAG, "Got IP:" IPSTR " in %u ms", IP2STR(&event->ip_info.ip), down_us / 1000);
+    perf_record(PERF_STAGE_WIFI, down_us);
+    boot_ready(BOOT_STAGE_IP);
+    wifi_attempts = 0;
+    wifi_up = true;
     xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT);
   }
 }
 
 
+/**
+ * @brief             Loads the AP of the last connection from NVS.
+ */
+static void wifi_cache_load()
+{
+  nvs_handle_t nvs;
+  if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+    return;
+  }
+
+  size_t size = sizeof(wifi_cache);
+  wifi_cached = nvs_get_blob(nvs, WIFI_NVS_KEY, &wifi_cache, &size) == ESP_OK && size == sizeof(wifi_cache);
+  nvs_close(nvs);
+}
+
+
+/**
+ * @brief             Keeps the AP of the current connection in NVS. Only writes when the AP changed.
+ */
+static void wifi_cache_store()
+{
+  wifi_ap_record_t ap;
+  if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+    return;
+  }
+
+  if (wifi_cached && memcmp(ap.bssid, wifi_cache.bssid, sizeof(wifi_cache.bssid)) == 0 && ap.primary == wifi_cache.channel) {
+    return;
+  }
+
+  wifi_cache_t cache;
+  memcpy(cache.bssid, ap.bssid, sizeof(cache.bssid));
+  cache.channel = ap.primary;
+
+  nvs_handle_t nvs;
+  esp_err_t esp_err = nvs_open(WIFI_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+  if (esp_err == ESP_OK) {
+    esp_err = nvs_set_blob(nvs, WIFI_NVS_KEY, &cache, sizeof(cache));
+    if (esp_err == ESP_OK) {
+      esp_err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+  }
+
+  if (esp_err != ESP_OK) {
+    ESP_LOGE(WIFI_TAG, "AP cache store failed with error 0x%x [%s]", esp_err, esp_err_to_name(esp_err));
+    return;
+  }
+
+  wifi_cache = cache;
+  wifi_cached = true;
+  ESP_LOGI(WIFI_TAG, "Cached AP " MACSTR " on channel %u", MAC2STR(cache.bssid), cache.channel);
+}
+
+
 /**
  * @brief             Waits until the wifi_event_handler sets the WIFI_CONNECTED_BIT or the WIFI_FAIL_BIT and logs the info.
  */
@@ -65,27 +245,28 @@ static void wifi_check_connection()
   // Waits until either the WIFI_CONNECTED_BIT or the WIFI_FAIL_BIT is set. The bits are set by the wifi_event_handler.
   EventBits_t bits = xEventGroupWaitBits(wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT, pdFALSE, pdFALSE, portMAX_DELAY);
 
+  // Clears the bits and prepares for the next iteration.
+  xEventGroupClearBits(wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT);
+
   if (bits & WIFI_CONNECTED_BIT) {
     ESP_LOGI(WIFI_TAG, "Connected to AP with SSID: %s", WIFI_SSID);
-  } else if (bits & WIFI_FAIL_BIT) {
-    ESP_LOGI(WIFI_TAG, "Failed to connect to AP with SSID: %s", WIFI_SSID);
-  } else {
-    ESP_LOGE(WIFI_TAG, "Unexpected event");
+    wifi_cache_store();
+  }
+  if (bits & WIFI_FAIL_BIT) {
+    ESP_LOGI(WIFI_TAG, "Disconnected from AP with SSID: %s", WIFI_SSID);
   }
-
-  // Clears the bits and prepares for the next iteration.
-  xEventGroupClearBits(wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT);
 }
 
 
 /**
- * @brief             The WIFI task function. Makes a connection to an AP and preserves it.
+ * @brief             The WIFI task function. Makes a connection to an AP, preferably the cached one, and reports every
+ *                    later outcome of the reconnections started by the wifi_event_handler.
  */
 void wifi_task()
 {
   esp_err_t esp_err = ESP_OK;
 
-  wifi_event_group = xEventGroupCreate();
+  wifi_event_group = xEventGroupCreateStatic(&wifi_event_group_buffer);
 
   esp_err = esp_netif_init();
   if (esp_err != ESP_OK) {
@@ -97,7 +278,23 @@ void wifi_task()
     ESP_LOGE(WIFI_TAG, "Event loop creation failed with error 0x%x [%s]", esp_err, esp_err_to_name(esp_err));
   }
 
-  esp_netif_create_default_wifi_sta();
+  wifi_netif = esp_netif_create_default_wifi_sta();
+  boot_ready(BOOT_STAGE_NET);
+
+  const esp_timer_create_args_t backoff_timer_args = {
+    .callback = wifi_backoff_expired,
+    .name = "wifi_backoff"
+  };
+  esp_err = esp_timer_create(&backoff_timer_args, &wifi_backoff_timer);
+  if (esp_err != ESP_OK) {
+    ESP_LOGE(WIFI_TAG, "Backoff timer creation failed with error 0x%x [%s]", esp_err, esp_err_to_name(esp_err));
+  }
+
+  // SNTP keeps polling in the background and synchronizes as soon as the connection is up.
+  clock_init();
+
+  // The driver keeps its calibration and the AP cache in NVS.
+  boot_wait(BOOT_STAGE_NVS, portMAX_DELAY);
 
   wifi_init_config_t wifi_init_config = WIFI_INIT_CONFIG_DEFAULT();
   esp_err = esp_wifi_init(&wifi_init_config);
@@ -105,6 +302,8 @@ void wifi_task()
     ESP_LOGE(WIFI_TAG, "Driver initialization failed with error 0x%x [%s]", esp_err, esp_err_to_name(esp_err));
   }
 
+  wifi_cache_load();
+
   esp_event_handler_instance_t instance_any_id;
   esp_err = esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, &wifi_event_handler, NULL, &instance_any_id);
   if (esp_err != ESP_OK) {
@@ -117,11 +316,14 @@ void wifi_task()
     ESP_LOGE(WIFI_TAG, "IP event instance register failed with error 0x%x [%s]", esp_err, esp_err_to_name(esp_err));
   }
 
-  wifi_config_t wifi_config = {
+  wifi_config = (wifi_config_t) {
     .sta = {
       .ssid = WIFI_SSID,
       .password = WIFI_PASS,
       .threshold.authmode = WIFI_AUTH_WPA2_PSK,
+#if POWER_MODE == POWER_MODE_LIGHT_SLEEP
+      .listen_interval = POWER_LISTEN_INTERVAL,
+#endif
       .pmf_cfg = {
         .capable = true,
         .required = false
@@ -133,25 +335,22 @@ void wifi_task()
     ESP_LOGE(WIFI_TAG, "Operation mode setup failed with error 0x%x [%s]", esp_err, esp_err_to_name(esp_err));
   }
 
-  esp_err = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
-  if (esp_err != ESP_OK) {
-    ESP_LOGE(WIFI_TAG, "Configuration failed with error 0x%x [%s]", esp_err, esp_err_to_name(esp_err));
-  }
+  wifi_set_target(true);
 
   esp_err = esp_wifi_start();
   if (esp_err != ESP_OK) {
     ESP_LOGE(WIFI_TAG, "Start failed with error 0x%x [%s]", esp_err, esp_err_to_name(esp_err));
   }
 
-  wifi_check_connection();
+#if POWER_MODE == POWER_MODE_LIGHT_SLEEP
+  // Wakes the radio only every POWER_LISTEN_INTERVAL beacons, so that the chip can light sleep in between.
+  esp_err = esp_wifi_set_ps(WIFI_PS_MAX_MODEM);
+  if (esp_err != ESP_OK) {
+    ESP_LOGE(WIFI_TAG, "Power save setup failed with error 0x%x [%s]", esp_err, esp_err_to_name(esp_err));
+  }
+#endif
 
   while(1) {
-    if (wifi_reconnect_counter == WIFI_MAX_RECONNECTIONS) {
-      wifi_reconnect_counter = 0;
-      esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, NULL, 0, 100 / portTICK_PERIOD_MS);
-      wifi_check_connection();
-    }
-
-    vTaskDelay(WIFI_CHECK_CONNECTION_PERIOD_MS / portTICK_PERIOD_MS);
+    wifi_check_connection();
   }
 }
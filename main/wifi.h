@@ -13,20 +13,46 @@
 #define _WIFI_H_
 
 
+#include <stdint.h>
+
+
 #define WIFI_TAG                        "WIFI"
 
 #define WIFI_SSID                       "Your Wifi SSID"
 #define WIFI_PASS                       "Your WiFi Password"
 
-#define WIFI_CHECK_CONNECTION_PERIOD_MS (10000)
 #define WIFI_CONNECTED_BIT              (BIT0)
 #define WIFI_FAIL_BIT                   (BIT1)
-#define WIFI_MAX_RECONNECTIONS          (10)
+
+// A failed connection is retried after a delay that doubles up to WIFI_BACKOFF_MAX_MS, of which a random half is
+// taken, so that stations that lost the same AP do not retry in lockstep.
+#define WIFI_BACKOFF_MIN_MS             (500)
+#define WIFI_BACKOFF_MAX_MS             (60000)
+
+// The AP that was last connected to is kept in NVS, and the next connection goes straight to it on its channel before
+// falling back to a full scan.
+#define WIFI_NVS_NAMESPACE              "wifi"
+#define WIFI_NVS_KEY                    "ap"
+
+// Skips DHCP with a fixed address. Otherwise the last lease is requested again, see CONFIG_LWIP_DHCP_RESTORE_LAST_IP.
+#define WIFI_STATIC_IP                  (0)
+#define WIFI_IP                         "192.168.1.50"
+#define WIFI_GATEWAY                    "192.168.1.1"
+#define WIFI_NETMASK                    "255.255.255.0"
+#define WIFI_DNS                        "192.168.1.1"
 
 #define WIFI_TASK_NAME                  "wifi"
 #define WIFI_TASK_PRIORITY              (tskIDLE_PRIORITY + 1)
 #define WIFI_TASK_STACK_SIZE            (8192)
 
+/**
+ * @brief   The AP of the last connection.
+ */
+typedef struct {
+  uint8_t bssid[6];
+  uint8_t channel;
+} wifi_cache_t;
+
 
 void wifi_task();
 
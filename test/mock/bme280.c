@@ -0,0 +1,142 @@
+/**
+ * @file    bme280.c
+ *
+ * @brief   BME280 Driver Shim Source File
+ *
+ * @remarks Mirrors the calls of the Bosch driver over the interface of the device, so that every access goes through
+ *          bme.c and i2c.c as on the target. The data registers are decoded as the simulated sensor encodes them.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "bme280.h"
+
+#include "mock.h"
+
+
+static int8_t bme280_set_regs(uint8_t reg_addr, uint8_t value, struct bme280_dev *dev)
+{
+  dev->intf_rslt = dev->write(reg_addr, &value, 1, dev->intf_ptr);
+
+  return dev->intf_rslt == 0 ? BME280_OK : BME280_E_COMM_FAIL;
+}
+
+
+int8_t bme280_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint16_t len, struct bme280_dev *dev)
+{
+  if (dev == NULL || dev->read == NULL) {
+    return BME280_E_NULL_PTR;
+  }
+
+  dev->intf_rslt = dev->read(reg_addr, reg_data, len, dev->intf_ptr);
+
+  return dev->intf_rslt == 0 ? BME280_OK : BME280_E_COMM_FAIL;
+}
+
+
+int8_t bme280_init(struct bme280_dev *dev)
+{
+  int8_t rslt = BME280_E_DEV_NOT_FOUND;
+
+  // The Bosch driver tries five times, 1 ms apart.
+  for (int attempt = 0; attempt < 5; attempt++) {
+    uint8_t chip_id = 0;
+    if (bme280_get_regs(BME280_CHIP_ID_ADDR, &chip_id, 1, dev) == BME280_OK && chip_id == BME280_CHIP_ID) {
+      dev->chip_id = chip_id;
+      rslt = bme280_set_regs(BME280_RESET_ADDR, BME280_SOFT_RESET_COMMAND, dev);
+      break;
+    }
+    dev->delay_us(1000, dev->intf_ptr);
+  }
+
+  if (rslt == BME280_OK) {
+    // The start-up time after a reset.
+    dev->delay_us(2000, dev->intf_ptr);
+  }
+
+  return rslt;
+}
+
+
+int8_t bme280_set_sensor_settings(uint8_t desired_settings, struct bme280_dev *dev)
+{
+  int8_t rslt = BME280_OK;
+  const struct bme280_settings *settings = &dev->settings;
+
+  // The settings only take effect in sleep mode.
+  uint8_t ctrl_meas = 0;
+  rslt = bme280_get_regs(BME280_PWR_CTRL_ADDR, &ctrl_meas, 1, dev);
+  if (rslt == BME280_OK && (ctrl_meas & 0x03) != BME280_SLEEP_MODE) {
+    rslt = bme280_set_regs(BME280_PWR_CTRL_ADDR, ctrl_meas & ~0x03, dev);
+  }
+
+  if (rslt == BME280_OK && (desired_settings & BME280_OSR_HUM_SEL)) {
+    // The humidity setting is only latched by a write to the measurement control.
+    rslt = bme280_set_regs(BME280_CTRL_HUM_ADDR, settings->osr_h & 0x07, dev);
+    desired_settings |= BME280_OSR_PRESS_SEL | BME280_OSR_TEMP_SEL;
+  }
+
+  if (rslt == BME280_OK && (desired_settings & (BME280_OSR_PRESS_SEL | BME280_OSR_TEMP_SEL))) {
+    ctrl_meas = (settings->osr_t & 0x07) << 5 | (settings->osr_p & 0x07) << 2;
+    rslt = bme280_set_regs(BME280_PWR_CTRL_ADDR, ctrl_meas, dev);
+  }
+
+  if (rslt == BME280_OK && (desired_settings & (BME280_FILTER_SEL | BME280_STANDBY_SEL))) {
+    uint8_t config = (settings->standby_time & 0x07) << 5 | (settings->filter & 0x07) << 2;
+    rslt = bme280_set_regs(BME280_CONFIG_ADDR, config, dev);
+  }
+
+  return rslt;
+}
+
+
+int8_t bme280_set_sensor_mode(uint8_t sensor_mode, struct bme280_dev *dev)
+{
+  uint8_t ctrl_meas = 0;
+
+  int8_t rslt = bme280_get_regs(BME280_PWR_CTRL_ADDR, &ctrl_meas, 1, dev);
+  if (rslt == BME280_OK) {
+    rslt = bme280_set_regs(BME280_PWR_CTRL_ADDR, (ctrl_meas & ~0x03) | (sensor_mode & 0x03), dev);
+  }
+
+  return rslt;
+}
+
+
+int8_t bme280_get_sensor_data(uint8_t sensor_comp, struct bme280_data *comp_data, struct bme280_dev *dev)
+{
+  uint8_t data[BME280_P_T_H_DATA_LEN];
+
+  int8_t rslt = bme280_get_regs(BME280_DATA_ADDR, data, sizeof(data), dev);
+  if (rslt != BME280_OK) {
+    return rslt;
+  }
+
+  uint32_t pressure = (uint32_t)data[0] << 12 | (uint32_t)data[1] << 4 | data[2] >> 4;
+  uint32_t temperature = (uint32_t)data[3] << 12 | (uint32_t)data[4] << 4 | data[5] >> 4;
+  uint32_t humidity = (uint32_t)data[6] << 8 | data[7];
+
+  comp_data->pressure = pressure;
+  comp_data->temperature = (int32_t)temperature - MOCK_BME280_T_OFFSET;
+  comp_data->humidity = humidity * 2;
+
+  return BME280_OK;
+}
+
+
+/**
+ * @brief           The maximum measurement time in milliseconds, as computed by the Bosch driver.
+ */
+uint32_t bme280_cal_meas_delay(const struct bme280_settings *settings)
+{
+  static const uint8_t osr[] = { 0, 1, 2, 4, 8, 16 };
+
+  uint32_t t = osr[settings->osr_t < sizeof(osr) ? settings->osr_t : sizeof(osr) - 1];
+  uint32_t p = osr[settings->osr_p < sizeof(osr) ? settings->osr_p : sizeof(osr) - 1];
+  uint32_t h = osr[settings->osr_h < sizeof(osr) ? settings->osr_h : sizeof(osr) - 1];
+
+  return (1250 + 2300 * t + (2300 * p + 575) + (2300 * h + 575)) / 1000;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file    bme280.h
+ *
+ * @brief   BME280 Driver Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_BME280_H_
+#define _MOCK_BME280_H_
+
+
+#include <stdint.h>
+
+
+#define BME280_OK                     (0)
+#define BME280_E_NULL_PTR             (-1)
+#define BME280_E_DEV_NOT_FOUND        (-2)
+#define BME280_E_COMM_FAIL            (-4)
+
+#define BME280_I2C_ADDR_PRIM          (0x76)
+#define BME280_I2C_ADDR_SEC           (0x77)
+#define BME280_CHIP_ID                (0x60)
+
+#define BME280_CHIP_ID_ADDR           (0xD0)
+#define BME280_RESET_ADDR             (0xE0)
+#define BME280_CTRL_HUM_ADDR          (0xF2)
+#define BME280_STATUS_REG_ADDR        (0xF3)
+#define BME280_PWR_CTRL_ADDR          (0xF4)
+#define BME280_CONFIG_ADDR            (0xF5)
+#define BME280_DATA_ADDR              (0xF7)
+#define BME280_P_T_H_DATA_LEN         (8)
+#define BME280_SOFT_RESET_COMMAND     (0xB6)
+
+#define BME280_I2C_INTF               (1)
+
+#define BME280_NO_OVERSAMPLING        (0)
+#define BME280_OVERSAMPLING_1X        (1)
+#define BME280_OVERSAMPLING_2X        (2)
+#define BME280_OVERSAMPLING_4X        (3)
+#define BME280_OVERSAMPLING_8X        (4)
+#define BME280_OVERSAMPLING_16X       (5)
+
+#define BME280_FILTER_COEFF_OFF       (0)
+#define BME280_FILTER_COEFF_2         (1)
+#define BME280_FILTER_COEFF_4         (2)
+#define BME280_FILTER_COEFF_8         (3)
+#define BME280_FILTER_COEFF_16        (4)
+
+#define BME280_STANDBY_TIME_0_5_MS    (0)
+#define BME280_STANDBY_TIME_62_5_MS   (1)
+#define BME280_STANDBY_TIME_125_MS    (2)
+#define BME280_STANDBY_TIME_250_MS    (3)
+#define BME280_STANDBY_TIME_500_MS    (4)
+#define BME280_STANDBY_TIME_1000_MS   (5)
+
+#define BME280_OSR_PRESS_SEL          (1)
+#define BME280_OSR_TEMP_SEL           (1 << 1)
+#define BME280_OSR_HUM_SEL            (1 << 2)
+#define BME280_FILTER_SEL             (1 << 3)
+#define BME280_STANDBY_SEL            (1 << 4)
+
+#define BME280_PRESS                  (1)
+#define BME280_TEMP                   (1 << 1)
+#define BME280_HUM                    (1 << 2)
+#define BME280_ALL                    (0x07)
+
+#define BME280_SLEEP_MODE             (0x00)
+#define BME280_FORCED_MODE            (0x01)
+#define BME280_NORMAL_MODE            (0x03)
+
+typedef int8_t (*bme280_read_fptr_t)(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr);
+typedef int8_t (*bme280_write_fptr_t)(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr);
+typedef void (*bme280_delay_us_fptr_t)(uint32_t period, void *intf_ptr);
+
+// As with BME280_32BIT_ENABLE: 0.01 degC, Pa and 1/1024 %RH.
+struct bme280_data {
+  uint32_t pressure;
+  int32_t temperature;
+  uint32_t humidity;
+};
+
+struct bme280_settings {
+  uint8_t osr_p;
+  uint8_t osr_t;
+  uint8_t osr_h;
+  uint8_t filter;
+  uint8_t standby_time;
+};
+
+struct bme280_dev {
+  uint8_t chip_id;
+  int intf;
+  void *intf_ptr;
+  int8_t intf_rslt;
+  bme280_read_fptr_t read;
+  bme280_write_fptr_t write;
+  bme280_delay_us_fptr_t delay_us;
+  struct bme280_settings settings;
+};
+
+
+int8_t bme280_init(struct bme280_dev *dev);
+
+
+int8_t bme280_set_sensor_settings(uint8_t desired_settings, struct bme280_dev *dev);
+
+
+int8_t bme280_set_sensor_mode(uint8_t sensor_mode, struct bme280_dev *dev);
+
+
+int8_t bme280_get_sensor_data(uint8_t sensor_comp, struct bme280_data *comp_data, struct bme280_dev *dev);
+
+
+int8_t bme280_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint16_t len, struct bme280_dev *dev);
+
+
+uint32_t bme280_cal_meas_delay(const struct bme280_settings *settings);
+
+
+#endif /* _MOCK_BME280_H_ */
@@ -0,0 +1,100 @@
+/**
+ * @file    i2c.h
+ *
+ * @brief   I2C Driver Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_DRIVER_I2C_H_
+#define _MOCK_DRIVER_I2C_H_
+
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define I2C_NUM_0                     (0)
+#define I2C_NUM_1                     (1)
+#define I2C_NUM_MAX                   (2)
+
+#define GPIO_NUM_5                    (5)
+#define GPIO_NUM_18                   (18)
+#define GPIO_NUM_19                   (19)
+#define GPIO_NUM_23                   (23)
+#define GPIO_PULLUP_ENABLE            (1)
+
+// As in the IDF, a link holds a header and up to five commands per transaction.
+#define I2C_INTERNAL_STRUCT_SIZE      (24)
+#define I2C_LINK_RECOMMENDED_SIZE(TRANSACTIONS) \
+                                      (2 * I2C_INTERNAL_STRUCT_SIZE + I2C_INTERNAL_STRUCT_SIZE * (5 * (TRANSACTIONS)))
+
+typedef int i2c_port_t;
+typedef void *i2c_cmd_handle_t;
+
+typedef enum {
+  I2C_MODE_SLAVE,
+  I2C_MODE_MASTER
+} i2c_mode_t;
+
+typedef enum {
+  I2C_MASTER_WRITE,
+  I2C_MASTER_READ
+} i2c_rw_t;
+
+typedef enum {
+  I2C_MASTER_ACK,
+  I2C_MASTER_NACK,
+  I2C_MASTER_LAST_NACK
+} i2c_ack_type_t;
+
+typedef struct {
+  i2c_mode_t mode;
+  int sda_io_num;
+  int scl_io_num;
+  int sda_pullup_en;
+  int scl_pullup_en;
+  struct {
+    uint32_t clk_speed;
+  } master;
+} i2c_config_t;
+
+
+esp_err_t i2c_param_config(i2c_port_t port, const i2c_config_t *config);
+
+
+esp_err_t i2c_driver_install(i2c_port_t port, i2c_mode_t mode, size_t rx_len, size_t tx_len, int flags);
+
+
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t *buffer, uint32_t size);
+
+
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd);
+
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd);
+
+
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd);
+
+
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd, uint8_t data, bool ack_en);
+
+
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd, const uint8_t *data, size_t len, bool ack_en);
+
+
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd, uint8_t *data, size_t len, i2c_ack_type_t ack);
+
+
+esp_err_t i2c_master_cmd_begin(i2c_port_t port, i2c_cmd_handle_t cmd, TickType_t ticks);
+
+
+#endif /* _MOCK_DRIVER_I2C_H_ */
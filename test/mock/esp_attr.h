@@ -0,0 +1,23 @@
+/**
+ * @file    esp_attr.h
+ *
+ * @brief   ESP Attributes Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_ESP_ATTR_H_
+#define _MOCK_ESP_ATTR_H_
+
+
+// There is no RTC memory or IRAM, so these are plain data and code.
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+
+#endif /* _MOCK_ESP_ATTR_H_ */
@@ -0,0 +1,39 @@
+/**
+ * @file    esp_err.h
+ *
+ * @brief   ESP Error Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_ESP_ERR_H_
+#define _MOCK_ESP_ERR_H_
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+typedef int esp_err_t;
+
+#define ESP_OK                        (0)
+#define ESP_FAIL                      (-1)
+#define ESP_ERR_NO_MEM                (0x101)
+#define ESP_ERR_INVALID_ARG           (0x102)
+#define ESP_ERR_INVALID_STATE         (0x103)
+#define ESP_ERR_INVALID_SIZE          (0x104)
+#define ESP_ERR_NOT_FOUND             (0x105)
+#define ESP_ERR_NOT_SUPPORTED         (0x106)
+#define ESP_ERR_TIMEOUT               (0x107)
+#define ESP_ERR_INVALID_RESPONSE      (0x108)
+#define ESP_ERR_INVALID_CRC           (0x109)
+
+
+const char *esp_err_to_name(esp_err_t code);
+
+
+#endif /* _MOCK_ESP_ERR_H_ */
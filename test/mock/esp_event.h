@@ -0,0 +1,42 @@
+/**
+ * @file    esp_event.h
+ *
+ * @brief   ESP Event Loop Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_ESP_EVENT_H_
+#define _MOCK_ESP_EVENT_H_
+
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#include <stdint.h>
+
+
+#define ESP_EVENT_ANY_ID              (-1)
+
+typedef const char *esp_event_base_t;
+typedef void *esp_event_handler_instance_t;
+typedef void (*esp_event_handler_t)(void *arg, esp_event_base_t base, int32_t id, void *data);
+
+extern esp_event_base_t const WIFI_EVENT;
+extern esp_event_base_t const IP_EVENT;
+
+
+esp_err_t esp_event_loop_create_default();
+
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler,
+                                              void *arg, esp_event_handler_instance_t *instance);
+
+
+esp_err_t esp_event_post(esp_event_base_t base, int32_t id, const void *data, size_t size, TickType_t ticks);
+
+
+#endif /* _MOCK_ESP_EVENT_H_ */
@@ -0,0 +1,33 @@
+/**
+ * @file    esp_heap_caps.h
+ *
+ * @brief   ESP Heap Capabilities Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_ESP_HEAP_CAPS_H_
+#define _MOCK_ESP_HEAP_CAPS_H_
+
+
+#include "esp_err.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define MALLOC_CAP_8BIT               (1 << 2)
+
+typedef void (*esp_alloc_failed_hook_t)(size_t size, uint32_t caps, const char *function_name);
+
+
+esp_err_t heap_caps_register_failed_alloc_callback(esp_alloc_failed_hook_t callback);
+
+
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+
+
+#endif /* _MOCK_ESP_HEAP_CAPS_H_ */
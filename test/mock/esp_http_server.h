@@ -0,0 +1,81 @@
+/**
+ * @file    esp_http_server.h
+ *
+ * @brief   ESP HTTP Server Shim Header File
+ *
+ * @remarks Serves over the sockets of the host, on a loopback port picked by the system, see mock_httpd_port().
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_ESP_HTTP_SERVER_H_
+#define _MOCK_ESP_HTTP_SERVER_H_
+
+
+#include "esp_err.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+
+#define HTTPD_RESP_USE_STRLEN         (-1)
+
+#define HTTPD_DEFAULT_CONFIG()        {      \
+  .server_port = 80,                         \
+  .max_open_sockets = 7,                     \
+  .max_uri_handlers = 8,                     \
+  .stack_size = 4096,                        \
+  .lru_purge_enable = false                  \
+}
+
+typedef struct mock_httpd *httpd_handle_t;
+
+typedef enum {
+  HTTP_GET,
+  HTTP_POST
+} httpd_method_t;
+
+typedef struct {
+  uint16_t server_port;
+  uint16_t max_open_sockets;
+  uint16_t max_uri_handlers;
+  size_t stack_size;
+  bool lru_purge_enable;
+} httpd_config_t;
+
+typedef struct {
+  const char *uri;
+  int fd;
+  const char *type;
+  bool started;
+} httpd_req_t;
+
+typedef struct {
+  const char *uri;
+  httpd_method_t method;
+  esp_err_t (*handler)(httpd_req_t *req);
+  void *user_ctx;
+} httpd_uri_t;
+
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config);
+
+
+esp_err_t httpd_stop(httpd_handle_t handle);
+
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler);
+
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type);
+
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t buf_len);
+
+
+#endif /* _MOCK_ESP_HTTP_SERVER_H_ */
@@ -0,0 +1,22 @@
+/**
+ * @file    esp_idf_version.h
+ *
+ * @brief   ESP IDF Version Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_ESP_IDF_VERSION_H_
+#define _MOCK_ESP_IDF_VERSION_H_
+
+
+#define ESP_IDF_VERSION_VAL(major, minor, patch)  (((major) << 16) | ((minor) << 8) | (patch))
+
+// The oldest release the station supports.
+#define ESP_IDF_VERSION               ESP_IDF_VERSION_VAL(4, 4, 0)
+
+
+#endif /* _MOCK_ESP_IDF_VERSION_H_ */
@@ -0,0 +1,44 @@
+/**
+ * @file    esp_log.h
+ *
+ * @brief   ESP Log Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_ESP_LOG_H_
+#define _MOCK_ESP_LOG_H_
+
+
+#include "esp_err.h"
+
+#include <stdint.h>
+
+
+typedef enum {
+  ESP_LOG_NONE,
+  ESP_LOG_ERROR,
+  ESP_LOG_WARN,
+  ESP_LOG_INFO,
+  ESP_LOG_DEBUG,
+  ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+#define ESP_LOGE(tag, format, ...)    mock_log(ESP_LOG_ERROR, 'E', tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)    mock_log(ESP_LOG_WARN, 'W', tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)    mock_log(ESP_LOG_INFO, 'I', tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)    mock_log(ESP_LOG_DEBUG, 'D', tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...)    mock_log(ESP_LOG_VERBOSE, 'V', tag, format, ##__VA_ARGS__)
+
+
+void mock_log(esp_log_level_t level, char letter, const char *tag, const char *format, ...)
+  __attribute__((format(printf, 4, 5)));
+
+
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+
+
+#endif /* _MOCK_ESP_LOG_H_ */
@@ -0,0 +1,83 @@
+/**
+ * @file    esp_netif.h
+ *
+ * @brief   ESP Network Interface Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_ESP_NETIF_H_
+#define _MOCK_ESP_NETIF_H_
+
+
+#include "esp_err.h"
+
+#include <stdint.h>
+
+
+#define IPSTR                         "%d.%d.%d.%d"
+#define IP2STR(ipaddr)                (int)((ipaddr)->addr & 0xff), (int)(((ipaddr)->addr >> 8) & 0xff), \
+                                      (int)(((ipaddr)->addr >> 16) & 0xff), (int)(((ipaddr)->addr >> 24) & 0xff)
+
+#define ESP_IPADDR_TYPE_V4            (0)
+
+typedef struct esp_netif_obj esp_netif_t;
+
+typedef struct {
+  uint32_t addr;
+} esp_ip4_addr_t;
+
+typedef struct {
+  esp_ip4_addr_t ip;
+  esp_ip4_addr_t netmask;
+  esp_ip4_addr_t gw;
+} esp_netif_ip_info_t;
+
+typedef enum {
+  ESP_NETIF_DNS_MAIN,
+  ESP_NETIF_DNS_BACKUP
+} esp_netif_dns_type_t;
+
+typedef struct {
+  struct {
+    union {
+      esp_ip4_addr_t ip4;
+    } u_addr;
+    uint8_t type;
+  } ip;
+} esp_netif_dns_info_t;
+
+typedef enum {
+  IP_EVENT_STA_GOT_IP,
+  IP_EVENT_STA_LOST_IP
+} ip_event_t;
+
+typedef struct {
+  esp_netif_t *esp_netif;
+  esp_netif_ip_info_t ip_info;
+  bool ip_changed;
+} ip_event_got_ip_t;
+
+
+esp_err_t esp_netif_init();
+
+
+esp_netif_t *esp_netif_create_default_wifi_sta();
+
+
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t *netif);
+
+
+esp_err_t esp_netif_set_ip_info(esp_netif_t *netif, const esp_netif_ip_info_t *ip_info);
+
+
+esp_err_t esp_netif_set_dns_info(esp_netif_t *netif, esp_netif_dns_type_t type, esp_netif_dns_info_t *dns);
+
+
+esp_err_t esp_netif_str_to_ip4(const char *src, esp_ip4_addr_t *dst);
+
+
+#endif /* _MOCK_ESP_NETIF_H_ */
@@ -0,0 +1,25 @@
+/**
+ * @file    esp_rom_crc.h
+ *
+ * @brief   ESP ROM CRC Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_ESP_ROM_CRC_H_
+#define _MOCK_ESP_ROM_CRC_H_
+
+
+#include <stdint.h>
+
+
+uint16_t esp_rom_crc16_le(uint16_t crc, const uint8_t *buf, uint32_t len);
+
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len);
+
+
+#endif /* _MOCK_ESP_ROM_CRC_H_ */
@@ -0,0 +1,22 @@
+/**
+ * @file    esp_rom_sys.h
+ *
+ * @brief   ESP ROM System Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_ESP_ROM_SYS_H_
+#define _MOCK_ESP_ROM_SYS_H_
+
+
+#include <stdint.h>
+
+
+void esp_rom_delay_us(uint32_t us);
+
+
+#endif /* _MOCK_ESP_ROM_SYS_H_ */
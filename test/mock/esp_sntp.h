@@ -0,0 +1,36 @@
+/**
+ * @file    esp_sntp.h
+ *
+ * @brief   ESP SNTP Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_ESP_SNTP_H_
+#define _MOCK_ESP_SNTP_H_
+
+
+#include <sys/time.h>
+
+
+#define SNTP_OPMODE_POLL              (0)
+
+typedef void (*sntp_sync_time_cb_t)(struct timeval *tv);
+
+
+void sntp_setoperatingmode(int mode);
+
+
+void sntp_setservername(int index, const char *server);
+
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback);
+
+
+void sntp_init();
+
+
+#endif /* _MOCK_ESP_SNTP_H_ */
@@ -0,0 +1,37 @@
+/**
+ * @file    esp_system.h
+ *
+ * @brief   ESP System Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_ESP_SYSTEM_H_
+#define _MOCK_ESP_SYSTEM_H_
+
+
+#include "esp_err.h"
+
+#include <stdint.h>
+
+
+#define MACSTR                        "%02x:%02x:%02x:%02x:%02x:%02x"
+#define MAC2STR(a)                    (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5]
+
+
+uint32_t esp_get_free_heap_size();
+
+
+uint32_t esp_get_minimum_free_heap_size();
+
+
+uint32_t esp_random();
+
+
+void esp_restart();
+
+
+#endif /* _MOCK_ESP_SYSTEM_H_ */
@@ -0,0 +1,74 @@
+/**
+ * @file    esp_tls.h
+ *
+ * @brief   ESP TLS Shim Header File
+ *
+ * @remarks Connects to the fake InfluxDB over real TLS 1.2, see tls.c.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_ESP_TLS_H_
+#define _MOCK_ESP_TLS_H_
+
+
+#include "esp_err.h"
+#include "mbedtls/ssl.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+
+#define ESP_TLS_ERR_SSL_WANT_READ     MBEDTLS_ERR_SSL_WANT_READ
+#define ESP_TLS_ERR_SSL_WANT_WRITE    MBEDTLS_ERR_SSL_WANT_WRITE
+
+typedef struct {
+  mbedtls_ssl_session saved_session;
+} esp_tls_client_session_t;
+
+typedef struct {
+  const unsigned char *cacert_buf;
+  unsigned int cacert_bytes;
+  bool non_block;
+  int timeout_ms;
+  bool use_global_ca_store;
+  const char *common_name;
+  bool skip_common_name;
+  esp_tls_client_session_t *client_session;
+} esp_tls_cfg_t;
+
+typedef struct esp_tls {
+  mbedtls_ssl_context ssl;
+  int sockfd;
+  void *error_handle;
+  // The connection of the mock.
+  struct mock_tls *mock;
+} esp_tls_t;
+
+
+esp_tls_t *esp_tls_init();
+
+
+int esp_tls_conn_new_sync(const char *hostname, int hostlen, int port, const esp_tls_cfg_t *cfg, esp_tls_t *tls);
+
+
+ssize_t esp_tls_conn_write(esp_tls_t *tls, const void *data, size_t datalen);
+
+
+ssize_t esp_tls_conn_read(esp_tls_t *tls, void *data, size_t datalen);
+
+
+int esp_tls_conn_destroy(esp_tls_t *tls);
+
+
+esp_err_t esp_tls_get_and_clear_last_error(void *error_handle, int *esp_tls_code, int *esp_tls_flags);
+
+
+esp_err_t esp_tls_set_global_ca_store(const unsigned char *cacert_pem_buf, const unsigned int cacert_pem_bytes);
+
+
+#endif /* _MOCK_ESP_TLS_H_ */
@@ -0,0 +1,131 @@
+/**
+ * @file    esp_wifi.h
+ *
+ * @brief   ESP WIFI Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_ESP_WIFI_H_
+#define _MOCK_ESP_WIFI_H_
+
+
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+
+#include <stdint.h>
+
+
+#define WIFI_INIT_CONFIG_DEFAULT()    { 0 }
+
+typedef enum {
+  WIFI_EVENT_STA_START = 2,
+  WIFI_EVENT_STA_STOP,
+  WIFI_EVENT_STA_CONNECTED,
+  WIFI_EVENT_STA_DISCONNECTED
+} wifi_event_t;
+
+typedef enum {
+  WIFI_MODE_NULL,
+  WIFI_MODE_STA
+} wifi_mode_t;
+
+typedef enum {
+  WIFI_IF_STA
+} wifi_interface_t;
+
+typedef enum {
+  WIFI_PS_NONE,
+  WIFI_PS_MIN_MODEM,
+  WIFI_PS_MAX_MODEM
+} wifi_ps_type_t;
+
+typedef enum {
+  WIFI_AUTH_OPEN,
+  WIFI_AUTH_WEP,
+  WIFI_AUTH_WPA_PSK,
+  WIFI_AUTH_WPA2_PSK
+} wifi_auth_mode_t;
+
+typedef enum {
+  WIFI_FAST_SCAN,
+  WIFI_ALL_CHANNEL_SCAN
+} wifi_scan_method_t;
+
+typedef enum {
+  WIFI_CONNECT_AP_BY_SIGNAL,
+  WIFI_CONNECT_AP_BY_SECURITY
+} wifi_sort_method_t;
+
+typedef struct {
+  int reserved;
+} wifi_init_config_t;
+
+typedef struct {
+  bool capable;
+  bool required;
+} wifi_pmf_config_t;
+
+typedef struct {
+  int8_t rssi;
+  wifi_auth_mode_t authmode;
+} wifi_scan_threshold_t;
+
+typedef struct {
+  uint8_t ssid[32];
+  uint8_t password[64];
+  wifi_scan_method_t scan_method;
+  bool bssid_set;
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint16_t listen_interval;
+  wifi_sort_method_t sort_method;
+  wifi_scan_threshold_t threshold;
+  wifi_pmf_config_t pmf_cfg;
+} wifi_sta_config_t;
+
+typedef union {
+  wifi_sta_config_t sta;
+} wifi_config_t;
+
+typedef struct {
+  uint8_t bssid[6];
+  uint8_t ssid[33];
+  uint8_t primary;
+  int8_t rssi;
+} wifi_ap_record_t;
+
+typedef struct {
+  uint8_t ssid[32];
+  uint8_t ssid_len;
+  uint8_t bssid[6];
+  uint8_t reason;
+} wifi_event_sta_disconnected_t;
+
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config);
+
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *config);
+
+
+esp_err_t esp_wifi_start();
+
+
+esp_err_t esp_wifi_connect();
+
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type);
+
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap);
+
+
+#endif /* _MOCK_ESP_WIFI_H_ */
@@ -0,0 +1,260 @@
+/**
+ * @file    flash.c
+ *
+ * @brief   Flash Shim Source File
+ *
+ * @remarks The store partition and the NVS live in RAM. Writes can only clear bits and erases set whole sectors, as on
+ *          the NOR flash, so that a record written twice or over an unerased slot shows up as corrupt.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "mock.h"
+
+#include "esp_partition.h"
+#include "nvs_flash.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+
+#define MOCK_FLASH_SECTOR_SIZE        (4096)
+#define MOCK_FLASH_PAGE_SIZE          (256)
+
+
+typedef struct {
+  char key[32];
+  uint8_t blob[MOCK_NVS_BLOB_SIZE];
+  size_t length;
+} mock_nvs_entry_t;
+
+static const esp_partition_t mock_partition = {
+  .type = ESP_PARTITION_TYPE_DATA,
+  .subtype = 0x40,
+  .address = 0x110000,
+  .size = MOCK_FLASH_SIZE,
+  .label = "store"
+};
+
+bool mock_flash_fail = false;
+
+static uint8_t mock_flash[MOCK_FLASH_SIZE];
+static bool mock_flash_ready;
+static mock_flash_stats_t mock_flash_stats;
+static pthread_mutex_t mock_flash_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static mock_nvs_entry_t mock_nvs[MOCK_NVS_ENTRIES];
+static const char *mock_nvs_namespaces[MOCK_NVS_ENTRIES];
+static pthread_mutex_t mock_nvs_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+void mock_flash_erase()
+{
+  pthread_mutex_lock(&mock_flash_mutex);
+  memset(mock_flash, 0xff, sizeof(mock_flash));
+  mock_flash_ready = true;
+  pthread_mutex_unlock(&mock_flash_mutex);
+}
+
+
+void mock_flash_get_stats(mock_flash_stats_t *stats)
+{
+  pthread_mutex_lock(&mock_flash_mutex);
+  *stats = mock_flash_stats;
+  pthread_mutex_unlock(&mock_flash_mutex);
+}
+
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+  if (type != mock_partition.type || (label != NULL && strcmp(label, mock_partition.label) != 0)) {
+    return NULL;
+  }
+
+  // A new chip comes erased.
+  if (!mock_flash_ready) {
+    mock_flash_erase();
+  }
+
+  return &mock_partition;
+}
+
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t offset, void *dst, size_t size)
+{
+  if (offset + size > partition->size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  pthread_mutex_lock(&mock_flash_mutex);
+  memcpy(dst, &mock_flash[offset], size);
+  pthread_mutex_unlock(&mock_flash_mutex);
+
+  return ESP_OK;
+}
+
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t offset, const void *src, size_t size)
+{
+  if (offset + size > partition->size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  if (mock_flash_fail) {
+    return ESP_FAIL;
+  }
+
+  const uint8_t *data = src;
+  pthread_mutex_lock(&mock_flash_mutex);
+  for (size_t i = 0; i < size; i++) {
+    mock_flash[offset + i] &= data[i];
+  }
+  mock_flash_stats.writes++;
+  if (size > 0 && offset % MOCK_FLASH_PAGE_SIZE == 0 && size % MOCK_FLASH_PAGE_SIZE == 0) {
+    mock_flash_stats.page_writes++;
+  }
+  pthread_mutex_unlock(&mock_flash_mutex);
+
+  return ESP_OK;
+}
+
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+  if (offset % MOCK_FLASH_SECTOR_SIZE != 0 || size % MOCK_FLASH_SECTOR_SIZE != 0 || offset + size > partition->size) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  pthread_mutex_lock(&mock_flash_mutex);
+  memset(&mock_flash[offset], 0xff, size);
+  mock_flash_stats.erases++;
+  pthread_mutex_unlock(&mock_flash_mutex);
+
+  return ESP_OK;
+}
+
+
+esp_err_t nvs_flash_init()
+{
+  return ESP_OK;
+}
+
+
+esp_err_t nvs_flash_erase()
+{
+  pthread_mutex_lock(&mock_nvs_mutex);
+  memset(mock_nvs, 0, sizeof(mock_nvs));
+  pthread_mutex_unlock(&mock_nvs_mutex);
+
+  return ESP_OK;
+}
+
+
+/**
+ * @brief           Opens a namespace. The handle is the index of the namespace plus one.
+ */
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle)
+{
+  esp_err_t esp_err = ESP_ERR_NO_MEM;
+
+  pthread_mutex_lock(&mock_nvs_mutex);
+  for (uint32_t i = 0; i < MOCK_NVS_ENTRIES; i++) {
+    if (mock_nvs_namespaces[i] == NULL) {
+      if (mode == NVS_READONLY) {
+        esp_err = ESP_ERR_NVS_NOT_FOUND;
+        break;
+      }
+      mock_nvs_namespaces[i] = name;
+    }
+
+    if (strcmp(mock_nvs_namespaces[i], name) == 0) {
+      *handle = i + 1;
+      esp_err = ESP_OK;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&mock_nvs_mutex);
+
+  return esp_err;
+}
+
+
+static mock_nvs_entry_t *mock_nvs_find(nvs_handle_t handle, const char *key, bool create)
+{
+  char name[sizeof(mock_nvs[0].key)];
+  snprintf(name, sizeof(name), "%u/%s", handle, key);
+
+  for (uint32_t i = 0; i < MOCK_NVS_ENTRIES; i++) {
+    if (strcmp(mock_nvs[i].key, name) == 0) {
+      return &mock_nvs[i];
+    }
+  }
+
+  for (uint32_t i = 0; create && i < MOCK_NVS_ENTRIES; i++) {
+    if (mock_nvs[i].key[0] == '\0') {
+      strcpy(mock_nvs[i].key, name);
+      return &mock_nvs[i];
+    }
+  }
+
+  return NULL;
+}
+
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *value, size_t *length)
+{
+  esp_err_t esp_err = ESP_OK;
+
+  pthread_mutex_lock(&mock_nvs_mutex);
+  mock_nvs_entry_t *entry = mock_nvs_find(handle, key, false);
+  if (entry == NULL) {
+    esp_err = ESP_ERR_NVS_NOT_FOUND;
+  } else if (value != NULL && *length < entry->length) {
+    esp_err = ESP_ERR_NVS_INVALID_LENGTH;
+  } else {
+    if (value != NULL) {
+      memcpy(value, entry->blob, entry->length);
+    }
+    *length = entry->length;
+  }
+  pthread_mutex_unlock(&mock_nvs_mutex);
+
+  return esp_err;
+}
+
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+  esp_err_t esp_err = ESP_OK;
+
+  if (length > MOCK_NVS_BLOB_SIZE) {
+    return ESP_ERR_NVS_INVALID_LENGTH;
+  }
+
+  pthread_mutex_lock(&mock_nvs_mutex);
+  mock_nvs_entry_t *entry = mock_nvs_find(handle, key, true);
+  if (entry == NULL) {
+    esp_err = ESP_ERR_NVS_NO_FREE_PAGES;
+  } else {
+    memcpy(entry->blob, value, length);
+    entry->length = length;
+  }
+  pthread_mutex_unlock(&mock_nvs_mutex);
+
+  return esp_err;
+}
+
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+  return ESP_OK;
+}
+
+
+void nvs_close(nvs_handle_t handle)
+{
+}
@@ -0,0 +1,342 @@
+/**
+ * @file    freertos.c
+ *
+ * @brief   FreeRTOS Shim Source File
+ *
+ * @remarks The tasks are POSIX threads and the ticks follow the monotonic clock. Priorities are not honored, so the
+ *          code under test must not rely on them for mutual exclusion, which it must not on the dual core either.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "mock.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+struct mock_task {
+  pthread_t thread;
+  char name[configMAX_TASK_NAME_LEN];
+  uint32_t stack_depth;
+  TaskFunction_t fn;
+  void *arg;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  uint32_t notify;
+};
+
+struct mock_event_group {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  EventBits_t bits;
+};
+
+_Static_assert(sizeof(struct mock_event_group) <= sizeof(StaticEventGroup_t), "StaticEventGroup_t is too small");
+
+static __thread struct mock_task *mock_current;
+static pthread_mutex_t mock_critical = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+
+/**
+ * @brief           Initializes a condition that waits on the monotonic clock.
+ */
+static void mock_cond_init(pthread_cond_t *cond)
+{
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(cond, &attr);
+  pthread_condattr_destroy(&attr);
+}
+
+
+/**
+ * @brief           Waits on a condition until a deadline, or forever without one.
+ *
+ * @return        - true if signaled
+ *                - false if timed out
+ */
+static bool mock_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex, const struct timespec *deadline)
+{
+  if (deadline == NULL) {
+    pthread_cond_wait(cond, mutex);
+    return true;
+  }
+
+  return pthread_cond_timedwait(cond, mutex, deadline) == 0;
+}
+
+
+/**
+ * @brief           Converts a timeout in ticks to an absolute deadline.
+ *
+ * @return          The deadline, or NULL to wait forever.
+ */
+static struct timespec *mock_deadline(TickType_t ticks, struct timespec *deadline)
+{
+  if (ticks == portMAX_DELAY) {
+    return NULL;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, deadline);
+  uint64_t ns = deadline->tv_nsec + (uint64_t)ticks * portTICK_PERIOD_MS * 1000000;
+  deadline->tv_sec += ns / 1000000000;
+  deadline->tv_nsec = ns % 1000000000;
+
+  return deadline;
+}
+
+
+static struct mock_task *mock_task_new(const char *name, uint32_t stack_depth)
+{
+  struct mock_task *task = calloc(1, sizeof(*task));
+  strncpy(task->name, name, sizeof(task->name) - 1);
+  task->stack_depth = stack_depth;
+  pthread_mutex_init(&task->mutex, NULL);
+  mock_cond_init(&task->cond);
+
+  return task;
+}
+
+
+static void *mock_task_run(void *arg)
+{
+  mock_current = arg;
+  mock_current->fn(mock_current->arg);
+
+  return NULL;
+}
+
+
+void mock_critical_enter(portMUX_TYPE *mux)
+{
+  pthread_mutex_lock(&mock_critical);
+}
+
+
+void mock_critical_exit(portMUX_TYPE *mux)
+{
+  pthread_mutex_unlock(&mock_critical);
+}
+
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg, UBaseType_t priority,
+                       TaskHandle_t *task)
+{
+  struct mock_task *created = mock_task_new(name, stack_depth);
+  created->fn = fn;
+  created->arg = arg;
+
+  if (pthread_create(&created->thread, NULL, mock_task_run, created) != 0) {
+    free(created);
+    return pdFAIL;
+  }
+  pthread_detach(created->thread);
+
+  if (task != NULL) {
+    *task = created;
+  }
+
+  return pdPASS;
+}
+
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                               UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb)
+{
+  TaskHandle_t task = NULL;
+  xTaskCreate(fn, name, stack_depth, arg, priority, &task);
+
+  return task;
+}
+
+
+void vTaskDelete(TaskHandle_t task)
+{
+  // Only a task can delete itself here.
+  if (task == NULL || task == mock_current) {
+    pthread_exit(NULL);
+  }
+}
+
+
+void vTaskDelay(TickType_t ticks)
+{
+  struct timespec delay = {
+    .tv_sec = ticks * portTICK_PERIOD_MS / 1000,
+    .tv_nsec = (ticks * portTICK_PERIOD_MS % 1000) * 1000000L
+  };
+  nanosleep(&delay, NULL);
+}
+
+
+TickType_t xTaskGetTickCount()
+{
+  return esp_timer_get_time() / (portTICK_PERIOD_MS * 1000);
+}
+
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+  // Threads that were not created as tasks, like the main thread, get a task on first use.
+  if (mock_current == NULL) {
+    mock_current = mock_task_new("main", 0);
+    mock_current->thread = pthread_self();
+  }
+
+  return mock_current;
+}
+
+
+char *pcTaskGetTaskName(TaskHandle_t task)
+{
+  return task != NULL ? task->name : xTaskGetCurrentTaskHandle()->name;
+}
+
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+  // The stacks of the threads are not the ones sized for the target, so nothing is known of their use.
+  return task != NULL ? task->stack_depth : xTaskGetCurrentTaskHandle()->stack_depth;
+}
+
+
+/**
+ * @brief           Takes the CPU time the thread of a task has used, to compare what the code under test costs.
+ */
+uint64_t mock_task_cpu_us(TaskHandle_t task)
+{
+  clockid_t clock;
+  struct timespec cpu;
+  if (pthread_getcpuclockid(task->thread, &clock) != 0 || clock_gettime(clock, &cpu) != 0) {
+    return 0;
+  }
+
+  return cpu.tv_sec * 1000000ULL + cpu.tv_nsec / 1000;
+}
+
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+  struct mock_task *task = xTaskGetCurrentTaskHandle();
+  struct timespec deadline;
+  struct timespec *until = mock_deadline(ticks, &deadline);
+
+  pthread_mutex_lock(&task->mutex);
+  while (task->notify == 0 && ticks > 0 && mock_cond_wait(&task->cond, &task->mutex, until)) {
+  }
+
+  uint32_t value = task->notify;
+  if (value > 0) {
+    task->notify = clear ? 0 : value - 1;
+  }
+  pthread_mutex_unlock(&task->mutex);
+
+  return value;
+}
+
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+  pthread_mutex_lock(&task->mutex);
+  task->notify++;
+  pthread_cond_signal(&task->cond);
+  pthread_mutex_unlock(&task->mutex);
+
+  return pdPASS;
+}
+
+
+static void mock_event_group_init(struct mock_event_group *group)
+{
+  pthread_mutex_init(&group->mutex, NULL);
+  mock_cond_init(&group->cond);
+  group->bits = 0;
+}
+
+
+EventGroupHandle_t xEventGroupCreate()
+{
+  struct mock_event_group *group = malloc(sizeof(*group));
+  mock_event_group_init(group);
+
+  return group;
+}
+
+
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *buffer)
+{
+  struct mock_event_group *group = (struct mock_event_group *)buffer;
+  mock_event_group_init(group);
+
+  return group;
+}
+
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear, BaseType_t all,
+                                TickType_t ticks)
+{
+  struct timespec deadline;
+  struct timespec *until = mock_deadline(ticks, &deadline);
+
+  pthread_mutex_lock(&group->mutex);
+  while (true) {
+    bool met = all ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+    if (met || ticks == 0 || !mock_cond_wait(&group->cond, &group->mutex, until)) {
+      break;
+    }
+  }
+
+  EventBits_t value = group->bits;
+  bool met = all ? (value & bits) == bits : (value & bits) != 0;
+  if (met && clear) {
+    group->bits &= ~bits;
+  }
+  pthread_mutex_unlock(&group->mutex);
+
+  return value;
+}
+
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+  pthread_mutex_lock(&group->mutex);
+  group->bits |= bits;
+  EventBits_t value = group->bits;
+  pthread_cond_broadcast(&group->cond);
+  pthread_mutex_unlock(&group->mutex);
+
+  return value;
+}
+
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+  pthread_mutex_lock(&group->mutex);
+  EventBits_t value = group->bits;
+  group->bits &= ~bits;
+  pthread_mutex_unlock(&group->mutex);
+
+  return value;
+}
+
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+  pthread_mutex_lock(&group->mutex);
+  EventBits_t value = group->bits;
+  pthread_mutex_unlock(&group->mutex);
+
+  return value;
+}
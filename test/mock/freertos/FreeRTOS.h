@@ -0,0 +1,106 @@
+/**
+ * @file    FreeRTOS.h
+ *
+ * @brief   FreeRTOS Shim Header File
+ *
+ * @remarks The subset of the ESP-IDF FreeRTOS the station uses, on top of POSIX threads. Tasks are threads, the ticks
+ *          follow CLOCK_MONOTONIC and a critical section is one process-wide recursive mutex.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_FREERTOS_H_
+#define _MOCK_FREERTOS_H_
+
+
+#include "esp_attr.h"
+#include "esp_err.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+// As in the sdkconfig.
+#define configTICK_RATE_HZ            (100)
+#define configMAX_TASK_NAME_LEN       (16)
+
+#define portTICK_PERIOD_MS            (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY                 ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms)             ((TickType_t)((uint64_t)(ms) * configTICK_RATE_HZ / 1000))
+
+#define pdFALSE                       (0)
+#define pdTRUE                        (1)
+#define pdFAIL                        (0)
+#define pdPASS                        (1)
+
+#define tskIDLE_PRIORITY              (0)
+
+#define BIT0                          (1UL << 0)
+#define BIT1                          (1UL << 1)
+#define BIT2                          (1UL << 2)
+#define BIT3                          (1UL << 3)
+#define BIT4                          (1UL << 4)
+#define BIT5                          (1UL << 5)
+#define BIT6                          (1UL << 6)
+#define BIT7                          (1UL << 7)
+#define BIT8                          (1UL << 8)
+#define BIT9                          (1UL << 9)
+#define BIT10                         (1UL << 10)
+#define BIT11                         (1UL << 11)
+#define BIT12                         (1UL << 12)
+#define BIT13                         (1UL << 13)
+#define BIT14                         (1UL << 14)
+#define BIT15                         (1UL << 15)
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+// The stack depth of the IDF is in bytes.
+typedef uint8_t StackType_t;
+
+/**
+ * @brief   A spinlock on the ESP32. All of them map to the same recursive mutex here.
+ */
+typedef struct {
+  uint32_t owner;
+  uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED  { 0, 0 }
+
+#define portENTER_CRITICAL(mux)       mock_critical_enter(mux)
+#define portEXIT_CRITICAL(mux)        mock_critical_exit(mux)
+#define portENTER_CRITICAL_ISR(mux)   mock_critical_enter(mux)
+#define portEXIT_CRITICAL_ISR(mux)    mock_critical_exit(mux)
+
+/**
+ * @brief   Room for the objects the static constructors place in the caller's memory.
+ */
+typedef struct {
+  uint64_t space[32];
+} StaticTask_t;
+
+typedef struct {
+  uint64_t space[32];
+} StaticEventGroup_t;
+
+typedef struct {
+  uint64_t space[32];
+} StaticSemaphore_t;
+
+typedef struct {
+  uint64_t space[32];
+} StaticQueue_t;
+
+
+void mock_critical_enter(portMUX_TYPE *mux);
+
+
+void mock_critical_exit(portMUX_TYPE *mux);
+
+
+#endif /* _MOCK_FREERTOS_H_ */
@@ -0,0 +1,42 @@
+/**
+ * @file    event_groups.h
+ *
+ * @brief   FreeRTOS Event Group Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_EVENT_GROUPS_H_
+#define _MOCK_EVENT_GROUPS_H_
+
+
+#include "freertos/FreeRTOS.h"
+
+
+typedef struct mock_event_group *EventGroupHandle_t;
+typedef uint32_t EventBits_t;
+
+
+EventGroupHandle_t xEventGroupCreate();
+
+
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t *buffer);
+
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear, BaseType_t all,
+                                TickType_t ticks);
+
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group);
+
+
+#endif /* _MOCK_EVENT_GROUPS_H_ */
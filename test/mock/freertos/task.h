@@ -0,0 +1,55 @@
+/**
+ * @file    task.h
+ *
+ * @brief   FreeRTOS Task Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_TASK_H_
+#define _MOCK_TASK_H_
+
+
+#include "freertos/FreeRTOS.h"
+
+
+typedef struct mock_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg, UBaseType_t priority,
+                       TaskHandle_t *task);
+
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                               UBaseType_t priority, StackType_t *stack, StaticTask_t *tcb);
+
+
+void vTaskDelete(TaskHandle_t task);
+
+
+void vTaskDelay(TickType_t ticks);
+
+
+TickType_t xTaskGetTickCount();
+
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+
+
+char *pcTaskGetTaskName(TaskHandle_t task);
+
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+
+#endif /* _MOCK_TASK_H_ */
@@ -0,0 +1,332 @@
+/**
+ * @file    httpd.c
+ *
+ * @brief   HTTP Server Shim Source File
+ *
+ * @remarks A real server on a loopback port, so that the handlers can be scraped by real clients. Like the one of the
+ *          ESP IDF, it runs the handlers one at a time in a single task, keeps up to max_open_sockets connections
+ *          alive and, with lru_purge_enable, closes the least recently used one to accept a new one. The configured
+ *          port is ignored for one picked by the system, see mock_httpd_port().
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "mock.h"
+
+#include "esp_http_server.h"
+#include "esp_timer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+
+#define MOCK_HTTPD_MAX_SOCKETS        (16)
+#define MOCK_HTTPD_MAX_URIS           (8)
+#define MOCK_HTTPD_REQUEST_SIZE       (1024)
+
+typedef struct {
+  int fd;
+  int64_t used_us;
+  char request[MOCK_HTTPD_REQUEST_SIZE];
+  uint32_t request_len;
+} mock_httpd_socket_t;
+
+struct mock_httpd {
+  httpd_config_t config;
+  int listen_fd;
+  pthread_t thread;
+  atomic_bool stop;
+  httpd_uri_t uris[MOCK_HTTPD_MAX_URIS];
+  uint32_t uri_count;
+  mock_httpd_socket_t sockets[MOCK_HTTPD_MAX_SOCKETS];
+};
+
+static uint16_t mock_httpd_bound_port;
+
+
+uint16_t mock_httpd_port()
+{
+  return mock_httpd_bound_port;
+}
+
+
+static bool mock_httpd_send_all(int fd, const char *data, size_t len)
+{
+  while (len > 0) {
+    ssize_t sent = send(fd, data, len, MSG_NOSIGNAL);
+    if (sent <= 0) {
+      return false;
+    }
+    data += sent;
+    len -= sent;
+  }
+
+  return true;
+}
+
+
+static void mock_httpd_close(mock_httpd_socket_t *socket)
+{
+  close(socket->fd);
+  socket->fd = -1;
+  socket->request_len = 0;
+}
+
+
+static void mock_httpd_accept(struct mock_httpd *server)
+{
+  int fd = accept(server->listen_fd, NULL, NULL);
+  if (fd < 0) {
+    return;
+  }
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  mock_httpd_socket_t *free_socket = NULL;
+  mock_httpd_socket_t *oldest = NULL;
+  for (uint32_t i = 0; i < server->config.max_open_sockets; i++) {
+    mock_httpd_socket_t *socket = &server->sockets[i];
+    if (socket->fd < 0) {
+      free_socket = socket;
+      break;
+    }
+    if (oldest == NULL || socket->used_us < oldest->used_us) {
+      oldest = socket;
+    }
+  }
+
+  if (free_socket == NULL) {
+    if (!server->config.lru_purge_enable) {
+      close(fd);
+      return;
+    }
+    mock_httpd_close(oldest);
+    free_socket = oldest;
+  }
+
+  free_socket->fd = fd;
+  free_socket->used_us = esp_timer_get_time();
+  free_socket->request_len = 0;
+}
+
+
+/**
+ * @brief           Serves the request at the start of the buffer of a socket, once its headers are complete. The
+ *                  request bodies are not supported.
+ *
+ * @return          false if the connection is to be closed
+ */
+static bool mock_httpd_serve(struct mock_httpd *server, mock_httpd_socket_t *socket)
+{
+  char *end = strstr(socket->request, "\r\n\r\n");
+  if (end == NULL) {
+    return socket->request_len < MOCK_HTTPD_REQUEST_SIZE - 1;
+  }
+  end += 4;
+
+  char method[8];
+  char uri[256];
+  if (sscanf(socket->request, "%7s %255s", method, uri) != 2) {
+    return false;
+  }
+  char *query = strchr(uri, '?');
+  if (query != NULL) {
+    *query = '\0';
+  }
+
+  const httpd_uri_t *handler = NULL;
+  for (uint32_t i = 0; i < server->uri_count; i++) {
+    if (strcmp(server->uris[i].uri, uri) == 0 && server->uris[i].method == (strcmp(method, "GET") == 0 ? HTTP_GET : HTTP_POST)) {
+      handler = &server->uris[i];
+    }
+  }
+
+  bool keep = true;
+  if (handler == NULL) {
+    static const char not_found[] = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+    keep = mock_httpd_send_all(socket->fd, not_found, sizeof(not_found) - 1);
+  }
+  else {
+    httpd_req_t req = { .uri = uri, .fd = socket->fd, .type = "text/html" };
+    if (handler->handler(&req) != ESP_OK) {
+      // As the ESP IDF does, a failed handler closes the connection, after an error if nothing was sent yet.
+      if (!req.started) {
+        static const char error[] = "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n";
+        mock_httpd_send_all(socket->fd, error, sizeof(error) - 1);
+      }
+      keep = false;
+    }
+  }
+
+  socket->request_len -= end - socket->request;
+  memmove(socket->request, end, socket->request_len);
+  socket->request[socket->request_len] = '\0';
+  socket->used_us = esp_timer_get_time();
+
+  return keep;
+}
+
+
+static void *mock_httpd_task(void *arg)
+{
+  struct mock_httpd *server = arg;
+
+  while (!atomic_load(&server->stop)) {
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(server->listen_fd, &fds);
+    int max_fd = server->listen_fd;
+    for (uint32_t i = 0; i < server->config.max_open_sockets; i++) {
+      if (server->sockets[i].fd >= 0) {
+        FD_SET(server->sockets[i].fd, &fds);
+        max_fd = server->sockets[i].fd > max_fd ? server->sockets[i].fd : max_fd;
+      }
+    }
+
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = 100000 };
+    if (select(max_fd + 1, &fds, NULL, NULL, &timeout) <= 0) {
+      continue;
+    }
+
+    // The pending requests first, so that a purge does not close one that is waiting to be served.
+    for (uint32_t i = 0; i < server->config.max_open_sockets; i++) {
+      mock_httpd_socket_t *socket = &server->sockets[i];
+      if (socket->fd < 0 || !FD_ISSET(socket->fd, &fds)) {
+        continue;
+      }
+
+      ssize_t len = recv(socket->fd, socket->request + socket->request_len, MOCK_HTTPD_REQUEST_SIZE - 1 - socket->request_len, 0);
+      if (len <= 0) {
+        mock_httpd_close(socket);
+        continue;
+      }
+      socket->request_len += len;
+      socket->request[socket->request_len] = '\0';
+
+      if (!mock_httpd_serve(server, socket)) {
+        mock_httpd_close(socket);
+      }
+    }
+
+    if (FD_ISSET(server->listen_fd, &fds)) {
+      mock_httpd_accept(server);
+    }
+  }
+
+  return NULL;
+}
+
+
+esp_err_t httpd_start(httpd_handle_t *handle, const httpd_config_t *config)
+{
+  if (config->max_open_sockets > MOCK_HTTPD_MAX_SOCKETS) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  struct mock_httpd *server = calloc(1, sizeof(*server));
+  server->config = *config;
+  for (uint32_t i = 0; i < MOCK_HTTPD_MAX_SOCKETS; i++) {
+    server->sockets[i].fd = -1;
+  }
+
+  server->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+  socklen_t addr_len = sizeof(addr);
+  if (server->listen_fd < 0 ||
+      bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+      listen(server->listen_fd, 16) != 0 ||
+      getsockname(server->listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+    if (server->listen_fd >= 0) {
+      close(server->listen_fd);
+    }
+    free(server);
+    return ESP_FAIL;
+  }
+  mock_httpd_bound_port = ntohs(addr.sin_port);
+
+  pthread_create(&server->thread, NULL, mock_httpd_task, server);
+  *handle = server;
+
+  return ESP_OK;
+}
+
+
+esp_err_t httpd_stop(httpd_handle_t handle)
+{
+  atomic_store(&handle->stop, true);
+  pthread_join(handle->thread, NULL);
+
+  for (uint32_t i = 0; i < MOCK_HTTPD_MAX_SOCKETS; i++) {
+    if (handle->sockets[i].fd >= 0) {
+      mock_httpd_close(&handle->sockets[i]);
+    }
+  }
+  close(handle->listen_fd);
+  free(handle);
+
+  return ESP_OK;
+}
+
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler)
+{
+  if (handle->uri_count >= handle->config.max_uri_handlers || handle->uri_count >= MOCK_HTTPD_MAX_URIS) {
+    return ESP_ERR_NO_MEM;
+  }
+
+  handle->uris[handle->uri_count++] = *uri_handler;
+
+  return ESP_OK;
+}
+
+
+esp_err_t httpd_resp_set_type(httpd_req_t *req, const char *type)
+{
+  req->type = type;
+
+  return ESP_OK;
+}
+
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t *req, const char *buf, ssize_t buf_len)
+{
+  char header[128];
+
+  if (!req->started) {
+    int len = snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: %s\r\nTransfer-Encoding: chunked\r\n\r\n", req->type);
+    if (!mock_httpd_send_all(req->fd, header, len)) {
+      return ESP_FAIL;
+    }
+    req->started = true;
+  }
+
+  if (buf == NULL) {
+    return mock_httpd_send_all(req->fd, "0\r\n\r\n", 5) ? ESP_OK : ESP_FAIL;
+  }
+  if (buf_len == HTTPD_RESP_USE_STRLEN) {
+    buf_len = strlen(buf);
+  }
+  if (buf_len == 0) {
+    return ESP_OK;
+  }
+
+  int len = snprintf(header, sizeof(header), "%zx\r\n", (size_t)buf_len);
+  if (!mock_httpd_send_all(req->fd, header, len) || !mock_httpd_send_all(req->fd, buf, buf_len) ||
+      !mock_httpd_send_all(req->fd, "\r\n", 2)) {
+    return ESP_FAIL;
+  }
+
+  return ESP_OK;
+}
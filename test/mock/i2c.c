@@ -0,0 +1,339 @@
+/**
+ * @file    i2c.c
+ *
+ * @brief   I2C Shim Source File
+ *
+ * @remarks The command links are recorded in the buffer of the caller and played back against simulated BME280s. A
+ *          sensor keeps its register map and measures in forced and normal mode, with the typical measurement time of
+ *          the datasheet. Its raw registers carry the compensated values directly, offset to be unsigned, since the
+ *          Bosch compensation is not under test.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "mock.h"
+
+#include "bme280.h"
+#include "esp_timer.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+
+
+#define MOCK_BME280_MAX               (4)
+
+
+typedef enum {
+  MOCK_I2C_START,
+  MOCK_I2C_STOP,
+  MOCK_I2C_WRITE,
+  MOCK_I2C_READ
+} mock_i2c_op_type_t;
+
+typedef struct {
+  mock_i2c_op_type_t type;
+  uint8_t byte;
+  uint8_t *data;
+  const uint8_t *src;
+  size_t len;
+} mock_i2c_op_t;
+
+typedef struct {
+  uint32_t capacity;
+  uint32_t count;
+  mock_i2c_op_t ops[];
+} mock_i2c_link_t;
+
+typedef struct {
+  i2c_port_t port;
+  uint8_t addr;
+  uint8_t regs[256];
+  uint8_t pointer;
+  int64_t meas_end_us;
+  uint32_t measurements;
+  // Whether the last measurement is still to be read out, and the ones that were.
+  bool unread;
+  uint32_t readouts;
+} mock_bme280_t;
+
+mock_fault_t mock_i2c_fault = { .latency_us = 150 };
+
+static mock_bme280_t mock_bme280s[MOCK_BME280_MAX];
+static uint32_t mock_bme280_count;
+static pthread_mutex_t mock_i2c_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/**
+ * @brief           The number of measurements for an oversampling setting.
+ */
+static uint32_t mock_bme280_osr(uint8_t osr)
+{
+  return osr == 0 ? 0 : 1 << (osr - 1);
+}
+
+
+/**
+ * @brief           Starts a measurement, which ends after the typical time of the datasheet.
+ */
+static void mock_bme280_start(mock_bme280_t *sensor)
+{
+  uint32_t t = mock_bme280_osr(sensor->regs[BME280_PWR_CTRL_ADDR] >> 5);
+  uint32_t p = mock_bme280_osr(sensor->regs[BME280_PWR_CTRL_ADDR] >> 2 & 0x07);
+  uint32_t h = mock_bme280_osr(sensor->regs[BME280_CTRL_HUM_ADDR] & 0x07);
+
+  uint32_t meas_us = 1000 + 2000 * t + (p > 0 ? 2000 * p + 500 : 0) + (h > 0 ? 2000 * h + 500 : 0);
+  sensor->meas_end_us = esp_timer_get_time() + meas_us;
+}
+
+
+/**
+ * @brief           Completes a pending measurement. The weather drifts slowly around 21.5 degC, 1013.25 hPa and
+ *                  45 %RH, so that consecutive samples differ a little as on a real station.
+ */
+static void mock_bme280_update(mock_bme280_t *sensor)
+{
+  if (sensor->meas_end_us == 0 || esp_timer_get_time() < sensor->meas_end_us) {
+    return;
+  }
+
+  sensor->meas_end_us = 0;
+  sensor->measurements++;
+  sensor->unread = true;
+
+  double phase = sensor->measurements / 60.0 + sensor->addr;
+  int32_t temperature = 2150 + (int32_t)(150 * sin(phase)) + (int32_t)(mock_random() % 5) - 2;
+  uint32_t pressure = 101325 + (int32_t)(80 * cos(phase / 3)) + mock_random() % 3;
+  uint32_t humidity = (45 * 1024 + (int32_t)(5 * 1024 * sin(phase / 2))) / 2;
+
+  uint32_t t_raw = temperature + MOCK_BME280_T_OFFSET;
+  uint8_t *data = &sensor->regs[BME280_DATA_ADDR];
+  data[0] = pressure >> 12;
+  data[1] = pressure >> 4;
+  data[2] = pressure << 4;
+  data[3] = t_raw >> 12;
+  data[4] = t_raw >> 4;
+  data[5] = t_raw << 4;
+  data[6] = humidity >> 8;
+  data[7] = humidity;
+
+  // Normal mode measures again after the standby time, which is not simulated.
+  if ((sensor->regs[BME280_PWR_CTRL_ADDR] & 0x03) == BME280_NORMAL_MODE) {
+    mock_bme280_start(sensor);
+  } else {
+    sensor->regs[BME280_PWR_CTRL_ADDR] &= ~0x03;
+  }
+}
+
+
+static uint8_t mock_bme280_read(mock_bme280_t *sensor)
+{
+  mock_bme280_update(sensor);
+
+  uint8_t reg = sensor->pointer++;
+  if (reg == BME280_DATA_ADDR + BME280_P_T_H_DATA_LEN - 1 && sensor->unread) {
+    sensor->unread = false;
+    sensor->readouts++;
+  }
+  if (reg == BME280_STATUS_REG_ADDR) {
+    return sensor->meas_end_us != 0 && (sensor->regs[BME280_PWR_CTRL_ADDR] & 0x03) != BME280_NORMAL_MODE ? 0x08 : 0x00;
+  }
+
+  return sensor->regs[reg];
+}
+
+
+static void mock_bme280_write(mock_bme280_t *sensor, uint8_t value)
+{
+  uint8_t reg = sensor->pointer++;
+
+  switch (reg) {
+    case BME280_RESET_ADDR:
+      if (value == BME280_SOFT_RESET_COMMAND) {
+        memset(&sensor->regs[BME280_CTRL_HUM_ADDR], 0, BME280_CONFIG_ADDR - BME280_CTRL_HUM_ADDR + 1);
+        sensor->meas_end_us = 0;
+      }
+      break;
+    case BME280_PWR_CTRL_ADDR:
+      sensor->regs[reg] = value;
+      if ((value & 0x03) != BME280_SLEEP_MODE) {
+        mock_bme280_start(sensor);
+      }
+      break;
+    case BME280_CTRL_HUM_ADDR:
+    case BME280_CONFIG_ADDR:
+      sensor->regs[reg] = value;
+      break;
+    default:
+      break;
+  }
+}
+
+
+void mock_bme280_attach(i2c_port_t port, uint8_t addr)
+{
+  pthread_mutex_lock(&mock_i2c_mutex);
+  mock_bme280_t *sensor = &mock_bme280s[mock_bme280_count++];
+  memset(sensor, 0, sizeof(*sensor));
+  sensor->port = port;
+  sensor->addr = addr;
+  sensor->regs[BME280_CHIP_ID_ADDR] = BME280_CHIP_ID;
+  pthread_mutex_unlock(&mock_i2c_mutex);
+}
+
+
+/**
+ * @brief           Counts the measurements the driver read out, each of which makes a sample. A measurement the bus
+ *                  failed to deliver is not one of them.
+ */
+uint32_t mock_bme280_measurements()
+{
+  uint32_t measurements = 0;
+
+  pthread_mutex_lock(&mock_i2c_mutex);
+  for (uint32_t i = 0; i < mock_bme280_count; i++) {
+    measurements += mock_bme280s[i].readouts;
+  }
+  pthread_mutex_unlock(&mock_i2c_mutex);
+
+  return measurements;
+}
+
+
+esp_err_t i2c_param_config(i2c_port_t port, const i2c_config_t *config)
+{
+  return port < I2C_NUM_MAX ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+
+esp_err_t i2c_driver_install(i2c_port_t port, i2c_mode_t mode, size_t rx_len, size_t tx_len, int flags)
+{
+  return port < I2C_NUM_MAX ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t *buffer, uint32_t size)
+{
+  if (size < sizeof(mock_i2c_link_t) + sizeof(mock_i2c_op_t)) {
+    return NULL;
+  }
+
+  mock_i2c_link_t *link = (mock_i2c_link_t *)buffer;
+  link->capacity = (size - sizeof(mock_i2c_link_t)) / sizeof(mock_i2c_op_t);
+  link->count = 0;
+
+  return link;
+}
+
+
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd)
+{
+}
+
+
+static esp_err_t mock_i2c_add(i2c_cmd_handle_t cmd, mock_i2c_op_t op)
+{
+  mock_i2c_link_t *link = cmd;
+  if (link == NULL) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (link->count >= link->capacity) {
+    return ESP_ERR_NO_MEM;
+  }
+
+  link->ops[link->count++] = op;
+
+  return ESP_OK;
+}
+
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd)
+{
+  return mock_i2c_add(cmd, (mock_i2c_op_t) { .type = MOCK_I2C_START });
+}
+
+
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd)
+{
+  return mock_i2c_add(cmd, (mock_i2c_op_t) { .type = MOCK_I2C_STOP });
+}
+
+
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd, uint8_t data, bool ack_en)
+{
+  return mock_i2c_add(cmd, (mock_i2c_op_t) { .type = MOCK_I2C_WRITE, .byte = data, .len = 1 });
+}
+
+
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd, const uint8_t *data, size_t len, bool ack_en)
+{
+  return mock_i2c_add(cmd, (mock_i2c_op_t) { .type = MOCK_I2C_WRITE, .src = data, .len = len });
+}
+
+
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd, uint8_t *data, size_t len, i2c_ack_type_t ack)
+{
+  return mock_i2c_add(cmd, (mock_i2c_op_t) { .type = MOCK_I2C_READ, .data = data, .len = len });
+}
+
+
+/**
+ * @brief           Plays a command link back. The first byte after a start addresses a sensor, the next written byte
+ *                  sets its register pointer and any further bytes go to the registers from there on.
+ */
+esp_err_t i2c_master_cmd_begin(i2c_port_t port, i2c_cmd_handle_t cmd, TickType_t ticks)
+{
+  mock_i2c_link_t *link = cmd;
+  mock_bme280_t *sensor = NULL;
+  bool addressed = false;
+  bool pointed = false;
+
+  mock_sleep_us(mock_delay_us(&mock_i2c_fault));
+  if (mock_fails(&mock_i2c_fault)) {
+    return ESP_FAIL;
+  }
+
+  pthread_mutex_lock(&mock_i2c_mutex);
+  for (uint32_t i = 0; i < link->count; i++) {
+    mock_i2c_op_t *op = &link->ops[i];
+
+    if (op->type == MOCK_I2C_START) {
+      addressed = false;
+      continue;
+    }
+    if (op->type == MOCK_I2C_STOP) {
+      break;
+    }
+
+    for (size_t j = 0; j < op->len; j++) {
+      if (!addressed) {
+        uint8_t addr = (op->src != NULL ? op->src[j] : op->byte) >> 1;
+        sensor = NULL;
+        for (uint32_t k = 0; k < mock_bme280_count; k++) {
+          if (mock_bme280s[k].port == port && mock_bme280s[k].addr == addr) {
+            sensor = &mock_bme280s[k];
+          }
+        }
+        // Nobody acknowledges the address.
+        if (sensor == NULL) {
+          pthread_mutex_unlock(&mock_i2c_mutex);
+          return ESP_FAIL;
+        }
+        addressed = true;
+      } else if (op->type == MOCK_I2C_READ) {
+        op->data[j] = mock_bme280_read(sensor);
+      } else if (!pointed) {
+        sensor->pointer = op->src != NULL ? op->src[j] : op->byte;
+        pointed = true;
+      } else {
+        mock_bme280_write(sensor, op->src != NULL ? op->src[j] : op->byte);
+      }
+    }
+  }
+  pthread_mutex_unlock(&mock_i2c_mutex);
+
+  return ESP_OK;
+}
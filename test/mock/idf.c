@@ -0,0 +1,409 @@
+/**
+ * @file    idf.c
+ *
+ * @brief   ESP IDF Shim Source File
+ *
+ * @remarks The system services the firmware uses: time, timers, logs, randomness, the ROM helpers, the TLS CA store
+ *          and SNTP. The faults are drawn from a seeded generator, so that a run can be repeated.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "mock.h"
+
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_rom_sys.h"
+#include "esp_sntp.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_tls.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+// The CA certificates the firmware embeds. Only the symbols are needed, as the mock TLS does not verify anything.
+__asm__(".section .rodata\n"
+        ".global _binary_influxdb_pem_start\n"
+        "_binary_influxdb_pem_start:\n"
+        ".global _binary_influxdb_pem_end\n"
+        "_binary_influxdb_pem_end:\n"
+        ".byte 0\n"
+        ".previous");
+
+struct esp_timer {
+  esp_timer_create_args_t args;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  bool armed;
+  int64_t deadline_us;
+  uint64_t period_us;
+};
+
+uint32_t mock_sntp_delay_ms = 100;
+
+static int64_t mock_start_us;
+static uint64_t mock_state = 0x9e3779b97f4a7c15ULL;
+static pthread_mutex_t mock_state_mutex = PTHREAD_MUTEX_INITIALIZER;
+static esp_log_level_t mock_log_level = ESP_LOG_WARN;
+static pthread_mutex_t mock_log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static sntp_sync_time_cb_t mock_sntp_cb;
+
+
+static int64_t mock_monotonic_us()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+
+/**
+ * @brief           Starts the clock of esp_timer_get_time at the process start, as it starts at the boot.
+ */
+__attribute__((constructor)) static void mock_boot()
+{
+  mock_start_us = mock_monotonic_us();
+}
+
+
+void mock_seed(uint32_t seed)
+{
+  pthread_mutex_lock(&mock_state_mutex);
+  mock_state = 0x9e3779b97f4a7c15ULL ^ seed;
+  pthread_mutex_unlock(&mock_state_mutex);
+}
+
+
+/**
+ * @brief           Draws from a splitmix64 generator.
+ */
+uint32_t mock_random()
+{
+  pthread_mutex_lock(&mock_state_mutex);
+  uint64_t z = (mock_state += 0x9e3779b97f4a7c15ULL);
+  pthread_mutex_unlock(&mock_state_mutex);
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+  return (z ^ (z >> 31)) >> 32;
+}
+
+
+uint32_t mock_delay_us(const mock_fault_t *fault)
+{
+  return fault->latency_us + (fault->jitter_us > 0 ? mock_random() % (fault->jitter_us + 1) : 0);
+}
+
+
+bool mock_fails(const mock_fault_t *fault)
+{
+  return fault->fail_ppm > 0 && mock_random() % 1000000 < fault->fail_ppm;
+}
+
+
+void mock_sleep_us(uint32_t us)
+{
+  struct timespec delay = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000L };
+  nanosleep(&delay, NULL);
+}
+
+
+int64_t esp_timer_get_time()
+{
+  return mock_monotonic_us() - mock_start_us;
+}
+
+
+static void *mock_timer_run(void *arg)
+{
+  struct esp_timer *timer = arg;
+
+  pthread_mutex_lock(&timer->mutex);
+  while (true) {
+    if (!timer->armed) {
+      pthread_cond_wait(&timer->cond, &timer->mutex);
+      continue;
+    }
+
+    int64_t wait_us = timer->deadline_us - esp_timer_get_time();
+    if (wait_us > 0) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_MONOTONIC, &deadline);
+      uint64_t ns = deadline.tv_nsec + (uint64_t)wait_us * 1000;
+      deadline.tv_sec += ns / 1000000000;
+      deadline.tv_nsec = ns % 1000000000;
+      pthread_cond_timedwait(&timer->cond, &timer->mutex, &deadline);
+      continue;
+    }
+
+    if (timer->period_us > 0) {
+      timer->deadline_us += timer->period_us;
+    } else {
+      timer->armed = false;
+    }
+
+    // The callback may restart or stop the timer.
+    pthread_mutex_unlock(&timer->mutex);
+    timer->args.callback(timer->args.arg);
+    pthread_mutex_lock(&timer->mutex);
+  }
+
+  return NULL;
+}
+
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *timer)
+{
+  struct esp_timer *created = calloc(1, sizeof(*created));
+  created->args = *args;
+  pthread_mutex_init(&created->mutex, NULL);
+
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&created->cond, &attr);
+  pthread_condattr_destroy(&attr);
+
+  if (pthread_create(&created->thread, NULL, mock_timer_run, created) != 0) {
+    free(created);
+    return ESP_ERR_NO_MEM;
+  }
+  pthread_detach(created->thread);
+
+  *timer = created;
+
+  return ESP_OK;
+}
+
+
+static esp_err_t mock_timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us)
+{
+  pthread_mutex_lock(&timer->mutex);
+  if (timer->armed) {
+    pthread_mutex_unlock(&timer->mutex);
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  timer->armed = true;
+  timer->deadline_us = esp_timer_get_time() + timeout_us;
+  timer->period_us = period_us;
+  pthread_cond_signal(&timer->cond);
+  pthread_mutex_unlock(&timer->mutex);
+
+  return ESP_OK;
+}
+
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+  return mock_timer_start(timer, timeout_us, 0);
+}
+
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+  return mock_timer_start(timer, period_us, period_us);
+}
+
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+  pthread_mutex_lock(&timer->mutex);
+  bool armed = timer->armed;
+  timer->armed = false;
+  pthread_cond_signal(&timer->cond);
+  pthread_mutex_unlock(&timer->mutex);
+
+  return armed ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+
+void mock_log(esp_log_level_t level, char letter, const char *tag, const char *format, ...)
+{
+  if (level > mock_log_level) {
+    return;
+  }
+
+  va_list args;
+  va_start(args, format);
+  pthread_mutex_lock(&mock_log_mutex);
+  fprintf(stderr, "%c (%u) %s: ", letter, (uint32_t)(esp_timer_get_time() / 1000), tag);
+  vfprintf(stderr, format, args);
+  fputc('\n', stderr);
+  pthread_mutex_unlock(&mock_log_mutex);
+  va_end(args);
+}
+
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+  // Only the global level is kept.
+  mock_log_level = level;
+}
+
+
+const char *esp_err_to_name(esp_err_t code)
+{
+  switch (code) {
+    case ESP_OK:
+      return "ESP_OK";
+    case ESP_FAIL:
+      return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+      return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+      return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+      return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_FOUND:
+      return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_TIMEOUT:
+      return "ESP_ERR_TIMEOUT";
+    default:
+      return "UNKNOWN ERROR";
+  }
+}
+
+
+uint32_t esp_get_free_heap_size()
+{
+  // A typical station after boot.
+  return 180000;
+}
+
+
+uint32_t esp_get_minimum_free_heap_size()
+{
+  return 150000;
+}
+
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+  return 110000;
+}
+
+
+esp_err_t heap_caps_register_failed_alloc_callback(esp_alloc_failed_hook_t callback)
+{
+  return ESP_OK;
+}
+
+
+uint32_t esp_random()
+{
+  return mock_random();
+}
+
+
+void esp_restart()
+{
+  exit(1);
+}
+
+
+void esp_rom_delay_us(uint32_t us)
+{
+  int64_t end_us = esp_timer_get_time() + us;
+  while (esp_timer_get_time() < end_us) {
+  }
+}
+
+
+/**
+ * @brief           The CRC16 of the ROM, which inverts the CRC on the way in and out.
+ */
+uint16_t esp_rom_crc16_le(uint16_t crc, const uint8_t *buf, uint32_t len)
+{
+  crc = ~crc;
+  for (uint32_t i = 0; i < len; i++) {
+    crc ^= buf[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = crc & 1 ? (crc >> 1) ^ 0x8408 : crc >> 1;
+    }
+  }
+
+  return ~crc;
+}
+
+
+/**
+ * @brief           The CRC32 of the ROM, the same as the one of zlib and gzip.
+ */
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+  crc = ~crc;
+  for (uint32_t i = 0; i < len; i++) {
+    crc ^= buf[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = crc & 1 ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+    }
+  }
+
+  return ~crc;
+}
+
+
+esp_err_t esp_tls_get_and_clear_last_error(void *error_handle, int *esp_tls_code, int *esp_tls_flags)
+{
+  return ESP_OK;
+}
+
+
+esp_err_t esp_tls_set_global_ca_store(const unsigned char *cacert_pem_buf, const unsigned int cacert_pem_bytes)
+{
+  return ESP_OK;
+}
+
+
+void sntp_setoperatingmode(int mode)
+{
+}
+
+
+void sntp_setservername(int index, const char *server)
+{
+}
+
+
+void sntp_set_time_sync_notification_cb(sntp_sync_time_cb_t callback)
+{
+  mock_sntp_cb = callback;
+}
+
+
+static void *mock_sntp_run(void *arg)
+{
+  mock_sleep_us(mock_sntp_delay_ms * 1000);
+
+  // The host clock is already right, so the synchronization only reports it.
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  if (mock_sntp_cb != NULL) {
+    mock_sntp_cb(&tv);
+  }
+
+  return NULL;
+}
+
+
+void sntp_init()
+{
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, mock_sntp_run, NULL) == 0) {
+    pthread_detach(thread);
+  }
+}
@@ -0,0 +1,36 @@
+/**
+ * @file    sockets.h
+ *
+ * @brief   lwIP Sockets Shim Header File
+ *
+ * @remarks The sockets are the ones of the host. As lwIP maps them to its own calls, connect and send are mapped to
+ *          the ones of tls.c, which lead to the UDP listener of the fake InfluxDB and go away with the WIFI.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_LWIP_SOCKETS_H_
+#define _MOCK_LWIP_SOCKETS_H_
+
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+
+#define connect                       lwip_connect
+#define send                          lwip_send
+
+
+int lwip_connect(int s, const struct sockaddr *name, socklen_t namelen);
+
+
+ssize_t lwip_send(int s, const void *data, size_t size, int flags);
+
+
+#endif /* _MOCK_LWIP_SOCKETS_H_ */
@@ -0,0 +1,58 @@
+/**
+ * @file    ssl.h
+ *
+ * @brief   mbedTLS SSL Shim Header File
+ *
+ * @remarks A session holds an OpenSSL session, see tls.c, and is saved in its DER encoding.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_MBEDTLS_SSL_H_
+#define _MOCK_MBEDTLS_SSL_H_
+
+
+#include <stddef.h>
+#include <time.h>
+
+
+#define MBEDTLS_ERR_SSL_BAD_INPUT_DATA      (-0x7100)
+#define MBEDTLS_ERR_SSL_ALLOC_FAILED        (-0x7F00)
+#define MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL    (-0x6A00)
+#define MBEDTLS_ERR_SSL_WANT_READ           (-0x6900)
+#define MBEDTLS_ERR_SSL_WANT_WRITE          (-0x6880)
+
+typedef time_t mbedtls_time_t;
+
+typedef struct {
+  mbedtls_time_t start;
+  unsigned char master[48];
+  void *handle;
+} mbedtls_ssl_session;
+
+typedef struct {
+  mbedtls_ssl_session *session;
+  // The OpenSSL connection.
+  void *handle;
+} mbedtls_ssl_context;
+
+
+void mbedtls_ssl_session_init(mbedtls_ssl_session *session);
+
+
+void mbedtls_ssl_session_free(mbedtls_ssl_session *session);
+
+
+int mbedtls_ssl_session_save(const mbedtls_ssl_session *session, unsigned char *buf, size_t buf_len, size_t *olen);
+
+
+int mbedtls_ssl_session_load(mbedtls_ssl_session *session, const unsigned char *buf, size_t len);
+
+
+int mbedtls_ssl_get_session(const mbedtls_ssl_context *ssl, mbedtls_ssl_session *session);
+
+
+#endif /* _MOCK_MBEDTLS_SSL_H_ */
@@ -0,0 +1,171 @@
+/**
+ * @file    mock.h
+ *
+ * @brief   Mock HAL Control Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_H_
+#define _MOCK_H_
+
+
+#include "driver/i2c.h"
+#include "esp_event.h"
+#include "freertos/task.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+// The network the station joins.
+#define MOCK_WIFI_CHANNEL             (6)
+#define MOCK_WIFI_BSSID               { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 }
+// DHCP after the association.
+#define MOCK_WIFI_DHCP_US             (50000)
+
+// The raw temperature of the simulated sensors is offset by 50 degC.
+#define MOCK_BME280_T_OFFSET          (5000)
+
+#define MOCK_FLASH_SIZE               (0x40000)
+#define MOCK_NVS_ENTRIES              (8)
+#define MOCK_NVS_BLOB_SIZE            (64)
+#define MOCK_HTTP_BODY_SIZE           (32768)
+
+/**
+ * @brief   The behavior of a simulated operation. Each one takes the latency plus a uniform random part of the jitter,
+ *          and fails with the given probability in parts per million.
+ */
+typedef struct {
+  uint32_t latency_us;
+  uint32_t jitter_us;
+  uint32_t fail_ppm;
+} mock_fault_t;
+
+/**
+ * @brief   What the fake InfluxDB received.
+ */
+typedef struct {
+  uint32_t connects;
+  uint32_t resumptions;
+  uint32_t requests;
+  uint32_t failures;
+  uint32_t gzipped;
+  uint64_t bytes;
+  uint64_t raw_bytes;
+  uint64_t wire_bytes;                // both ways, with the TLS records and handshakes
+  uint64_t peak_heap;                 // the most any handshake of the client took, see mock_tls_handshake_t
+  uint32_t lines;                     // points written, once per series and timestamp
+  uint32_t duplicates;                // lines of a point that were written before
+  uint32_t overwrites;                // lines that gave a field of a point another value
+  uint32_t bad_lines;
+  uint32_t max_line_len;
+} mock_http_stats_t;
+
+/**
+ * @brief   What the last TLS handshake of the client cost.
+ */
+typedef struct {
+  bool resumed;
+  uint32_t us;
+  uint64_t bytes_out;
+  uint64_t bytes_in;
+  uint64_t peak_heap;                 // above the heap in use before the handshake, by the TLS library
+} mock_tls_handshake_t;
+
+/**
+ * @brief   What was done to the store partition.
+ */
+typedef struct {
+  uint32_t writes;
+  uint32_t page_writes;               // writes of whole pages, starting on one
+  uint32_t erases;
+} mock_flash_stats_t;
+
+// Every transaction on the I2C buses.
+extern mock_fault_t mock_i2c_fault;
+// Every association, from esp_wifi_connect to the connected event. One to a cached AP takes a quarter of it.
+extern mock_fault_t mock_wifi_fault;
+// Every TCP and TLS connection setup, on top of the real handshake. The TCP part takes a third of it, and a resumed
+// handshake skips the round trip of another third.
+extern mock_fault_t mock_http_connect_fault;
+// Every request on an established connection.
+extern mock_fault_t mock_http_request_fault;
+// The status and body of the accepted posts. A post with malformed lines is answered with a partial write instead.
+extern int mock_http_status;
+extern const char *mock_http_body;
+// The lines the server refuses as malformed, per million. It either writes the rest of the post, as a partial write,
+// or refuses the whole post, as some servers and proxies do.
+extern uint32_t mock_http_bad_ppm;
+extern bool mock_http_partial;
+// The server closes connections that were idle for longer.
+extern uint32_t mock_http_idle_ms;
+// The size of the chunks the response body is delivered in.
+extern uint32_t mock_http_chunk;
+// Makes every write to the store partition fail, as a worn out sector would.
+extern bool mock_flash_fail;
+// The time from sntp_init to the synchronization.
+extern uint32_t mock_sntp_delay_ms;
+
+
+void mock_seed(uint32_t seed);
+
+
+uint32_t mock_random();
+
+
+uint32_t mock_delay_us(const mock_fault_t *fault);
+
+
+bool mock_fails(const mock_fault_t *fault);
+
+
+void mock_sleep_us(uint32_t us);
+
+
+esp_err_t mock_event_post_delayed(esp_event_base_t base, int32_t id, const void *data, size_t size, uint32_t delay_us);
+
+
+void mock_bme280_attach(i2c_port_t port, uint8_t addr);
+
+
+uint32_t mock_bme280_measurements();
+
+
+bool mock_wifi_is_up();
+
+
+void mock_wifi_drop();
+
+
+uint32_t mock_wifi_link();
+
+
+void mock_http_get_stats(mock_http_stats_t *stats);
+
+
+uint32_t mock_http_points(const char *measurement);
+
+
+void mock_tls_get_last(mock_tls_handshake_t *handshake);
+
+
+void mock_udp_settle();
+
+
+void mock_flash_erase();
+
+
+void mock_flash_get_stats(mock_flash_stats_t *stats);
+
+
+uint16_t mock_httpd_port();
+
+
+uint64_t mock_task_cpu_us(TaskHandle_t task);
+
+
+#endif /* _MOCK_H_ */
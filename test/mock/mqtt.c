@@ -0,0 +1,436 @@
+/**
+ * @file    mqtt.c
+ *
+ * @brief   ESP MQTT Client Shim Source File
+ *
+ * @remarks An MQTT 3.1.1 client over the mocked esp-tls, which connects to the broker in front of the fake InfluxDB,
+ *          see tls.c. As the client of the IDF, it runs its own thread, which connects, reads the acknowledgements
+ *          and reconnects, while esp_mqtt_client_publish() writes from the caller. Both take the lock of the client,
+ *          so an acknowledgement may be handled before the publish returned its id. A QoS 1 publish stays in the
+ *          outbox until acknowledged, is resent on reconnection and expires after the default outbox timeout.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "mock.h"
+
+#include "esp_timer.h"
+#include "esp_tls.h"
+#include "mqtt_client.h"
+
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define MOCK_MQTT_OUTBOX              (16)
+#define MOCK_MQTT_OUTBOX_EXPIRED_US   (30000000)
+#define MOCK_MQTT_RECONNECT_MS        (10000)
+#define MOCK_MQTT_NETWORK_TIMEOUT_MS  (10000)
+#define MOCK_MQTT_POLL_MS             (10)
+#define MOCK_MQTT_PACKET_SIZE         (MOCK_HTTP_BODY_SIZE)
+
+#define MOCK_MQTT_CONNECT             (0x10)
+#define MOCK_MQTT_CONNACK             (0x20)
+#define MOCK_MQTT_PUBLISH             (0x30)
+#define MOCK_MQTT_PUBACK              (0x40)
+#define MOCK_MQTT_PINGREQ             (0xc0)
+#define MOCK_MQTT_PINGRESP            (0xd0)
+#define MOCK_MQTT_DUP                 (0x08)
+
+/**
+ * @brief   A publish waiting for its acknowledgement, as it went on the wire.
+ */
+typedef struct {
+  int msg_id;
+  int64_t created_us;
+  size_t len;
+  uint8_t *packet;
+} mock_mqtt_outbox_t;
+
+struct esp_mqtt_client {
+  esp_mqtt_client_config_t config;
+  esp_event_handler_t handler;
+  void *handler_arg;
+  pthread_mutex_t mutex;
+  esp_tls_t *tls;
+  // The association the connection was made over.
+  uint32_t link;
+  bool connected;
+  int64_t sent_us;
+  uint16_t next_id;
+  mock_mqtt_outbox_t outbox[MOCK_MQTT_OUTBOX];
+};
+
+
+static void mock_mqtt_dispatch(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event_id, int msg_id,
+                               int session_present)
+{
+  esp_mqtt_event_t event = {
+    .event_id = event_id,
+    .client = client,
+    .msg_id = msg_id,
+    .session_present = session_present
+  };
+
+  if (client->handler != NULL) {
+    client->handler(client->handler_arg, "MQTT_EVENTS", event_id, &event);
+  }
+}
+
+
+/**
+ * @brief           Writes a whole packet. Must be called with the lock held.
+ */
+static bool mock_mqtt_write(esp_mqtt_client_handle_t client, const uint8_t *packet, size_t len)
+{
+  for (size_t written = 0; written < len; ) {
+    ssize_t ret = esp_tls_conn_write(client->tls, packet + written, len - written);
+    if (ret <= 0) {
+      return false;
+    }
+    written += ret;
+  }
+  client->sent_us = esp_timer_get_time();
+
+  return true;
+}
+
+
+/**
+ * @brief           Reads a whole packet.
+ *
+ * @return          The length of the packet, header included, or 0 if the connection is gone.
+ */
+static size_t mock_mqtt_read(esp_mqtt_client_handle_t client, uint8_t *packet, size_t size)
+{
+  size_t len = 0;
+  size_t header_len = 0;
+  size_t remaining = 0;
+
+  while (header_len == 0 || len < header_len + remaining) {
+    ssize_t ret = esp_tls_conn_read(client->tls, packet + len, header_len == 0 ? 1 : header_len + remaining - len);
+    if (ret <= 0) {
+      return 0;
+    }
+    len += ret;
+
+    // The remaining length takes up to four bytes of seven bits each.
+    if (header_len == 0 && len >= 2 && !(packet[len - 1] & 0x80)) {
+      header_len = len;
+      for (size_t i = len - 1; i >= 1; i--) {
+        remaining = remaining << 7 | (packet[i] & 0x7f);
+      }
+      if (header_len + remaining > size) {
+        return 0;
+      }
+    } else if (header_len == 0 && len >= 5) {
+      return 0;
+    }
+  }
+
+  return len;
+}
+
+
+static size_t mock_mqtt_put_length(uint8_t *packet, size_t length)
+{
+  size_t len = 0;
+
+  do {
+    packet[len] = length & 0x7f;
+    length >>= 7;
+    packet[len] |= length > 0 ? 0x80 : 0;
+    len++;
+  } while (length > 0);
+
+  return len;
+}
+
+
+static size_t mock_mqtt_put_string(uint8_t *packet, const char *string)
+{
+  size_t len = string != NULL ? strlen(string) : 0;
+
+  packet[0] = len >> 8;
+  packet[1] = len;
+  memcpy(packet + 2, string, len);
+
+  return 2 + len;
+}
+
+
+/**
+ * @brief           Connects and sets the session up. Resends what is in the outbox, as the session is kept.
+ *
+ * @return          Whether the broker accepted the connection.
+ */
+static bool mock_mqtt_connect(esp_mqtt_client_handle_t client)
+{
+  esp_tls_cfg_t cfg = {
+    .timeout_ms = client->config.network_timeout_ms > 0 ? client->config.network_timeout_ms : MOCK_MQTT_NETWORK_TIMEOUT_MS,
+    .use_global_ca_store = client->config.use_global_ca_store,
+    .skip_common_name = client->config.skip_cert_common_name_check
+  };
+
+  esp_tls_t *tls = esp_tls_init();
+  if (tls == NULL) {
+    return false;
+  }
+  uint32_t link = mock_wifi_link();
+  if (esp_tls_conn_new_sync("broker", 6, 8883, &cfg, tls) != 1) {
+    esp_tls_conn_destroy(tls);
+    return false;
+  }
+
+  uint8_t body[256];
+  size_t body_len = mock_mqtt_put_string(body, "MQTT");
+  body[body_len++] = 4;
+  body[body_len++] = (client->config.disable_clean_session ? 0 : 0x02) | (client->config.username != NULL ? 0x80 : 0) |
+                     (client->config.password != NULL ? 0x40 : 0);
+  body[body_len++] = client->config.keepalive >> 8;
+  body[body_len++] = client->config.keepalive;
+  body_len += mock_mqtt_put_string(body + body_len, client->config.client_id);
+  if (client->config.username != NULL) {
+    body_len += mock_mqtt_put_string(body + body_len, client->config.username);
+  }
+  if (client->config.password != NULL) {
+    body_len += mock_mqtt_put_string(body + body_len, client->config.password);
+  }
+
+  uint8_t packet[sizeof(body) + 5] = { MOCK_MQTT_CONNECT };
+  size_t len = 1 + mock_mqtt_put_length(packet + 1, body_len);
+  memcpy(packet + len, body, body_len);
+  len += body_len;
+
+  pthread_mutex_lock(&client->mutex);
+  client->tls = tls;
+  client->link = link;
+  bool connected = mock_mqtt_write(client, packet, len) && mock_mqtt_read(client, packet, sizeof(packet)) == 4 &&
+                   packet[0] == MOCK_MQTT_CONNACK && packet[3] == 0;
+  int session_present = packet[2] & 0x01;
+
+  for (uint32_t i = 0; i < MOCK_MQTT_OUTBOX && connected; i++) {
+    if (client->outbox[i].packet != NULL) {
+      client->outbox[i].packet[0] |= MOCK_MQTT_DUP;
+      connected = mock_mqtt_write(client, client->outbox[i].packet, client->outbox[i].len);
+    }
+  }
+
+  client->connected = connected;
+  if (!connected) {
+    client->tls = NULL;
+    esp_tls_conn_destroy(tls);
+  }
+  pthread_mutex_unlock(&client->mutex);
+
+  if (connected) {
+    mock_mqtt_dispatch(client, MQTT_EVENT_CONNECTED, 0, session_present);
+  }
+
+  return connected;
+}
+
+
+static void mock_mqtt_disconnect(esp_mqtt_client_handle_t client)
+{
+  pthread_mutex_lock(&client->mutex);
+  client->connected = false;
+  esp_tls_conn_destroy(client->tls);
+  client->tls = NULL;
+  pthread_mutex_unlock(&client->mutex);
+
+  mock_mqtt_dispatch(client, MQTT_EVENT_DISCONNECTED, 0, 0);
+}
+
+
+/**
+ * @brief           Drops the publishes that waited too long for their acknowledgement. Must be called with the lock
+ *                  held.
+ */
+static void mock_mqtt_expire(esp_mqtt_client_handle_t client)
+{
+  int64_t now_us = esp_timer_get_time();
+
+  for (uint32_t i = 0; i < MOCK_MQTT_OUTBOX; i++) {
+    if (client->outbox[i].packet != NULL && now_us - client->outbox[i].created_us >= MOCK_MQTT_OUTBOX_EXPIRED_US) {
+      free(client->outbox[i].packet);
+      client->outbox[i].packet = NULL;
+    }
+  }
+}
+
+
+/**
+ * @brief           Handles the packets of the broker until the connection is lost. Pings the broker while idle.
+ */
+static void mock_mqtt_serve(esp_mqtt_client_handle_t client)
+{
+  uint8_t *packet = malloc(MOCK_MQTT_PACKET_SIZE);
+
+  while (1) {
+    struct pollfd pfd = { .fd = client->tls->sockfd, .events = POLLIN };
+    bool readable = poll(&pfd, 1, MOCK_MQTT_POLL_MS) > 0;
+
+    pthread_mutex_lock(&client->mutex);
+    mock_mqtt_expire(client);
+
+    // A connection made over a lost association is gone.
+    bool up = mock_wifi_is_up() && mock_wifi_link() == client->link;
+    size_t len = up && readable ? mock_mqtt_read(client, packet, MOCK_MQTT_PACKET_SIZE) : 0;
+
+    int acked = 0;
+    if (len == 4 && packet[0] == MOCK_MQTT_PUBACK) {
+      acked = packet[2] << 8 | packet[3];
+      for (uint32_t i = 0; i < MOCK_MQTT_OUTBOX; i++) {
+        if (client->outbox[i].packet != NULL && client->outbox[i].msg_id == acked) {
+          free(client->outbox[i].packet);
+          client->outbox[i].packet = NULL;
+        }
+      }
+    }
+
+    if (up && esp_timer_get_time() - client->sent_us >= client->config.keepalive * 1000000LL / 2) {
+      uint8_t ping[] = { MOCK_MQTT_PINGREQ, 0 };
+      up = mock_mqtt_write(client, ping, sizeof(ping));
+    }
+    pthread_mutex_unlock(&client->mutex);
+
+    if (acked > 0) {
+      mock_mqtt_dispatch(client, MQTT_EVENT_PUBLISHED, acked, 0);
+    }
+    if (!up || (readable && len == 0)) {
+      break;
+    }
+  }
+
+  free(packet);
+}
+
+
+static void *mock_mqtt_run(void *arg)
+{
+  esp_mqtt_client_handle_t client = arg;
+  uint32_t reconnect_ms = client->config.reconnect_timeout_ms > 0 ? client->config.reconnect_timeout_ms :
+                          MOCK_MQTT_RECONNECT_MS;
+
+  while (1) {
+    mock_mqtt_dispatch(client, MQTT_EVENT_BEFORE_CONNECT, 0, 0);
+    if (mock_mqtt_connect(client)) {
+      mock_mqtt_serve(client);
+      mock_mqtt_disconnect(client);
+    }
+    mock_sleep_us(reconnect_ms * 1000);
+  }
+
+  return NULL;
+}
+
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *config)
+{
+  esp_mqtt_client_handle_t client = calloc(1, sizeof(struct esp_mqtt_client));
+  if (client == NULL) {
+    return NULL;
+  }
+
+  client->config = *config;
+  pthread_mutex_init(&client->mutex, NULL);
+
+  return client;
+}
+
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t event_handler, void *event_handler_arg)
+{
+  client->handler = event_handler;
+  client->handler_arg = event_handler_arg;
+
+  return ESP_OK;
+}
+
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client)
+{
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, mock_mqtt_run, client) != 0) {
+    return ESP_FAIL;
+  }
+  pthread_detach(thread);
+
+  return ESP_OK;
+}
+
+
+/**
+ * @brief           Publishes a message. A QoS 1 publish is kept in the outbox until the broker acknowledges it.
+ *
+ * @return          The message id, 0 for QoS 0, or -1 if there is no connection or the outbox is full.
+ */
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len, int qos,
+                            int retain)
+{
+  size_t topic_len = strlen(topic);
+  size_t remaining = 2 + topic_len + (qos > 0 ? 2 : 0) + len;
+  uint8_t *packet = malloc(5 + remaining);
+  if (packet == NULL) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&client->mutex);
+  if (!client->connected) {
+    pthread_mutex_unlock(&client->mutex);
+    free(packet);
+    return -1;
+  }
+
+  int slot = -1;
+  for (int i = 0; i < MOCK_MQTT_OUTBOX && qos > 0 && slot < 0; i++) {
+    if (client->outbox[i].packet == NULL) {
+      slot = i;
+    }
+  }
+  if (qos > 0 && slot < 0) {
+    pthread_mutex_unlock(&client->mutex);
+    free(packet);
+    return -1;
+  }
+
+  int msg_id = 0;
+  if (qos > 0) {
+    client->next_id = client->next_id == UINT16_MAX ? 1 : client->next_id + 1;
+    msg_id = client->next_id;
+  }
+
+  packet[0] = MOCK_MQTT_PUBLISH | qos << 1 | (retain ? 1 : 0);
+  size_t packet_len = 1 + mock_mqtt_put_length(packet + 1, remaining);
+  packet_len += mock_mqtt_put_string(packet + packet_len, topic);
+  if (qos > 0) {
+    packet[packet_len++] = msg_id >> 8;
+    packet[packet_len++] = msg_id;
+  }
+  memcpy(packet + packet_len, data, len);
+  packet_len += len;
+
+  // A publish that did not make it out is resent with the outbox on reconnection.
+  mock_mqtt_write(client, packet, packet_len);
+  if (qos > 0) {
+    client->outbox[slot] = (mock_mqtt_outbox_t) {
+      .msg_id = msg_id,
+      .created_us = esp_timer_get_time(),
+      .len = packet_len,
+      .packet = packet
+    };
+  } else {
+    free(packet);
+  }
+  pthread_mutex_unlock(&client->mutex);
+
+  return msg_id;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file    mqtt_client.h
+ *
+ * @brief   ESP MQTT Client Shim Header File
+ *
+ * @remarks Speaks MQTT 3.1.1 over the mocked esp-tls to the broker in front of the fake InfluxDB, see mqtt.c.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_MQTT_CLIENT_H_
+#define _MOCK_MQTT_CLIENT_H_
+
+
+#include "esp_err.h"
+#include "esp_event.h"
+
+#include <stdbool.h>
+
+
+typedef struct esp_mqtt_client *esp_mqtt_client_handle_t;
+
+typedef enum {
+  MQTT_EVENT_ANY = -1,
+  MQTT_EVENT_ERROR = 0,
+  MQTT_EVENT_CONNECTED,
+  MQTT_EVENT_DISCONNECTED,
+  MQTT_EVENT_SUBSCRIBED,
+  MQTT_EVENT_UNSUBSCRIBED,
+  MQTT_EVENT_PUBLISHED,
+  MQTT_EVENT_DATA,
+  MQTT_EVENT_BEFORE_CONNECT,
+  MQTT_EVENT_DELETED
+} esp_mqtt_event_id_t;
+
+typedef struct {
+  esp_mqtt_event_id_t event_id;
+  esp_mqtt_client_handle_t client;
+  int msg_id;
+  int session_present;
+} esp_mqtt_event_t;
+
+typedef esp_mqtt_event_t *esp_mqtt_event_handle_t;
+
+typedef struct {
+  const char *uri;
+  const char *client_id;
+  const char *username;
+  const char *password;
+  int keepalive;
+  bool disable_clean_session;
+  bool use_global_ca_store;
+  bool skip_cert_common_name_check;
+  int reconnect_timeout_ms;
+  int network_timeout_ms;
+} esp_mqtt_client_config_t;
+
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *config);
+
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t event_handler, void *event_handler_arg);
+
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client);
+
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len, int qos,
+                            int retain);
+
+
+#endif /* _MOCK_MQTT_CLIENT_H_ */
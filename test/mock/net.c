@@ -0,0 +1,357 @@
+/**
+ * @file    net.c
+ *
+ * @brief   Network Shim Source File
+ *
+ * @remarks The default event loop, the network interface and the WIFI driver. The driver walks through the events of
+ *          a real association, each after its simulated latency, and loses the AP on request or on injected failures.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "mock.h"
+
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+#define MOCK_EVENT_HANDLERS           (8)
+#define MOCK_EVENT_DATA_SIZE          (64)
+
+
+typedef struct mock_event {
+  struct mock_event *next;
+  esp_event_base_t base;
+  int32_t id;
+  int64_t due_us;
+  // The association the event belongs to, or 0 for none.
+  uint32_t session;
+  uint8_t data[MOCK_EVENT_DATA_SIZE];
+} mock_event_t;
+
+typedef struct {
+  esp_event_base_t base;
+  int32_t id;
+  esp_event_handler_t handler;
+  void *arg;
+} mock_handler_t;
+
+esp_event_base_t const WIFI_EVENT = "WIFI_EVENT";
+esp_event_base_t const IP_EVENT = "IP_EVENT";
+
+mock_fault_t mock_wifi_fault = { .latency_us = 300000, .jitter_us = 200000 };
+
+static mock_handler_t mock_handlers[MOCK_EVENT_HANDLERS];
+static uint32_t mock_handler_count;
+static mock_event_t *mock_events;
+static pthread_mutex_t mock_event_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mock_event_cond;
+static bool mock_event_loop;
+
+static wifi_config_t mock_wifi_config;
+static const uint8_t mock_wifi_bssid[6] = MOCK_WIFI_BSSID;
+static atomic_bool mock_wifi_up;
+// Bumped on every connect and drop, so that the events of an association that was dropped are ignored.
+static atomic_uint mock_wifi_session;
+static esp_netif_t *mock_netif = (esp_netif_t *)&mock_wifi_session;
+
+
+static void *mock_event_run(void *arg)
+{
+  pthread_mutex_lock(&mock_event_mutex);
+  while (true) {
+    if (mock_events == NULL) {
+      pthread_cond_wait(&mock_event_cond, &mock_event_mutex);
+      continue;
+    }
+
+    int64_t wait_us = mock_events->due_us - esp_timer_get_time();
+    if (wait_us > 0) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_MONOTONIC, &deadline);
+      uint64_t ns = deadline.tv_nsec + (uint64_t)wait_us * 1000;
+      deadline.tv_sec += ns / 1000000000;
+      deadline.tv_nsec = ns % 1000000000;
+      pthread_cond_timedwait(&mock_event_cond, &mock_event_mutex, &deadline);
+      continue;
+    }
+
+    mock_event_t *event = mock_events;
+    mock_events = event->next;
+    uint32_t count = mock_handler_count;
+    pthread_mutex_unlock(&mock_event_mutex);
+
+    // The events of an association that was dropped or replaced never arrive.
+    if (event->session != 0 && event->session != atomic_load(&mock_wifi_session)) {
+      count = 0;
+    } else if (event->base == IP_EVENT && event->id == IP_EVENT_STA_GOT_IP) {
+      atomic_store(&mock_wifi_up, true);
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+      mock_handler_t *handler = &mock_handlers[i];
+      if (handler->base == event->base && (handler->id == ESP_EVENT_ANY_ID || handler->id == event->id)) {
+        handler->handler(handler->arg, event->base, event->id, event->data);
+      }
+    }
+    free(event);
+
+    pthread_mutex_lock(&mock_event_mutex);
+  }
+
+  return NULL;
+}
+
+
+esp_err_t esp_event_loop_create_default()
+{
+  pthread_mutex_lock(&mock_event_mutex);
+  if (mock_event_loop) {
+    pthread_mutex_unlock(&mock_event_mutex);
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&mock_event_cond, &attr);
+  pthread_condattr_destroy(&attr);
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, mock_event_run, NULL);
+  pthread_detach(thread);
+  mock_event_loop = true;
+  pthread_mutex_unlock(&mock_event_mutex);
+
+  return ESP_OK;
+}
+
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler,
+                                              void *arg, esp_event_handler_instance_t *instance)
+{
+  pthread_mutex_lock(&mock_event_mutex);
+  if (mock_handler_count >= MOCK_EVENT_HANDLERS) {
+    pthread_mutex_unlock(&mock_event_mutex);
+    return ESP_ERR_NO_MEM;
+  }
+
+  mock_handlers[mock_handler_count] = (mock_handler_t) { base, id, handler, arg };
+  if (instance != NULL) {
+    *instance = &mock_handlers[mock_handler_count];
+  }
+  mock_handler_count++;
+  pthread_mutex_unlock(&mock_event_mutex);
+
+  return ESP_OK;
+}
+
+
+/**
+ * @brief           Posts an event to be dispatched by the loop after a delay. The events are kept in order of their
+ *                  due time, and in order of posting for the same due time.
+ */
+static esp_err_t mock_event_queue(esp_event_base_t base, int32_t id, const void *data, size_t size, uint32_t delay_us,
+                                  uint32_t session)
+{
+  if (size > MOCK_EVENT_DATA_SIZE) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  mock_event_t *event = calloc(1, sizeof(*event));
+  event->base = base;
+  event->id = id;
+  event->due_us = esp_timer_get_time() + delay_us;
+  event->session = session;
+  if (data != NULL) {
+    memcpy(event->data, data, size);
+  }
+
+  pthread_mutex_lock(&mock_event_mutex);
+  mock_event_t **next = &mock_events;
+  while (*next != NULL && (*next)->due_us <= event->due_us) {
+    next = &(*next)->next;
+  }
+  event->next = *next;
+  *next = event;
+  pthread_cond_signal(&mock_event_cond);
+  pthread_mutex_unlock(&mock_event_mutex);
+
+  return ESP_OK;
+}
+
+
+esp_err_t mock_event_post_delayed(esp_event_base_t base, int32_t id, const void *data, size_t size, uint32_t delay_us)
+{
+  return mock_event_queue(base, id, data, size, delay_us, 0);
+}
+
+
+esp_err_t esp_event_post(esp_event_base_t base, int32_t id, const void *data, size_t size, TickType_t ticks)
+{
+  return mock_event_post_delayed(base, id, data, size, 0);
+}
+
+
+esp_err_t esp_netif_init()
+{
+  return ESP_OK;
+}
+
+
+esp_netif_t *esp_netif_create_default_wifi_sta()
+{
+  return mock_netif;
+}
+
+
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t *netif)
+{
+  return ESP_OK;
+}
+
+
+esp_err_t esp_netif_set_ip_info(esp_netif_t *netif, const esp_netif_ip_info_t *ip_info)
+{
+  return ESP_OK;
+}
+
+
+esp_err_t esp_netif_set_dns_info(esp_netif_t *netif, esp_netif_dns_type_t type, esp_netif_dns_info_t *dns)
+{
+  return ESP_OK;
+}
+
+
+esp_err_t esp_netif_str_to_ip4(const char *src, esp_ip4_addr_t *dst)
+{
+  unsigned int a, b, c, d;
+  if (sscanf(src, "%u.%u.%u.%u", &a, &b, &c, &d) != 4) {
+    return ESP_FAIL;
+  }
+
+  dst->addr = a | b << 8 | c << 16 | d << 24;
+
+  return ESP_OK;
+}
+
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config)
+{
+  return ESP_OK;
+}
+
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+  return ESP_OK;
+}
+
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *config)
+{
+  mock_wifi_config = *config;
+
+  return ESP_OK;
+}
+
+
+esp_err_t esp_wifi_set_ps(wifi_ps_type_t type)
+{
+  return ESP_OK;
+}
+
+
+esp_err_t esp_wifi_start()
+{
+  return esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, NULL, 0, 0);
+}
+
+
+/**
+ * @brief           Associates with the AP. A connection to the cached AP on its channel skips the scan and takes a
+ *                  quarter of the time, while one to a wrong cached AP fails after it.
+ */
+esp_err_t esp_wifi_connect()
+{
+  const wifi_sta_config_t *sta = &mock_wifi_config.sta;
+  bool cached = sta->bssid_set;
+  bool found = !cached || (memcmp(sta->bssid, mock_wifi_bssid, sizeof(mock_wifi_bssid)) == 0 &&
+                           sta->channel == MOCK_WIFI_CHANNEL);
+
+  uint32_t delay_us = mock_delay_us(&mock_wifi_fault);
+  if (cached) {
+    delay_us /= 4;
+  }
+
+  atomic_store(&mock_wifi_up, false);
+  uint32_t session = atomic_fetch_add(&mock_wifi_session, 1) + 1;
+
+  if (!found || mock_fails(&mock_wifi_fault)) {
+    wifi_event_sta_disconnected_t disconnected = { .reason = 201 };
+    return mock_event_queue(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &disconnected, sizeof(disconnected), delay_us,
+                            session);
+  }
+
+  ip_event_got_ip_t got_ip = {
+    .esp_netif = mock_netif,
+    .ip_info.ip.addr = 192 | 168 << 8 | 1 << 16 | 50 << 24
+  };
+  mock_event_queue(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, NULL, 0, delay_us, session);
+
+  // The link is usable once the address arrives.
+  return mock_event_queue(IP_EVENT, IP_EVENT_STA_GOT_IP, &got_ip, sizeof(got_ip), delay_us + MOCK_WIFI_DHCP_US,
+                          session);
+}
+
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap)
+{
+  if (!atomic_load(&mock_wifi_up)) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  memset(ap, 0, sizeof(*ap));
+  memcpy(ap->bssid, mock_wifi_bssid, sizeof(mock_wifi_bssid));
+  ap->primary = MOCK_WIFI_CHANNEL;
+  ap->rssi = -60;
+
+  return ESP_OK;
+}
+
+
+bool mock_wifi_is_up()
+{
+  return atomic_load(&mock_wifi_up);
+}
+
+
+void mock_wifi_drop()
+{
+  atomic_store(&mock_wifi_up, false);
+  atomic_fetch_add(&mock_wifi_session, 1);
+
+  wifi_event_sta_disconnected_t disconnected = { .reason = 8 };
+  esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &disconnected, sizeof(disconnected), 0);
+}
+
+
+/**
+ * @brief           The current association. A connection made over an earlier one is lost.
+ */
+uint32_t mock_wifi_link()
+{
+  return atomic_load(&mock_wifi_session);
+}
@@ -0,0 +1,51 @@
+/**
+ * @file    nvs.h
+ *
+ * @brief   NVS Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_NVS_H_
+#define _MOCK_NVS_H_
+
+
+#include "esp_err.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define ESP_ERR_NVS_BASE              (0x1100)
+#define ESP_ERR_NVS_NOT_FOUND         (ESP_ERR_NVS_BASE + 0x02)
+#define ESP_ERR_NVS_INVALID_LENGTH    (ESP_ERR_NVS_BASE + 0x0c)
+#define ESP_ERR_NVS_NO_FREE_PAGES     (ESP_ERR_NVS_BASE + 0x0d)
+#define ESP_ERR_NVS_NEW_VERSION_FOUND (ESP_ERR_NVS_BASE + 0x10)
+
+typedef uint32_t nvs_handle_t;
+
+typedef enum {
+  NVS_READONLY,
+  NVS_READWRITE
+} nvs_open_mode_t;
+
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *handle);
+
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *value, size_t *length);
+
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length);
+
+
+esp_err_t nvs_commit(nvs_handle_t handle);
+
+
+void nvs_close(nvs_handle_t handle);
+
+
+#endif /* _MOCK_NVS_H_ */
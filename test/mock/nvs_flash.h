@@ -0,0 +1,25 @@
+/**
+ * @file    nvs_flash.h
+ *
+ * @brief   NVS Flash Shim Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_NVS_FLASH_H_
+#define _MOCK_NVS_FLASH_H_
+
+
+#include "nvs.h"
+
+
+esp_err_t nvs_flash_init();
+
+
+esp_err_t nvs_flash_erase();
+
+
+#endif /* _MOCK_NVS_FLASH_H_ */
@@ -0,0 +1,18 @@
+/**
+ * @file    sdkconfig.h
+ *
+ * @brief   SDK Configuration Shim Header File
+ *
+ * @remarks Nothing is configured, so the firmware falls back to the defaults of the ESP IDF.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _MOCK_SDKCONFIG_H_
+#define _MOCK_SDKCONFIG_H_
+
+
+#endif /* _MOCK_SDKCONFIG_H_ */
@@ -0,0 +1,1144 @@
+/**
+ * @file    tls.c
+ *
+ * @brief   TLS Shim Source File
+ *
+ * @remarks A fake InfluxDB behind real TLS 1.2 connections, over OpenSSL on socket pairs. It takes its session tickets
+ *          back for an abbreviated handshake, closes the connections that were idle for too long and goes away with
+ *          the WIFI. The bodies are unzipped and parsed line by line, and a body with malformed lines is answered with
+ *          a partial write, as by InfluxDB 1.x. An MQTT client is served by a broker in front of it instead, which
+ *          hands the payloads of the QoS 1 publishes over as a Telegraf mqtt_consumer would, and acknowledges each one
+ *          a request latency later, without holding up the ones behind it. A UDP listener on the loopback takes in
+ *          the datagrams as the InfluxDB UDP service does, without an answer. The fields are kept by series and timestamp as the database does, so
+ *          a point sent again is written once, lines of the same point are merged and a field written again with
+ *          another value is an overwrite. The response is written in small records, so that it comes off the
+ *          socket in parts. What each handshake of the client took, the time, the bytes on the wire and the heap of
+ *          the TLS library, is measured for comparison.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "mock.h"
+
+#include "esp_timer.h"
+#include "esp_tls.h"
+#include "mbedtls/ssl.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <zlib.h>
+
+
+#define MOCK_TLS_HEADER_SIZE          (1024)
+#define MOCK_TLS_RESPONSE_SIZE        (512)
+// The acknowledgements the broker holds back at once.
+#define MOCK_MQTT_PENDING             (64)
+// Keeps the blocks of the TLS library aligned behind their size.
+#define MOCK_TLS_HEAP_HEADER          (16)
+// The datagrams the UDP listener is behind by at most, in 64 KB.
+#define MOCK_UDP_BUFFER_SIZE          (1 << 22)
+#define MOCK_UDP_DATAGRAM_SIZE        (65536)
+// How long the datagrams sent are waited for.
+#define MOCK_UDP_SETTLE_MS            (1000)
+// The points and fields the server keeps, a power of two.
+#define MOCK_HTTP_ENTRIES             (1 << 19)
+
+/**
+ * @brief   A point or a field of one the server keeps, by the hash of its series, timestamp and field name. A field
+ *          keeps the hash of its value, a point the one of its measurement.
+ */
+typedef struct {
+  uint64_t key;
+  uint64_t value;
+  bool point;
+} mock_http_entry_t;
+
+struct mock_tls {
+  SSL *ssl;
+  // The association the connection was made over.
+  uint32_t link;
+  mbedtls_ssl_session session;
+};
+
+mock_fault_t mock_http_connect_fault = { .latency_us = 60000, .jitter_us = 40000 };
+mock_fault_t mock_http_request_fault = { .latency_us = 20000, .jitter_us = 20000 };
+int mock_http_status = 204;
+const char *mock_http_body = "";
+uint32_t mock_http_bad_ppm = 0;
+bool mock_http_partial = true;
+uint32_t mock_http_idle_ms = 5000;
+uint32_t mock_http_chunk = 16;
+
+static pthread_once_t mock_tls_once = PTHREAD_ONCE_INIT;
+static pthread_once_t mock_udp_once = PTHREAD_ONCE_INIT;
+static int mock_udp_fd = -1;
+static struct sockaddr_in mock_udp_addr;
+static atomic_uint mock_udp_sent;
+static atomic_uint mock_udp_received;
+static SSL_CTX *mock_tls_server_ctx;
+static SSL_CTX *mock_tls_client_ctx;
+static mock_tls_handshake_t mock_tls_last;
+
+static mock_http_stats_t mock_http_stats;
+// Whether the broker keeps a session for the client.
+static bool mock_mqtt_session;
+static mock_http_entry_t mock_http_entries[MOCK_HTTP_ENTRIES];
+static uint32_t mock_http_entry_count;
+static pthread_mutex_t mock_http_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// The heap the TLS library holds on each thread, and its peak.
+static __thread int64_t mock_tls_heap;
+static __thread int64_t mock_tls_heap_peak;
+
+
+static void mock_tls_heap_add(int64_t size)
+{
+  mock_tls_heap += size;
+  if (mock_tls_heap > mock_tls_heap_peak) {
+    mock_tls_heap_peak = mock_tls_heap;
+  }
+}
+
+
+static void *mock_tls_malloc(size_t size, const char *file, int line)
+{
+  uint8_t *block = malloc(MOCK_TLS_HEAP_HEADER + size);
+  if (block == NULL) {
+    return NULL;
+  }
+
+  *(size_t *)block = size;
+  mock_tls_heap_add(size);
+
+  return block + MOCK_TLS_HEAP_HEADER;
+}
+
+
+static void *mock_tls_realloc(void *ptr, size_t size, const char *file, int line)
+{
+  if (ptr == NULL) {
+    return mock_tls_malloc(size, file, line);
+  }
+
+  uint8_t *block = (uint8_t *)ptr - MOCK_TLS_HEAP_HEADER;
+  size_t old_size = *(size_t *)block;
+  block = realloc(block, MOCK_TLS_HEAP_HEADER + size);
+  if (block == NULL) {
+    return NULL;
+  }
+
+  *(size_t *)block = size;
+  mock_tls_heap_add((int64_t)size - (int64_t)old_size);
+
+  return block + MOCK_TLS_HEAP_HEADER;
+}
+
+
+static void mock_tls_free(void *ptr, const char *file, int line)
+{
+  if (ptr == NULL) {
+    return;
+  }
+
+  uint8_t *block = (uint8_t *)ptr - MOCK_TLS_HEAP_HEADER;
+  mock_tls_heap -= *(size_t *)block;
+  free(block);
+}
+
+
+/**
+ * @brief           Routes the heap of the TLS library through the counters, which has to happen before its first
+ *                  allocation.
+ */
+__attribute__((constructor)) static void mock_tls_hook_heap()
+{
+  CRYPTO_set_mem_functions(mock_tls_malloc, mock_tls_realloc, mock_tls_free);
+}
+
+
+/**
+ * @brief           Creates the certificate of the server, self-signed on P-256 as the embedded influxdb.pem would be,
+ *                  and the contexts of both ends. The server issues session tickets and keeps no session cache.
+ */
+static void mock_tls_setup()
+{
+  // A write to a connection the server closed fails instead of killing the process.
+  signal(SIGPIPE, SIG_IGN);
+
+  EVP_PKEY *key = EVP_EC_gen("P-256");
+  X509 *cert = X509_new();
+  X509_set_version(cert, 2);
+  ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+  X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+  X509_gmtime_adj(X509_getm_notAfter(cert), 86400);
+  X509_set_pubkey(cert, key);
+  X509_NAME *name = X509_get_subject_name(cert);
+  X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)"influxdb", -1, -1, 0);
+  X509_set_issuer_name(cert, name);
+  X509_sign(cert, key, EVP_sha256());
+
+  mock_tls_server_ctx = SSL_CTX_new(TLS_server_method());
+  SSL_CTX_set_min_proto_version(mock_tls_server_ctx, TLS1_2_VERSION);
+  SSL_CTX_set_max_proto_version(mock_tls_server_ctx, TLS1_2_VERSION);
+  SSL_CTX_use_certificate(mock_tls_server_ctx, cert);
+  SSL_CTX_use_PrivateKey(mock_tls_server_ctx, key);
+  SSL_CTX_set_session_cache_mode(mock_tls_server_ctx, SSL_SESS_CACHE_OFF);
+  SSL_CTX_set_timeout(mock_tls_server_ctx, 86400);
+
+  // The profile of the trimmed mbedTLS of the station.
+  mock_tls_client_ctx = SSL_CTX_new(TLS_client_method());
+  SSL_CTX_set_min_proto_version(mock_tls_client_ctx, TLS1_2_VERSION);
+  SSL_CTX_set_max_proto_version(mock_tls_client_ctx, TLS1_2_VERSION);
+  SSL_CTX_set_cipher_list(mock_tls_client_ctx, "ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-ECDSA-AES256-GCM-SHA384");
+  SSL_CTX_set1_groups_list(mock_tls_client_ctx, "P-256:P-384:X25519");
+  SSL_CTX_set_options(mock_tls_client_ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+  SSL_CTX_set_verify(mock_tls_client_ctx, SSL_VERIFY_PEER, NULL);
+  X509_STORE *store = SSL_CTX_get_cert_store(mock_tls_client_ctx);
+  X509_STORE_add_cert(store, cert);
+  X509_STORE_set_flags(store, X509_V_FLAG_PARTIAL_CHAIN);
+
+  X509_free(cert);
+  EVP_PKEY_free(key);
+}
+
+
+/**
+ * @brief           Checks a line against the line protocol: a measurement with optional tags, a space, at least one
+ *                  field and an optional integer timestamp.
+ */
+static bool mock_http_line_is_valid(const char *line, size_t len)
+{
+  const char *fields = memchr(line, ' ', len);
+  if (fields == NULL || fields == line) {
+    return false;
+  }
+
+  fields++;
+  size_t fields_len = len - (fields - line);
+  const char *timestamp = memchr(fields, ' ', fields_len);
+  size_t set_len = timestamp != NULL ? (size_t)(timestamp - fields) : fields_len;
+  if (set_len == 0 || memchr(fields, '=', set_len) == NULL) {
+    return false;
+  }
+
+  if (timestamp != NULL) {
+    timestamp++;
+    size_t timestamp_len = len - (timestamp - line);
+    if (timestamp_len == 0) {
+      return false;
+    }
+    for (size_t i = 0; i < timestamp_len; i++) {
+      if ((timestamp[i] < '0' || timestamp[i] > '9') && !(i == 0 && timestamp[i] == '-')) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief           Tells whether a line is one of the mock_http_bad_ppm the server refuses. The same line is refused
+ *                  each time it is sent.
+ */
+static bool mock_http_line_is_refused(const char *line, size_t len)
+{
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ (uint8_t)line[i]) * 16777619u;
+  }
+
+  return hash % 1000000 < mock_http_bad_ppm;
+}
+
+
+static uint64_t mock_http_hash(uint64_t hash, const char *data, size_t len)
+{
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ (uint8_t)data[i]) * 1099511628211ull;
+  }
+
+  return hash;
+}
+
+
+/**
+ * @brief           Finds the entry of a key, or the free one it goes to. Must be called with the mutex held.
+ */
+static mock_http_entry_t *mock_http_entry(uint64_t key)
+{
+  // Zero marks the free entries.
+  key |= 1;
+
+  uint32_t slot = key & (MOCK_HTTP_ENTRIES - 1);
+  while (mock_http_entries[slot].key != 0 && mock_http_entries[slot].key != key) {
+    slot = (slot + 1) & (MOCK_HTTP_ENTRIES - 1);
+  }
+
+  if (mock_http_entries[slot].key == 0) {
+    if (mock_http_entry_count >= MOCK_HTTP_ENTRIES / 2) {
+      fprintf(stderr, "The mocked server keeps up to %u points and fields\n", MOCK_HTTP_ENTRIES / 2);
+      abort();
+    }
+    mock_http_entries[slot].key = key;
+    mock_http_entry_count++;
+  }
+
+  return &mock_http_entries[slot];
+}
+
+
+/**
+ * @brief           Writes a valid line as the database would. A line without a timestamp is stamped with the time it
+ *                  arrived, so it is always a new point. The fields are split on every comma, as the station writes no
+ *                  strings. Must be called with the mutex held.
+ */
+static void mock_http_write_line(const char *line, size_t len)
+{
+  static const uint64_t seed = 14695981039346656037ull;
+
+  const char *fields = memchr(line, ' ', len) + 1;
+  const char *timestamp = memchr(fields, ' ', len - (fields - line));
+  const char *end = timestamp != NULL ? timestamp : line + len;
+  const char *tags = memchr(line, ',', fields - 1 - line);
+
+  uint64_t key = mock_http_hash(seed, line, fields - line);
+  if (timestamp != NULL) {
+    key = mock_http_hash(key, timestamp, len - (timestamp - line));
+  } else {
+    key = mock_http_hash(key, (const char *)&mock_http_entry_count, sizeof(mock_http_entry_count));
+  }
+
+  mock_http_entry_t *point = mock_http_entry(key);
+  bool merged = point->point;
+  if (!merged) {
+    point->point = true;
+    point->value = mock_http_hash(seed, line, (tags != NULL ? tags : fields - 1) - line);
+    mock_http_stats.lines++;
+  }
+
+  bool changed = false;
+  bool overwritten = false;
+  for (const char *field = fields; field < end; ) {
+    const char *comma = memchr(field, ',', end - field);
+    const char *field_end = comma != NULL ? comma : end;
+    const char *equals = memchr(field, '=', field_end - field);
+    if (equals != NULL) {
+      mock_http_entry_t *entry = mock_http_entry(mock_http_hash(key, field, equals - field));
+      uint64_t value = mock_http_hash(seed, equals + 1, field_end - equals - 1) | 1;
+      if (entry->value == 0) {
+        changed = true;
+      } else if (entry->value != value) {
+        overwritten = true;
+      }
+      entry->value = value;
+    }
+    field = field_end + 1;
+  }
+
+  if (overwritten) {
+    mock_http_stats.overwrites++;
+  } else if (merged && !changed) {
+    mock_http_stats.duplicates++;
+  }
+}
+
+
+/**
+ * @brief           Takes in a body as the server would and sets the response.
+ *
+ * @return          The status.
+ */
+static int mock_http_ingest(const uint8_t *body, size_t len, bool gzip, char *response, size_t size)
+{
+  static uint8_t raw[MOCK_HTTP_BODY_SIZE];
+  size_t raw_len = len;
+
+  pthread_mutex_lock(&mock_http_mutex);
+  mock_http_stats.requests++;
+  mock_http_stats.bytes += len;
+
+  if (gzip) {
+    z_stream stream = { 0 };
+    inflateInit2(&stream, 16 + MAX_WBITS);
+    stream.next_in = (uint8_t *)body;
+    stream.avail_in = len;
+    stream.next_out = raw;
+    stream.avail_out = sizeof(raw);
+    int z_err = inflate(&stream, Z_FINISH);
+    raw_len = stream.total_out;
+    inflateEnd(&stream);
+
+    mock_http_stats.gzipped++;
+    if (z_err != Z_STREAM_END) {
+      pthread_mutex_unlock(&mock_http_mutex);
+      snprintf(response, size, "{\"error\":\"bad gzip body\"}");
+      return 400;
+    }
+    body = raw;
+  }
+  mock_http_stats.raw_bytes += raw_len;
+
+  uint32_t bad_lines = 0;
+  const char *bad = NULL;
+  size_t bad_len = 0;
+  const char *line = (const char *)body;
+  const char *end = line + raw_len;
+  while (line < end) {
+    const char *newline = memchr(line, '\n', end - line);
+    size_t line_len = newline != NULL ? (size_t)(newline - line) : (size_t)(end - line);
+    if (line_len > mock_http_stats.max_line_len) {
+      mock_http_stats.max_line_len = line_len;
+    }
+    if (line_len > 0) {
+      if (!mock_http_line_is_valid(line, line_len) || mock_http_line_is_refused(line, line_len)) {
+        bad_lines++;
+        if (bad == NULL) {
+          bad = line;
+          bad_len = line_len;
+        }
+      }
+    }
+    line += line_len + 1;
+  }
+
+  mock_http_stats.bad_lines += bad_lines;
+
+  // The unzipped body is shared by the connections. Without partial writes, a single bad line refuses them all.
+  if (bad_lines > 0 && !mock_http_partial) {
+    snprintf(response, size, "{\"error\":\"unable to parse '%.*s': invalid field format\"}",
+             (int)(bad_len < 64 ? bad_len : 64), bad);
+    pthread_mutex_unlock(&mock_http_mutex);
+    return 400;
+  }
+
+  for (line = (const char *)body; line < end; ) {
+    const char *newline = memchr(line, '\n', end - line);
+    size_t line_len = newline != NULL ? (size_t)(newline - line) : (size_t)(end - line);
+    if (line_len > 0 && mock_http_line_is_valid(line, line_len) && !mock_http_line_is_refused(line, line_len)) {
+      mock_http_write_line(line, line_len);
+    }
+    line += line_len + 1;
+  }
+
+  if (bad_lines > 0) {
+    snprintf(response, size, "{\"error\":\"partial write: unable to parse '%.*s': invalid field format dropped=%u\"}",
+             (int)(bad_len < 64 ? bad_len : 64), bad, bad_lines);
+    pthread_mutex_unlock(&mock_http_mutex);
+    return 400;
+  }
+  pthread_mutex_unlock(&mock_http_mutex);
+
+  snprintf(response, size, "%s", mock_http_body);
+
+  return mock_http_status;
+}
+
+
+static const char *mock_http_reason(int status)
+{
+  switch (status) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 404: return "Not Found";
+    case 413: return "Request Entity Too Large";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "Unknown";
+  }
+}
+
+
+/**
+ * @brief           Writes a buffer to a connection in records of mock_http_chunk bytes.
+ */
+static bool mock_tls_write_chunked(SSL *ssl, const char *data, size_t len)
+{
+  for (size_t offset = 0; offset < len; offset += mock_http_chunk) {
+    size_t part = len - offset < mock_http_chunk ? len - offset : mock_http_chunk;
+    if (SSL_write(ssl, data + offset, part) <= 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief           Reads a request and answers it, as the InfluxDB does.
+ *
+ * @param buffer    Room for the header and the body of the request.
+ *
+ * @return        - true if the connection is kept open for the next request
+ *                - false if it was closed, or is to be closed
+ */
+static bool mock_tls_serve_request(SSL *ssl, int fd, char *buffer)
+{
+  size_t size = MOCK_TLS_HEADER_SIZE + MOCK_HTTP_BODY_SIZE;
+  size_t len = 0;
+  size_t header_len = 0;
+  size_t body_len = 0;
+  char *header_end = NULL;
+
+  while (header_end == NULL || len < header_len + body_len) {
+    // The connection is closed once idle for too long, but not in the middle of a request.
+    if (len == 0 && SSL_pending(ssl) == 0) {
+      struct pollfd pfd = { .fd = fd, .events = POLLIN };
+      if (poll(&pfd, 1, mock_http_idle_ms) == 0) {
+        SSL_shutdown(ssl);
+        return false;
+      }
+    }
+
+    int ret = SSL_read(ssl, buffer + len, size - 1 - len);
+    if (ret <= 0) {
+      return false;
+    }
+    len += ret;
+    buffer[len] = '\0';
+
+    if (header_end == NULL && (header_end = strstr(buffer, "\r\n\r\n")) != NULL) {
+      header_len = header_end + 4 - buffer;
+      const char *length = strcasestr(buffer, "\r\nContent-Length:");
+      body_len = length != NULL && length < header_end ? strtoul(length + 17, NULL, 10) : 0;
+      if (header_len + body_len >= size) {
+        return false;
+      }
+    } else if (header_end == NULL && len >= MOCK_TLS_HEADER_SIZE) {
+      return false;
+    }
+  }
+  *header_end = '\0';
+
+  mock_sleep_us(mock_delay_us(&mock_http_request_fault));
+  if (mock_fails(&mock_http_request_fault)) {
+    pthread_mutex_lock(&mock_http_mutex);
+    mock_http_stats.failures++;
+    pthread_mutex_unlock(&mock_http_mutex);
+    return false;
+  }
+
+  const char *encoding = strcasestr(buffer, "\r\nContent-Encoding:");
+  bool gzip = encoding != NULL && strncmp(encoding + 19, " gzip", 5) == 0;
+  bool close = strcasestr(buffer, "\r\nConnection: close") != NULL;
+
+  char body[MOCK_TLS_RESPONSE_SIZE / 2];
+  int status = 0;
+  if (strncmp(buffer, "POST /write?", 12) != 0 || strstr(buffer, "precision=") == NULL ||
+      strstr(buffer, " HTTP/1.1\r\n") == NULL) {
+    status = 404;
+    snprintf(body, sizeof(body), "404 page not found\n");
+  } else {
+    status = mock_http_ingest((const uint8_t *)buffer + header_len, body_len, gzip, body, sizeof(body));
+  }
+
+  // A success has no body, as with the InfluxDB 1.x, and the errors are sized.
+  char response[MOCK_TLS_RESPONSE_SIZE];
+  size_t response_len = snprintf(response, sizeof(response),
+                                 "HTTP/1.1 %d %s\r\n"
+                                 "Content-Type: application/json\r\n"
+                                 "X-Influxdb-Version: 1.8.10\r\n"
+                                 "%s", status, mock_http_reason(status), close ? "Connection: close\r\n" : "");
+  if (status != 204) {
+    response_len += snprintf(response + response_len, sizeof(response) - response_len, "Content-Length: %u\r\n",
+                             (unsigned)strlen(body));
+  }
+  response_len += snprintf(response + response_len, sizeof(response) - response_len, "\r\n%s",
+                           status != 204 ? body : "");
+  if (response_len >= sizeof(response)) {
+    response_len = sizeof(response) - 1;
+  }
+
+  if (!mock_tls_write_chunked(ssl, response, response_len)) {
+    return false;
+  }
+
+  if (close) {
+    SSL_shutdown(ssl);
+    return false;
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief           Counts the bytes a connection has exchanged since the last call, the TLS records included.
+ */
+static void mock_tls_count_wire(SSL *ssl, uint64_t *counted)
+{
+  uint64_t bytes = BIO_number_read(SSL_get_rbio(ssl)) + BIO_number_written(SSL_get_wbio(ssl));
+
+  pthread_mutex_lock(&mock_http_mutex);
+  mock_http_stats.wire_bytes += bytes - *counted;
+  pthread_mutex_unlock(&mock_http_mutex);
+  *counted = bytes;
+}
+
+
+/**
+ * @brief           Reads an MQTT packet.
+ *
+ * @return          The length of the packet, header included, or 0 if the connection is gone or the packet is too
+ *                  large.
+ */
+static size_t mock_mqtt_read(SSL *ssl, uint8_t *packet, size_t size)
+{
+  size_t header_len = 0;
+  size_t remaining = 0;
+
+  // The remaining length takes up to four bytes of seven bits each.
+  for (size_t len = 0; header_len == 0; len++) {
+    if (len == 5 || SSL_read(ssl, packet + len, 1) != 1) {
+      return 0;
+    }
+    if (len >= 1 && !(packet[len] & 0x80)) {
+      header_len = len + 1;
+    }
+  }
+  for (size_t i = header_len - 1; i >= 1; i--) {
+    remaining = remaining << 7 | (packet[i] & 0x7f);
+  }
+  if (header_len + remaining > size) {
+    return 0;
+  }
+
+  for (size_t len = header_len; len < header_len + remaining; ) {
+    int ret = SSL_read(ssl, packet + len, header_len + remaining - len);
+    if (ret <= 0) {
+      return 0;
+    }
+    len += ret;
+  }
+
+  return header_len + remaining;
+}
+
+
+/**
+ * @brief           Serves an MQTT client, from its CONNECT until either end closes the connection. The publishes go to
+ *                  the InfluxDB as they come in, and each is acknowledged once its request latency is over. A failed
+ *                  request drops the connection with everything not acknowledged yet.
+ */
+static void mock_mqtt_serve(SSL *ssl, int fd, uint8_t *packet, uint64_t *counted)
+{
+  struct {
+    uint16_t msg_id;
+    int64_t due_us;
+  } pending[MOCK_MQTT_PENDING];
+  uint32_t pending_count = 0;
+
+  size_t len = mock_mqtt_read(ssl, packet, MOCK_TLS_HEADER_SIZE + MOCK_HTTP_BODY_SIZE);
+  if (len < 12 || packet[0] != 0x10) {
+    return;
+  }
+
+  // The variable header of a CONNECT follows a two byte length and "MQTT": the level, the flags and the keepalive.
+  size_t header_len;
+  for (header_len = 1; packet[header_len] & 0x80; header_len++) {
+  }
+  header_len++;
+  bool clean = packet[header_len + 7] & 0x02;
+
+  pthread_mutex_lock(&mock_http_mutex);
+  bool session_present = !clean && mock_mqtt_session;
+  mock_mqtt_session = !clean;
+  pthread_mutex_unlock(&mock_http_mutex);
+
+  uint8_t connack[] = { 0x20, 0x02, session_present, 0x00 };
+  if (SSL_write(ssl, connack, sizeof(connack)) <= 0) {
+    return;
+  }
+
+  while (1) {
+    int64_t now_us = esp_timer_get_time();
+    int timeout_ms = -1;
+    if (pending_count > 0) {
+      timeout_ms = pending[0].due_us > now_us ? (pending[0].due_us - now_us + 999) / 1000 : 0;
+    }
+
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    if (SSL_pending(ssl) > 0 || poll(&pfd, 1, timeout_ms) > 0) {
+      len = mock_mqtt_read(ssl, packet, MOCK_TLS_HEADER_SIZE + MOCK_HTTP_BODY_SIZE);
+      if (len == 0) {
+        return;
+      }
+
+      uint8_t type = packet[0] & 0xf0;
+      if (type == 0xc0) {
+        uint8_t pingresp[] = { 0xd0, 0x00 };
+        if (SSL_write(ssl, pingresp, sizeof(pingresp)) <= 0) {
+          return;
+        }
+      } else if (type == 0xe0) {
+        return;
+      } else if (type == 0x30) {
+        for (header_len = 1; packet[header_len] & 0x80; header_len++) {
+        }
+        header_len++;
+        uint32_t qos = packet[0] >> 1 & 0x03;
+        size_t topic_len = packet[header_len] << 8 | packet[header_len + 1];
+        size_t offset = header_len + 2 + topic_len;
+        uint16_t msg_id = 0;
+        if (qos > 0) {
+          msg_id = packet[offset] << 8 | packet[offset + 1];
+          offset += 2;
+        }
+
+        if (mock_fails(&mock_http_request_fault)) {
+          pthread_mutex_lock(&mock_http_mutex);
+          mock_http_stats.failures++;
+          pthread_mutex_unlock(&mock_http_mutex);
+          return;
+        }
+
+        // Telegraf logs the lines it cannot parse and writes the rest.
+        char response[MOCK_TLS_RESPONSE_SIZE / 2];
+        const uint8_t *payload = packet + offset;
+        size_t payload_len = len - offset;
+        bool gzip = payload_len >= 2 && payload[0] == 0x1f && payload[1] == 0x8b;
+        mock_http_ingest(payload, payload_len, gzip, response, sizeof(response));
+
+        if (qos > 0 && pending_count < MOCK_MQTT_PENDING) {
+          pending[pending_count].msg_id = msg_id;
+          pending[pending_count].due_us = esp_timer_get_time() + mock_delay_us(&mock_http_request_fault);
+          // The acknowledgements keep their order, as on one connection.
+          if (pending_count > 0 && pending[pending_count].due_us < pending[pending_count - 1].due_us) {
+            pending[pending_count].due_us = pending[pending_count - 1].due_us;
+          }
+          pending_count++;
+        }
+      }
+    }
+
+    now_us = esp_timer_get_time();
+    while (pending_count > 0 && pending[0].due_us <= now_us) {
+      uint8_t puback[] = { 0x40, 0x02, pending[0].msg_id >> 8, pending[0].msg_id };
+      if (SSL_write(ssl, puback, sizeof(puback)) <= 0) {
+        return;
+      }
+      pending_count--;
+      memmove(&pending[0], &pending[1], pending_count * sizeof(pending[0]));
+    }
+
+    mock_tls_count_wire(ssl, counted);
+  }
+}
+
+
+/**
+ * @brief           Serves one connection until either end closes it.
+ */
+static void *mock_tls_serve(void *arg)
+{
+  int fd = (intptr_t)arg;
+  SSL *ssl = SSL_new(mock_tls_server_ctx);
+  SSL_set_fd(ssl, fd);
+
+  if (SSL_accept(ssl) == 1) {
+    pthread_mutex_lock(&mock_http_mutex);
+    mock_http_stats.connects++;
+    if (SSL_session_reused(ssl)) {
+      mock_http_stats.resumptions++;
+    }
+    pthread_mutex_unlock(&mock_http_mutex);
+
+    uint64_t counted = 0;
+    mock_tls_count_wire(ssl, &counted);
+
+    // An MQTT client starts with a CONNECT, where an HTTP one starts with the request line.
+    char *buffer = malloc(MOCK_TLS_HEADER_SIZE + MOCK_HTTP_BODY_SIZE);
+    uint8_t first = 0;
+    if (SSL_peek(ssl, &first, 1) == 1 && first == 0x10) {
+      mock_mqtt_serve(ssl, fd, (uint8_t *)buffer, &counted);
+    } else {
+      while (mock_tls_serve_request(ssl, fd, buffer)) {
+        mock_tls_count_wire(ssl, &counted);
+      }
+    }
+    mock_tls_count_wire(ssl, &counted);
+    free(buffer);
+  }
+
+  SSL_free(ssl);
+  close(fd);
+
+  return NULL;
+}
+
+
+/**
+ * @brief           Takes in the datagrams of the UDP listener, one body each.
+ */
+static void *mock_udp_serve(void *arg)
+{
+  static uint8_t datagram[MOCK_UDP_DATAGRAM_SIZE];
+  char response[MOCK_TLS_RESPONSE_SIZE];
+
+  while (1) {
+    ssize_t len = recv(mock_udp_fd, datagram, sizeof(datagram), 0);
+    if (len < 0) {
+      continue;
+    }
+
+    pthread_mutex_lock(&mock_http_mutex);
+    mock_http_stats.wire_bytes += len;
+    pthread_mutex_unlock(&mock_http_mutex);
+
+    mock_http_ingest(datagram, len, false, response, sizeof(response));
+    atomic_fetch_add(&mock_udp_received, 1);
+  }
+
+  return NULL;
+}
+
+
+/**
+ * @brief           Binds the UDP listener to a free port of the loopback, with a buffer deep enough not to drop.
+ */
+static void mock_udp_setup()
+{
+  mock_udp_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  int buffer_size = MOCK_UDP_BUFFER_SIZE;
+  setsockopt(mock_udp_fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+
+  mock_udp_addr.sin_family = AF_INET;
+  mock_udp_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(mock_udp_addr);
+  if (bind(mock_udp_fd, (struct sockaddr *)&mock_udp_addr, len) != 0 ||
+      getsockname(mock_udp_fd, (struct sockaddr *)&mock_udp_addr, &len) != 0) {
+    perror("UDP listener");
+    abort();
+  }
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, mock_udp_serve, NULL);
+  pthread_detach(thread);
+}
+
+
+/**
+ * @brief           Copies what an OpenSSL session holds into an mbedTLS one.
+ */
+static void mock_tls_describe(mbedtls_ssl_session *session, SSL_SESSION *handle)
+{
+  session->start = SSL_SESSION_get_time(handle);
+  SSL_SESSION_get_master_key(handle, session->master, sizeof(session->master));
+}
+
+
+void mock_http_get_stats(mock_http_stats_t *stats)
+{
+  pthread_mutex_lock(&mock_http_mutex);
+  *stats = mock_http_stats;
+  pthread_mutex_unlock(&mock_http_mutex);
+}
+
+
+uint32_t mock_http_points(const char *measurement)
+{
+  uint64_t hash = mock_http_hash(14695981039346656037ull, measurement, strlen(measurement));
+  uint32_t points = 0;
+
+  pthread_mutex_lock(&mock_http_mutex);
+  for (uint32_t slot = 0; slot < MOCK_HTTP_ENTRIES; slot++) {
+    if (mock_http_entries[slot].point && mock_http_entries[slot].value == hash) {
+      points++;
+    }
+  }
+  pthread_mutex_unlock(&mock_http_mutex);
+
+  return points;
+}
+
+
+void mock_udp_settle()
+{
+  int64_t start_us = esp_timer_get_time();
+
+  while (atomic_load(&mock_udp_received) != atomic_load(&mock_udp_sent) &&
+         esp_timer_get_time() - start_us < MOCK_UDP_SETTLE_MS * 1000LL) {
+    mock_sleep_us(1000);
+  }
+}
+
+
+void mock_tls_get_last(mock_tls_handshake_t *handshake)
+{
+  pthread_mutex_lock(&mock_http_mutex);
+  *handshake = mock_tls_last;
+  pthread_mutex_unlock(&mock_http_mutex);
+}
+
+
+void mbedtls_ssl_session_init(mbedtls_ssl_session *session)
+{
+  memset(session, 0, sizeof(*session));
+}
+
+
+void mbedtls_ssl_session_free(mbedtls_ssl_session *session)
+{
+  if (session->handle != NULL) {
+    SSL_SESSION_free(session->handle);
+  }
+  memset(session, 0, sizeof(*session));
+}
+
+
+int mbedtls_ssl_session_save(const mbedtls_ssl_session *session, unsigned char *buf, size_t buf_len, size_t *olen)
+{
+  if (session->handle == NULL) {
+    return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  }
+
+  int len = i2d_SSL_SESSION(session->handle, NULL);
+  *olen = len > 0 ? len : 0;
+  if (len <= 0) {
+    return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  }
+  if ((size_t)len > buf_len) {
+    return MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL;
+  }
+
+  i2d_SSL_SESSION(session->handle, &buf);
+
+  return 0;
+}
+
+
+int mbedtls_ssl_session_load(mbedtls_ssl_session *session, const unsigned char *buf, size_t len)
+{
+  SSL_SESSION *handle = d2i_SSL_SESSION(NULL, &buf, len);
+  if (handle == NULL) {
+    return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  }
+
+  session->handle = handle;
+  mock_tls_describe(session, handle);
+
+  return 0;
+}
+
+
+int mbedtls_ssl_get_session(const mbedtls_ssl_context *ssl, mbedtls_ssl_session *session)
+{
+  SSL_SESSION *handle = ssl->handle != NULL ? SSL_get1_session(ssl->handle) : NULL;
+  if (handle == NULL) {
+    return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+  }
+
+  session->handle = handle;
+  mock_tls_describe(session, handle);
+
+  return 0;
+}
+
+
+esp_tls_t *esp_tls_init()
+{
+  esp_tls_t *tls = calloc(1, sizeof(esp_tls_t));
+  if (tls == NULL) {
+    return NULL;
+  }
+
+  tls->mock = calloc(1, sizeof(struct mock_tls));
+  if (tls->mock == NULL) {
+    free(tls);
+    return NULL;
+  }
+  tls->sockfd = -1;
+
+  return tls;
+}
+
+
+/**
+ * @brief           Connects to the fake InfluxDB. The host and the port are ignored.
+ *
+ * @return        - 1 once connected
+ *                - -1 on failure
+ */
+int esp_tls_conn_new_sync(const char *hostname, int hostlen, int port, const esp_tls_cfg_t *cfg, esp_tls_t *tls)
+{
+  pthread_once(&mock_tls_once, mock_tls_setup);
+
+  uint32_t delay_us = mock_delay_us(&mock_http_connect_fault);
+  mock_sleep_us(delay_us / 3);
+  if (!mock_wifi_is_up() || mock_fails(&mock_http_connect_fault)) {
+    return -1;
+  }
+
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+    return -1;
+  }
+
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, mock_tls_serve, (void *)(intptr_t)fds[1]) != 0) {
+    close(fds[0]);
+    close(fds[1]);
+    return -1;
+  }
+  pthread_detach(thread);
+
+  struct timeval timeout = { .tv_sec = cfg->timeout_ms / 1000, .tv_usec = (cfg->timeout_ms % 1000) * 1000 };
+  setsockopt(fds[0], SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fds[0], SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  tls->sockfd = fds[0];
+  tls->mock->link = mock_wifi_link();
+
+  int64_t heap = mock_tls_heap;
+  mock_tls_heap_peak = heap;
+  int64_t start_us = esp_timer_get_time();
+
+  SSL *ssl = SSL_new(mock_tls_client_ctx);
+  SSL_set_fd(ssl, fds[0]);
+  if (cfg->client_session != NULL && cfg->client_session->saved_session.handle != NULL) {
+    SSL_set_session(ssl, cfg->client_session->saved_session.handle);
+  }
+  tls->mock->ssl = ssl;
+
+  if (SSL_connect(ssl) != 1) {
+    ERR_clear_error();
+    return -1;
+  }
+
+  mock_tls_handshake_t handshake = {
+    .resumed = SSL_session_reused(ssl),
+    .us = esp_timer_get_time() - start_us,
+    .bytes_out = BIO_number_written(SSL_get_wbio(ssl)),
+    .bytes_in = BIO_number_read(SSL_get_rbio(ssl)),
+    .peak_heap = mock_tls_heap_peak - heap
+  };
+  pthread_mutex_lock(&mock_http_mutex);
+  mock_tls_last = handshake;
+  if (handshake.peak_heap > mock_http_stats.peak_heap) {
+    mock_http_stats.peak_heap = handshake.peak_heap;
+  }
+  pthread_mutex_unlock(&mock_http_mutex);
+
+  mock_sleep_us(handshake.resumed ? delay_us / 3 : delay_us - delay_us / 3);
+
+  mock_tls_describe(&tls->mock->session, SSL_get_session(ssl));
+  tls->ssl.session = &tls->mock->session;
+  tls->ssl.handle = ssl;
+
+  return 1;
+}
+
+
+/**
+ * @brief           Maps the result of an OpenSSL read or write to the one of esp-tls.
+ */
+static ssize_t mock_tls_result(esp_tls_t *tls, int ret)
+{
+  if (ret > 0) {
+    return ret;
+  }
+
+  switch (SSL_get_error(tls->mock->ssl, ret)) {
+    case SSL_ERROR_ZERO_RETURN:
+      return 0;
+    case SSL_ERROR_WANT_READ:
+      return ESP_TLS_ERR_SSL_WANT_READ;
+    case SSL_ERROR_WANT_WRITE:
+      return ESP_TLS_ERR_SSL_WANT_WRITE;
+    default:
+      ERR_clear_error();
+      return -1;
+  }
+}
+
+
+ssize_t esp_tls_conn_write(esp_tls_t *tls, const void *data, size_t datalen)
+{
+  // A connection made over a lost association is gone.
+  if (!mock_wifi_is_up() || mock_wifi_link() != tls->mock->link) {
+    return -1;
+  }
+
+  return mock_tls_result(tls, SSL_write(tls->mock->ssl, data, datalen));
+}
+
+
+ssize_t esp_tls_conn_read(esp_tls_t *tls, void *data, size_t datalen)
+{
+  if (!mock_wifi_is_up() || mock_wifi_link() != tls->mock->link) {
+    return -1;
+  }
+
+  return mock_tls_result(tls, SSL_read(tls->mock->ssl, data, datalen));
+}
+
+
+/**
+ * @brief           Closes the connection without a close notify, as esp-tls does.
+ */
+int esp_tls_conn_destroy(esp_tls_t *tls)
+{
+  if (tls->mock->ssl != NULL) {
+    SSL_free(tls->mock->ssl);
+  }
+  if (tls->sockfd >= 0) {
+    close(tls->sockfd);
+  }
+  free(tls->mock);
+  free(tls);
+
+  return 0;
+}
+
+
+/**
+ * @brief           Connects a UDP socket to the listener, whatever the address.
+ */
+int lwip_connect(int s, const struct sockaddr *name, socklen_t namelen)
+{
+  pthread_once(&mock_udp_once, mock_udp_setup);
+
+  return connect(s, (struct sockaddr *)&mock_udp_addr, sizeof(mock_udp_addr));
+}
+
+
+/**
+ * @brief           Sends a datagram, which fails without a route while the WIFI is down.
+ */
+ssize_t lwip_send(int s, const void *data, size_t size, int flags)
+{
+  if (!mock_wifi_is_up()) {
+    errno = EHOSTUNREACH;
+    return -1;
+  }
+
+  ssize_t sent = send(s, data, size, flags);
+  if (sent >= 0) {
+    atomic_fetch_add(&mock_udp_sent, 1);
+  }
+
+  return sent;
+}
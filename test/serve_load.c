@@ -0,0 +1,411 @@
+/**
+ * @file    serve_load.c
+ *
+ * @brief   Serve Load Test Source File
+ *
+ * @remarks Scrapes the HTTP server of the station from concurrent clients over loopback, as a few collectors and
+ *          dashboards would, for a given time. Every client alternates between /metrics and /history on a kept-alive
+ *          connection and reconnects when the server purges it. Every response is checked, and the throughput and
+ *          the latencies are printed, one key=value per line.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "mock.h"
+
+#include "esp_log.h"
+#include "nvs_flash.h"
+
+#include "agg.h"
+#include "bme.h"
+#include "boot.h"
+#include "clock.h"
+#include "http.h"
+#include "i2c.h"
+#include "perf.h"
+#include "serve.h"
+
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define SERVE_LOAD_MAX_CLIENTS        (64)
+#define SERVE_LOAD_MAX_LATENCIES      (65536)
+#define SERVE_LOAD_BODY_SIZE          (32768)
+
+typedef struct {
+  uint32_t clients;
+  uint32_t seconds;
+} serve_load_config_t;
+
+typedef struct {
+  int fd;
+  char buffer[4096];
+  uint32_t pos;
+  uint32_t len;
+} serve_load_reader_t;
+
+typedef struct {
+  pthread_t thread;
+  uint32_t requests;
+  uint32_t reconnects;
+  uint32_t errors;
+  uint64_t bytes;
+  uint32_t latency_count;
+  uint32_t latencies_us[SERVE_LOAD_MAX_LATENCIES];
+} serve_load_client_t;
+
+static serve_load_client_t serve_load_clients[SERVE_LOAD_MAX_CLIENTS];
+static int64_t serve_load_end_us;
+static uint32_t serve_load_history_lines;
+
+
+static int64_t serve_load_now_us()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+
+static int serve_load_connect()
+{
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr = {
+    .sin_family = AF_INET,
+    .sin_port = htons(mock_httpd_port()),
+    .sin_addr.s_addr = htonl(INADDR_LOOPBACK)
+  };
+  if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  return fd;
+}
+
+
+/**
+ * @brief           Reads up to the next CRLF, which is dropped.
+ *
+ * @return          The length of the line, or -1 if the connection was closed.
+ */
+static int serve_load_read_line(serve_load_reader_t *reader, char *line, uint32_t size)
+{
+  uint32_t len = 0;
+  for (;;) {
+    if (reader->pos == reader->len) {
+      ssize_t received = recv(reader->fd, reader->buffer, sizeof(reader->buffer), 0);
+      if (received <= 0) {
+        return -1;
+      }
+      reader->pos = 0;
+      reader->len = received;
+    }
+
+    char c = reader->buffer[reader->pos++];
+    if (c == '\n' && len > 0 && line[len - 1] == '\r') {
+      line[len - 1] = '\0';
+      return len - 1;
+    }
+    if (len < size - 1) {
+      line[len++] = c;
+    }
+  }
+}
+
+
+static bool serve_load_read(serve_load_reader_t *reader, char *data, uint32_t len)
+{
+  while (len > 0) {
+    if (reader->pos == reader->len) {
+      ssize_t received = recv(reader->fd, reader->buffer, sizeof(reader->buffer), 0);
+      if (received <= 0) {
+        return false;
+      }
+      reader->pos = 0;
+      reader->len = received;
+    }
+
+    uint32_t n = reader->len - reader->pos < len ? reader->len - reader->pos : len;
+    memcpy(data, reader->buffer + reader->pos, n);
+    reader->pos += n;
+    data += n;
+    len -= n;
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief           Reads a chunked response.
+ *
+ * @param reader    The reader of the connection.
+ * @param body      The body destination, NUL terminated.
+ * @param started   Set once any of the response was received.
+ *
+ * @return          The length of the body, or -1 if the response is malformed or the connection was closed.
+ */
+static int serve_load_response(serve_load_reader_t *reader, char *body, bool *started)
+{
+  char line[256];
+  int len = serve_load_read_line(reader, line, sizeof(line));
+  if (len < 0) {
+    return -1;
+  }
+  *started = true;
+  if (strncmp(line, "HTTP/1.1 200 ", 13) != 0) {
+    return -1;
+  }
+
+  bool chunked = false;
+  while ((len = serve_load_read_line(reader, line, sizeof(line))) > 0) {
+    chunked |= strcmp(line, "Transfer-Encoding: chunked") == 0;
+  }
+  if (len < 0 || !chunked) {
+    return -1;
+  }
+
+  uint32_t body_len = 0;
+  for (;;) {
+    if (serve_load_read_line(reader, line, sizeof(line)) <= 0) {
+      return -1;
+    }
+    uint32_t chunk_len = strtoul(line, NULL, 16);
+    if (chunk_len == 0) {
+      break;
+    }
+    if (body_len + chunk_len >= SERVE_LOAD_BODY_SIZE || !serve_load_read(reader, body + body_len, chunk_len) ||
+        serve_load_read_line(reader, line, sizeof(line)) != 0) {
+      return -1;
+    }
+    body_len += chunk_len;
+  }
+  body[body_len] = '\0';
+
+  return serve_load_read_line(reader, line, sizeof(line)) == 0 ? (int)body_len : -1;
+}
+
+
+/**
+ * @brief           Checks a /history body, which has to hold every kept sample as a line of its own.
+ */
+static bool serve_load_history_is_valid(const char *body, uint32_t len)
+{
+  uint32_t lines = 0;
+  const char *line = body;
+  const char *end;
+  while ((end = memchr(line, '\n', body + len - line)) != NULL) {
+    if (strncmp(line, HTTP_MEASUREMENT ",location=", strlen(HTTP_MEASUREMENT ",location=")) != 0 ||
+        memchr(line, ' ', end - line) == NULL) {
+      return false;
+    }
+    lines++;
+    line = end + 1;
+  }
+
+  return line == body + len && lines == serve_load_history_lines;
+}
+
+
+static void *serve_load_client(void *arg)
+{
+  serve_load_client_t *client = arg;
+  static char bodies[SERVE_LOAD_MAX_CLIENTS][SERVE_LOAD_BODY_SIZE];
+  char *body = bodies[client - serve_load_clients];
+  serve_load_reader_t reader = { .fd = -1 };
+
+  while (serve_load_now_us() < serve_load_end_us) {
+    if (reader.fd < 0) {
+      reader.fd = serve_load_connect();
+      reader.pos = reader.len = 0;
+      if (reader.fd < 0) {
+        client->errors++;
+        continue;
+      }
+    }
+
+    bool history = client->requests % 2 == 1;
+    char request[64];
+    int request_len = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: station\r\n\r\n", history ? "/history" : "/metrics");
+
+    int64_t start_us = serve_load_now_us();
+    bool started = false;
+    int len = -1;
+    if (send(reader.fd, request, request_len, MSG_NOSIGNAL) == request_len) {
+      len = serve_load_response(&reader, body, &started);
+    }
+
+    if (len < 0) {
+      close(reader.fd);
+      reader.fd = -1;
+      // A connection purged for a newer one is closed before it is served, and the request is sent again.
+      if (started) {
+        client->errors++;
+      }
+      else {
+        client->reconnects++;
+      }
+      continue;
+    }
+
+    bool valid = history ? serve_load_history_is_valid(body, len) : strstr(body, "station_temperature_celsius{location=") != NULL;
+    if (!valid) {
+      client->errors++;
+    }
+    client->requests++;
+    client->bytes += len;
+    if (client->latency_count < SERVE_LOAD_MAX_LATENCIES) {
+      client->latencies_us[client->latency_count++] = serve_load_now_us() - start_us;
+    }
+  }
+
+  if (reader.fd >= 0) {
+    close(reader.fd);
+  }
+
+  return NULL;
+}
+
+
+static int serve_load_compare(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+
+  return x < y ? -1 : x > y;
+}
+
+
+static void serve_load_usage(const char *name)
+{
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  --clients N          scrape from N concurrent clients, up to %u (8)\n"
+          "  --seconds N          run for N seconds (5)\n"
+          "  --verbose            log at the info level\n", name, SERVE_LOAD_MAX_CLIENTS);
+}
+
+
+static void serve_load_parse(int argc, char **argv, serve_load_config_t *config)
+{
+  static const struct option options[] = {
+    { "clients", required_argument, NULL, 'c' },
+    { "seconds", required_argument, NULL, 's' },
+    { "verbose", no_argument, NULL, 'v' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+
+  int option;
+  while ((option = getopt_long(argc, argv, "", options, NULL)) != -1) {
+    uint32_t value = optarg != NULL ? strtoul(optarg, NULL, 0) : 0;
+    switch (option) {
+      case 'c': config->clients = value < SERVE_LOAD_MAX_CLIENTS ? value : SERVE_LOAD_MAX_CLIENTS; break;
+      case 's': config->seconds = value; break;
+      case 'v': esp_log_level_set("*", ESP_LOG_INFO); break;
+      case 'h':
+        serve_load_usage(argv[0]);
+        exit(0);
+      default:
+        serve_load_usage(argv[0]);
+        exit(2);
+    }
+  }
+}
+
+
+int main(int argc, char **argv)
+{
+  serve_load_config_t config = {
+    .clients = 8,
+    .seconds = 5
+  };
+  serve_load_parse(argc, argv, &config);
+
+  mock_bme280_attach(I2C_PORT, BME280_I2C_ADDR_PRIM);
+  mock_bme280_attach(I2C_PORT, BME280_I2C_ADDR_SEC);
+  boot_init();
+  nvs_flash_init();
+  i2c_setup();
+  uint32_t found = bme_init();
+
+  // A full history, as the station keeps after a few rounds of sampling.
+  for (uint32_t i = 0; i < AGG_HISTORY_SIZE; i++) {
+    sample_t sample = {
+      .temperature = 2150 + (int32_t)i,
+      .pressure = 10132500 + i,
+      .humidity = 45000 + i,
+      .timestamp = CLOCK_EPOCH_MIN_MS + i * 1000LL,
+      .sensor = i % found
+    };
+    agg_keep(&sample);
+  }
+  serve_load_history_lines = AGG_HISTORY_SIZE;
+
+  if (serve_start() != ESP_OK) {
+    return 1;
+  }
+
+  int64_t start_us = serve_load_now_us();
+  serve_load_end_us = start_us + config.seconds * 1000000LL;
+  for (uint32_t i = 0; i < config.clients; i++) {
+    pthread_create(&serve_load_clients[i].thread, NULL, serve_load_client, &serve_load_clients[i]);
+  }
+
+  uint32_t requests = 0;
+  uint32_t reconnects = 0;
+  uint32_t errors = 0;
+  uint64_t bytes = 0;
+  uint32_t latency_count = 0;
+  static uint32_t latencies_us[SERVE_LOAD_MAX_CLIENTS * SERVE_LOAD_MAX_LATENCIES / 16];
+  for (uint32_t i = 0; i < config.clients; i++) {
+    serve_load_client_t *client = &serve_load_clients[i];
+    pthread_join(client->thread, NULL);
+    requests += client->requests;
+    reconnects += client->reconnects;
+    errors += client->errors;
+    bytes += client->bytes;
+    for (uint32_t j = 0; j < client->latency_count && latency_count < sizeof(latencies_us) / sizeof(latencies_us[0]); j++) {
+      latencies_us[latency_count++] = client->latencies_us[j];
+    }
+  }
+  double elapsed_s = (serve_load_now_us() - start_us) / 1e6;
+  qsort(latencies_us, latency_count, sizeof(latencies_us[0]), serve_load_compare);
+
+  printf("clients=%u\n", config.clients);
+  printf("max_sockets=%u\n", SERVE_MAX_SOCKETS);
+  printf("seconds=%.2f\n", elapsed_s);
+  printf("requests=%u\n", requests);
+  printf("requests_per_s=%.0f\n", requests / elapsed_s);
+  printf("bytes_per_s=%.0f\n", bytes / elapsed_s);
+  printf("reconnects=%u\n", reconnects);
+  printf("errors=%u\n", errors);
+  if (latency_count > 0) {
+    printf("latency_p50_us=%u\n", latencies_us[latency_count / 2]);
+    printf("latency_p99_us=%u\n", latencies_us[(uint64_t)latency_count * 99 / 100]);
+    printf("latency_max_us=%u\n", latencies_us[latency_count - 1]);
+  }
+  printf("serve_p50_us=%u\n", perf_percentile(PERF_STAGE_SERVE, 50));
+  printf("serve_p99_us=%u\n", perf_percentile(PERF_STAGE_SERVE, 99));
+
+  return requests > 0 && errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,289 @@
+/**
+ * @file    station.c
+ *
+ * @brief   Station Benchmark Source File
+ *
+ * @remarks Runs the firmware of the station on the host, from the sensors to the InfluxDB, against the mocked HAL. The
+ *          sensors are sampled at a given rate and the uploads kicked on a given period, as the scheduler does on the
+ *          target, and the latencies and failures of the buses and the network are injected. At the end everything
+ *          is flushed and a diffable summary is printed, one key=value per line.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "mock.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nvs_flash.h"
+
+#include "bme.h"
+#include "boot.h"
+#include "http.h"
+#include "i2c.h"
+#include "perf.h"
+#include "stats.h"
+#include "store.h"
+#include "wifi.h"
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#define STATION_TAG                   "STAT"
+
+typedef struct {
+  uint32_t seconds;
+  double rate_hz;
+  uint32_t sensors;
+  uint32_t upload_ms;
+  uint32_t drop_s;
+  uint32_t seed;
+} station_config_t;
+
+
+static void station_usage(const char *name)
+{
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  --seconds N          run for N seconds (10)\n"
+          "  --rate-hz R          sample all sensors R times per second, up to 1000 / BME_SAMPLING_PERIOD_MS (1)\n"
+          "  --sensors N          attach N sensors, up to 4 (1)\n"
+          "  --upload-ms N        kick the uploads every N ms (5000)\n"
+          "  --drop-at N          drop the WIFI N seconds in (never)\n"
+          "  --i2c-us N           I2C transaction latency (150)\n"
+          "  --i2c-fail-ppm N     I2C transaction failures per million (0)\n"
+          "  --wifi-us N          association latency (300000)\n"
+          "  --wifi-fail-ppm N    association failures per million (0)\n"
+          "  --connect-us N       TCP and TLS setup latency (60000)\n"
+          "  --connect-fail-ppm N connection failures per million (0)\n"
+          "  --post-us N          request latency (20000)\n"
+          "  --post-fail-ppm N    request failures per million (0)\n"
+          "  --idle-ms N          server keep-alive timeout (5000)\n"
+          "  --bad-line-ppm N     lines the server refuses as malformed per million (0)\n"
+          "  --whole-refusal      refuse the whole post over a bad line, not a partial write\n"
+          "  --seed N             seed of the injected faults (1)\n"
+          "  --verbose            log at the info level\n", name);
+}
+
+
+static void station_parse(int argc, char **argv, station_config_t *config)
+{
+  static const struct option options[] = {
+    { "seconds", required_argument, NULL, 's' },
+    { "rate-hz", required_argument, NULL, 'r' },
+    { "sensors", required_argument, NULL, 'n' },
+    { "upload-ms", required_argument, NULL, 'u' },
+    { "drop-at", required_argument, NULL, 'd' },
+    { "i2c-us", required_argument, NULL, 'a' },
+    { "i2c-fail-ppm", required_argument, NULL, 'A' },
+    { "wifi-us", required_argument, NULL, 'w' },
+    { "wifi-fail-ppm", required_argument, NULL, 'W' },
+    { "connect-us", required_argument, NULL, 'c' },
+    { "connect-fail-ppm", required_argument, NULL, 'C' },
+    { "post-us", required_argument, NULL, 'p' },
+    { "post-fail-ppm", required_argument, NULL, 'P' },
+    { "idle-ms", required_argument, NULL, 'i' },
+    { "bad-line-ppm", required_argument, NULL, 'B' },
+    { "whole-refusal", no_argument, NULL, 'R' },
+    { "seed", required_argument, NULL, 'S' },
+    { "verbose", no_argument, NULL, 'v' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+
+  int option;
+  while ((option = getopt_long(argc, argv, "", options, NULL)) != -1) {
+    uint32_t value = optarg != NULL ? strtoul(optarg, NULL, 0) : 0;
+    switch (option) {
+      case 's': config->seconds = value; break;
+      case 'r': config->rate_hz = strtod(optarg, NULL); break;
+      case 'n': config->sensors = value < BME_MAX_SENSORS ? value : BME_MAX_SENSORS; break;
+      case 'u': config->upload_ms = value; break;
+      case 'd': config->drop_s = value; break;
+      case 'a': mock_i2c_fault.latency_us = value; break;
+      case 'A': mock_i2c_fault.fail_ppm = value; break;
+      case 'w': mock_wifi_fault.latency_us = value; break;
+      case 'W': mock_wifi_fault.fail_ppm = value; break;
+      case 'c': mock_http_connect_fault.latency_us = value; break;
+      case 'C': mock_http_connect_fault.fail_ppm = value; break;
+      case 'p': mock_http_request_fault.latency_us = value; break;
+      case 'P': mock_http_request_fault.fail_ppm = value; break;
+      case 'i': mock_http_idle_ms = value; break;
+      case 'B': mock_http_bad_ppm = value; break;
+      case 'R': mock_http_partial = false; break;
+      case 'S': config->seed = value; break;
+      case 'v': esp_log_level_set("*", ESP_LOG_INFO); break;
+      case 'h':
+        station_usage(argv[0]);
+        exit(0);
+      default:
+        station_usage(argv[0]);
+        exit(2);
+    }
+  }
+}
+
+
+int main(int argc, char **argv)
+{
+  station_config_t config = {
+    .seconds = 10,
+    .rate_hz = 1,
+    .sensors = 1,
+    .upload_ms = 5000,
+    .drop_s = UINT32_MAX,
+    .seed = 1
+  };
+  station_parse(argc, argv, &config);
+  mock_seed(config.seed);
+
+  // Faster sampling would overrun the queue and share timestamps.
+  if (config.rate_hz <= 0 || config.rate_hz > 1000.0 / BME_SAMPLING_PERIOD_MS) {
+    fprintf(stderr, "The firmware is built for up to %g Hz\n", 1000.0 / BME_SAMPLING_PERIOD_MS);
+    exit(2);
+  }
+
+  static const struct {
+    i2c_port_t port;
+    uint8_t addr;
+  } sensors[] = {
+    { I2C_PORT, BME280_I2C_ADDR_PRIM },
+    { I2C_PORT, BME280_I2C_ADDR_SEC },
+    { I2C_PORT_1, BME280_I2C_ADDR_PRIM },
+    { I2C_PORT_1, BME280_I2C_ADDR_SEC }
+  };
+  for (uint32_t i = 0; i < config.sensors; i++) {
+    mock_bme280_attach(sensors[i].port, sensors[i].addr);
+  }
+
+  // As app_main does.
+  boot_init();
+
+  TaskHandle_t wifi_task_handle = NULL;
+  TaskHandle_t http_task_handle = NULL;
+  xTaskCreate((TaskFunction_t)wifi_task, WIFI_TASK_NAME, WIFI_TASK_STACK_SIZE, NULL, WIFI_TASK_PRIORITY, &wifi_task_handle);
+  perf_watch(wifi_task_handle);
+  xTaskCreate((TaskFunction_t)http_task, HTTP_TASK_NAME, HTTP_TASK_STACK_SIZE, NULL, HTTP_TASK_PRIORITY, &http_task_handle);
+  perf_watch(http_task_handle);
+
+  nvs_flash_init();
+  boot_ready(BOOT_STAGE_NVS);
+
+  i2c_setup();
+  uint32_t found = bme_init();
+  boot_ready(BOOT_STAGE_SENSOR);
+  ESP_LOGI(STATION_TAG, "Found %u sensors", found);
+
+  // Samples on a fixed grid, so that a slow round does not shift the ones after it.
+  uint64_t period_us = 1000000 / config.rate_hz;
+  uint64_t rounds = config.seconds * config.rate_hz;
+  int64_t start_us = esp_timer_get_time();
+  int64_t kick_us = start_us + config.upload_ms * 1000LL;
+  bool dropped = false;
+
+  for (uint64_t round = 0; round < rounds; round++) {
+    int64_t due_us = start_us + round * period_us;
+    int64_t now_us = esp_timer_get_time();
+    if (due_us > now_us) {
+      mock_sleep_us(due_us - now_us);
+    }
+
+    bme_sample();
+
+    if (esp_timer_get_time() >= kick_us) {
+      http_kick();
+      kick_us += config.upload_ms * 1000LL;
+    }
+
+    if (!dropped && esp_timer_get_time() - start_us >= config.drop_s * 1000000LL) {
+      dropped = true;
+      mock_wifi_drop();
+    }
+  }
+
+  esp_err_t flush_err = http_flush(30000);
+  int64_t elapsed_us = esp_timer_get_time() - start_us;
+  uint64_t cpu_us = mock_task_cpu_us(http_task_handle);
+  // The datagrams are not acknowledged, so the listener may still be taking them in.
+  mock_udp_settle();
+
+  mock_http_stats_t server;
+  mock_http_get_stats(&server);
+  http_stats_t client;
+  http_get_stats(&client);
+  i2c_stats_t i2c;
+  i2c_get_stats(&i2c);
+  uint32_t points = mock_http_points(HTTP_MEASUREMENT);
+  uint32_t backlog = store_count();
+
+  printf("seconds=%.2f\n", elapsed_us / 1e6);
+  printf("rate_hz=%g\n", config.rate_hz);
+  printf("sensors=%u\n", found);
+  printf("rounds=%llu\n", (unsigned long long)rounds);
+  printf("measurements=%u\n", mock_bme280_measurements());
+  printf("i2c_transactions=%u\n", i2c.transactions);
+  printf("i2c_errors=%u\n", i2c.errors);
+  printf("i2c_max_us=%u\n", i2c.max_latency_us);
+  printf("backlog=%u\n", backlog);
+  printf("flush=%s\n", flush_err == ESP_OK ? "ok" : flush_err == ESP_FAIL ? "stored" : "timeout");
+  printf("requests=%u\n", client.requests);
+  printf("handshakes=%u\n", client.handshakes);
+  printf("resumptions=%u\n", client.resumptions);
+  printf("reuses=%u\n", client.reuses);
+  printf("failures=%u\n", client.failures);
+  printf("queue_max=%u\n", client.queue_max);
+  printf("queue_length=%u\n", HTTP_QUEUE_LENGTH);
+  printf("server_requests=%u\n", server.requests);
+  printf("requests_per_s=%.2f\n", server.requests / (elapsed_us / 1e6));
+  printf("server_connects=%u\n", server.connects);
+  printf("server_resumptions=%u\n", server.resumptions);
+  printf("server_lines=%u\n", server.lines);
+  printf("server_points=%u\n", points);
+  printf("points_per_s=%.2f\n", points / (elapsed_us / 1e6));
+  printf("server_duplicates=%u\n", server.duplicates);
+  printf("server_overwrites=%u\n", server.overwrites);
+  printf("server_bad_lines=%u\n", server.bad_lines);
+  printf("server_max_line_len=%u\n", server.max_line_len);
+  printf("server_bytes=%llu\n", (unsigned long long)server.bytes);
+  printf("server_raw_bytes=%llu\n", (unsigned long long)server.raw_bytes);
+  printf("server_wire_bytes=%llu\n", (unsigned long long)server.wire_bytes);
+  // What the transport costs the station: the time of the task that sends, and its stack and the heap of TLS.
+  printf("http_cpu_us=%llu\n", (unsigned long long)cpu_us);
+  printf("cpu_us_per_point=%.1f\n", points > 0 ? (double)cpu_us / points : 0.0);
+  printf("http_stack_size=%u\n", HTTP_TASK_STACK_SIZE);
+  printf("tls_peak_heap=%llu\n", (unsigned long long)server.peak_heap);
+  for (uint32_t counter = 0; counter < STATS_COUNTER_MAX; counter++) {
+    printf("%s=%u\n", stats_name(counter), stats_get(counter));
+  }
+
+  static const char *stages[] = { "acquire", "queue", "batch", "connect", "resume", "post", "ingest", "serve", "wifi" };
+  for (uint32_t stage = 0; stage < PERF_STAGE_MAX; stage++) {
+    printf("%s_p50_us=%u\n", stages[stage], perf_percentile(stage, 50));
+    printf("%s_p99_us=%u\n", stages[stage], perf_percentile(stage, 99));
+  }
+
+  for (uint32_t stage = 0; stage < BOOT_STAGE_MAX; stage++) {
+    printf("boot_stage%u_ms=%u\n", stage, boot_stage_ms(stage));
+  }
+
+  // Every sample that was measured has to have been written once, refused for good or still be in the store, and
+  // none may have overwritten another. Of the refused lines, exactly the bad ones have to have been dropped. The
+  // health of the station only goes along in the longer runs, which refuse no lines.
+  uint32_t rejected = stats_get(STATS_POINTS_REJECTED);
+  bool ok = found == config.sensors && points > 0 && flush_err == ESP_OK && server.overwrites == 0 &&
+            points + rejected + backlog == mock_bme280_measurements();
+  if (mock_http_bad_ppm == 0) {
+    ok = ok && server.bad_lines == 0;
+  } else {
+    ok = ok && rejected > 0 && rejected <= server.bad_lines && server.lines + rejected == client.points;
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+#!/bin/sh
+#
+# Runs the host benchmarks once per command line and prints the chosen keys of their summaries side by side, one run
+# per row. Run from the build directory of the tests, e.g.:
+#
+#   ../../test/sweep.sh "requests handshakes post_p50_us" "./station --seconds 20" "./station_close --seconds 20"
+#
+# The tables of test/results were made this way, see the command lines at their top.
+
+if [ $# -lt 2 ]; then
+  echo "usage: $0 \"key ...\" \"command\" ..." >&2
+  exit 2
+fi
+
+keys=$1
+shift
+
+width=3
+for run in "$@"; do
+  [ ${#run} -gt $width ] && width=${#run}
+done
+
+printf '%-*s' $width "run"
+for key in $keys; do
+  printf ' %10s' "$key"
+done
+printf '\n'
+
+status=0
+for run in "$@"; do
+  summary=$($run 2>/dev/null) || status=1
+  printf '%-*s' $width "$run"
+  for key in $keys; do
+    value=$(printf '%s\n' "$summary" | awk -F= -v key="$key" '$1 == key { print $2; exit }')
+    column=$(( ${#key} > 10 ? ${#key} : 10 ))
+    printf ' %*s' $column "${value:--}"
+  done
+  printf '\n'
+done
+
+exit $status
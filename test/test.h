@@ -0,0 +1,57 @@
+/**
+ * @file    test.h
+ *
+ * @brief   Test Header File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#ifndef _TEST_H_
+#define _TEST_H_
+
+
+#include <stdio.h>
+#include <string.h>
+
+
+// Checks a condition, reports it if it does not hold and goes on with the test.
+#define TEST_ASSERT(cond)             do {                                            \
+  test_checks++;                                                                      \
+  if (!(cond)) {                                                                      \
+    test_failures++;                                                                  \
+    fprintf(stderr, "%s:%d: %s: assertion failed: %s\n", __FILE__, __LINE__, __func__, #cond); \
+  }                                                                                   \
+} while (0)
+
+#define TEST_ASSERT_EQ(a, b)          do {                                            \
+  long long a_ = (long long)(a);                                                      \
+  long long b_ = (long long)(b);                                                      \
+  test_checks++;                                                                      \
+  if (a_ != b_) {                                                                     \
+    test_failures++;                                                                  \
+    fprintf(stderr, "%s:%d: %s: %s == %lld, expected %lld\n", __FILE__, __LINE__, __func__, #a, a_, b_); \
+  }                                                                                   \
+} while (0)
+
+#define TEST_ASSERT_STR(a, b)         do {                                            \
+  const char *a_ = (a);                                                               \
+  const char *b_ = (b);                                                               \
+  test_checks++;                                                                      \
+  if (strcmp(a_, b_) != 0) {                                                          \
+    test_failures++;                                                                  \
+    fprintf(stderr, "%s:%d: %s: %s == \"%s\", expected \"%s\"\n", __FILE__, __LINE__, __func__, #a, a_, b_); \
+  }                                                                                   \
+} while (0)
+
+// Prints the summary and gives the exit code of the test program.
+#define TEST_END()                    (printf("%u checks, %u failures\n", test_checks, test_failures), \
+                                       test_failures > 0)
+
+static unsigned int test_checks;
+static unsigned int test_failures;
+
+
+#endif /* _TEST_H_ */
@@ -0,0 +1,182 @@
+/**
+ * @file    test_agg.c
+ *
+ * @brief   Aggregation Test Source File
+ *
+ * @remarks The running sums are checked against a naive recompute in double precision over every sample of the window,
+ *          which is what keeping the raw samples would cost instead. Both the error and the time per sample of each
+ *          are printed.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "test.h"
+
+#include "agg.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+#define TEST_AGG_WINDOWS              (200)
+
+typedef struct {
+  const char *name;
+  int32_t base;
+  int32_t swing;
+  int32_t noise;
+} test_agg_quantity_t;
+
+// Within the ranges of the BME280, in the units of the samples.
+static const test_agg_quantity_t test_agg_quantities[] = {
+  { "temperature", 2150, 300, 20 },
+  { "pressure", 101325, 400, 30 },
+  { "humidity", 45000, 8000, 500 }
+};
+
+static int32_t test_values[3][AGG_MAX_SAMPLES];
+
+
+static double test_agg_now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static int32_t test_agg_value(const test_agg_quantity_t *quantity, uint32_t i, uint32_t count)
+{
+  double drift = quantity->swing * sin(6.283 * i / count);
+
+  return quantity->base + (int32_t)drift + rand() % (2 * quantity->noise + 1) - quantity->noise;
+}
+
+
+static const agg_field_t *test_agg_field(const agg_t *agg, uint32_t quantity)
+{
+  return quantity == 0 ? &agg->temperature : quantity == 1 ? &agg->pressure : &agg->humidity;
+}
+
+
+/**
+ * @brief           Takes windows of every size up to AGG_MAX_SAMPLES. The mean has to be the rounded exact mean, and the
+ *                  standard deviation within one tenth of a unit.
+ */
+static void test_agg_accuracy()
+{
+  double agg_s = 0;
+  double naive_s = 0;
+  uint64_t samples = 0;
+  double max_mean_error = 0;
+  double max_stddev_error = 0;
+
+  srand(1);
+  for (uint32_t w = 0; w < TEST_AGG_WINDOWS; w++) {
+    uint32_t count = w == 0 ? AGG_MAX_SAMPLES : 1 + rand() % AGG_MAX_SAMPLES;
+    for (uint32_t q = 0; q < 3; q++) {
+      for (uint32_t i = 0; i < count; i++) {
+        test_values[q][i] = test_agg_value(&test_agg_quantities[q], i, count);
+      }
+    }
+
+    double start = test_agg_now();
+    agg_t agg;
+    agg_reset(&agg);
+    for (uint32_t i = 0; i < count; i++) {
+      sample_t sample = { .temperature = test_values[0][i], .pressure = test_values[1][i], .humidity = test_values[2][i] };
+      agg_add(&agg, &sample);
+    }
+    int32_t means[3];
+    uint32_t stddevs[3];
+    for (uint32_t q = 0; q < 3; q++) {
+      means[q] = agg_mean(test_agg_field(&agg, q), agg.count);
+      stddevs[q] = agg_stddev(test_agg_field(&agg, q), agg.count, 10);
+    }
+    agg_s += test_agg_now() - start;
+
+    // The raw samples kept and the two passes done at the end of the window.
+    start = test_agg_now();
+    double exact_means[3];
+    double exact_stddevs[3];
+    for (uint32_t q = 0; q < 3; q++) {
+      double sum = 0;
+      for (uint32_t i = 0; i < count; i++) {
+        sum += test_values[q][i];
+      }
+      exact_means[q] = sum / count;
+
+      double sum_sq = 0;
+      for (uint32_t i = 0; i < count; i++) {
+        sum_sq += (test_values[q][i] - exact_means[q]) * (test_values[q][i] - exact_means[q]);
+      }
+      exact_stddevs[q] = count > 1 ? sqrt(sum_sq / (count - 1)) : 0;
+    }
+    naive_s += test_agg_now() - start;
+    samples += count;
+
+    for (uint32_t q = 0; q < 3; q++) {
+      double mean_error = fabs(means[q] - exact_means[q]);
+      double stddev_error = fabs(stddevs[q] / 10.0 - exact_stddevs[q]);
+      TEST_ASSERT(mean_error <= 0.5 + 1e-9);
+      TEST_ASSERT(stddev_error <= 0.1);
+      if (mean_error > max_mean_error) {
+        max_mean_error = mean_error;
+      }
+      if (stddev_error > max_stddev_error) {
+        max_stddev_error = stddev_error;
+      }
+    }
+  }
+
+  printf("%llu samples in %u windows\n", (unsigned long long)samples, TEST_AGG_WINDOWS);
+  printf("running sums: %.1f ns/sample, %u bytes per sensor, max error mean %.3f stddev %.3f units\n",
+         1e9 * agg_s / samples, (unsigned)sizeof(agg_t), max_mean_error, max_stddev_error);
+  printf("naive recompute: %.1f ns/sample, %u bytes per sensor for a full window\n",
+         1e9 * naive_s / samples, (unsigned)(AGG_MAX_SAMPLES * sizeof(sample_t)));
+}
+
+
+/**
+ * @brief           The extremes of a window and its negative values.
+ */
+static void test_agg_edges()
+{
+  agg_t agg;
+  agg_reset(&agg);
+  TEST_ASSERT_EQ(agg_mean(&agg.temperature, 0), 0);
+  TEST_ASSERT_EQ(agg_stddev(&agg.temperature, 0, 10), 0);
+
+  static const int32_t values[] = { -1005, -995, -1000, -1000 };
+  for (uint32_t i = 0; i < 4; i++) {
+    sample_t sample = { .temperature = values[i], .pressure = 100000, .humidity = 0, .sensor = 2 };
+    agg_add(&agg, &sample);
+  }
+
+  TEST_ASSERT_EQ(agg.temperature.min, -1005);
+  TEST_ASSERT_EQ(agg.temperature.max, -995);
+  TEST_ASSERT_EQ(agg_mean(&agg.temperature, agg.count), -1000);
+  // sqrt(50 / 3) = 4.08
+  TEST_ASSERT_EQ(agg_stddev(&agg.temperature, agg.count, 100), 408);
+  TEST_ASSERT_EQ(agg_stddev(&agg.pressure, agg.count, 100), 0);
+
+  sample_t mean;
+  agg_sample(&agg, &mean);
+  TEST_ASSERT_EQ(mean.temperature, -1000);
+  TEST_ASSERT_EQ(mean.pressure, 100000);
+  TEST_ASSERT_EQ(mean.sensor, 2);
+}
+
+
+int main()
+{
+  test_agg_edges();
+  test_agg_accuracy();
+
+  return TEST_END();
+}
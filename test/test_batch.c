@@ -0,0 +1,226 @@
+/**
+ * @file    test_batch.c
+ *
+ * @brief   Batch Test Source File
+ *
+ * @remarks Also prints the bytes on the wire per point across batch sizes: the request and the response of a post, as
+ *          http.c makes them and InfluxDB 1.8 answers them, with the TLS record overhead of AES-GCM.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "test.h"
+
+#include "batch.h"
+#include "gzip.h"
+#include "http.h"
+#include "lp.h"
+
+
+// The header, the explicit nonce and the tag of a TLS 1.2 AES-GCM record. The request header, its body and the
+// response take one record each.
+#define TEST_BATCH_TLS_RECORD         (5 + 8 + 16)
+#define TEST_BATCH_TLS_RECORDS        (3)
+
+// As recorded from InfluxDB 1.8.
+static const char test_batch_response[] =
+  "HTTP/1.1 204 No Content\r\nContent-Type: application/json\r\nRequest-Id: 5b1c9a2e-0f5a-11ef-8001-0242ac110002\r\n"
+  "X-Influxdb-Build: OSS\r\nX-Influxdb-Version: 1.8.10\r\nDate: Fri, 16 Oct 2026 09:00:00 GMT\r\n\r\n";
+
+static batch_t test_batch;
+static uint8_t test_batch_gzip[BATCH_BUFFER_SIZE];
+
+
+static uint32_t test_batch_append(uint32_t value, uint32_t now_ms)
+{
+  uint32_t size = 0;
+  char *line = batch_line(&test_batch, &size);
+
+  lp_t lp;
+  lp_begin(&lp, line, size, "m");
+  lp_field_int(&lp, "v", value);
+  uint32_t len = lp_end(&lp);
+  if (len > 0) {
+    batch_commit(&test_batch, len, now_ms);
+  }
+
+  return len;
+}
+
+
+static void test_batch_lines()
+{
+  batch_reset(&test_batch);
+  TEST_ASSERT(!batch_is_due(&test_batch, 0));
+
+  test_batch_append(1, 1000);
+  test_batch_append(2, 2000);
+  test_batch_append(3, 3000);
+
+  TEST_ASSERT_EQ(test_batch.points, 3);
+  TEST_ASSERT_EQ(test_batch.first_ms, 1000);
+  TEST_ASSERT_EQ(test_batch.len, strlen("m v=1i\nm v=2i\nm v=3i"));
+  TEST_ASSERT(memcmp(test_batch.buffer, "m v=1i\nm v=2i\nm v=3i", test_batch.len) == 0);
+
+  batch_reset(&test_batch);
+  TEST_ASSERT_EQ(test_batch.points, 0);
+  TEST_ASSERT_EQ(test_batch.len, 0);
+}
+
+
+static void test_batch_due()
+{
+  batch_reset(&test_batch);
+
+  // By age.
+  test_batch_append(1, 5000);
+  TEST_ASSERT(!batch_is_due(&test_batch, 5000 + BATCH_MAX_AGE_MS - 1));
+  TEST_ASSERT(batch_is_due(&test_batch, 5000 + BATCH_MAX_AGE_MS));
+
+  // Across the wrap of the millisecond counter.
+  batch_reset(&test_batch);
+  test_batch_append(1, UINT32_MAX - 10);
+  TEST_ASSERT(!batch_is_due(&test_batch, 10));
+  TEST_ASSERT(batch_is_due(&test_batch, BATCH_MAX_AGE_MS));
+
+  // By count.
+  batch_reset(&test_batch);
+  for (uint32_t i = 0; i < BATCH_MAX_POINTS; i++) {
+    TEST_ASSERT(!batch_is_due(&test_batch, 0));
+    test_batch_append(i, 0);
+  }
+  TEST_ASSERT(batch_is_due(&test_batch, 0));
+}
+
+
+/**
+ * @brief           A batch that keeps taking points fills up without overrunning its buffer, and is full as long as
+ *                  a line of the maximum size may not fit.
+ */
+static void test_batch_full()
+{
+  batch_reset(&test_batch);
+
+  uint32_t appended = 0;
+  while (!batch_is_full(&test_batch)) {
+    TEST_ASSERT(test_batch_append(1000000 + appended, 0) > 0);
+    appended++;
+  }
+
+  TEST_ASSERT(test_batch.len <= BATCH_BUFFER_SIZE);
+  TEST_ASSERT(BATCH_BUFFER_SIZE - test_batch.len <= BATCH_MAX_LINE_SIZE);
+  TEST_ASSERT(batch_is_due(&test_batch, 0));
+  TEST_ASSERT_EQ(test_batch.points, appended);
+}
+
+
+/**
+ * @brief           The room of a point is capped at BATCH_MAX_LINE_SIZE, and a batch fits as many of them as it has room
+ *                  for with their separators.
+ */
+static void test_batch_room()
+{
+  uint32_t size = 0;
+
+  batch_reset(&test_batch);
+  batch_line(&test_batch, &size);
+  TEST_ASSERT_EQ(size, BATCH_MAX_LINE_SIZE);
+  TEST_ASSERT(batch_fits(&test_batch, BATCH_BUFFER_SIZE / (BATCH_MAX_LINE_SIZE + 1)));
+  TEST_ASSERT(!batch_fits(&test_batch, BATCH_BUFFER_SIZE / (BATCH_MAX_LINE_SIZE + 1) + 1));
+
+  // Right at the edge, a point of the maximum size still fits after its separator.
+  test_batch.points = 1;
+  test_batch.len = BATCH_BUFFER_SIZE - BATCH_MAX_LINE_SIZE - 1;
+  TEST_ASSERT(!batch_is_full(&test_batch));
+  batch_line(&test_batch, &size);
+  TEST_ASSERT_EQ(size, BATCH_MAX_LINE_SIZE);
+
+  test_batch.len++;
+  TEST_ASSERT(batch_is_full(&test_batch));
+  batch_line(&test_batch, &size);
+  TEST_ASSERT_EQ(size, BATCH_MAX_LINE_SIZE - 1);
+}
+
+
+/**
+ * @brief           Fills the batch with points of four sensors, as http_encode makes them, sampled every 10 s.
+ */
+static void test_batch_points(uint32_t points)
+{
+  static const char *locations[] = { "home", "i2c0-77", "i2c1-76", "i2c1-77" };
+
+  batch_reset(&test_batch);
+  for (uint32_t i = 0; i < points; i++) {
+    uint32_t size = 0;
+    char *line = batch_line(&test_batch, &size);
+
+    lp_t lp;
+    lp_begin(&lp, line, size, HTTP_MEASUREMENT);
+    lp_tag(&lp, "location", locations[i % 4]);
+    lp_field_fixed(&lp, "temperature", 2150 + (int32_t)(i * 7 % 50), 2);
+    lp_field_fixed(&lp, "pressure", 10132500 + i * 13, 2);
+    lp_field_fixed(&lp, "humidity", 45000 + i * 31 % 900, 3);
+    lp_timestamp(&lp, 1791288000 + i / 4 * 10);
+    batch_commit(&test_batch, lp_end(&lp), 0);
+  }
+}
+
+
+/**
+ * @brief           Prints the bytes a post of each batch size costs per point. They have to fall with the size, as the
+ *                  headers are shared by more points and the body compresses better.
+ */
+static void test_batch_wire()
+{
+  static const uint32_t sizes[] = { 1, 2, 4, 8, BATCH_MAX_POINTS, 16, 24, 32 };
+  char header[HTTP_HEADER_SIZE];
+  uint32_t last_per_point = UINT32_MAX;
+
+  printf("points  raw body  sent body  header  response  tls  bytes/point\n");
+  for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    test_batch_points(sizes[i]);
+    TEST_ASSERT_EQ(test_batch.points, sizes[i]);
+
+    uint32_t body_len = test_batch.len;
+    const char *encoding = "";
+    if (HTTP_GZIP && test_batch.len >= HTTP_GZIP_MIN_SIZE) {
+      uint32_t gzip_len = gzip_compress((const uint8_t *)test_batch.buffer, test_batch.len, test_batch_gzip,
+                                        test_batch.len < sizeof(test_batch_gzip) ? test_batch.len : sizeof(test_batch_gzip));
+      if (gzip_len > 0) {
+        body_len = gzip_len;
+        encoding = "Content-Encoding: gzip\r\n";
+      }
+    }
+
+    uint32_t header_len = snprintf(header, sizeof(header),
+                                   "POST " HTTP_WRITE_PATH "&precision=" HTTP_PRECISION " HTTP/1.1\r\n"
+                                   "Host: " HTTP_HOST "\r\n"
+                                   "Content-Type: text/plain\r\n"
+                                   "%s"
+                                   "Content-Length: %u\r\n"
+                                   "\r\n", encoding, body_len);
+    uint32_t response_len = sizeof(test_batch_response) - 1;
+    uint32_t tls_len = TEST_BATCH_TLS_RECORDS * TEST_BATCH_TLS_RECORD;
+    uint32_t per_point = (header_len + body_len + response_len + tls_len + sizes[i] / 2) / sizes[i];
+    printf("%6u  %8u  %9u  %6u  %8u  %3u  %11u\n", sizes[i], test_batch.len, body_len, header_len, response_len,
+           tls_len, per_point);
+
+    TEST_ASSERT(per_point < last_per_point);
+    last_per_point = per_point;
+  }
+}
+
+
+int main()
+{
+  test_batch_lines();
+  test_batch_due();
+  test_batch_full();
+  test_batch_room();
+  test_batch_wire();
+
+  return TEST_END();
+}
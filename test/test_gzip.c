@@ -0,0 +1,214 @@
+/**
+ * @file    test_gzip.c
+ *
+ * @brief   GZIP Test Source File
+ *
+ * @remarks Every compressed body is inflated again with zlib, as the server does. The time to compress a batch and the
+ *          bytes it saves are printed for every batch size, which is what HTTP_GZIP_MIN_SIZE is chosen from.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "test.h"
+
+#include "batch.h"
+#include "gzip.h"
+#include "http.h"
+#include "lp.h"
+
+#include <stdlib.h>
+#include <time.h>
+#include <zlib.h>
+
+
+#define TEST_GZIP_ROUNDS              (2000)
+// The header that announces a compressed body.
+#define TEST_GZIP_HEADER_SIZE         (sizeof("Content-Encoding: gzip\r\n") - 1)
+
+
+static uint8_t test_in[16384];
+static uint8_t test_out[20000];
+static uint8_t test_check[16384];
+
+
+/**
+ * @brief           Compresses and inflates a buffer back, and checks that it comes back the same.
+ *
+ * @return          The compressed length.
+ */
+static uint32_t test_gzip_round_trip(const uint8_t *in, uint32_t in_len)
+{
+  uint32_t out_len = gzip_compress(in, in_len, test_out, sizeof(test_out));
+  TEST_ASSERT(out_len > 0);
+
+  z_stream stream = { 0 };
+  inflateInit2(&stream, 16 + MAX_WBITS);
+  stream.next_in = test_out;
+  stream.avail_in = out_len;
+  stream.next_out = test_check;
+  stream.avail_out = sizeof(test_check);
+  int z_err = inflate(&stream, Z_FINISH);
+  uint32_t check_len = stream.total_out;
+  inflateEnd(&stream);
+
+  TEST_ASSERT_EQ(z_err, Z_STREAM_END);
+  TEST_ASSERT_EQ(check_len, in_len);
+  TEST_ASSERT(memcmp(test_check, in, in_len) == 0);
+  // The trailer crc and size are checked by zlib, so all of the body was consumed.
+  TEST_ASSERT_EQ(stream.avail_in, 0);
+
+  return out_len;
+}
+
+
+/**
+ * @brief           Fills the input with a batch of points, as http.c posts them.
+ */
+static uint32_t test_gzip_batch(uint32_t points)
+{
+  uint32_t len = 0;
+
+  for (uint32_t i = 0; i < points; i++) {
+    lp_t lp;
+    lp_begin(&lp, (char *)&test_in[len], sizeof(test_in) - len - 1, "weather");
+    lp_tag(&lp, "location", i % 2 ? "home" : "garden");
+    lp_field_fixed(&lp, "temperature", 2150 + (int32_t)(i * 7 % 50), 2);
+    lp_field_fixed(&lp, "pressure", 10132500 + i * 13, 2);
+    lp_field_fixed(&lp, "humidity", 45000 + i * 31 % 900, 3);
+    lp_timestamp(&lp, 1791288000 + i * 10);
+    len += lp_end(&lp);
+    test_in[len++] = '\n';
+  }
+
+  return len - 1;
+}
+
+
+static void test_gzip_edges()
+{
+  test_gzip_round_trip((const uint8_t *)"", 0);
+  test_gzip_round_trip((const uint8_t *)"a", 1);
+  test_gzip_round_trip((const uint8_t *)"abcabcabcabcabcabcabc", 21);
+
+  // A run longer than the longest match, which has to be split.
+  memset(test_in, 'x', 1000);
+  test_gzip_round_trip(test_in, 1000);
+
+  // Matches that reach back to the edge of the window.
+  for (uint32_t i = 0; i < sizeof(test_in); i++) {
+    test_in[i] = i % (GZIP_WINDOW_SIZE - 1) < 16 ? 'a' + i % 16 : (uint8_t)(i * 2654435761u >> 24);
+  }
+  test_gzip_round_trip(test_in, sizeof(test_in));
+}
+
+
+static void test_gzip_random()
+{
+  srand(1);
+  for (uint32_t i = 0; i < sizeof(test_in); i++) {
+    test_in[i] = rand();
+  }
+
+  // Incompressible data grows, but must still decode.
+  uint32_t out_len = test_gzip_round_trip(test_in, 4096);
+  TEST_ASSERT(out_len > 4096);
+
+  // Random text over a small alphabet.
+  for (uint32_t i = 0; i < sizeof(test_in); i++) {
+    test_in[i] = "abc ,=\n"[rand() % 7];
+  }
+  test_gzip_round_trip(test_in, sizeof(test_in));
+}
+
+
+static void test_gzip_batches()
+{
+  uint32_t len = test_gzip_batch(BATCH_MAX_POINTS);
+  uint32_t out_len = test_gzip_round_trip(test_in, len);
+  printf("%u points: %u -> %u bytes (%u%%)\n", BATCH_MAX_POINTS, len, out_len, 100 * out_len / len);
+
+  // The repeated keys have to give at least half of it back.
+  TEST_ASSERT(out_len < len / 2);
+
+  len = test_gzip_batch(100);
+  out_len = test_gzip_round_trip(test_in, len);
+  printf("100 points: %u -> %u bytes (%u%%)\n", len, out_len, 100 * out_len / len);
+}
+
+
+static double test_gzip_now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/**
+ * @brief           Times the compression of batches of every size up to a full buffer, and prints what each saves on
+ *                  the wire once the header that announces it is paid for. Exactly the bodies from HTTP_GZIP_MIN_SIZE
+ *                  up have to save at least a quarter of their size.
+ */
+static void test_gzip_sizes()
+{
+  printf("points   raw  gzip  saved      us  ns/byte  ns/saved byte\n");
+  for (uint32_t points = 1; points <= 40; points = points < 4 ? points + 1 : points < 16 ? points + 2 : points + 8) {
+    uint32_t len = test_gzip_batch(points);
+    if (len > BATCH_BUFFER_SIZE) {
+      break;
+    }
+
+    uint32_t out_len = 0;
+    double start = test_gzip_now();
+    for (uint32_t i = 0; i < TEST_GZIP_ROUNDS; i++) {
+      out_len = gzip_compress(test_in, len, test_out, sizeof(test_out));
+    }
+    double ns = 1e9 * (test_gzip_now() - start) / TEST_GZIP_ROUNDS;
+
+    int32_t saved = (int32_t)len - (int32_t)out_len - (int32_t)TEST_GZIP_HEADER_SIZE;
+    char per_saved[16] = "-";
+    if (saved > 0) {
+      snprintf(per_saved, sizeof(per_saved), "%.1f", ns / saved);
+    }
+    printf("%6u  %4u  %4u  %5d  %6.1f  %7.2f  %13s\n", points, len, out_len, saved, ns / 1000, ns / len, per_saved);
+
+    // The time per byte is about the same at every size, so a quarter saved keeps the time per saved byte within
+    // four times of it.
+    if (len >= HTTP_GZIP_MIN_SIZE) {
+      TEST_ASSERT(saved >= (int32_t)len / 4);
+    } else {
+      TEST_ASSERT(saved < (int32_t)len / 4);
+    }
+  }
+}
+
+
+/**
+ * @brief           A body that does not fit into the buffer is reported as 0 at every size short of its length.
+ */
+static void test_gzip_overflow()
+{
+  uint32_t len = test_gzip_batch(BATCH_MAX_POINTS);
+  uint32_t out_len = gzip_compress(test_in, len, test_out, sizeof(test_out));
+
+  for (uint32_t size = 0; size < out_len; size++) {
+    TEST_ASSERT_EQ(gzip_compress(test_in, len, test_out, size), 0);
+  }
+  TEST_ASSERT_EQ(gzip_compress(test_in, len, test_out, out_len), out_len);
+}
+
+
+int main()
+{
+  test_gzip_edges();
+  test_gzip_random();
+  test_gzip_batches();
+  test_gzip_sizes();
+  test_gzip_overflow();
+
+  return TEST_END();
+}
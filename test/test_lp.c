@@ -0,0 +1,248 @@
+/**
+ * @file    test_lp.c
+ *
+ * @brief   Line Protocol Test Source File
+ *
+ * @remarks The points are checked to be byte-identical to the ones of the sprintf encoder lp.c replaced, over the edge
+ *          values and over random samples, and the time per point of each is printed.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "test.h"
+
+#include "lp.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+
+#define TEST_LP_RANDOM                (1000000)
+#define TEST_LP_BENCH                 (1000000)
+
+static char test_buf[256];
+static char test_ref[256];
+
+// The values around the edges of the fixed-point formatting.
+static const int32_t test_lp_edges[] = {
+  0, 1, -1, 9, -9, 10, -10, 99, -99, 100, -100, 101, -101, 999, -999, 1000, -1000, 1001, -1001, 12345, -12345,
+  2150, -4000, 8500, 30000, 110000, 10132500, 100000, 999999, 1000000, INT32_MAX, INT32_MIN, INT32_MAX - 1,
+  INT32_MIN + 1
+};
+
+
+static const char *test_lp_line(lp_t *lp)
+{
+  uint32_t len = lp_end(lp);
+  test_buf[len] = '\0';
+
+  return test_buf;
+}
+
+
+static void test_lp_point()
+{
+  lp_t lp;
+
+  lp_begin(&lp, test_buf, sizeof(test_buf) - 1, "weather");
+  lp_tag(&lp, "location", "home");
+  lp_field_fixed(&lp, "temperature", 2150, 2);
+  lp_field_fixed(&lp, "pressure", 10132500, 2);
+  lp_field_fixed(&lp, "humidity", 45123, 3);
+  lp_timestamp(&lp, 1791288000);
+  TEST_ASSERT_STR(test_lp_line(&lp), "weather,location=home temperature=21.50,pressure=101325.00,humidity=45.123 1791288000");
+}
+
+
+static void test_lp_fixed()
+{
+  lp_t lp;
+
+  lp_begin(&lp, test_buf, sizeof(test_buf) - 1, "m");
+  lp_field_fixed(&lp, "a", -5, 2);
+  lp_field_fixed(&lp, "b", -1234, 2);
+  lp_field_fixed(&lp, "c", 7, 3);
+  lp_field_fixed(&lp, "d", 42, 0);
+  lp_field_fixed(&lp, "e", INT32_MIN, 2);
+  TEST_ASSERT_STR(test_lp_line(&lp), "m a=-0.05,b=-12.34,c=0.007,d=42,e=-21474836.48");
+
+  lp_begin(&lp, test_buf, sizeof(test_buf) - 1, "m");
+  lp_field_int(&lp, "a", 0);
+  lp_field_int(&lp, "b", -17);
+  lp_field_int(&lp, "c", INT32_MIN);
+  TEST_ASSERT_STR(test_lp_line(&lp), "m a=0i,b=-17i,c=-2147483648i");
+}
+
+
+static void test_lp_escape()
+{
+  lp_t lp;
+
+  lp_begin(&lp, test_buf, sizeof(test_buf) - 1, "my weather,x");
+  lp_tag(&lp, "the place", "living room,=1");
+  lp_field_int(&lp, "a=b", 1);
+  TEST_ASSERT_STR(test_lp_line(&lp), "my\\ weather\\,x,the\\ place=living\\ room\\,\\=1 a\\=b=1i");
+}
+
+
+/**
+ * @brief           A point that does not fit is reported as empty at every size short of its length.
+ */
+static void test_lp_overflow()
+{
+  static const char expected[] = "weather,location=home temperature=21.50 1791288000";
+  lp_t lp;
+
+  for (uint32_t size = 0; size <= sizeof(expected); size++) {
+    lp_begin(&lp, test_buf, size, "weather");
+    lp_tag(&lp, "location", "home");
+    lp_field_fixed(&lp, "temperature", 2150, 2);
+    lp_timestamp(&lp, 1791288000);
+
+    uint32_t len = lp_end(&lp);
+    if (size < sizeof(expected) - 1) {
+      TEST_ASSERT_EQ(len, 0);
+    } else {
+      TEST_ASSERT_EQ(len, sizeof(expected) - 1);
+    }
+  }
+}
+
+
+static double test_lp_now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/**
+ * @brief           Encodes a sample as http_encode does, without its timestamp.
+ */
+static uint32_t test_lp_sample(char *line, uint32_t size, int32_t temperature, uint32_t pressure, uint32_t humidity)
+{
+  lp_t lp;
+  lp_begin(&lp, line, size, "sensor");
+  lp_tag(&lp, "location", "home");
+  lp_field_fixed(&lp, "temperature", temperature, 2);
+  lp_field_fixed(&lp, "pressure", pressure, 2);
+  lp_field_fixed(&lp, "humidity", humidity, 3);
+
+  return lp_end(&lp);
+}
+
+
+/**
+ * @brief           Encodes a sample as the sprintf encoder did, with the humidity in the three decimals it is sent with
+ *                  since.
+ */
+static uint32_t test_lp_sample_sprintf(char *line, uint32_t size, int32_t temperature, uint32_t pressure,
+                                       uint32_t humidity)
+{
+  return snprintf(line, size, "sensor,location=home temperature=%0.2lf,pressure=%0.2lf,humidity=%0.3lf",
+                  0.01 * temperature, 0.01 * pressure, 0.001 * humidity);
+}
+
+
+/**
+ * @brief           Every edge value in every number of decimals, and random samples over the whole range of the fields,
+ *                  come out as sprintf makes them.
+ */
+static void test_lp_sprintf()
+{
+  static const double scales[] = { 1, 0.1, 0.01, 0.001 };
+  lp_t lp;
+
+  for (uint32_t i = 0; i < sizeof(test_lp_edges) / sizeof(test_lp_edges[0]); i++) {
+    int32_t value = test_lp_edges[i];
+    for (uint32_t decimals = 0; decimals < 4; decimals++) {
+      lp_begin(&lp, test_buf, sizeof(test_buf) - 1, "m");
+      lp_field_fixed(&lp, "v", value, decimals);
+      snprintf(test_ref, sizeof(test_ref), "m v=%0.*lf", (int)decimals, scales[decimals] * value);
+      TEST_ASSERT_STR(test_lp_line(&lp), test_ref);
+    }
+
+    lp_begin(&lp, test_buf, sizeof(test_buf) - 1, "m");
+    lp_field_int(&lp, "v", value);
+    snprintf(test_ref, sizeof(test_ref), "m v=%di", value);
+    TEST_ASSERT_STR(test_lp_line(&lp), test_ref);
+
+    lp_begin(&lp, test_buf, sizeof(test_buf) - 1, "m");
+    lp_field_int(&lp, "v", 1);
+    lp_timestamp(&lp, (uint64_t)(uint32_t)value * 1000000000ULL);
+    snprintf(test_ref, sizeof(test_ref), "m v=1i %llu", (unsigned long long)(uint32_t)value * 1000000000ULL);
+    TEST_ASSERT_STR(test_lp_line(&lp), test_ref);
+  }
+
+  // The timestamps across the 9-digit parts, up to the largest.
+  static const uint64_t timestamps[] = {
+    0, 999999999, 1000000000, 1000000001, 999999999999999999ULL, 1000000000000000000ULL, 1792141200000000000ULL,
+    UINT64_MAX
+  };
+  for (uint32_t i = 0; i < sizeof(timestamps) / sizeof(timestamps[0]); i++) {
+    lp_begin(&lp, test_buf, sizeof(test_buf) - 1, "m");
+    lp_field_int(&lp, "v", 1);
+    lp_timestamp(&lp, timestamps[i]);
+    snprintf(test_ref, sizeof(test_ref), "m v=1i %llu", (unsigned long long)timestamps[i]);
+    TEST_ASSERT_STR(test_lp_line(&lp), test_ref);
+  }
+
+  uint32_t mismatches = 0;
+  srand(1);
+  for (uint32_t i = 0; i < TEST_LP_RANDOM; i++) {
+    int32_t temperature = (int32_t)((uint32_t)rand() << 16 ^ (uint32_t)rand());
+    uint32_t pressure = (uint32_t)rand() % 2000000;
+    uint32_t humidity = (uint32_t)rand() % 100001;
+    uint32_t len = test_lp_sample(test_buf, sizeof(test_buf), temperature, pressure, humidity);
+    uint32_t ref_len = test_lp_sample_sprintf(test_ref, sizeof(test_ref), temperature, pressure, humidity);
+    if (len != ref_len || memcmp(test_buf, test_ref, len) != 0) {
+      if (mismatches++ == 0) {
+        fprintf(stderr, "  %.*s\n  %s\n", (int)len, test_buf, test_ref);
+      }
+    }
+  }
+  TEST_ASSERT_EQ(mismatches, 0);
+}
+
+
+/**
+ * @brief           Times the encoding of a sample with lp.c and with sprintf.
+ */
+static void test_lp_bench()
+{
+  uint32_t total = 0;
+
+  double start = test_lp_now();
+  for (uint32_t i = 0; i < TEST_LP_BENCH; i++) {
+    total += test_lp_sample(test_buf, sizeof(test_buf), 2150 + (int32_t)(i % 1000), 101325 + i % 500, 45000 + i % 900);
+  }
+  double lp_s = test_lp_now() - start;
+
+  start = test_lp_now();
+  for (uint32_t i = 0; i < TEST_LP_BENCH; i++) {
+    total += test_lp_sample_sprintf(test_buf, sizeof(test_buf), 2150 + (int32_t)(i % 1000), 101325 + i % 500,
+                                    45000 + i % 900);
+  }
+  double sprintf_s = test_lp_now() - start;
+
+  printf("lp: %.1f ns/point, sprintf: %.1f ns/point (%u bytes)\n", 1e9 * lp_s / TEST_LP_BENCH,
+         1e9 * sprintf_s / TEST_LP_BENCH, total);
+}
+
+
+int main()
+{
+  test_lp_point();
+  test_lp_fixed();
+  test_lp_escape();
+  test_lp_overflow();
+  test_lp_sprintf();
+  test_lp_bench();
+
+  return TEST_END();
+}
@@ -0,0 +1,251 @@
+/**
+ * @file    test_resp.c
+ *
+ * @brief   Response Test Source File
+ *
+ * @remarks The bodies are as recorded from InfluxDB 1.8 and 2.7. Each one is fed whole, split in two at every byte and
+ *          one byte at a time, and has to parse the same every way. So are the whole responses, in every framing of
+ *          the body.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "test.h"
+
+#include "resp.h"
+
+
+typedef struct {
+  const char *body;
+  bool partial;
+  uint32_t dropped;
+  const char *message;
+} test_resp_case_t;
+
+static const test_resp_case_t test_resp_cases[] = {
+  {
+    "{\"error\":\"partial write: unable to parse 'weather,location=home temperature=': missing field value dropped=1\"}\n",
+    true, 1, "partial write: unable to parse 'weather,location=home temperature=': missing field value dropped=1"
+  },
+  {
+    "{\"error\":\"partial write: points beyond retention policy dropped=12\"}\n",
+    true, 12, "partial write: points beyond retention policy dropped=12"
+  },
+  {
+    "{\"error\":\"unable to parse 'weather,location=home temperature=21.50 abc': bad timestamp\"}\n",
+    false, 0, "unable to parse 'weather,location=home temperature=21.50 abc': bad timestamp"
+  },
+  {
+    "{\"code\":\"invalid\",\"message\":\"partial write error (2 written): unable to parse 'weather t=': missing field value\"}",
+    true, 0, "partial write error (2 written): unable to parse 'weather t=': missing field value"
+  },
+  {
+    "{\"code\":\"unauthorized\",\"message\":\"unauthorized access\"}",
+    false, 0, "unauthorized access"
+  },
+  {
+    // An escaped quote inside the message, and keys that are not kept.
+    "{\"line\":3, \"error\" : \"unable to parse 'weather,location=\\\"home\\\" t=1': invalid tag\", \"op\":\"write\"}",
+    false, 0, "unable to parse 'weather,location=\"home\" t=1': invalid tag"
+  },
+  {
+    // A key too long to keep, with a value that must not be taken for the message.
+    "{\"a_key_longer_than_the_buffer\":\"dropped=7\",\"error\":\"timeout\"}",
+    false, 0, "timeout"
+  },
+  {
+    "<html><body><h1>502 Bad Gateway</h1></body></html>\r\n",
+    false, 0, ""
+  },
+  {
+    "",
+    false, 0, ""
+  },
+  {
+    // A message longer than what is kept, with the count at its end.
+    "{\"error\":\"partial write: unable to parse 'weather,location=home temperature=21.50,pressure=101325.00,humidity=45.000,"
+    "extra=1,extra2=2,extra3=3 1791288000x': bad timestamp dropped=3\"}",
+    true, 3, "partial write: unable to parse 'weather,location=home temperature=21.50,pressure=101325.00,humidity=45.000,"
+    "extra=1,extra2=2,ext"
+  }
+};
+
+
+static void test_resp_check(const test_resp_case_t *c, resp_t *resp, const char *how)
+{
+  bool ok = resp->partial == c->partial && resp->dropped == c->dropped &&
+            strcmp(resp_message(resp), c->message) == 0;
+  TEST_ASSERT(ok);
+  if (!ok) {
+    fprintf(stderr, "  %s of %s\n  parsed partial=%d dropped=%u message=%s\n", how, c->body, resp->partial,
+            resp->dropped, resp_message(resp));
+  }
+}
+
+
+static void test_resp_recorded()
+{
+  for (uint32_t i = 0; i < sizeof(test_resp_cases) / sizeof(test_resp_cases[0]); i++) {
+    const test_resp_case_t *c = &test_resp_cases[i];
+    uint32_t len = strlen(c->body);
+    resp_t resp;
+
+    resp_reset(&resp);
+    resp_feed(&resp, c->body, len);
+    test_resp_check(c, &resp, "whole");
+
+    for (uint32_t split = 0; split <= len; split++) {
+      resp_reset(&resp);
+      resp_feed(&resp, c->body, split);
+      resp_feed(&resp, c->body + split, len - split);
+      test_resp_check(c, &resp, "split");
+    }
+
+    resp_reset(&resp);
+    for (uint32_t j = 0; j < len; j++) {
+      resp_feed(&resp, &c->body[j], 1);
+    }
+    test_resp_check(c, &resp, "bytewise");
+  }
+}
+
+
+typedef struct {
+  const char *response;
+  int status;
+  bool close;
+  bool ended;                         // complete only once the connection closes
+  bool partial;
+  uint32_t dropped;
+  const char *message;
+} test_resp_frame_t;
+
+static const test_resp_frame_t test_resp_frames[] = {
+  {
+    "HTTP/1.1 204 No Content\r\nContent-Type: application/json\r\nRequest-Id: 5b1c9a2e-0f5a-11ef-8001-0242ac110002\r\n"
+    "X-Influxdb-Build: OSS\r\nX-Influxdb-Version: 1.8.10\r\nDate: Fri, 16 Oct 2026 09:00:00 GMT\r\n\r\n",
+    204, false, false, false, 0, ""
+  },
+  {
+    // A partial write, with the error repeated in a header that must not be taken for the body.
+    "HTTP/1.1 400 Bad Request\r\nContent-Type: application/json\r\nRequest-Id: 7d3e10a4-0f5a-11ef-8002-0242ac110002\r\n"
+    "X-Influxdb-Build: OSS\r\nX-Influxdb-Error: partial write: unable to parse 'weather,location=home temperature= "
+    "1792141200000000000': missing field value dropped=1\r\nX-Influxdb-Version: 1.8.10\r\n"
+    "Date: Fri, 16 Oct 2026 09:00:02 GMT\r\nContent-Length: 131\r\n\r\n"
+    "{\"error\":\"partial write: unable to parse 'weather,location=home temperature= 1792141200000000000': missing field "
+    "value dropped=1\"}\n",
+    400, false, false, true, 1,
+    "partial write: unable to parse 'weather,location=home temperature= 1792141200000000000': missing field value dropped=1"
+  },
+  {
+    // A refusal of the whole body, which wrote none of its points.
+    "HTTP/1.1 400 Bad Request\r\nContent-Type: application/json\r\nRequest-Id: 7d3e10a5-0f5a-11ef-8003-0242ac110002\r\n"
+    "X-Influxdb-Build: OSS\r\nX-Influxdb-Error: unable to parse 'weather,location=home temperature=21.4 "
+    "179214120000000000a': bad timestamp\r\nX-Influxdb-Version: 1.8.10\r\nDate: Fri, 16 Oct 2026 09:00:03 GMT\r\n"
+    "Content-Length: 104\r\n\r\n"
+    "{\"error\":\"unable to parse 'weather,location=home temperature=21.4 179214120000000000a': bad timestamp\"}\n",
+    400, false, false, false, 0,
+    "unable to parse 'weather,location=home temperature=21.4 179214120000000000a': bad timestamp"
+  },
+  {
+    "HTTP/1.1 400 Bad Request\r\nContent-Type: application/json\r\nContent-Length: 51\r\nConnection: close\r\n\r\n"
+    "{\"error\":\"partial write: bad timestamp dropped=2\"}\n",
+    400, true, false, true, 2, "partial write: bad timestamp dropped=2"
+  },
+  {
+    // Chunked by a proxy, with a chunk extension and a trailer.
+    "HTTP/1.1 401 Unauthorized\r\ntransfer-encoding: Chunked\r\n\r\n"
+    "10;ext=1\r\n{\"code\":\"unautho\r\n1d\r\nrized\",\"message\":\"bad token\"}\r\n0\r\nX-Trailer: 1\r\n\r\n",
+    401, false, false, false, 0, "bad token"
+  },
+  {
+    "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n",
+    204, false, false, false, 0, ""
+  },
+  {
+    // A body without a length ends with the connection.
+    "HTTP/1.0 502 Bad Gateway\r\nContent-Type: text/html\r\n\r\n<html><body>{\"error\":\"upstream\"}</body></html>",
+    502, true, true, false, 0, "upstream"
+  },
+  {
+    "SSH-2.0-OpenSSH_9.2\r\n",
+    0, true, false, false, 0, ""
+  }
+};
+
+
+static void test_resp_frame_check(const test_resp_frame_t *f, resp_t *resp, uint32_t taken, const char *how)
+{
+  uint32_t len = strlen(f->response);
+  bool done = f->ended ? !resp_is_done(resp) && resp_end(resp) : resp_is_done(resp);
+  bool ok = done && taken == len && resp->status == f->status && resp->close == f->close &&
+            resp->partial == f->partial && resp->dropped == f->dropped && strcmp(resp_message(resp), f->message) == 0;
+  TEST_ASSERT(ok);
+  if (!ok) {
+    fprintf(stderr, "  %s of %s\n  parsed done=%d taken=%u status=%d close=%d partial=%d dropped=%u message=%s\n", how,
+            f->response, done, taken, resp->status, resp->close, resp->partial, resp->dropped, resp_message(resp));
+  }
+}
+
+
+static void test_resp_framing()
+{
+  char buffer[1024];
+
+  for (uint32_t i = 0; i < sizeof(test_resp_frames) / sizeof(test_resp_frames[0]); i++) {
+    const test_resp_frame_t *f = &test_resp_frames[i];
+    uint32_t len = strlen(f->response);
+    resp_t resp;
+
+    for (uint32_t split = 0; split <= len; split++) {
+      resp_reset(&resp);
+      uint32_t taken = resp_read(&resp, f->response, split);
+      taken += resp_read(&resp, f->response + split, len - split);
+      test_resp_frame_check(f, &resp, taken, "split");
+    }
+
+    resp_reset(&resp);
+    uint32_t taken = 0;
+    for (uint32_t j = 0; j < len; j++) {
+      taken += resp_read(&resp, &f->response[j], 1);
+    }
+    test_resp_frame_check(f, &resp, taken, "bytewise");
+
+    // Whatever follows a complete response is left to the caller.
+    if (!f->ended) {
+      snprintf(buffer, sizeof(buffer), "%sHTTP/1.1 204", f->response);
+      resp_reset(&resp);
+      TEST_ASSERT_EQ(resp_read(&resp, buffer, strlen(buffer)), len);
+      TEST_ASSERT(resp_is_done(&resp));
+    }
+  }
+}
+
+
+static void test_resp_classify()
+{
+  TEST_ASSERT_EQ(resp_classify(200), RESP_RESULT_SUCCESS);
+  TEST_ASSERT_EQ(resp_classify(204), RESP_RESULT_SUCCESS);
+  TEST_ASSERT_EQ(resp_classify(400), RESP_RESULT_DROP);
+  TEST_ASSERT_EQ(resp_classify(413), RESP_RESULT_DROP);
+  TEST_ASSERT_EQ(resp_classify(422), RESP_RESULT_DROP);
+  TEST_ASSERT_EQ(resp_classify(401), RESP_RESULT_RETRY);
+  TEST_ASSERT_EQ(resp_classify(404), RESP_RESULT_RETRY);
+  TEST_ASSERT_EQ(resp_classify(429), RESP_RESULT_RETRY);
+  TEST_ASSERT_EQ(resp_classify(500), RESP_RESULT_RETRY);
+  TEST_ASSERT_EQ(resp_classify(503), RESP_RESULT_RETRY);
+  TEST_ASSERT_EQ(resp_classify(0), RESP_RESULT_RETRY);
+}
+
+
+int main()
+{
+  test_resp_recorded();
+  test_resp_framing();
+  test_resp_classify();
+
+  return TEST_END();
+}
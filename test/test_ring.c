@@ -0,0 +1,115 @@
+/**
+ * @file    test_ring.c
+ *
+ * @brief   Ring Test Source File
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "test.h"
+
+#include "ring.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+
+#define TEST_RING_LENGTH              (8)
+#define TEST_RING_STRESS_COUNT        (200000)
+
+
+typedef struct {
+  uint32_t seq;
+  uint32_t check;
+} test_elem_t;
+
+static test_elem_t test_storage[TEST_RING_LENGTH];
+static ring_t test_ring = RING_INIT(test_storage, TEST_RING_LENGTH);
+
+
+static void test_ring_order()
+{
+  test_elem_t elem;
+
+  TEST_ASSERT(!ring_pop(&test_ring, &elem));
+  TEST_ASSERT_EQ(ring_count(&test_ring), 0);
+
+  // Runs around the storage a few times, so that the indices wrap.
+  for (uint32_t round = 0; round < 5; round++) {
+    for (uint32_t i = 0; i < TEST_RING_LENGTH; i++) {
+      elem = (test_elem_t) { round * 100 + i, ~(round * 100 + i) };
+      TEST_ASSERT(ring_push(&test_ring, &elem));
+    }
+
+    TEST_ASSERT_EQ(ring_count(&test_ring), TEST_RING_LENGTH);
+    elem = (test_elem_t) { 0, 0 };
+    TEST_ASSERT(!ring_push(&test_ring, &elem));
+
+    for (uint32_t i = 0; i < TEST_RING_LENGTH; i++) {
+      TEST_ASSERT(ring_pop(&test_ring, &elem));
+      TEST_ASSERT_EQ(elem.seq, round * 100 + i);
+      TEST_ASSERT_EQ(elem.check, ~(round * 100 + i));
+    }
+    TEST_ASSERT(!ring_pop(&test_ring, &elem));
+  }
+}
+
+
+static void *test_ring_producer()
+{
+  for (uint32_t seq = 0; seq < TEST_RING_STRESS_COUNT; seq++) {
+    test_elem_t elem = { seq, ~seq };
+    while (!ring_push(&test_ring, &elem)) {
+      sched_yield();
+    }
+  }
+
+  return NULL;
+}
+
+
+/**
+ * @brief           Pushes and pops from two threads. Every element has to arrive once, in order and whole.
+ */
+static void test_ring_threads()
+{
+  pthread_t producer;
+  pthread_create(&producer, NULL, test_ring_producer, NULL);
+
+  uint32_t expected = 0;
+  uint32_t torn = 0;
+  uint32_t reordered = 0;
+  while (expected < TEST_RING_STRESS_COUNT) {
+    test_elem_t elem;
+    if (!ring_pop(&test_ring, &elem)) {
+      sched_yield();
+      continue;
+    }
+    if (elem.check != ~elem.seq) {
+      torn++;
+    }
+    if (elem.seq != expected) {
+      reordered++;
+    }
+    expected = elem.seq + 1;
+  }
+
+  pthread_join(producer, NULL);
+
+  TEST_ASSERT_EQ(torn, 0);
+  TEST_ASSERT_EQ(reordered, 0);
+  TEST_ASSERT_EQ(ring_count(&test_ring), 0);
+}
+
+
+int main()
+{
+  test_ring_order();
+  test_ring_threads();
+
+  return TEST_END();
+}
@@ -0,0 +1,329 @@
+/**
+ * @file    test_store.c
+ *
+ * @brief   Store Test Source File
+ *
+ * @remarks The log runs on the RAM flash of the mock, and a reboot is a mount of the same flash. The sensors are
+ *          stubbed, so that a reboot can find them in another order.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "test.h"
+#include "mock.h"
+
+#include "esp_partition.h"
+
+#include "bme.h"
+#include "clock.h"
+#include "stats.h"
+#include "store.h"
+
+
+#define TEST_STORE_SLOTS              (160)
+#define TEST_STORE_APPEND             (32)
+
+typedef struct {
+  i2c_port_t port;
+  uint8_t addr;
+} test_bus_t;
+
+// The sensors in the order they were found at the last boot.
+static test_bus_t test_buses[BME_MAX_SENSORS];
+static uint32_t test_bus_count;
+
+static sample_t test_samples[MOCK_FLASH_SIZE / STORE_SECTOR_SIZE * TEST_STORE_SLOTS];
+
+
+bool bme_get_bus(uint8_t sensor, i2c_port_t *port, uint8_t *addr)
+{
+  if (sensor >= test_bus_count) {
+    return false;
+  }
+
+  *port = test_buses[sensor].port;
+  *addr = test_buses[sensor].addr;
+
+  return true;
+}
+
+
+uint8_t bme_find(i2c_port_t port, uint8_t addr)
+{
+  for (uint32_t i = 0; i < test_bus_count; i++) {
+    if (test_buses[i].port == port && test_buses[i].addr == addr) {
+      return i;
+    }
+  }
+
+  return BME_MAX_SENSORS;
+}
+
+
+static sample_t test_store_sample(uint32_t i)
+{
+  return (sample_t) {
+    .temperature = -500 + (int32_t)i,
+    .pressure = 100000 + i,
+    .humidity = 45000 + i,
+    .acquired_us = 12345,
+    .timestamp = CLOCK_EPOCH_MIN_MS + i * 1000LL,
+    .sensor = i % 2
+  };
+}
+
+
+static void test_store_boot()
+{
+  mock_flash_erase();
+  test_buses[0] = (test_bus_t) { I2C_NUM_0, 0x76 };
+  test_buses[1] = (test_bus_t) { I2C_NUM_1, 0x77 };
+  test_bus_count = 2;
+  TEST_ASSERT_EQ(store_init(), ESP_OK);
+  TEST_ASSERT_EQ(store_count(), 0);
+}
+
+
+static void test_store_layout()
+{
+  TEST_ASSERT_EQ(sizeof(store_record_t), 24);
+  TEST_ASSERT_EQ(sizeof(store_record_t) * TEST_STORE_APPEND, STORE_APPEND_PAGES * STORE_PAGE_SIZE);
+}
+
+
+/**
+ * @brief           The samples come back whole, with their sensor, and without their time relative to this boot.
+ */
+static void test_store_round_trip()
+{
+  test_store_boot();
+
+  for (uint32_t i = 0; i < 40; i++) {
+    sample_t sample = test_store_sample(i);
+    TEST_ASSERT_EQ(store_write(&sample), ESP_OK);
+  }
+  // A time relative to boot, before the clock is synchronized, is left to the server.
+  sample_t relative = test_store_sample(40);
+  relative.timestamp = 5000;
+  store_write(&relative);
+  TEST_ASSERT_EQ(store_count(), 41);
+
+  TEST_ASSERT_EQ(store_read(test_samples, 48), 41);
+  for (uint32_t i = 0; i < 40; i++) {
+    sample_t expected = test_store_sample(i);
+    TEST_ASSERT_EQ(test_samples[i].temperature, expected.temperature);
+    TEST_ASSERT_EQ(test_samples[i].pressure, expected.pressure);
+    TEST_ASSERT_EQ(test_samples[i].humidity, expected.humidity);
+    TEST_ASSERT_EQ(test_samples[i].timestamp, expected.timestamp);
+    TEST_ASSERT_EQ(test_samples[i].sensor, expected.sensor);
+  }
+  TEST_ASSERT_EQ(test_samples[40].timestamp, CLOCK_UNKNOWN);
+
+  TEST_ASSERT_EQ(store_commit(41), ESP_OK);
+  TEST_ASSERT_EQ(store_count(), 0);
+  TEST_ASSERT_EQ(store_read(test_samples, 48), 0);
+}
+
+
+/**
+ * @brief           After a reboot the sensors are found in another order, or not at all, and every stored sample still
+ *                  gets the sensor it was taken by.
+ */
+static void test_store_reboot()
+{
+  test_store_boot();
+
+  for (uint32_t i = 0; i < 10; i++) {
+    sample_t sample = test_store_sample(i);
+    store_write(&sample);
+  }
+  store_flush();
+
+  // A third sensor is found first, and the second one is gone.
+  test_buses[0] = (test_bus_t) { I2C_NUM_0, 0x77 };
+  test_buses[1] = (test_bus_t) { I2C_NUM_0, 0x76 };
+  test_bus_count = 2;
+  TEST_ASSERT_EQ(store_init(), ESP_OK);
+  TEST_ASSERT_EQ(store_count(), 10);
+
+  TEST_ASSERT_EQ(store_read(test_samples, 48), 10);
+  for (uint32_t i = 0; i < 10; i++) {
+    TEST_ASSERT_EQ(test_samples[i].sensor, i % 2 == 0 ? 1 : BME_MAX_SENSORS);
+    TEST_ASSERT_EQ(test_samples[i].temperature, test_store_sample(i).temperature);
+  }
+}
+
+
+/**
+ * @brief           The records go to flash in appends of whole pages, and an early flush only misaligns the append right
+ *                  after it.
+ */
+static void test_store_pages()
+{
+  test_store_boot();
+
+  mock_flash_stats_t before, after;
+  mock_flash_get_stats(&before);
+  for (uint32_t i = 0; i < 3 * TEST_STORE_APPEND; i++) {
+    sample_t sample = test_store_sample(i);
+    store_write(&sample);
+  }
+  mock_flash_get_stats(&after);
+  TEST_ASSERT_EQ(after.writes - before.writes, 3);
+  TEST_ASSERT_EQ(after.page_writes - before.page_writes, 3);
+
+  // An early flush, then the append that brings the records back onto a page, then whole pages again.
+  for (uint32_t i = 0; i < 8; i++) {
+    sample_t sample = test_store_sample(i);
+    store_write(&sample);
+  }
+  store_flush();
+  mock_flash_get_stats(&before);
+  for (uint32_t i = 0; i < TEST_STORE_APPEND - 8; i++) {
+    sample_t sample = test_store_sample(i);
+    store_write(&sample);
+  }
+  mock_flash_get_stats(&after);
+  TEST_ASSERT_EQ(after.writes - before.writes, 1);
+  TEST_ASSERT_EQ(after.page_writes - before.page_writes, 0);
+
+  // Into the next sector, which takes its header first.
+  mock_flash_get_stats(&before);
+  for (uint32_t i = 0; i < TEST_STORE_SLOTS; i++) {
+    sample_t sample = test_store_sample(i);
+    store_write(&sample);
+  }
+  mock_flash_get_stats(&after);
+  TEST_ASSERT_EQ(after.page_writes - before.page_writes, TEST_STORE_SLOTS / TEST_STORE_APPEND);
+  TEST_ASSERT_EQ(after.erases - before.erases, 1);
+  TEST_ASSERT_EQ(store_count(), 4 * TEST_STORE_APPEND + TEST_STORE_SLOTS);
+}
+
+
+/**
+ * @brief           A record torn by a power loss is skipped, and the records around it are kept.
+ */
+static void test_store_torn()
+{
+  test_store_boot();
+
+  for (uint32_t i = 0; i < TEST_STORE_APPEND; i++) {
+    sample_t sample = test_store_sample(i);
+    store_write(&sample);
+  }
+
+  // Clears a bit in the pressure of the second record, as an interrupted write would leave it.
+  const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                              STORE_PARTITION_LABEL);
+  uint8_t torn = 0xFE;
+  esp_partition_write(partition, STORE_PAGE_SIZE + sizeof(store_record_t) + 8, &torn, 1);
+
+  TEST_ASSERT_EQ(store_init(), ESP_OK);
+  TEST_ASSERT_EQ(store_count(), TEST_STORE_APPEND - 1);
+  TEST_ASSERT_EQ(store_read(test_samples, 48), TEST_STORE_APPEND - 1);
+  TEST_ASSERT_EQ(test_samples[0].temperature, test_store_sample(0).temperature);
+  TEST_ASSERT_EQ(test_samples[1].temperature, test_store_sample(2).temperature);
+}
+
+
+/**
+ * @brief           A log that runs over drops its oldest sector and counts the lost samples.
+ */
+static void test_store_full()
+{
+  test_store_boot();
+
+  uint32_t capacity = sizeof(test_samples) / sizeof(test_samples[0]);
+  uint32_t lost = stats_get(STATS_POINTS_LOST);
+  for (uint32_t i = 0; i < capacity; i++) {
+    sample_t sample = test_store_sample(i);
+    store_write(&sample);
+  }
+  TEST_ASSERT_EQ(stats_get(STATS_POINTS_LOST) - lost, 0);
+  TEST_ASSERT_EQ(store_count(), capacity);
+
+  // One more append takes the place of the oldest sector.
+  for (uint32_t i = 0; i < TEST_STORE_APPEND; i++) {
+    sample_t sample = test_store_sample(capacity + i);
+    store_write(&sample);
+  }
+  TEST_ASSERT_EQ(stats_get(STATS_POINTS_LOST) - lost, TEST_STORE_SLOTS);
+  TEST_ASSERT_EQ(store_count(), capacity + TEST_STORE_APPEND - TEST_STORE_SLOTS);
+
+  TEST_ASSERT_EQ(store_init(), ESP_OK);
+  TEST_ASSERT_EQ(store_count(), capacity + TEST_STORE_APPEND - TEST_STORE_SLOTS);
+  TEST_ASSERT_EQ(store_read(test_samples, 1), 1);
+  TEST_ASSERT_EQ(test_samples[0].temperature, test_store_sample(TEST_STORE_SLOTS).temperature);
+}
+
+
+/**
+ * @brief           A log that is drained as it fills erases each sector once per cycle, when the head reuses it, and
+ *                  mounts without pending samples in between.
+ */
+static void test_store_wear()
+{
+  test_store_boot();
+
+  uint32_t sectors = MOCK_FLASH_SIZE / STORE_SECTOR_SIZE;
+  mock_flash_stats_t before, after;
+  mock_flash_get_stats(&before);
+  for (uint32_t i = 0; i < 3 * sectors; i++) {
+    for (uint32_t j = 0; j < TEST_STORE_SLOTS; j++) {
+      sample_t sample = test_store_sample(j);
+      store_write(&sample);
+    }
+    TEST_ASSERT_EQ(store_read(test_samples, TEST_STORE_SLOTS), TEST_STORE_SLOTS);
+    TEST_ASSERT_EQ(store_commit(TEST_STORE_SLOTS), ESP_OK);
+
+    if (i == sectors) {
+      TEST_ASSERT_EQ(store_init(), ESP_OK);
+      TEST_ASSERT_EQ(store_count(), 0);
+    }
+  }
+  mock_flash_get_stats(&after);
+
+  // The first sector was formatted at boot.
+  TEST_ASSERT_EQ(after.erases - before.erases, 3 * sectors - 1);
+  TEST_ASSERT_EQ(store_count(), 0);
+}
+
+
+/**
+ * @brief           Records that cannot be written are counted as lost, along with the ones grouped with them.
+ */
+static void test_store_fail()
+{
+  test_store_boot();
+
+  uint32_t lost = stats_get(STATS_POINTS_LOST);
+  mock_flash_fail = true;
+  esp_err_t esp_err = ESP_OK;
+  for (uint32_t i = 0; i < TEST_STORE_APPEND; i++) {
+    sample_t sample = test_store_sample(i);
+    esp_err = store_write(&sample);
+  }
+  mock_flash_fail = false;
+
+  TEST_ASSERT_EQ(esp_err, ESP_FAIL);
+  TEST_ASSERT_EQ(stats_get(STATS_POINTS_LOST) - lost, TEST_STORE_APPEND);
+  TEST_ASSERT_EQ(store_count(), 0);
+}
+
+
+int main()
+{
+  test_store_layout();
+  test_store_round_trip();
+  test_store_reboot();
+  test_store_pages();
+  test_store_torn();
+  test_store_full();
+  test_store_wear();
+  test_store_fail();
+
+  return TEST_END();
+}
@@ -0,0 +1,143 @@
+/**
+ * @file    tls_bench.c
+ *
+ * @brief   TLS Benchmark Source File
+ *
+ * @remarks Connects to the fake InfluxDB through tls.c, alternating a full handshake, after the saved session is
+ *          dropped, with one that resumes it, as after an idle close, a lost AP or a deep sleep. The time, the bytes on
+ *          the wire and the peak heap of the TLS library of each kind are printed, one key=value per line. They are
+ *          the figures of OpenSSL on the host, and only the ratio between the two kinds carries over to mbedTLS on the
+ *          target, where they are measured as the connect and resume stages, see perf.h.
+ *
+ * @author  Charalampos Eleftheriadis
+ * @version 0.1
+ * @date    2026-10-16
+ */
+
+
+#include "mock.h"
+
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "nvs_flash.h"
+
+#include "boot.h"
+#include "http.h"
+#include "tls.h"
+#include "wifi.h"
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+typedef struct {
+  uint32_t count;
+  uint64_t us;
+  uint32_t max_us;
+  uint64_t bytes_out;
+  uint64_t bytes_in;
+  uint64_t peak_heap;
+} tls_bench_total_t;
+
+
+static void tls_bench_usage(const char *name)
+{
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  --rounds N           make N full and N resumed handshakes (20)\n"
+          "  --verbose            log at the info level\n", name);
+}
+
+
+static void tls_bench_print(const char *kind, const tls_bench_total_t *total)
+{
+  uint32_t count = total->count > 0 ? total->count : 1;
+
+  printf("%s_handshakes=%u\n", kind, total->count);
+  printf("%s_mean_us=%llu\n", kind, (unsigned long long)(total->us / count));
+  printf("%s_max_us=%u\n", kind, total->max_us);
+  printf("%s_bytes_out=%llu\n", kind, (unsigned long long)(total->bytes_out / count));
+  printf("%s_bytes_in=%llu\n", kind, (unsigned long long)(total->bytes_in / count));
+  printf("%s_peak_heap=%llu\n", kind, (unsigned long long)(total->peak_heap / count));
+}
+
+
+int main(int argc, char **argv)
+{
+  static const struct option options[] = {
+    { "rounds", required_argument, NULL, 'r' },
+    { "verbose", no_argument, NULL, 'v' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+
+  uint32_t rounds = 20;
+  int option;
+  while ((option = getopt_long(argc, argv, "", options, NULL)) != -1) {
+    switch (option) {
+      case 'r': rounds = strtoul(optarg, NULL, 0); break;
+      case 'v': esp_log_level_set("*", ESP_LOG_INFO); break;
+      case 'h':
+        tls_bench_usage(argv[0]);
+        exit(0);
+      default:
+        tls_bench_usage(argv[0]);
+        exit(2);
+    }
+  }
+
+  // Only the handshakes themselves are timed.
+  mock_http_connect_fault = (mock_fault_t) { 0 };
+
+  boot_init();
+  TaskHandle_t wifi_task_handle = NULL;
+  xTaskCreate((TaskFunction_t)wifi_task, WIFI_TASK_NAME, WIFI_TASK_STACK_SIZE, NULL, WIFI_TASK_PRIORITY, &wifi_task_handle);
+  nvs_flash_init();
+  boot_ready(BOOT_STAGE_NVS);
+  boot_wait(BOOT_STAGE_IP, portMAX_DELAY);
+
+  tls_bench_total_t totals[2] = { 0 };
+  uint32_t mismatches = 0;
+
+  for (uint32_t i = 0; i < 2 * rounds; i++) {
+    bool full = i % 2 == 0;
+    if (full) {
+      tls_forget();
+    }
+
+    bool resumed = false;
+    esp_tls_t *tls = tls_connect(HTTP_HOST, HTTP_PORT, HTTP_TIMEOUT_MS, &resumed);
+    if (tls == NULL) {
+      return 1;
+    }
+    tls_close(tls);
+
+    mock_tls_handshake_t handshake;
+    mock_tls_get_last(&handshake);
+    // Both ends have to agree, and a session has to be resumed whenever one is offered.
+    if (resumed != handshake.resumed || resumed == full) {
+      mismatches++;
+    }
+
+    tls_bench_total_t *total = &totals[handshake.resumed];
+    total->count++;
+    total->us += handshake.us;
+    total->max_us = handshake.us > total->max_us ? handshake.us : total->max_us;
+    total->bytes_out += handshake.bytes_out;
+    total->bytes_in += handshake.bytes_in;
+    total->peak_heap += handshake.peak_heap;
+  }
+
+  mock_http_stats_t server;
+  mock_http_get_stats(&server);
+
+  tls_bench_print("full", &totals[0]);
+  tls_bench_print("resumed", &totals[1]);
+  printf("server_connects=%u\n", server.connects);
+  printf("server_resumptions=%u\n", server.resumptions);
+  printf("mismatches=%u\n", mismatches);
+
+  return totals[1].count == rounds && mismatches == 0 ? 0 : 1;
+}